@@ -0,0 +1,208 @@
+#pragma once
+
+#include "kNet.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Camera channel of the client and the harness, sent unreliable and unordered: a sequence number lets the walls drop
+// stale packets, the latest wins. Also sent while the joystick is deflected, with cCameraJoystickFlag, so that the
+// joystick claims the camera with the time of the update.
+const kNet::message_id_t cCameraMessageID = 35;
+// Flag of the camera updates sent while the joystick is deflected.
+const unsigned char cCameraJoystickFlag = 1;
+// Content id of the camera messages, so that kNet replaces a queued update by a newer one instead of sending both.
+const unsigned cCameraContentID = 1;
+// Size of a camera update.
+const size_t cCameraMessageSize = 145;
+// Move of the walls at full deflection, in units per second (CAMERA_MOVE_SPEED on the walls).
+const float cCameraMoveSpeed = 300.0f;
+// Turn of the walls at full deflection, in degrees per second (CAMERA_TURN_SPEED on the walls).
+const float cCameraTurnSpeed = 90.0f;
+// Longest motion segment.
+const double cCameraSegmentSeconds = 0.25;
+
+// Camera velocity of the camera channel: move along right, up and forward and turn, each in [-1, 1].
+struct CameraVelocity
+{
+  float move[3];
+  float yaw;
+};
+
+// Camera motion integrated since the start of a motion segment, in full deflection seconds (see CameraOdometry on the
+// walls). Each velocity is integrated alone, and along the turned horizontal axes where the turn matters, so that the
+// walls rebuild the displacement for their pitch.
+struct CameraOdometry
+{
+  float yaw;
+  float right[2];
+  float up;
+  float upTurned[2];
+  float forward;
+  float forwardTurned[2];
+};
+
+// Motion segment: start time on the shared clock in ms, and motion since then.
+struct CameraSegment
+{
+  unsigned start;
+  CameraOdometry odometry;
+};
+
+// Time stamped on the commands and the camera updates: ms of the system clock, truncated to 32 bits like
+// Time::GetSystemTime on the walls. The walls arbitrate the camera and pick the motion segments with these stamps
+// rather than with the arrival times, which differ from wall to wall; the machines of the controllers keep their clocks
+// in sync with NTP.
+static unsigned SharedTime()
+{
+  return (unsigned)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Integrates the camera velocity into motion segments. A segment starts when the camera starts moving and every
+// cCameraSegmentSeconds while it moves; the walls place the camera at the start of the segment plus its motion, so
+// that where the camera ends depends on what the controller did and not on the packets or frames of each wall. The
+// motion since the camera started moving, the run, is integrated as well: its value at the start of the segment in
+// progress is a keyframe that places the segment from the start of the run, so that a wall that lost every update of
+// a segment still puts the next one where the others do.
+class CameraOdometer
+{
+public:
+  CameraOdometer();
+
+  // Integrate the velocity held since the last update up to now, in seconds, then hold the new velocity. Return true if
+  // a segment started, so that the caller sends it at once.
+  bool Update(double now, const CameraVelocity &velocity);
+
+  // Segment in progress, and the complete segment before it, for a wall that lost its last updates.
+  const CameraSegment &GetSegment() const { return segment; }
+  const CameraSegment &GetPrevious() const { return previous; }
+  // Keyframe: start of the run, and motion of the run up to the start of the segment in progress.
+  const CameraSegment &GetKeyframe() const { return keyframe; }
+
+private:
+  CameraSegment segment;
+  CameraSegment previous;
+  CameraSegment run;
+  CameraSegment keyframe;
+  // Velocity held since lastTime, yaw turned since the start of the segment and of the run in degrees, start of the
+  // segment in s.
+  CameraVelocity held;
+  double lastTime;
+  float turned;
+  float runTurned;
+  double segmentTime;
+};
+
+// Integrate a velocity held for dt seconds into the motion of a segment, turned by the given yaw since its start: the
+// exact integral while the yaw turns at a constant rate, with the mean of the sine and cosine of the yaw over dt.
+static void IntegrateCameraMotion(CameraOdometry &odometry, float &turned, const CameraVelocity &held, double dt)
+{
+  float turn = held.yaw * cCameraTurnSpeed * (float)dt;
+  double y0 = turned * M_PI / 180.0;
+  double y1 = (turned + turn) * M_PI / 180.0;
+  double meanSin, meanCos;
+  if (fabs(y1 - y0) < 1e-6)
+  {
+    meanSin = sin(0.5 * (y0 + y1));
+    meanCos = cos(0.5 * (y0 + y1));
+  }
+  else
+  {
+    meanSin = (cos(y0) - cos(y1)) / (y1 - y0);
+    meanCos = (sin(y1) - sin(y0)) / (y1 - y0);
+  }
+  float sinDt = (float)(meanSin * dt);
+  float cosDt = (float)(meanCos * dt);
+
+  odometry.yaw += turn;
+  odometry.right[0] += held.move[0] * cosDt;
+  odometry.right[1] -= held.move[0] * sinDt;
+  odometry.up += held.move[1] * (float)dt;
+  odometry.upTurned[0] += held.move[1] * sinDt;
+  odometry.upTurned[1] += held.move[1] * cosDt;
+  odometry.forward += held.move[2] * (float)dt;
+  odometry.forwardTurned[0] += held.move[2] * sinDt;
+  odometry.forwardTurned[1] += held.move[2] * cosDt;
+  turned += turn;
+}
+
+inline CameraOdometer::CameraOdometer() :
+  lastTime(0.0),
+  turned(0.0f),
+  runTurned(0.0f),
+  segmentTime(0.0)
+{
+  memset(&segment, 0, sizeof(segment));
+  memset(&held, 0, sizeof(held));
+  // a previous segment with the start of the current one is no segment for the walls
+  segment.start = SharedTime();
+  previous = segment;
+  run = segment;
+  keyframe = segment;
+}
+
+inline bool CameraOdometer::Update(double now, const CameraVelocity &velocity)
+{
+  double dt = lastTime > 0.0 ? now - lastTime : 0.0;
+  lastTime = now;
+  if (dt > 0.0)
+  {
+    IntegrateCameraMotion(segment.odometry, turned, held, dt);
+    IntegrateCameraMotion(run.odometry, runTurned, held, dt);
+  }
+
+  bool wasMoving = held.move[0] || held.move[1] || held.move[2] || held.yaw;
+  bool moving = velocity.move[0] || velocity.move[1] || velocity.move[2] || velocity.yaw;
+  held = velocity;
+  if (!moving || (wasMoving && now - segmentTime < cCameraSegmentSeconds))
+    return false;
+
+  // start times strictly increase, so that the walls tell the segments apart
+  previous = segment;
+  memset(&segment.odometry, 0, sizeof(segment.odometry));
+  unsigned time = SharedTime();
+  segment.start = (int)(time - previous.start) > 0 ? time : previous.start + 1;
+  segmentTime = now;
+  turned = 0.0f;
+
+  // a run starts with the motion, at the start of its first segment
+  if (!wasMoving)
+  {
+    memset(&run.odometry, 0, sizeof(run.odometry));
+    run.start = segment.start;
+    runTurned = 0.0f;
+  }
+  keyframe = run;
+  return true;
+}
+
+static void WriteCameraSegment(char *dest, const CameraSegment &segment)
+{
+  const CameraOdometry &odometry = segment.odometry;
+  memcpy(dest, &segment.start, 4);
+  memcpy(dest + 4, &odometry.yaw, 4);
+  memcpy(dest + 8, odometry.right, 8);
+  memcpy(dest + 16, &odometry.up, 4);
+  memcpy(dest + 20, odometry.upTurned, 8);
+  memcpy(dest + 28, &odometry.forward, 4);
+  memcpy(dest + 32, odometry.forwardTurned, 8);
+}
+
+// Camera channel payload, little endian like the Urho3D MemoryBuffer reading it: sequence number, velocity of the keys,
+// time and flags, then the motion segment in progress, the one before it and the keyframe of the run, 40 bytes each.
+// The walls place the camera from the segments and only extrapolate with the velocity until the next update.
+static size_t WriteCameraMessage(char *dest, unsigned sequence, const CameraVelocity &velocity, unsigned time,
+  unsigned char flags, const CameraSegment &segment, const CameraSegment &previous, const CameraSegment &keyframe)
+{
+  memcpy(dest, &sequence, 4);
+  memcpy(dest + 4, velocity.move, 12);
+  memcpy(dest + 16, &velocity.yaw, 4);
+  memcpy(dest + 20, &time, 4);
+  dest[24] = (char)flags;
+  WriteCameraSegment(dest + 25, segment);
+  WriteCameraSegment(dest + 65, previous);
+  WriteCameraSegment(dest + 105, keyframe);
+  return cCameraMessageSize;
+}
@@ -1,86 +1,1335 @@
 #include "kNet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/joystick.h>
+#endif
+
+#include "CameraChannel.h"
+
 #include "kNet/DebugMemoryLeakCheck.h"
 
 using namespace kNet;
 
 // Define a MessageID for our a custom message.
 const message_id_t cHelloMessageID = 32;
+// Reply of a wall to the "telemetry" command: "<key> <value>" lines.
+const message_id_t cTelemetryMessageID = 33;
+// How long to wait for the telemetry of every wall.
+const int cTelemetryTimeoutMs = 2000;
+// Simulation state of a wall, sent in reply to the "snapshot" command and loaded by the wall receiving it.
+const message_id_t cSnapshotMessageID = 34;
+// How long to wait for the snapshot of a peer.
+const int cSnapshotTimeoutMs = 1000;
+// Updates still sent after the camera stops, so that losing one does not leave the walls drifting.
+const int cCameraStopRepeats = 5;
+// Joystick axes, unreliable: keyframes holding every axis and deltas against the last keyframe (see JoystickChannel
+// on the walls).
+const message_id_t cJoystickMessageID = 36;
+// Reply of a wall to a joystick probe frame: sequence number, client time in ms and time spent on the wall in us.
+const message_id_t cJoystickEchoMessageID = 37;
+// Content id of the joystick delta frames. Keyframes have none, so that a queued keyframe is never replaced.
+const unsigned cJoystickContentID = 2;
+// Most joystick axes sent.
+const size_t cMaxJoystickAxes = 8;
+// Frames between two joystick keyframes, so that a lost keyframe only stalls the deltas for a tenth of a second.
+const int cJoystickKeyInterval = 25;
+// Cutoff of the low-pass filter of the joystick axes, in Hz.
+const double cJoystickCutoff = 30.0;
+// Interval of the joystick frames repeated while the stick is held still, and after it returns to rest.
+const double cJoystickKeepAlive = 0.05;
+// Frames repeated once the stick is back at rest.
+const int cJoystickStopRepeats = 3;
+// Quantized deflection below which an axis is at rest, the deadband of the walls.
+const int cJoystickRest = 15;
+// Deflection below which an axis reads 0 on the walls, the rest being rescaled to [0, 1] (JoystickChannel::DEADBAND).
+const float cJoystickDeadband = 0.12f;
+// Interval of the joystick latency probes.
+const double cJoystickProbeInterval = 0.25;
+// Time constant of the smoothing of the joystick axes on the walls, in ms (JoystickChannel::SMOOTHING).
+const double cWallSmoothingMs = 20.0;
+// Interval of the joystick statistics of "joystats".
+const double cJoystickStatsInterval = 5.0;
+// Objects created or updated at once, reliable and ordered with the commands (see SceneBatch on the walls).
+const message_id_t cSceneBatchMessageID = 38;
+// Most objects of a scene batch.
+const int cMaxBatchObjects = 65536;
+// How long a raw key press keeps its axis deflected, a bit more than the key repeat period.
+const double cKeyHoldSeconds = 0.1;
+// Port of the loopback stand-in wall of -benchcamera.
+const unsigned short cBenchPort = 31999;
+
+// Longest wait of the event loop, so that timers stay accurate.
+const int cMaxPollMs = 4;
+// Default rate of the camera updates while the camera moves.
+const double cDefaultCameraRate = 60.0;
+// Default sample rate of the joystick.
+const double cDefaultJoystickRate = 250.0;
+// First port of the walls, wall n listens on cFirstPort + n - 1.
+const unsigned short cFirstPort = 32000;
+// Most walls.
+const int cMaxWalls = 5;
+// Sustained rate and burst of the commands, camera steps included. The walls never drop a command, since a wall that
+// lost one the others kept would stay out of step: commands are limited here, where dropping one drops it for every
+// wall.
+const double cCommandRate = 240.0;
+const double cCommandBurst = 60.0;
 
 BottomMemoryAllocator bma;
-char com[100];
-std::string mess;
 
-int main(int argc, char **argv)
+// Variable-length unsigned integer of the Urho3D serialization: 7 bits per byte, the fourth byte holding 8 bits.
+static void WriteVLE(std::string &dest, unsigned value)
+{
+  for (int i = 0; i < 3 && value >= 0x80; ++i)
+  {
+    dest += (char)(value | 0x80);
+    value >>= 7;
+  }
+  dest += (char)value;
+}
+
+// Return whether a camera sequence number is newer than another, wrapping around.
+static bool IsNewerSequence(unsigned sequence, unsigned last)
+{
+  return (int)(sequence - last) > 0;
+}
+
+// Return the value below which the given fraction of the values lie.
+static double Percentile(std::vector<double> values, double fraction)
+{
+  if (values.empty())
+    return 0.0;
+  std::sort(values.begin(), values.end());
+  return values[std::min(values.size() - 1, (size_t)(fraction * values.size()))];
+}
+
+// Command at a time of a timeline script.
+struct TimelineEntry
+{
+  double time;
+  std::string command;
+};
+
+// Event-loop client: reads the keyboard, the joystick, a timeline script and a synthetic load generator without ever
+// blocking, and sends the resulting commands to every wall.
+class SolarClient
+{
+public:
+  SolarClient();
+  ~SolarClient();
+
+  // Connect to the walls, wall i on port cFirstPort + i.
+  void Connect(const std::vector<std::string> &addresses);
+  // Introduce the client to the walls: a name, the same on every wall, a role and optionally a priority.
+  void SayHello(const std::string &name, const std::string &role, int priority);
+  // Drop the given fraction of the sent packets, to try the show on a lossy network.
+  void SetPacketLoss(float loss);
+  // Read keys one by one instead of lines. ':' opens a command line, 'X' quits.
+  bool EnableRawKeyboard();
+  // Read a Linux joystick device, sampled and sent at the given rate while the stick moves.
+  bool OpenJoystick(const std::string &device, double rate);
+  // Load a timeline script: "<seconds> <command>" lines, '#' starts a comment. Return false if it could not be read.
+  bool LoadTimeline(const std::string &fileName, bool loop);
+  // Send the load commands cyclically at the given rate, 0 stops.
+  void SetLoad(double rate, const std::vector<std::string> &commands);
+  // Run until 'X'.
+  void Run();
+
+private:
+  // Seconds since the client started.
+  double Now() const;
+  // Handle a command typed by the operator.
+  void HandleCommand(const std::string &command);
+  // Send a command to every wall, or only to the given wall. Return false if the command was dropped by the rate limit.
+  bool Broadcast(const std::string &command, bool verbose, int wall = -1);
+  // Read what is available on the standard input.
+  void ReadInput();
+  // Read the pending joystick events.
+  void ReadJoystick();
+  // Send the commands that are due: timeline, load and camera updates.
+  void RunTimers(double now);
+  // Deflect the camera axis of a raw movement key. Return false if the key does not move the camera.
+  bool PressCameraKey(char key, double now);
+  // Return the camera velocity from the held keys.
+  CameraVelocity GetCameraVelocity(double now) const;
+  // Return the camera velocity of the joystick as the walls read it from the sent axes.
+  CameraVelocity GetJoystickVelocity() const;
+  // Send the camera velocity and motion on the unreliable channel, flagged while the joystick is deflected.
+  void SendCamera(const CameraVelocity &velocity);
+  // Filter and quantize the joystick axes and send a frame if they changed, or to keep the stream alive.
+  void SampleJoystick(double now);
+  // Print the joystick stream statistics and start over.
+  void PrintJoystickStats(double now);
+  // Create or move a square grid of spheres named <prefix><n> with one scene batch message.
+  void SendGrid(const std::string &prefix, int count);
+  // Receive the replies of the walls.
+  void ReceiveReplies();
+  // Start collecting the telemetry of every wall.
+  void StartTelemetry();
+  // Print the collected telemetry side by side.
+  void PrintTelemetry();
+  // Bring a restarted wall (1-based) back into the show from the snapshot of another wall.
+  void StartResync(int target);
+  // Ask the next candidate wall for its snapshot.
+  void RequestSnapshot();
+  // Return the time until the next timer, in milliseconds, at most cMaxPollMs.
+  int GetPollTimeout(double now) const;
+
+  Network network;
+  std::vector<Ptr(MessageConnection)> walls;
+  tick_t startTick;
+  bool running;
+
+  // Keyboard: stdin is left out of the poll once it reaches its end, since it would then be readable forever.
+  bool stdinOpen;
+  bool rawKeyboard;
+  bool rawLineActive;
+  struct termios savedTermios;
+  std::string inputLine;
+
+  // Joystick: axis values.
+  int joystickFd;
+  std::vector<int> axes;
+
+  // Joystick stream: sample rate and time of the next sample, filtered axes, axes of the last keyframe and of the last
+  // frame sent, sequence numbers, repeats left after returning to rest, whether the stick is deflected, time of the last
+  // frame and of the next probe.
+  double joystickRate;
+  double nextJoystickTime;
+  double lastJoystickSample;
+  std::vector<float> filteredAxes;
+  std::vector<int> keyAxes;
+  std::vector<int> sentAxes;
+  unsigned short joystickSequence;
+  unsigned short keySequence;
+  int framesSinceKey;
+  int joystickStopRepeats;
+  bool joystickDeflected;
+  double lastJoystickSend;
+  double nextProbeTime;
+
+  // Joystick statistics of "joystats": frames and payload bytes sent, probe round trips and input to display
+  // estimates in ms.
+  bool joystickStats;
+  double joystickStatsStart;
+  unsigned joystickFrames;
+  unsigned joystickKeyframes;
+  size_t joystickBytes;
+  std::vector<double> probeRoundTrips;
+  std::vector<double> probeLatencies;
+
+  // Camera channel: update rate, time of the next update, release time of the raw keys, last sequence number sent,
+  // motion segments of the keys and the joystick.
+  double cameraRate;
+  double nextCameraTime;
+  std::map<char, double> keyRelease;
+  int cameraStopRepeats;
+  unsigned cameraSequence;
+  CameraOdometer cameraOdometer;
+
+  // Timeline.
+  std::vector<TimelineEntry> timeline;
+  size_t nextEntry;
+  double timelineStart;
+  bool timelineLoop;
+
+  // Rate limit of the commands: tokens left, time of the last refill, commands dropped since the last load report.
+  double commandTokens;
+  double commandTime;
+  unsigned commandsDropped;
+
+  // Synthetic load.
+  double loadRate;
+  std::vector<std::string> loadCommands;
+  size_t nextLoadCommand;
+  double nextLoadTime;
+  double loadReportTime;
+  unsigned loadSent;
+
+  // Telemetry being collected.
+  bool telemetryActive;
+  double telemetryStart;
+  std::vector<std::string> telemetryKeys;
+  std::vector<std::map<std::string, double> > telemetryValues;
+  std::vector<bool> telemetryReceived;
+
+  // Resync in progress: target wall and wall asked for its snapshot, 0-based.
+  bool resyncActive;
+  int resyncTarget;
+  int resyncSource;
+  double resyncStart;
+};
+
+SolarClient::SolarClient() :
+  startTick(Clock::Tick()),
+  running(true),
+  stdinOpen(true),
+  rawKeyboard(false),
+  rawLineActive(false),
+  joystickFd(-1),
+  joystickRate(cDefaultJoystickRate),
+  nextJoystickTime(0.0),
+  lastJoystickSample(0.0),
+  joystickSequence(0),
+  keySequence(0),
+  framesSinceKey(0),
+  joystickStopRepeats(0),
+  joystickDeflected(false),
+  lastJoystickSend(0.0),
+  nextProbeTime(0.0),
+  joystickStats(false),
+  joystickStatsStart(0.0),
+  joystickFrames(0),
+  joystickKeyframes(0),
+  joystickBytes(0),
+  cameraRate(cDefaultCameraRate),
+  nextCameraTime(0.0),
+  cameraStopRepeats(0),
+  cameraSequence(0),
+  nextEntry(0),
+  timelineStart(0.0),
+  timelineLoop(false),
+  commandTokens(cCommandBurst),
+  commandTime(0.0),
+  commandsDropped(0),
+  loadRate(0.0),
+  nextLoadCommand(0),
+  nextLoadTime(0.0),
+  loadReportTime(0.0),
+  loadSent(0),
+  telemetryActive(false),
+  telemetryStart(0.0),
+  resyncActive(false),
+  resyncTarget(0),
+  resyncSource(0),
+  resyncStart(0.0)
+{
+}
+
+SolarClient::~SolarClient()
 {
-    if (argc < 2)
+  if (rawKeyboard)
+    tcsetattr(STDIN_FILENO, TCSANOW, &savedTermios);
+  if (joystickFd >= 0)
+    close(joystickFd);
+}
+
+double SolarClient::Now() const
+{
+  return Clock::TimespanToMillisecondsD(startTick, Clock::Tick()) / 1000.0;
+}
+
+void SolarClient::Connect(const std::vector<std::string> &addresses)
+{
+  for (size_t i = 0; i < addresses.size() && (int)i < cMaxWalls; ++i)
+    walls.push_back(network.Connect(addresses[i].c_str(), cFirstPort + i, SocketOverUDP, NULL));
+}
+
+void SolarClient::SayHello(const std::string &name, const std::string &role, int priority)
+{
+  std::string hello = "hello " + name + " " + role;
+  if (priority >= 0)
+    hello += " " + std::to_string(priority);
+  Broadcast(hello, true);
+}
+
+void SolarClient::SetPacketLoss(float loss)
+{
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    if (!walls[i])
+      continue;
+    NetworkSimulator &simulator = walls[i]->NetworkSendSimulator();
+    simulator.enabled = loss > 0.0f;
+    simulator.packetLossRate = loss;
+  }
+  printf("simulated packet loss: %.1f %%\n", loss * 100.0f);
+}
+
+bool SolarClient::EnableRawKeyboard()
+{
+  if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &savedTermios) != 0)
+    return false;
+
+  struct termios raw = savedTermios;
+  raw.c_lflag &= ~(ICANON | ECHO);
+  raw.c_cc[VMIN] = 0;
+  raw.c_cc[VTIME] = 0;
+  if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0)
+    return false;
+
+  rawKeyboard = true;
+  printf("raw keyboard: keys are sent as they are pressed, ':' opens a command line, 'X' quits\n");
+  return true;
+}
+
+bool SolarClient::OpenJoystick(const std::string &device, double rate)
+{
+#ifdef __linux__
+  joystickFd = open(device.c_str(), O_RDONLY | O_NONBLOCK);
+  if (joystickFd < 0)
+  {
+    printf("could not open joystick %s\n", device.c_str());
+    return false;
+  }
+  joystickRate = rate > 0.0 ? rate : cDefaultJoystickRate;
+  printf("joystick %s: sampled at %.0f Hz, filtered at %.0f Hz\n", device.c_str(), joystickRate, cJoystickCutoff);
+  return true;
+#else
+  printf("joystick input needs Linux\n");
+  return false;
+#endif
+}
+
+bool SolarClient::LoadTimeline(const std::string &fileName, bool loop)
+{
+  std::ifstream file(fileName.c_str());
+  if (!file)
+  {
+    printf("could not read timeline %s\n", fileName.c_str());
+    return false;
+  }
+
+  std::vector<TimelineEntry> entries;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    size_t first = line.find_first_not_of(" \t");
+    if (first == std::string::npos || line[first] == '#')
+      continue;
+
+    std::istringstream fields(line);
+    TimelineEntry entry;
+    if (!(fields >> entry.time))
     {
-          std::cout << "Usage: " << argv[0] << " server-ip-1 [server-ip-2 ...]" << std::endl;
-          return 0;
+      printf("timeline %s: bad line [%s]\n", fileName.c_str(), line.c_str());
+      continue;
     }
+    std::getline(fields >> std::ws, entry.command);
+    if (!entry.command.empty())
+      entries.push_back(entry);
+  }
 
-  kNet::SetLogChannels(LogUser | LogInfo | LogError);
-  EnableMemoryLeakLoggingAtExit();
+  // Stable, so that commands at the same time keep the order of the script
+  std::stable_sort(entries.begin(), entries.end(),
+    [](const TimelineEntry &a, const TimelineEntry &b) { return a.time < b.time; });
+
+  timeline = entries;
+  nextEntry = 0;
+  timelineStart = Now();
+  timelineLoop = loop;
+  printf("timeline %s: %d commands over %.1f s%s\n", fileName.c_str(), (int)timeline.size(),
+    timeline.empty() ? 0.0 : timeline.back().time, loop ? ", looped" : "");
+  return true;
+}
+
+void SolarClient::SetLoad(double rate, const std::vector<std::string> &commands)
+{
+  loadRate = rate;
+  if (!commands.empty())
+    loadCommands = commands;
+  nextLoadTime = Now();
+  loadReportTime = nextLoadTime + 1.0;
+  loadSent = 0;
+
+  if (loadRate > 0.0)
+    printf("load: %.0f commands/s cycling over %d commands\n", loadRate, (int)loadCommands.size());
+  else
+    printf("load: stopped\n");
+}
+
+bool SolarClient::Broadcast(const std::string &command, bool verbose, int wall)
+{
+  double now = Now();
+  commandTokens = std::min(commandTokens + (now - commandTime) * cCommandRate, cCommandBurst);
+  commandTime = now;
+  if (commandTokens < 1.0)
+  {
+    ++commandsDropped;
+    if (verbose)
+      printf("message dropped, over %.0f commands/s: [%s]\n", cCommandRate, command.c_str());
+    return false;
+  }
+  commandTokens -= 1.0;
+
+  // the text, then the time after a null so that the walls read the text as a string
+  std::string data = command + '\0';
+  unsigned time = SharedTime();
+  data.append((const char *)&time, 4);
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    if (!walls[i] || (wall >= 0 && (int)i != wall))
+      continue;
+    walls[i]->SendMessage(cHelloMessageID, true, true, 100, 0, data.data(), data.size());
+    if (verbose)
+      printf("message sent: [%s]\n", command.c_str());
+  }
+  return true;
+}
+
+void SolarClient::HandleCommand(const std::string &command)
+{
+  if (command.empty())
+    return;
+
+  if (command[0] == 'X')
+    running = false;
+
+  // client commands, not broadcast
+  else if (!command.compare(0, 7, "resync "))
+    StartResync(atoi(command.c_str() + 7));
+  else if (!command.compare(0, 5, "play "))
+    LoadTimeline(command.substr(5), false);
+  else if (!command.compare(0, 5, "loop "))
+    LoadTimeline(command.substr(5), true);
+  else if (!command.compare(0, 5, "load "))
+  {
+    std::istringstream fields(command.substr(5));
+    double rate = 0.0;
+    fields >> rate;
+    std::vector<std::string> commands;
+    std::string word;
+    while (fields >> word)
+      commands.push_back(word);
+    SetLoad(rate, commands);
+  }
+  else if (!command.compare(0, 5, "grid "))
+  {
+    std::istringstream fields(command.substr(5));
+    std::string prefix;
+    int count = 0;
+    fields >> prefix >> count;
+    SendGrid(prefix, count);
+  }
+  else if (command == "joystats")
+  {
+    joystickStats = !joystickStats;
+    PrintJoystickStats(Now());
+    if (!joystickStats)
+      printf("joystats: stopped\n");
+  }
+  else if (command == "stop")
+  {
+    timeline.clear();
+    if (loadRate > 0.0)
+      SetLoad(0.0, std::vector<std::string>());
+  }
+
+  else
+  {
+    Broadcast(command, true);
+    if (command == "telemetry")
+      StartTelemetry();
+  }
+}
+
+void SolarClient::ReadInput()
+{
+  char buffer[256];
+  ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer));
+  if (count == 0 && !rawKeyboard)
+  {
+    // end of the input, a timeline or a load may still be running (see Run)
+    stdinOpen = false;
+    return;
+  }
+
+  for (ssize_t i = 0; i < count; ++i)
+  {
+    char c = buffer[i];
 
-    Network network;
-  // const unsigned short cServerPort = 32000;
-
-  Ptr(MessageConnection) connection1;
-  Ptr(MessageConnection) connection2;
-  Ptr(MessageConnection) connection3;
-  Ptr(MessageConnection) connection4;
-  Ptr(MessageConnection) connection5;
-
-  connection1 = network.Connect(argv[1], 32000, SocketOverUDP,  NULL);
-  if (argc > 2) {
-    connection2 = network.Connect(argv[2], 32001, SocketOverUDP,  NULL);
-    if (argc > 3) {
-      connection3 = network.Connect(argv[3], 32002, SocketOverUDP,  NULL);
-      if (argc > 4) {
-        connection4 = network.Connect(argv[4], 32003, SocketOverUDP,  NULL);
-        if (argc > 5) {
-          connection5 = network.Connect(argv[5], 32004, SocketOverUDP,  NULL);
+    if (!rawKeyboard || rawLineActive)
+    {
+      if (c == '\n')
+      {
+        std::string line = inputLine;
+        inputLine.clear();
+        if (rawLineActive)
+        {
+          rawLineActive = false;
+          printf("\n");
         }
+        HandleCommand(line);
       }
+      else if (rawLineActive && (c == 127 || c == '\b'))
+      {
+        if (!inputLine.empty())
+        {
+          inputLine.erase(inputLine.size() - 1);
+          printf("\b \b");
+        }
+      }
+      else if (c != '\r')
+      {
+        inputLine += c;
+        if (rawLineActive)
+          putchar(c);
+      }
+      fflush(stdout);
+      continue;
+    }
+
+    // raw keys: movement keys deflect the camera while they repeat, the other keys are commands
+    if (PressCameraKey(c, Now()))
+      continue;
+    if (c == ':')
+    {
+      rawLineActive = true;
+      printf(":");
+      fflush(stdout);
     }
+    else if (c == 'X')
+      running = false;
+    else if (c > ' ' && c < 127)
+      Broadcast(std::string(1, c), false);
   }
+}
 
+void SolarClient::ReadJoystick()
+{
+#ifdef __linux__
+  struct js_event event;
+  while (read(joystickFd, &event, sizeof(event)) == sizeof(event))
+  {
+    int type = event.type & ~JS_EVENT_INIT;
+    if (type == JS_EVENT_AXIS)
+    {
+      if (event.number >= axes.size())
+        axes.resize(event.number + 1, 0);
+      axes[event.number] = event.value;
+    }
+    else if (type == JS_EVENT_BUTTON && event.value && !(event.type & JS_EVENT_INIT))
+    {
+      // buttons: camera presets, then pause, sky and labels
+      static const char *buttons[] = { "S", "t", "f", "r", "j", "u", "p", "b", "n" };
+      if (event.number < sizeof(buttons) / sizeof(buttons[0]))
+        Broadcast(buttons[event.number], true);
+    }
+  }
+#endif
+}
 
-  std::cin.getline(com,sizeof(com));
-  while (com[0]!='X')
+void SolarClient::RunTimers(double now)
+{
+  // timeline
+  while (nextEntry < timeline.size() && now - timelineStart >= timeline[nextEntry].time)
   {
-          if (connection1)
-          {
-                  connection1->SendMessage(cHelloMessageID, true, true, 100, 0, com, strlen(com));
-                  printf("message sent: [%s]\n",com);
+    printf("[%7.2f] ", timeline[nextEntry].time);
+    HandleCommand(timeline[nextEntry++].command);
+  }
+  if (!timeline.empty() && nextEntry == timeline.size())
+  {
+    if (timelineLoop)
+    {
+      nextEntry = 0;
+      timelineStart = now;
+    }
+    else
+      timeline.clear();
+  }
 
-          }
-          if (connection2)
-          {
-                  connection2->SendMessage(cHelloMessageID, true, true, 100, 0, com, strlen(com));
-                  printf("message sent: [%s]\n",com);
+  // synthetic load, catching up after a late wake-up so that the rate holds on average
+  if (loadRate > 0.0 && !loadCommands.empty())
+  {
+    while (now >= nextLoadTime)
+    {
+      if (Broadcast(loadCommands[nextLoadCommand], false))
+        ++loadSent;
+      nextLoadCommand = (nextLoadCommand + 1) % loadCommands.size();
+      nextLoadTime += 1.0 / loadRate;
+    }
+    if (now >= loadReportTime)
+    {
+      printf("load: %u commands sent in the last second, %u dropped over the rate limit\n", loadSent, commandsDropped);
+      loadSent = 0;
+      commandsDropped = 0;
+      loadReportTime = now + 1.0;
+    }
+  }
 
-          }
-          if (connection3)
-          {
-                  connection3->SendMessage(cHelloMessageID, true, true, 100, 0, com, strlen(com));
-                  printf("message sent: [%s]\n",com);
+  // camera channel: the current velocity and motion at a fixed rate while the camera moves, and a few times once it
+  // stops. While the joystick is deflected within the deadband of the walls, updates at the joystick keep-alive rate
+  // hold the camera. The motion includes the joystick, the velocity only the keys: the walls extrapolate the joystick
+  // from its own stream
+  if (now >= nextCameraTime)
+  {
+    CameraVelocity velocity = GetCameraVelocity(now);
+    CameraVelocity motion = GetJoystickVelocity();
+    for (int i = 0; i < 3; ++i)
+      motion.move[i] += velocity.move[i];
+    motion.yaw += velocity.yaw;
+    cameraOdometer.Update(now, motion);
+    bool moving = motion.move[0] || motion.move[1] || motion.move[2] || motion.yaw;
+    if (moving || joystickDeflected)
+      cameraStopRepeats = cCameraStopRepeats;
+    if (moving || joystickDeflected || cameraStopRepeats-- > 0)
+      SendCamera(velocity);
+    nextCameraTime = now + (moving || !joystickDeflected ? 1.0 / cameraRate : cJoystickKeepAlive);
+  }
 
-          }
-          if (connection4)
-          {
-                  connection4->SendMessage(cHelloMessageID, true, true, 100, 0, com, strlen(com));
-                  printf("message sent: [%s]\n",com);
+  if (joystickFd >= 0 && now >= nextJoystickTime)
+  {
+    SampleJoystick(now);
+    nextJoystickTime = now + 1.0 / joystickRate;
+  }
+  if (joystickStats && now - joystickStatsStart >= cJoystickStatsInterval)
+    PrintJoystickStats(now);
 
-          }
-          if (connection5)
-          {
-                  connection5->SendMessage(cHelloMessageID, true, true, 100, 0, com, strlen(com));
-                  printf("message sent: [%s]\n",com);
+  if (telemetryActive && now - telemetryStart > cTelemetryTimeoutMs / 1000.0)
+    PrintTelemetry();
+
+  if (resyncActive && now - resyncStart > cSnapshotTimeoutMs / 1000.0)
+  {
+    printf("resync: wall %d did not answer\n", resyncSource + 1);
+    ++resyncSource;
+    RequestSnapshot();
+  }
+}
+
+bool SolarClient::PressCameraKey(char key, double now)
+{
+  if (!strchr("zqsdolkm", key))
+    return false;
+  keyRelease[key] = now + cKeyHoldSeconds;
+  // send at once rather than at the next update
+  nextCameraTime = now;
+  return true;
+}
+
+CameraVelocity SolarClient::GetCameraVelocity(double now) const
+{
+  CameraVelocity velocity = { { 0.0f, 0.0f, 0.0f }, 0.0f };
+
+  // held raw keys, the joystick has its own stream, with the same meaning as the commands
+  static const char keys[] = "dqolzsmk";
+  for (int k = 0; k < 8; ++k)
+  {
+    std::map<char, double>::const_iterator release = keyRelease.find(keys[k]);
+    if (release == keyRelease.end() || now >= release->second)
+      continue;
+    float sign = k % 2 ? -1.0f : 1.0f;
+    if (k < 6)
+      velocity.move[k / 2] = sign;
+    else
+      velocity.yaw = sign;
+  }
+  return velocity;
+}
+
+CameraVelocity SolarClient::GetJoystickVelocity() const
+{
+  // stick left to move and slide, stick right to turn and climb, past the deadband of the walls
+  float axes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  for (size_t i = 0; i < 4 && i < sentAxes.size(); ++i)
+  {
+    float axis = sentAxes[i] / 127.0f;
+    float magnitude = fabsf(axis);
+    if (magnitude >= cJoystickDeadband)
+      axes[i] = copysignf((magnitude - cJoystickDeadband) / (1.0f - cJoystickDeadband), axis);
+  }
+  CameraVelocity velocity = { { axes[0], -axes[3], -axes[1] }, axes[2] };
+  return velocity;
+}
+
+void SolarClient::SendCamera(const CameraVelocity &velocity)
+{
+  char data[cCameraMessageSize];
+  size_t size = WriteCameraMessage(data, ++cameraSequence, velocity, SharedTime(),
+    joystickDeflected ? cCameraJoystickFlag : 0, cameraOdometer.GetSegment(), cameraOdometer.GetPrevious(),
+    cameraOdometer.GetKeyframe());
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    if (walls[i])
+      walls[i]->SendMessage(cCameraMessageID, false, false, 100, cCameraContentID, data, size);
+  }
+}
+
+// The axes go through a one-pole low-pass filter and are quantized to a signed byte, so that sensor noise neither
+// reaches the walls nor keeps the stream busy. A frame is sent when a quantized axis changes, every cJoystickKeepAlive
+// while the stick is held deflected so that the walls keep the camera, and a few times after it returns to rest.
+void SolarClient::SampleJoystick(double now)
+{
+  double elapsed = lastJoystickSample > 0.0 ? now - lastJoystickSample : 1.0 / joystickRate;
+  lastJoystickSample = now;
+  float fraction = (float)(1.0 - exp(-2.0 * M_PI * cJoystickCutoff * elapsed));
+
+  size_t numAxes = std::min(axes.size(), cMaxJoystickAxes);
+  if (!numAxes)
+    return;
+  filteredAxes.resize(numAxes, 0.0f);
+
+  std::vector<int> values(numAxes);
+  bool changed = sentAxes.size() != numAxes;
+  bool deflected = false;
+  for (size_t i = 0; i < numAxes; ++i)
+  {
+    filteredAxes[i] += (axes[i] / 32767.0f - filteredAxes[i]) * fraction;
+    values[i] = std::max(-127, std::min(127, (int)lround(filteredAxes[i] * 127.0f)));
+    changed = changed || values[i] != sentAxes[i];
+    deflected = deflected || abs(values[i]) >= cJoystickRest;
+  }
+
+  // the camera channel claims the camera as soon as the stick leaves its rest
+  if (deflected && !joystickDeflected)
+    nextCameraTime = now;
+  joystickDeflected = deflected;
+  if (deflected)
+    joystickStopRepeats = cJoystickStopRepeats;
+  bool keepAlive = (deflected || joystickStopRepeats > 0) && now - lastJoystickSend >= cJoystickKeepAlive;
+  if (!changed && !keepAlive)
+    return;
+  if (!deflected && !changed)
+    --joystickStopRepeats;
+
+  // a delta refers to the last keyframe: a keyframe is due when the deltas no longer fit in the frame
+  unsigned short sequence = ++joystickSequence;
+  bool keyframe = framesSinceKey >= cJoystickKeyInterval || keyAxes.size() != numAxes ||
+    (unsigned short)(sequence - keySequence) > 255;
+  for (size_t i = 0; i < numAxes && !keyframe; ++i)
+    keyframe = abs(values[i] - keyAxes[i]) > 127;
+  bool probe = now >= nextProbeTime;
+
+  char data[8 + cMaxJoystickAxes];
+  size_t size = 0;
+  data[size++] = (char)(sequence & 0xff);
+  data[size++] = (char)(sequence >> 8);
+  data[size++] = (char)(numAxes | (keyframe ? 0x10 : 0) | (probe ? 0x20 : 0));
+  if (probe)
+  {
+    unsigned short time = (unsigned short)(now * 1000.0);
+    data[size++] = (char)(time & 0xff);
+    data[size++] = (char)(time >> 8);
+    nextProbeTime = now + cJoystickProbeInterval;
+  }
+  if (keyframe)
+  {
+    for (size_t i = 0; i < numAxes; ++i)
+      data[size++] = (char)values[i];
+    keyAxes = values;
+    keySequence = sequence;
+    framesSinceKey = 0;
+    ++joystickKeyframes;
+  }
+  else
+  {
+    data[size++] = (char)(unsigned char)(sequence - keySequence);
+    size_t mask = size++;
+    data[mask] = 0;
+    for (size_t i = 0; i < numAxes; ++i)
+    {
+      if (values[i] == keyAxes[i])
+        continue;
+      data[mask] |= (char)(1 << i);
+      data[size++] = (char)(values[i] - keyAxes[i]);
+    }
+  }
+  ++framesSinceKey;
+
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    if (walls[i])
+      walls[i]->SendMessage(cJoystickMessageID, false, false, 100, keyframe ? 0 : cJoystickContentID, data, size);
+  }
+  sentAxes = values;
+  lastJoystickSend = now;
+  ++joystickFrames;
+  joystickBytes += size;
+}
+
+// The walls answer a probe once the frame that applied it is presented. Input to display is estimated as the one way
+// trip, half of the round trip without the time on the wall, plus the time on the wall and the delays of the client
+// filter, of the sampling and of the smoothing on the walls. Scan-out and the display itself are not measured.
+void SolarClient::PrintJoystickStats(double now)
+{
+  double elapsed = now - joystickStatsStart;
+  if (joystickFrames && elapsed > 0.0)
+  {
+    printf("joystats: %.0f frames/s, %.0f payload bytes/s, %.1f keyframes/s, %d probe echoes\n",
+      joystickFrames / elapsed, joystickBytes / elapsed, joystickKeyframes / elapsed, (int)probeLatencies.size());
+    if (!probeLatencies.empty())
+      printf("joystats: round trip p50 %.1f ms, input to display p50 %.1f p95 %.1f p99 %.1f max %.1f ms\n",
+        Percentile(probeRoundTrips, 0.5), Percentile(probeLatencies, 0.5), Percentile(probeLatencies, 0.95),
+        Percentile(probeLatencies, 0.99), Percentile(probeLatencies, 1.0));
+  }
+  else if (joystickStats)
+    printf("joystats: no joystick frame sent\n");
+
+  joystickStatsStart = now;
+  joystickFrames = 0;
+  joystickKeyframes = 0;
+  joystickBytes = 0;
+  probeRoundTrips.clear();
+  probeLatencies.clear();
+}
+
+void SolarClient::SendGrid(const std::string &prefix, int count)
+{
+  if (prefix.empty() || count < 1 || count > cMaxBatchObjects)
+  {
+    printf("grid: usage grid <prefix> <count>, at most %d objects\n", cMaxBatchObjects);
+    return;
+  }
+
+  // one model and one material, referred to by index
+  std::string data = prefix + '\0';
+  WriteVLE(data, 1);
+  data += std::string("Sphere.mdl") + '\0';
+  WriteVLE(data, 1);
+  data += std::string("earthmap.xml") + '\0';
+
+  WriteVLE(data, count);
+  int side = (int)ceil(sqrt((double)count));
+  for (int i = 0; i < count; ++i)
+  {
+    // position, rotation (w, x, y, z) and scale
+    float transform[10] = { 2.0f * (i % side - side / 2), 0.0f, 2.0f * (i / side - side / 2), 1.0f, 0.0f, 0.0f, 0.0f,
+      1.0f, 1.0f, 1.0f };
+    WriteVLE(data, i);
+    data.append((const char *)transform, sizeof(transform));
+    WriteVLE(data, 0);
+    WriteVLE(data, 0);
+  }
+
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    if (walls[i])
+      walls[i]->SendMessage(cSceneBatchMessageID, true, true, 100, 0, data.data(), data.size());
+  }
+  printf("grid: %d objects %s0 to %s%d sent in %d bytes\n", count, prefix.c_str(), prefix.c_str(), count - 1,
+    (int)data.size());
+}
+
+int SolarClient::GetPollTimeout(double now) const
+{
+  double next = now + cMaxPollMs / 1000.0;
+  if (nextEntry < timeline.size())
+    next = std::min(next, timelineStart + timeline[nextEntry].time);
+  if (loadRate > 0.0)
+    next = std::min(next, nextLoadTime);
+  if (cameraStopRepeats > 0 || !keyRelease.empty())
+    next = std::min(next, nextCameraTime);
+  if (joystickFd >= 0)
+    next = std::min(next, nextJoystickTime);
+  return std::max(0, (int)((next - now) * 1000.0));
+}
+
+void SolarClient::ReceiveReplies()
+{
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    if (!walls[i])
+      continue;
+
+    NetworkMessage *msg;
+    while ((msg = walls[i]->ReceiveMessage(0)) != 0)
+    {
+      if (msg->id == cTelemetryMessageID && telemetryActive && !telemetryReceived[i])
+      {
+        std::istringstream lines(std::string(msg->data, msg->dataSize));
+        std::string key;
+        double value;
+        while (lines >> key >> value)
+        {
+          if (std::find(telemetryKeys.begin(), telemetryKeys.end(), key) == telemetryKeys.end())
+            telemetryKeys.push_back(key);
+          telemetryValues[i][key] = value;
+        }
+        telemetryReceived[i] = true;
+        if (std::find(telemetryReceived.begin(), telemetryReceived.end(), false) == telemetryReceived.end())
+          PrintTelemetry();
+      }
+      else if (msg->id == cJoystickEchoMessageID && joystickStats && msg->dataSize >= 8)
+      {
+        unsigned short sent;
+        unsigned wallMicroseconds;
+        memcpy(&sent, msg->data + 2, 2);
+        memcpy(&wallMicroseconds, msg->data + 4, 4);
+        double roundTrip = (unsigned short)((unsigned short)(Now() * 1000.0) - sent);
+        double wall = wallMicroseconds / 1000.0;
+        double filter = 1000.0 / (2.0 * M_PI * cJoystickCutoff) + 500.0 / joystickRate;
+        probeRoundTrips.push_back(roundTrip);
+        probeLatencies.push_back(std::max(0.0, roundTrip - wall) / 2.0 + wall + filter + cWallSmoothingMs);
+      }
+      else if (msg->id == cSnapshotMessageID && resyncActive && (int)i == resyncSource)
+      {
+        walls[resyncTarget]->SendMessage(cSnapshotMessageID, true, true, 100, 0, msg->data, msg->dataSize);
+        printf("resync: snapshot of wall %d (%d bytes) sent to wall %d\n", resyncSource + 1, (int)msg->dataSize,
+          resyncTarget + 1);
+        resyncActive = false;
+      }
+      walls[i]->FreeMessage(msg);
+    }
+  }
+}
+
+void SolarClient::StartTelemetry()
+{
+  telemetryActive = true;
+  telemetryStart = Now();
+  telemetryKeys.clear();
+  telemetryValues.assign(walls.size(), std::map<std::string, double>());
+  telemetryReceived.assign(walls.size(), false);
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    if (!walls[i])
+      telemetryReceived[i] = true;
+  }
+}
+
+// Counts and memory are summed over the walls, frame times keep the slowest wall since a show is only as smooth as
+// its worst screen, and ratios keep the highest.
+void SolarClient::PrintTelemetry()
+{
+  int numWalls = (int)walls.size();
+  int numReceived = 0;
+
+  printf("%-28s", "telemetry");
+  for (int i = 0; i < numWalls; ++i)
+  {
+    bool answered = walls[i] && telemetryReceived[i];
+    numReceived += answered ? 1 : 0;
+    printf(" %14s", answered ? ("wall " + std::to_string(i + 1)).c_str() : "-");
+  }
+  printf(" %14s\n", "total");
+
+  for (size_t k = 0; k < telemetryKeys.size(); ++k)
+  {
+    const std::string &key = telemetryKeys[k];
+    bool isFrameTime = key.compare(0, 6, "frame.") == 0 && key != "frame.count";
+    bool isRatio = key.size() > 6 && key.compare(key.size() - 6, 6, ".ratio") == 0;
+    double total = 0.0;
+    printf("%-28s", key.c_str());
+    for (int i = 0; i < numWalls; ++i)
+    {
+      std::map<std::string, double>::const_iterator v = telemetryValues[i].find(key);
+      if (v == telemetryValues[i].end())
+      {
+        printf(" %14s", "-");
+        continue;
+      }
+      printf(" %14.3f", v->second);
+      total = isFrameTime || isRatio ? std::max(total, v->second) : total + v->second;
+    }
+    printf(" %14.3f\n", total);
+  }
+
+  if (numReceived < numWalls)
+    printf("telemetry: %d of %d walls answered\n", numReceived, numWalls);
+  telemetryActive = false;
+}
+
+void SolarClient::StartResync(int target)
+{
+  if (target < 1 || target > (int)walls.size() || !walls[target - 1])
+  {
+    printf("resync: no wall %d\n", target);
+    return;
+  }
+
+  resyncActive = true;
+  resyncTarget = target - 1;
+  resyncSource = 0;
+  RequestSnapshot();
+}
+
+void SolarClient::RequestSnapshot()
+{
+  while (resyncSource < (int)walls.size() && (resyncSource == resyncTarget || !walls[resyncSource]))
+    ++resyncSource;
+
+  if (resyncSource >= (int)walls.size())
+  {
+    printf("resync: no wall answered\n");
+    resyncActive = false;
+    return;
+  }
+
+  // framed and stamped like every other command; if the rate limit drops it, the timeout moves on to the next wall
+  Broadcast("snapshot", true, resyncSource);
+  resyncStart = Now();
+}
+
+void SolarClient::Run()
+{
+  while (running)
+  {
+    double now = Now();
+
+    struct pollfd fds[2];
+    int numFds = 0;
+    int stdinIndex = -1, joystickIndex = -1;
+    if (stdinOpen)
+    {
+      stdinIndex = numFds;
+      fds[numFds].fd = STDIN_FILENO;
+      fds[numFds++].events = POLLIN;
+    }
+    if (joystickFd >= 0)
+    {
+      joystickIndex = numFds;
+      fds[numFds].fd = joystickFd;
+      fds[numFds++].events = POLLIN;
+    }
+
+    if (poll(fds, numFds, GetPollTimeout(now)) > 0)
+    {
+      if (stdinIndex >= 0 && (fds[stdinIndex].revents & (POLLIN | POLLHUP)))
+        ReadInput();
+      if (joystickIndex >= 0 && (fds[joystickIndex].revents & POLLIN))
+        ReadJoystick();
+    }
+
+    RunTimers(Now());
+    ReceiveReplies();
+
+    // without input, the client exits once the timeline and the load are over
+    if (!stdinOpen && timeline.empty() && loadRate <= 0.0)
+      running = false;
+  }
+}
+
+// Loopback stand-in of a wall for -benchcamera: keeps the connection of the client to read its camera updates.
+class CameraStandIn : public INetworkServerListener
+{
+public:
+  CameraStandIn() : connection(0) {}
+  virtual void NewConnectionEstablished(MessageConnection *newConnection) { connection = newConnection; }
+
+  MessageConnection *connection;
+};
+
+// Send camera updates at 60 Hz to a stand-in wall on the loopback, dropping a fraction of the packets, and print how
+// long each update takes to be applied, that is until the stand-in applies it or a newer one. The reliable ordered
+// channel of the commands is compared with the camera channel, where stale packets are dropped.
+static void BenchmarkCamera()
+{
+  static const float losses[] = { 0.0f, 0.01f, 0.05f, 0.1f, 0.2f };
+  const int numUpdates = 300;
+  const double period = 1.0 / cDefaultCameraRate;
+
+  Network network;
+  CameraStandIn standIn;
+  NetworkServer *server = network.StartServer(cBenchPort, SocketOverUDP, &standIn, true);
+  if (!server)
+  {
+    printf("benchcamera: could not listen on port %d\n", cBenchPort);
+    return;
+  }
+  Ptr(MessageConnection) sender = network.Connect("127.0.0.1", cBenchPort, SocketOverUDP, NULL);
+
+  tick_t start = Clock::Tick();
+  while (!standIn.connection || !sender || sender->GetConnectionState() != ConnectionOK)
+  {
+    server->Process();
+    Clock::Sleep(1);
+    if (Clock::TimespanToMillisecondsD(start, Clock::Tick()) > 5000.0)
+    {
+      printf("benchcamera: could not connect to the stand-in\n");
+      network.StopServer();
+      return;
+    }
+  }
+
+  printf("%-6s %-10s %8s %8s %8s %8s %7s %8s\n", "loss", "channel", "p50 ms", "p95 ms", "p99 ms", "max ms", "stale",
+    "missing");
+
+  unsigned sequence = 0;
+  CameraVelocity velocity = { { 0.0f, 0.0f, 1.0f }, 0.0f };
+  CameraOdometer odometer;
+  char data[cCameraMessageSize];
+
+  for (size_t l = 0; l < sizeof(losses) / sizeof(losses[0]); ++l)
+  {
+    for (int reliable = 1; reliable >= 0; --reliable)
+    {
+      NetworkSimulator &simulator = sender->NetworkSendSimulator();
+      simulator.enabled = losses[l] > 0.0f;
+      simulator.packetLossRate = losses[l];
+
+      // sequence numbers continue from run to run so that late packets of the previous run count as stale
+      unsigned first = sequence + 1;
+      unsigned lastApplied = sequence;
+      std::vector<double> sendTimes;
+      std::vector<double> latencies;
+      int numStale = 0;
 
+      tick_t runStart = Clock::Tick();
+      double lastSend = 0.0;
+      for (;;)
+      {
+        double now = Clock::TimespanToMillisecondsD(runStart, Clock::Tick());
+        if ((int)sendTimes.size() < numUpdates && now >= sendTimes.size() * period * 1000.0)
+        {
+          odometer.Update(now / 1000.0, velocity);
+          size_t size = WriteCameraMessage(data, ++sequence, velocity, SharedTime(), 0, odometer.GetSegment(),
+            odometer.GetPrevious(), odometer.GetKeyframe());
+          sender->SendMessage(cCameraMessageID, reliable != 0, reliable != 0, 100, reliable ? 0 : cCameraContentID,
+            data, size);
+          sendTimes.push_back(now);
+          lastSend = now;
+        }
+
+        server->Process();
+        NetworkMessage *msg;
+        while ((msg = standIn.connection->ReceiveMessage(0)) != 0)
+        {
+          unsigned received;
+          if (msg->id == cCameraMessageID && msg->dataSize >= 4)
+          {
+            memcpy(&received, msg->data, 4);
+            if (!IsNewerSequence(received, lastApplied))
+              ++numStale;
+            else
+            {
+              for (unsigned s = lastApplied + 1; s != received + 1; ++s)
+              {
+                if (s - first < sendTimes.size())
+                  latencies.push_back(now - sendTimes[s - first]);
+              }
+              lastApplied = received;
+            }
           }
-    std::cin.getline(com,sizeof(com));
+          standIn.connection->FreeMessage(msg);
+        }
+
+        // done once the last update is applied, or a second after it was sent
+        if ((int)sendTimes.size() == numUpdates && (lastApplied == sequence || now - lastSend > 1000.0))
+          break;
+        Clock::Sleep(1);
+      }
+
+      printf("%5.0f%% %-10s %8.2f %8.2f %8.2f %8.2f %7d %8d\n", losses[l] * 100.0f,
+        reliable ? "reliable" : "camera", Percentile(latencies, 0.5), Percentile(latencies, 0.95),
+        Percentile(latencies, 0.99), Percentile(latencies, 1.0), numStale, numUpdates - (int)latencies.size());
+    }
   }
-   
-    return 0;
+
+  network.StopServer();
 }
 
+static void PrintUsage(const char *program)
+{
+  std::cout << "Usage: " << program << " [options] server-ip-1 [server-ip-2 ...]" << std::endl
+    << "  -raw                  send keys as they are pressed (':' for a command line)" << std::endl
+    << "  -joystick <device>    read a joystick, for example /dev/input/js0" << std::endl
+    << "  -joyrate <hz>         joystick sample rate, default 250" << std::endl
+    << "  -script <file>        play a timeline of \"<seconds> <command>\" lines" << std::endl
+    << "  -loop                 repeat the timeline" << std::endl
+    << "  -load <hz> [cmds]     send commands at a fixed rate, cmds separated by commas (default z,q,s,d,k,m)"
+    << std::endl
+    << "  -loss <percent>       drop this share of the sent packets" << std::endl
+    << "  -name <name>          controller name, default <host>:<pid>" << std::endl
+    << "  -role <role>          operator (default), docent, joystick, script or observer" << std::endl
+    << "  -priority <n>         camera priority instead of the default of the role" << std::endl
+    << "Usage: " << program << " -benchcamera" << std::endl
+    << "  camera latency on the loopback under packet loss, reliable channel against camera channel" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<std::string> addresses;
+  std::string joystick, script, name, role = "operator";
+  int priority = -1;
+  double joystickRate = cDefaultJoystickRate;
+  double loadRate = 0.0;
+  float loss = 0.0f;
+  std::vector<std::string> loadCommands;
+  bool raw = false, loop = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-raw")
+      raw = true;
+    else if (arg == "-joystick" && i + 1 < argc)
+      joystick = argv[++i];
+    else if (arg == "-joyrate" && i + 1 < argc)
+      joystickRate = atof(argv[++i]);
+    else if (arg == "-script" && i + 1 < argc)
+      script = argv[++i];
+    else if (arg == "-loop")
+      loop = true;
+    else if (arg == "-name" && i + 1 < argc)
+      name = argv[++i];
+    else if (arg == "-role" && i + 1 < argc)
+      role = argv[++i];
+    else if (arg == "-priority" && i + 1 < argc)
+      priority = atoi(argv[++i]);
+    else if (arg == "-loss" && i + 1 < argc)
+      loss = (float)atof(argv[++i]) / 100.0f;
+    else if (arg == "-benchcamera")
+    {
+      BenchmarkCamera();
+      return 0;
+    }
+    else if (arg == "-load" && i + 1 < argc)
+    {
+      loadRate = atof(argv[++i]);
+      if (i + 1 < argc && argv[i + 1][0] != '-' && strchr(argv[i + 1], ','))
+      {
+        std::istringstream fields(argv[++i]);
+        std::string command;
+        while (std::getline(fields, command, ','))
+          loadCommands.push_back(command);
+      }
+    }
+    else if (arg[0] == '-')
+    {
+      PrintUsage(argv[0]);
+      return 0;
+    }
+    else
+      addresses.push_back(arg);
+  }
+
+  if (addresses.empty())
+  {
+    PrintUsage(argv[0]);
+    return 0;
+  }
+
+  kNet::SetLogChannels(LogUser | LogInfo | LogError);
+  EnableMemoryLeakLoggingAtExit();
+
+  if (name.empty())
+  {
+    char host[256] = "client";
+    gethostname(host, sizeof(host) - 1);
+    name = std::string(host) + ":" + std::to_string(getpid());
+  }
+
+  SolarClient client;
+  client.Connect(addresses);
+  client.SayHello(name, role, priority);
+  if (loss > 0.0f)
+    client.SetPacketLoss(loss);
+
+  if (raw)
+    client.EnableRawKeyboard();
+  if (!joystick.empty())
+    client.OpenJoystick(joystick, joystickRate);
+  if (!script.empty())
+    client.LoadTimeline(script, loop);
+  if (loadCommands.empty())
+  {
+    const char *defaults[] = { "z", "q", "s", "d", "k", "m" };
+    loadCommands.assign(defaults, defaults + 6);
+  }
+  client.SetLoad(loadRate, loadCommands);
+
+  client.Run();
+  return 0;
+}
@@ -0,0 +1,841 @@
+#include "kNet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "CameraChannel.h"
+
+#include "kNet/DebugMemoryLeakCheck.h"
+
+using namespace kNet;
+
+// Text command, as sent by the client.
+const message_id_t cCommandMessageID = 32;
+// Reply of a wall to the "telemetry" command: "<key> <value>" lines.
+const message_id_t cTelemetryMessageID = 33;
+// Reply of a wall to the "snapshot" command: its simulation state (see StaticScene::SaveSnapshot).
+const message_id_t cSnapshotMessageID = 34;
+// First port of the walls, wall n listens on cFirstPort + n - 1.
+const unsigned short cFirstPort = 32000;
+// Most walls.
+const int cMaxWalls = 16;
+// How long the walls may take to start and accept the harness.
+const double cConnectTimeout = 30.0;
+// How long a connection attempt may stay pending before it is retried, while a wall is still loading.
+const double cConnectRetry = 2.0;
+// How long to wait for the replies of every wall.
+const double cReplyTimeout = 5.0;
+// Wait after the scenario, longer than the longest camera flight and the easing of the camera steps.
+const double cSettleSeconds = 7.0;
+// Snapshot identifier and version read by the harness.
+const char *cSnapshotID = "SNAP";
+const unsigned cSnapshotVersion = 1;
+// Largest difference of a camera or object coordinate between walls.
+const float cPositionTolerance = 0.01f;
+// Largest difference of a camera angle between walls, in degrees.
+const float cAngleTolerance = 0.01f;
+// Rate of the camera updates during a camera burst, and updates repeated once it stops, as the client sends them.
+const double cCameraRate = 60.0;
+const int cCameraStopRepeats = 5;
+// Chance of a camera burst at each command of the scenario, and shortest and longest burst in seconds.
+const double cBurstChance = 0.05;
+const double cMinBurstSeconds = 0.2;
+const double cMaxBurstSeconds = 1.0;
+// Camera drive of the floating origin check, at full speed: 150 units, past the rebase distance of the walls (100
+// units) once. Wait after it, longer than the camera input timeout of the walls.
+const double cRebaseSeconds = 0.5;
+const double cRebaseSettleSeconds = 1.0;
+// Rebase distance of the walls (BodySystem), and largest error of the distance driven.
+const double cRebaseDistance = 100.0;
+const double cRebaseTolerance = 1.0;
+
+BottomMemoryAllocator bma;
+
+// Conditions injected by the network shim, on the packets sent by the harness to the walls.
+struct NetworkConditions
+{
+  // One way delay and uniform random delay added to it, in ms. Packets closer than the jitter may be reordered.
+  float latency;
+  float jitter;
+  // Fraction of the packets dropped, and duplicated.
+  float loss;
+  float duplication;
+};
+
+// Network between the harness and a wall. Shims are chosen with -shim, a new one only has to configure the connection.
+class NetworkShim
+{
+public:
+  virtual ~NetworkShim() {}
+  // Apply the conditions to the connection to a wall.
+  virtual void Attach(MessageConnection *connection, const NetworkConditions &conditions) = 0;
+  // Return the name of the shim, for the report.
+  virtual const char *GetName() const = 0;
+};
+
+// Loopback as it is.
+class DirectShim : public NetworkShim
+{
+public:
+  virtual void Attach(MessageConnection *connection, const NetworkConditions &conditions) {}
+  virtual const char *GetName() const { return "none"; }
+};
+
+// kNet packet simulator on the send side of the connection. kNet resends the lost reliable packets and puts the
+// ordered messages back in order, so the walls must still end in the same state.
+class SimulatorShim : public NetworkShim
+{
+public:
+  virtual void Attach(MessageConnection *connection, const NetworkConditions &conditions)
+  {
+    NetworkSimulator &simulator = connection->NetworkSendSimulator();
+    simulator.enabled = true;
+    simulator.constantPacketSendDelay = conditions.latency;
+    simulator.uniformRandomPacketSendDelay = conditions.jitter;
+    simulator.packetLossRate = conditions.loss;
+    simulator.packetDuplicationRate = conditions.duplication;
+  }
+  virtual const char *GetName() const { return "simulator"; }
+};
+
+static NetworkShim *CreateShim(const std::string &name)
+{
+  if (name == "simulator")
+    return new SimulatorShim();
+  if (name == "none")
+    return new DirectShim();
+  return 0;
+}
+
+// Simulation state of a wall, read from its snapshot.
+struct WallState
+{
+  double time;
+  double timeScale;
+  bool updateEnabled;
+  double origin[3];
+  int anchor;
+  float anchorOffset[3];
+  float camera[3];
+  float pitch;
+  float yaw;
+  bool toggles[4];
+  // Points, then objects: position, rotation and scale, and model and material names.
+  std::map<std::string, std::vector<float> > points;
+  std::map<std::string, std::vector<float> > objects;
+  std::map<std::string, std::string> resources;
+};
+
+// Little endian reader of the Urho3D serialization of StaticScene::SaveSnapshot.
+class SnapshotReader
+{
+public:
+  SnapshotReader(const char *data, size_t size) : data(data), size(size), position(0), ok(true) {}
+
+  bool IsOk() const { return ok; }
+  void Read(void *dest, size_t count)
+  {
+    if (position + count > size)
+    {
+      ok = false;
+      memset(dest, 0, count);
+      return;
+    }
+    memcpy(dest, data + position, count);
+    position += count;
+  }
+  unsigned ReadUInt() { unsigned value; Read(&value, 4); return value; }
+  float ReadFloat() { float value; Read(&value, 4); return value; }
+  double ReadDouble() { double value; Read(&value, 8); return value; }
+  unsigned char ReadUByte() { unsigned char value; Read(&value, 1); return value; }
+  bool ReadBool() { return ReadUByte() != 0; }
+  void ReadFloats(float *dest, int count) { for (int i = 0; i < count; ++i) dest[i] = ReadFloat(); }
+  // Seven bits per byte, low bits first, the fourth byte holding eight bits.
+  unsigned ReadVLE()
+  {
+    unsigned value = 0;
+    for (int shift = 0; shift < 28; shift += 7)
+    {
+      unsigned char byte = ReadUByte();
+      if (shift == 21)
+        return value | (unsigned)byte << 21;
+      value |= (unsigned)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        break;
+    }
+    return value;
+  }
+  std::string ReadString()
+  {
+    std::string value;
+    for (;;)
+    {
+      char c;
+      Read(&c, 1);
+      if (!ok || !c)
+        return value;
+      value += c;
+    }
+  }
+
+private:
+  const char *data;
+  size_t size;
+  size_t position;
+  bool ok;
+};
+
+static bool ParseSnapshot(const char *data, size_t size, WallState &state)
+{
+  SnapshotReader reader(data, size);
+  char id[4];
+  reader.Read(id, 4);
+  if (memcmp(id, cSnapshotID, 4) || reader.ReadUInt() != cSnapshotVersion)
+    return false;
+
+  state.time = reader.ReadDouble();
+  state.timeScale = reader.ReadDouble();
+  state.updateEnabled = reader.ReadBool();
+  for (int i = 0; i < 3; ++i)
+    state.origin[i] = reader.ReadDouble();
+  state.anchor = reader.ReadUByte();
+  reader.ReadFloats(state.anchorOffset, 3);
+  reader.ReadFloats(state.camera, 3);
+  state.pitch = reader.ReadFloat();
+  state.yaw = reader.ReadFloat();
+  for (int i = 0; i < 4; ++i)
+    state.toggles[i] = reader.ReadBool();
+
+  unsigned numPoints = reader.ReadVLE();
+  for (unsigned i = 0; i < numPoints && reader.IsOk(); ++i)
+  {
+    std::string name = reader.ReadString();
+    std::vector<float> &point = state.points[name];
+    point.resize(3);
+    reader.ReadFloats(&point[0], 3);
+  }
+  unsigned numObjects = reader.ReadVLE();
+  for (unsigned i = 0; i < numObjects && reader.IsOk(); ++i)
+  {
+    std::string name = reader.ReadString();
+    std::vector<float> &object = state.objects[name];
+    object.resize(10);
+    reader.ReadFloats(&object[0], 10);
+    std::string model = reader.ReadString();
+    state.resources[name] = model + " " + reader.ReadString();
+  }
+  return reader.IsOk();
+}
+
+static bool IsClose(const float *a, const float *b, int count, float tolerance)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    if (fabs(a[i] - b[i]) > tolerance)
+      return false;
+  }
+  return true;
+}
+
+// Differences of a wall with the reference wall, the clock left apart.
+static void CompareStates(const WallState &reference, const WallState &state, std::vector<std::string> &differences)
+{
+  static const char *toggles[] = { "sky", "secret", "sky_secret", "labels" };
+
+  if (state.timeScale != reference.timeScale)
+    differences.push_back("time scale");
+  if (state.updateEnabled != reference.updateEnabled)
+    differences.push_back("pause");
+  for (int i = 0; i < 3; ++i)
+  {
+    if (fabs(state.origin[i] - reference.origin[i]) > cPositionTolerance)
+      differences.push_back("floating origin");
+  }
+  if (state.anchor != reference.anchor)
+    differences.push_back("camera anchor");
+  if (!IsClose(state.anchorOffset, reference.anchorOffset, 3, cPositionTolerance) ||
+    !IsClose(state.camera, reference.camera, 3, cPositionTolerance))
+    differences.push_back("camera position");
+  if (fabs(state.pitch - reference.pitch) > cAngleTolerance || fabs(state.yaw - reference.yaw) > cAngleTolerance)
+    differences.push_back("camera orientation");
+  for (int i = 0; i < 4; ++i)
+  {
+    if (state.toggles[i] != reference.toggles[i])
+      differences.push_back(toggles[i]);
+  }
+  if (state.points != reference.points)
+    differences.push_back("points");
+  if (state.resources != reference.resources)
+    differences.push_back("objects");
+  else
+  {
+    for (std::map<std::string, std::vector<float> >::const_iterator i = state.objects.begin();
+      i != state.objects.end(); ++i)
+    {
+      if (!IsClose(&i->second[0], &reference.objects.find(i->first)->second[0], 10, cPositionTolerance))
+        differences.push_back("object " + i->first);
+    }
+  }
+}
+
+// Values of a telemetry report, "<key> <value>" lines.
+static std::map<std::string, double> ParseTelemetry(const std::string &report)
+{
+  std::map<std::string, double> values;
+  std::istringstream lines(report);
+  std::string key;
+  double value;
+  while (lines >> key >> value)
+    values[key] = value;
+  return values;
+}
+
+static double Percentile(std::vector<double> values, double fraction)
+{
+  if (values.empty())
+    return 0.0;
+  std::sort(values.begin(), values.end());
+  return values[std::min(values.size() - 1, (size_t)(fraction * values.size()))];
+}
+
+// Starts headless walls on the loopback, drives them through a network shim like the client does, then checks that
+// they all end in the same simulation state.
+class Harness
+{
+public:
+  Harness();
+  ~Harness();
+
+  // Start the walls: the server binary with "<port> <angle> -headless -grant harness:operator" and the extra arguments,
+  // in a directory. The output of wall n goes to harness_wall<n>.log.
+  bool StartWalls(const std::string &server, const std::string &directory, int numWalls,
+    const std::vector<std::string> &arguments);
+  // Connect to every wall through the shim. Return false if a wall did not answer.
+  bool Connect(NetworkShim *shim, const NetworkConditions &conditions);
+  // Drive the camera of every wall past the rebase distance of its floating origin on the camera channel, then check
+  // that each wall moved its origin once and left the camera at the distance driven, without a jump back.
+  bool CheckRebase();
+  // Send random camera steps, presets and toggles at a rate for a duration, the same commands to every wall, with
+  // bursts of camera velocity on the unreliable camera channel.
+  void PlayScenario(unsigned seed, double duration, double rate);
+  // Pause the walls, compare their snapshots and print the sync error and the throughput. Return true if the walls
+  // agree and the sync error is below the tolerance, in ms.
+  bool Check(double tolerance);
+  // Stop the walls.
+  void StopWalls();
+
+private:
+  // Seconds since the harness started.
+  double Now() const;
+  // Send a command to every wall.
+  void Broadcast(const std::string &command);
+  // Integrate the camera velocity and send it with its motion to every wall, unreliable.
+  void SendCamera(const CameraVelocity &velocity);
+  // Drop the messages received from the walls.
+  void DrainReplies();
+  // Send a request to every wall and collect the reply of each, empty for a wall that did not answer.
+  void Request(const std::string &request, message_id_t replyID, std::vector<std::string> &replies);
+
+  Network network;
+  std::vector<Ptr(MessageConnection)> walls;
+  std::vector<pid_t> processes;
+  tick_t startTick;
+
+  // Commands and camera updates, and payload bytes sent during the scenario, and its duration.
+  unsigned numSent;
+  unsigned numCameraSent;
+  size_t bytesSent;
+  double scenarioTime;
+
+  // Camera channel: motion segments and last sequence number sent.
+  CameraOdometer cameraOdometer;
+  unsigned cameraSequence;
+};
+
+Harness::Harness() :
+  startTick(Clock::Tick()),
+  numSent(0),
+  numCameraSent(0),
+  bytesSent(0),
+  scenarioTime(0.0),
+  cameraSequence(0)
+{
+}
+
+Harness::~Harness()
+{
+  StopWalls();
+}
+
+double Harness::Now() const
+{
+  return Clock::TimespanToMillisecondsD(startTick, Clock::Tick()) / 1000.0;
+}
+
+bool Harness::StartWalls(const std::string &server, const std::string &directory, int numWalls,
+  const std::vector<std::string> &arguments)
+{
+  for (int i = 0; i < numWalls; ++i)
+  {
+    std::string logName = "harness_wall" + std::to_string(i + 1) + ".log";
+    std::vector<std::string> words;
+    words.push_back(server);
+    words.push_back(std::to_string(cFirstPort + i));
+    words.push_back(std::to_string(360 * i / numWalls));
+    words.push_back("-headless");
+    words.push_back("-grant");
+    words.push_back("harness:operator");
+    words.insert(words.end(), arguments.begin(), arguments.end());
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      printf("harness: could not start wall %d\n", i + 1);
+      return false;
+    }
+    if (pid == 0)
+    {
+      int log = open(logName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (log >= 0)
+      {
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+        close(log);
+      }
+      if (!directory.empty() && chdir(directory.c_str()) != 0)
+        _exit(127);
+      std::vector<char *> argv;
+      for (size_t w = 0; w < words.size(); ++w)
+        argv.push_back(const_cast<char *>(words[w].c_str()));
+      argv.push_back(0);
+      execv(server.c_str(), &argv[0]);
+      _exit(127);
+    }
+    processes.push_back(pid);
+    printf("harness: wall %d on port %d, pid %d, log %s\n", i + 1, cFirstPort + i, (int)pid, logName.c_str());
+  }
+  return true;
+}
+
+void Harness::StopWalls()
+{
+  for (size_t i = 0; i < processes.size(); ++i)
+    kill(processes[i], SIGTERM);
+  for (size_t i = 0; i < processes.size(); ++i)
+    waitpid(processes[i], 0, 0);
+  processes.clear();
+}
+
+bool Harness::Connect(NetworkShim *shim, const NetworkConditions &conditions)
+{
+  // a wall only listens once its scene is loaded: retry the pending connections until then
+  walls.assign(processes.size(), Ptr(MessageConnection)());
+  std::vector<double> attemptTimes(processes.size(), 0.0);
+  double start = Now();
+  for (;;)
+  {
+    int numConnected = 0;
+    for (size_t i = 0; i < walls.size(); ++i)
+    {
+      if (walls[i] && walls[i]->GetConnectionState() == ConnectionOK)
+      {
+        ++numConnected;
+        continue;
+      }
+      if (!walls[i] || Now() - attemptTimes[i] > cConnectRetry)
+      {
+        walls[i] = network.Connect("127.0.0.1", cFirstPort + i, SocketOverUDP, NULL);
+        attemptTimes[i] = Now();
+      }
+    }
+    if (numConnected == (int)walls.size())
+      break;
+    if (Now() - start > cConnectTimeout)
+    {
+      printf("harness: %d of %d walls answered\n", numConnected, (int)walls.size());
+      return false;
+    }
+    Clock::Sleep(10);
+  }
+
+  for (size_t i = 0; i < walls.size(); ++i)
+    shim->Attach(walls[i].ptr(), conditions);
+  printf("harness: %d walls connected in %.1f s, shim %s: latency %.0f ms, jitter %.0f ms, loss %.1f %%, "
+    "duplication %.1f %%\n", (int)walls.size(), Now() - start, shim->GetName(), conditions.latency,
+    conditions.jitter, conditions.loss * 100.0f, conditions.duplication * 100.0f);
+  return true;
+}
+
+void Harness::Broadcast(const std::string &command)
+{
+  std::string data = command + '\0';
+  unsigned time = SharedTime();
+  data.append((const char *)&time, 4);
+  for (size_t i = 0; i < walls.size(); ++i)
+    walls[i]->SendMessage(cCommandMessageID, true, true, 100, 0, data.data(), data.size());
+}
+
+void Harness::SendCamera(const CameraVelocity &velocity)
+{
+  cameraOdometer.Update(Now(), velocity);
+  char data[cCameraMessageSize];
+  size_t size = WriteCameraMessage(data, ++cameraSequence, velocity, SharedTime(), 0, cameraOdometer.GetSegment(),
+    cameraOdometer.GetPrevious(), cameraOdometer.GetKeyframe());
+  for (size_t i = 0; i < walls.size(); ++i)
+    walls[i]->SendMessage(cCameraMessageID, false, false, 100, cCameraContentID, data, size);
+  ++numCameraSent;
+  bytesSent += size * walls.size();
+}
+
+void Harness::DrainReplies()
+{
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    NetworkMessage *msg;
+    while ((msg = walls[i]->ReceiveMessage(0)) != 0)
+      walls[i]->FreeMessage(msg);
+  }
+}
+
+void Harness::Request(const std::string &request, message_id_t replyID, std::vector<std::string> &replies)
+{
+  DrainReplies();
+  Broadcast(request);
+  replies.assign(walls.size(), std::string());
+  std::vector<bool> received(walls.size(), false);
+  double start = Now();
+  while (std::find(received.begin(), received.end(), false) != received.end() && Now() - start < cReplyTimeout)
+  {
+    for (size_t i = 0; i < walls.size(); ++i)
+    {
+      NetworkMessage *msg;
+      while ((msg = walls[i]->ReceiveMessage(0)) != 0)
+      {
+        if (msg->id == replyID && !received[i])
+        {
+          replies[i].assign(msg->data, msg->dataSize);
+          received[i] = true;
+        }
+        walls[i]->FreeMessage(msg);
+      }
+    }
+    Clock::Sleep(1);
+  }
+}
+
+// The camera starts at the root of every wall, where the simulation position is the floating origin plus the camera
+// position. A wall whose camera anchor does not follow the origin sends the camera back past the rebase distance at
+// each frame: the origin then moves at every frame and runs away.
+bool Harness::CheckRebase()
+{
+  Broadcast("hello harness operator");
+  std::vector<std::string> snapshots[2], telemetry[2];
+  Request("snapshot", cSnapshotMessageID, snapshots[0]);
+  Request("telemetry", cTelemetryMessageID, telemetry[0]);
+
+  // straight up, away from the orbits: the camera is never pushed out of a body
+  CameraVelocity up = { { 0.0f, 1.0f, 0.0f }, 0.0f };
+  CameraVelocity rest = { { 0.0f, 0.0f, 0.0f }, 0.0f };
+  double start = Now();
+  double stop = start;
+  for (int repeats = 0; repeats < cCameraStopRepeats;)
+  {
+    bool moving = Now() - start < cRebaseSeconds;
+    if (!moving && !repeats)
+      stop = Now();
+    SendCamera(moving ? up : rest);
+    if (!moving)
+      ++repeats;
+    DrainReplies();
+    Clock::Sleep((int)(1000.0 / cCameraRate));
+  }
+  double settle = Now();
+  while (Now() - settle < cRebaseSettleSeconds)
+  {
+    DrainReplies();
+    Clock::Sleep(10);
+  }
+
+  Request("snapshot", cSnapshotMessageID, snapshots[1]);
+  Request("telemetry", cTelemetryMessageID, telemetry[1]);
+
+  double driven = (stop - start) * cCameraMoveSpeed;
+  bool passed = true;
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    WallState states[2];
+    double rebases[2];
+    bool valid = true;
+    for (int s = 0; s < 2; ++s)
+    {
+      valid = valid && !snapshots[s][i].empty() &&
+        ParseSnapshot(snapshots[s][i].data(), snapshots[s][i].size(), states[s]) &&
+        !telemetry[s][i].empty();
+      rebases[s] = ParseTelemetry(telemetry[s][i])["origin.rebases"];
+    }
+    if (!valid)
+    {
+      printf("harness: rebase: no valid snapshot or telemetry from wall %d\n", (int)i + 1);
+      passed = false;
+      continue;
+    }
+
+    double distance = 0.0, offset = 0.0;
+    for (int c = 0; c < 3; ++c)
+    {
+      double moved = states[1].origin[c] + states[1].camera[c] - states[0].origin[c] - states[0].camera[c];
+      distance += moved * moved;
+      offset += states[1].camera[c] * states[1].camera[c];
+    }
+    distance = sqrt(distance);
+    offset = sqrt(offset);
+    bool ok = rebases[1] - rebases[0] == 1.0 && fabs(distance - driven) <= cRebaseTolerance &&
+      offset <= cRebaseDistance;
+    printf("harness: rebase: wall %d moved the origin %.0f times, camera %.2f units away for %.2f driven, %.2f from "
+      "the origin: %s\n", (int)i + 1, rebases[1] - rebases[0], distance, driven, offset, ok ? "ok" : "FAIL");
+    passed = passed && ok;
+  }
+  return passed;
+}
+
+// Every wall receives the same commands in the same order, whatever the shim does to the packets; only the time
+// at which they arrive differs. The camera updates of the bursts are lost, duplicated and reordered by the shim like
+// any unreliable message: the walls must still end with the camera in the same place.
+void Harness::PlayScenario(unsigned seed, double duration, double rate)
+{
+  static const char *steps[] = { "z", "q", "s", "d", "o", "l", "k", "m" };
+  static const char *presets[] = { "S", "t", "f", "r", "j", "u" };
+  static const char *toggles[] = { "n", "b", "y", "*" };
+
+  Broadcast("hello harness operator");
+  Broadcast("warp 1");
+  Broadcast("date 2030-01-01");
+
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  CameraVelocity burst = { { 0.0f, 0.0f, 0.0f }, 0.0f };
+  CameraVelocity rest = burst;
+  double burstEnd = 0.0;
+  double nextCamera = 0.0;
+  int stopRepeats = 0;
+  double start = Now();
+  double next = start;
+  while (Now() - start < duration || stopRepeats > 0)
+  {
+    // camera burst: move and turn along random axes, at the update rate of the client, then stop
+    if (Now() >= nextCamera && (Now() < burstEnd || stopRepeats > 0))
+    {
+      bool moving = Now() < burstEnd;
+      SendCamera(moving ? burst : rest);
+      if (!moving)
+        --stopRepeats;
+      nextCamera = Now() + 1.0 / cCameraRate;
+    }
+
+    while (Now() - start < duration && Now() >= next)
+    {
+      if (Now() >= burstEnd && stopRepeats == 0 && uniform(random) < cBurstChance)
+      {
+        for (int i = 0; i < 3; ++i)
+          burst.move[i] = (float)((int)(random() % 3) - 1);
+        burst.yaw = (float)((int)(random() % 3) - 1);
+        burstEnd = Now() + cMinBurstSeconds + uniform(random) * (cMaxBurstSeconds - cMinBurstSeconds);
+        stopRepeats = cCameraStopRepeats;
+        nextCamera = Now();
+      }
+
+      unsigned draw = random() % 100;
+      std::string command;
+      if (draw < 70)
+        command = steps[random() % 8];
+      else if (draw < 85)
+        command = presets[random() % 6];
+      else
+        command = toggles[random() % 4];
+      Broadcast(command);
+      ++numSent;
+      bytesSent += (command.size() + 5) * walls.size();
+      next += 1.0 / rate;
+    }
+    DrainReplies();
+    Clock::Sleep(1);
+  }
+  scenarioTime = Now() - start;
+  printf("harness: %u commands and %u camera updates sent in %.1f s (seed %u), settling for %.0f s\n", numSent,
+    numCameraSent, scenarioTime, seed, cSettleSeconds);
+
+  double settle = Now();
+  while (Now() - settle < cSettleSeconds)
+  {
+    DrainReplies();
+    Clock::Sleep(10);
+  }
+}
+
+// The clocks run freely on each wall: the sync error is the spread of the clocks once paused, converted to real time,
+// which includes the different delivery times of the pause itself.
+bool Harness::Check(double tolerance)
+{
+  Broadcast("p");
+  std::vector<std::string> snapshots, telemetry;
+  Request("snapshot", cSnapshotMessageID, snapshots);
+  Request("telemetry", cTelemetryMessageID, telemetry);
+
+  bool agree = true;
+  std::vector<WallState> states(walls.size());
+  std::vector<double> clocks;
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    if (snapshots[i].empty() || !ParseSnapshot(snapshots[i].data(), snapshots[i].size(), states[i]))
+    {
+      printf("harness: no valid snapshot from wall %d\n", (int)i + 1);
+      agree = false;
+      continue;
+    }
+    clocks.push_back(states[i].time);
+
+    std::vector<std::string> differences;
+    if (i > 0 && !snapshots[0].empty())
+      CompareStates(states[0], states[i], differences);
+    for (size_t d = 0; d < differences.size(); ++d)
+      printf("harness: wall %d differs from wall 1: %s\n", (int)i + 1, differences[d].c_str());
+    agree = agree && differences.empty();
+  }
+
+  double syncError = 0.0;
+  if (!clocks.empty() && states[0].timeScale != 0.0)
+  {
+    std::vector<double> offsets;
+    for (size_t i = 0; i < clocks.size(); ++i)
+      offsets.push_back(fabs(clocks[i] - clocks[0]) * 1000.0 / fabs(states[0].timeScale));
+    syncError = Percentile(offsets, 1.0);
+    printf("harness: sync error %.1f ms (clock spread once paused), median offset to wall 1 %.1f ms\n", syncError,
+      Percentile(offsets, 0.5));
+  }
+
+  // throughput: commands each wall received and received above the rate limit, against those sent
+  printf("%-8s %10s %10s %10s %10s\n", "wall", "received", "overlimit", "cmds/s", "frame p95");
+  for (size_t i = 0; i < walls.size(); ++i)
+  {
+    std::map<std::string, double> values = ParseTelemetry(telemetry[i]);
+    if (telemetry[i].empty())
+    {
+      printf("wall %-3d %10s\n", (int)i + 1, "-");
+      agree = false;
+      continue;
+    }
+    printf("wall %-3d %10.0f %10.0f %10.1f %10.2f\n", (int)i + 1, values["input.received"], values["input.overlimit"],
+      scenarioTime > 0.0 ? numSent / scenarioTime : 0.0, values["frame.p95"]);
+    agree = agree && values["input.overlimit"] == 0.0;
+  }
+  printf("harness: %.0f payload bytes/s sent to the walls\n", scenarioTime > 0.0 ? bytesSent / scenarioTime : 0.0);
+
+  bool synced = syncError <= tolerance;
+  if (!synced)
+    printf("harness: sync error above the tolerance of %.0f ms\n", tolerance);
+  printf("harness: %s\n", agree && synced ? "PASS, the walls agree" : "FAIL");
+  return agree && synced;
+}
+
+static void PrintUsage(const char *program)
+{
+  std::cout << "Usage: " << program << " [options] <server binary> [-- server options]" << std::endl
+    << "  -walls <n>            headless walls started on the loopback, default 5" << std::endl
+    << "  -dir <directory>      working directory of the walls, default the current one" << std::endl
+    << "  -shim <name>          network shim: simulator (default) or none" << std::endl
+    << "  -latency <ms>         one way delay of the packets to the walls" << std::endl
+    << "  -jitter <ms>          random delay added to the latency, reorders the packets closer than it" << std::endl
+    << "  -loss <percent>       packets dropped" << std::endl
+    << "  -duplicate <percent>  packets sent twice" << std::endl
+    << "  -duration <s>         scenario length, default 20" << std::endl
+    << "  -rate <hz>            scenario commands per second, default 20" << std::endl
+    << "  -seed <n>             scenario seed, default 1" << std::endl
+    << "  -tolerance <ms>       largest sync error, default the latency plus the jitter plus 100 ms" << std::endl
+    << "The exit status is 0 when the walls follow a floating origin rebase and end in the same state." << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  std::string server, directory, shimName = "simulator";
+  std::vector<std::string> serverArguments;
+  NetworkConditions conditions = { 0.0f, 0.0f, 0.0f, 0.0f };
+  int numWalls = 5;
+  double duration = 20.0, rate = 20.0, tolerance = -1.0;
+  unsigned seed = 1;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--")
+    {
+      serverArguments.assign(argv + i + 1, argv + argc);
+      break;
+    }
+    else if (arg == "-walls" && i + 1 < argc)
+      numWalls = atoi(argv[++i]);
+    else if (arg == "-dir" && i + 1 < argc)
+      directory = argv[++i];
+    else if (arg == "-shim" && i + 1 < argc)
+      shimName = argv[++i];
+    else if (arg == "-latency" && i + 1 < argc)
+      conditions.latency = (float)atof(argv[++i]);
+    else if (arg == "-jitter" && i + 1 < argc)
+      conditions.jitter = (float)atof(argv[++i]);
+    else if (arg == "-loss" && i + 1 < argc)
+      conditions.loss = (float)atof(argv[++i]) / 100.0f;
+    else if (arg == "-duplicate" && i + 1 < argc)
+      conditions.duplication = (float)atof(argv[++i]) / 100.0f;
+    else if (arg == "-duration" && i + 1 < argc)
+      duration = atof(argv[++i]);
+    else if (arg == "-rate" && i + 1 < argc)
+      rate = atof(argv[++i]);
+    else if (arg == "-seed" && i + 1 < argc)
+      seed = (unsigned)atoi(argv[++i]);
+    else if (arg == "-tolerance" && i + 1 < argc)
+      tolerance = atof(argv[++i]);
+    else if (arg[0] == '-' || !server.empty())
+    {
+      PrintUsage(argv[0]);
+      return 2;
+    }
+    else
+      server = arg;
+  }
+
+  NetworkShim *shim = CreateShim(shimName);
+  if (server.empty() || !shim || numWalls < 1 || numWalls > cMaxWalls || rate <= 0.0)
+  {
+    PrintUsage(argv[0]);
+    delete shim;
+    return 2;
+  }
+  if (tolerance < 0.0)
+    tolerance = conditions.latency + conditions.jitter + 100.0;
+
+  kNet::SetLogChannels(LogError);
+
+  bool passed = false;
+  {
+    Harness harness;
+    if (harness.StartWalls(server, directory, numWalls, serverArguments) && harness.Connect(shim, conditions))
+    {
+      bool rebased = harness.CheckRebase();
+      harness.PlayScenario(seed, duration, rate);
+      passed = harness.Check(tolerance) && rebased;
+    }
+  }
+  delete shim;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,440 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+
+#include "AsteroidBelt.h"
+#include "BodySystem.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+/// Number of angular sectors used to keep chunks spatially coherent.
+static const unsigned NUM_SECTORS = 64;
+/// Maximum number of asteroids per chunk.
+static const unsigned CHUNK_SIZE = 2048;
+/// Number of work items per thread, so that the threads stay busy when chunks have unequal sizes.
+static const unsigned ITEMS_PER_THREAD = 4;
+
+/// Return the argument of latitude at a simulation time, in [0, 2 pi).
+static inline float AngleAt(float phase, float speed, double time)
+{
+    const double twoPi = 2.0 * M_PI;
+    double turns = speed * time / twoPi;
+    float u = phase + (float)((turns - floor(turns)) * twoPi);
+    return u >= (float)twoPi ? u - (float)twoPi : u;
+}
+
+AsteroidBelt::AsteroidBelt(Context* context) :
+    Drawable(context, DRAWABLE_GEOMETRY),
+    referenceRadius_(1.0f),
+    referenceSpeed_(0.0f),
+    innerRadius_(0.0f),
+    outerRadius_(0.0f),
+    halfThickness_(0.0f),
+    rockRadius_(0.0f),
+    drift_(0.0f),
+    time_(0.0),
+    minSpeed_(0.0f),
+    maxSpeed_(0.0f),
+    origin_(Vector3::ZERO),
+    lastPropagateTime_(0),
+    lastCullTime_(0)
+{
+}
+
+AsteroidBelt::~AsteroidBelt()
+{
+}
+
+void AsteroidBelt::UpdateBatches(const FrameInfo& frame)
+{
+    distance_ = frame.camera_->GetDistance(GetWorldBoundingBox().Center());
+
+    // Each wall renders its own 72 degree slice: drop the chunks outside this camera before the batches are queued
+    Cull(frame.camera_->GetFrustum());
+
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+        batches_[i].distance_ = frame.camera_->GetDistance(chunks_[i].box_.Center());
+}
+
+void AsteroidBelt::AddMesh(Model* model)
+{
+    if (!model || meshes_.Size() >= 256)
+        return;
+
+    meshes_.Push(SharedPtr<Model>(model));
+}
+
+void AsteroidBelt::SetMaterial(Material* material)
+{
+    material_ = material;
+
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+        batches_[i].material_ = material_;
+}
+
+void AsteroidBelt::SetReferenceOrbit(float radius, float angularSpeed)
+{
+    referenceRadius_ = radius;
+    referenceSpeed_ = angularSpeed;
+}
+
+void AsteroidBelt::Generate(unsigned count, float innerRadius, float outerRadius, float maxInclination, float minScale,
+    float maxScale, unsigned seed)
+{
+    if (meshes_.Empty())
+        return;
+
+    // Every wall generates the same belt from the same seed
+    SetRandomSeed(seed);
+
+    innerRadius_ = innerRadius;
+    outerRadius_ = outerRadius;
+
+    radius_.Resize(count);
+    angle_.Resize(count);
+    speed_.Resize(count);
+    cosNode_.Resize(count);
+    sinNode_.Resize(count);
+    cosInclination_.Resize(count);
+    sinInclination_.Resize(count);
+    mesh_.Resize(count);
+    transforms_.Resize(count);
+
+    rockRadius_ = 0.0f;
+    for (unsigned i = 0; i < meshes_.Size(); ++i)
+        rockRadius_ = Max(rockRadius_, meshes_[i]->GetBoundingBox().HalfSize().Length() * maxScale);
+
+    minSpeed_ = M_INFINITY;
+    maxSpeed_ = -M_INFINITY;
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float radius = Random(innerRadius, outerRadius);
+        float node = Random(2.0f * M_PI);
+        float inclination = Random(-maxInclination, maxInclination) * M_DEGTORAD;
+        // Kepler's third law: angular speed scales with radius^-3/2
+        float speed = referenceSpeed_ * M_DEGTORAD * powf(radius / referenceRadius_, -1.5f);
+
+        radius_[i] = radius;
+        angle_[i] = Random(2.0f * M_PI);
+        speed_[i] = speed;
+        cosNode_[i] = cosf(node);
+        sinNode_[i] = sinf(node);
+        cosInclination_[i] = cosf(inclination);
+        sinInclination_[i] = sinf(inclination);
+        mesh_[i] = (unsigned char)Random((int)meshes_.Size());
+
+        // Squashed, randomly oriented primitives read as rocks from a distance
+        float scale = Random(minScale, maxScale);
+        Vector3 rockScale(scale * Random(0.5f, 1.0f), scale * Random(0.5f, 1.0f), scale);
+        Quaternion rockRotation(Random(360.0f), Random(360.0f), Random(360.0f));
+        transforms_[i] = Matrix3x4(Vector3::ZERO, rockRotation, rockScale);
+
+        minSpeed_ = Min(minSpeed_, speed);
+        maxSpeed_ = Max(maxSpeed_, speed);
+    }
+
+    halfThickness_ = outerRadius_ * sinf(maxInclination * M_DEGTORAD) + rockRadius_;
+
+    Rebin();
+    OnMarkedDirty(node_);
+}
+
+void AsteroidBelt::Propagate(double time)
+{
+    if (chunks_.Empty())
+        return;
+
+    URHO3D_PROFILE(PropagateAsteroids);
+
+    HiresTimer timer;
+
+    double timeStep = time - time_;
+    time_ = time;
+    origin_ = node_ ? node_->GetWorldPosition() : Vector3::ZERO;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numItems = (queue->GetNumThreads() + 1) * ITEMS_PER_THREAD;
+    unsigned chunksPerItem = (chunks_.Size() + numItems - 1) / numItems;
+
+    AsteroidChunk* chunks = &chunks_[0];
+    for (unsigned start = 0; start < chunks_.Size(); start += chunksPerItem)
+    {
+        unsigned end = Min(start + chunksPerItem, chunks_.Size());
+
+        SharedPtr<WorkItem> item(new WorkItem());
+        item->workFunction_ = PropagateWork;
+        item->start_ = chunks + start;
+        item->end_ = chunks + end;
+        item->aux_ = this;
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+
+    // Differential rotation slowly spreads every chunk around the orbit. Once the spread reaches a sector, reorder so
+    // that the chunk boxes stay tight enough to be culled. When a single step spreads more than a sector (time warp or
+    // seek) the order would be stale by the next frame, so the chunks are left as they are and simply culled less
+    float stepDrift = (float)(Abs(maxSpeed_ - minSpeed_) * Abs(timeStep));
+    const float sector = 2.0f * M_PI / NUM_SECTORS;
+    drift_ += stepDrift;
+    if (drift_ > sector && stepDrift < sector)
+        Rebin();
+
+    lastPropagateTime_ = timer.GetUSec(false);
+}
+
+unsigned AsteroidBelt::Cull(const Frustum& frustum)
+{
+    HiresTimer timer;
+
+    unsigned visible = 0;
+    for (unsigned i = 0; i < chunks_.Size(); ++i)
+    {
+        const AsteroidChunk& chunk = chunks_[i];
+        bool inside = frustum.IsInsideFast(chunk.box_) != OUTSIDE;
+        batches_[i].numWorldTransforms_ = inside ? chunk.count_ : 0;
+        if (inside)
+            visible += chunk.count_;
+    }
+
+    lastCullTime_ = timer.GetUSec(false);
+    return visible;
+}
+
+void AsteroidBelt::OnNodeSet(Node* node)
+{
+    Drawable::OnNodeSet(node);
+
+    if (node)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+            SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(AsteroidBelt, HandleSceneUpdate));
+    }
+}
+
+void AsteroidBelt::OnWorldBoundingBoxUpdate()
+{
+    float extent = outerRadius_ + rockRadius_;
+    BoundingBox localBox(Vector3(-extent, -halfThickness_, -extent), Vector3(extent, halfThickness_, extent));
+    worldBoundingBox_ = localBox.Transformed(node_->GetWorldTransform());
+}
+
+void AsteroidBelt::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace SceneUpdate;
+
+    // Follow the simulation clock of the bodies, which carries the time scale and the jumps in time
+    BodySystem* bodySystem = GetScene()->GetComponent<BodySystem>();
+    Propagate(bodySystem ? bodySystem->GetTime() : time_ + eventData[P_TIMESTEP].GetFloat());
+}
+
+void AsteroidBelt::Rebin()
+{
+    URHO3D_PROFILE(RebinAsteroids);
+
+    unsigned count = radius_.Size();
+    unsigned numKeys = meshes_.Size() * NUM_SECTORS;
+
+    // Counting sort on (mesh, sector of the current longitude)
+    PODVector<unsigned> keys(count);
+    PODVector<unsigned> offsets(numKeys + 1);
+    for (unsigned i = 0; i < offsets.Size(); ++i)
+        offsets[i] = 0;
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float u = AngleAt(angle_[i], speed_[i], time_);
+        float c = cosf(u);
+        float s = sinf(u) * cosInclination_[i];
+        float x = cosNode_[i] * c - sinNode_[i] * s;
+        float z = -(sinNode_[i] * c + cosNode_[i] * s);
+        float longitude = atan2f(z, x) + M_PI;
+        unsigned sector = Min((unsigned)(longitude / (2.0f * M_PI) * NUM_SECTORS), NUM_SECTORS - 1);
+
+        keys[i] = mesh_[i] * NUM_SECTORS + sector;
+        ++offsets[keys[i] + 1];
+    }
+    for (unsigned k = 1; k <= numKeys; ++k)
+        offsets[k] += offsets[k - 1];
+
+    PODVector<unsigned> order(count);
+    PODVector<unsigned> cursor(offsets);
+    for (unsigned i = 0; i < count; ++i)
+        order[cursor[keys[i]]++] = i;
+
+    PODVector<float> radius(count), angle(count), speed(count), cosNode(count), sinNode(count), cosInclination(count),
+        sinInclination(count);
+    PODVector<unsigned char> mesh(count);
+    PODVector<Matrix3x4> transforms(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned j = order[i];
+        radius[i] = radius_[j];
+        angle[i] = angle_[j];
+        speed[i] = speed_[j];
+        cosNode[i] = cosNode_[j];
+        sinNode[i] = sinNode_[j];
+        cosInclination[i] = cosInclination_[j];
+        sinInclination[i] = sinInclination_[j];
+        mesh[i] = mesh_[j];
+        transforms[i] = transforms_[j];
+    }
+    radius_.Swap(radius);
+    angle_.Swap(angle);
+    speed_.Swap(speed);
+    cosNode_.Swap(cosNode);
+    sinNode_.Swap(sinNode);
+    cosInclination_.Swap(cosInclination);
+    sinInclination_.Swap(sinInclination);
+    mesh_.Swap(mesh);
+    transforms_.Swap(transforms);
+
+    // Split every (mesh, sector) run into chunks of at most CHUNK_SIZE asteroids
+    chunks_.Clear();
+    for (unsigned k = 0; k < numKeys; ++k)
+    {
+        for (unsigned start = offsets[k]; start < offsets[k + 1]; start += CHUNK_SIZE)
+        {
+            AsteroidChunk chunk;
+            chunk.start_ = start;
+            chunk.count_ = Min(CHUNK_SIZE, offsets[k + 1] - start);
+            chunk.mesh_ = k / NUM_SECTORS;
+            chunks_.Push(chunk);
+        }
+    }
+
+    batches_.Resize(chunks_.Size());
+    for (unsigned i = 0; i < chunks_.Size(); ++i)
+    {
+        const AsteroidChunk& chunk = chunks_[i];
+        SourceBatch& batch = batches_[i];
+        batch.geometry_ = meshes_[chunk.mesh_]->GetGeometry(0, 0);
+        batch.material_ = material_;
+        batch.worldTransform_ = &transforms_[chunk.start_];
+        batch.numWorldTransforms_ = chunk.count_;
+    }
+
+    // Refresh translations and chunk boxes for the new order
+    if (!chunks_.Empty())
+    {
+        PropagateChunks(&chunks_[0], &chunks_[0] + chunks_.Size());
+    }
+
+    drift_ = 0.0f;
+}
+
+void AsteroidBelt::PropagateChunks(AsteroidChunk* begin, AsteroidChunk* end)
+{
+    const double time = time_;
+    const Vector3 origin = origin_;
+    const Vector3 padding(rockRadius_, rockRadius_, rockRadius_);
+
+    for (AsteroidChunk* chunk = begin; chunk < end; ++chunk)
+    {
+        BoundingBox box;
+        unsigned last = chunk->start_ + chunk->count_;
+
+        for (unsigned i = chunk->start_; i < last; ++i)
+        {
+            float u = AngleAt(angle_[i], speed_[i], time);
+
+            float r = radius_[i];
+            float c = cosf(u);
+            float s = sinf(u);
+            float sc = s * cosInclination_[i];
+
+            // Same handedness as BodySystem: a positive angle turns +X towards -Z
+            Matrix3x4& transform = transforms_[i];
+            transform.m03_ = origin.x_ + r * (cosNode_[i] * c - sinNode_[i] * sc);
+            transform.m13_ = origin.y_ + r * s * sinInclination_[i];
+            transform.m23_ = origin.z_ - r * (sinNode_[i] * c + cosNode_[i] * sc);
+
+            box.Merge(Vector3(transform.m03_, transform.m13_, transform.m23_));
+        }
+
+        chunk->box_ = BoundingBox(box.min_ - padding, box.max_ + padding);
+    }
+}
+
+void AsteroidBelt::PropagateWork(const WorkItem* item, unsigned threadIndex)
+{
+    AsteroidBelt* belt = reinterpret_cast<AsteroidBelt*>(item->aux_);
+    belt->PropagateChunks(reinterpret_cast<AsteroidChunk*>(item->start_), reinterpret_cast<AsteroidChunk*>(item->end_));
+}
+
+void AsteroidBelt::Benchmark(Context* context)
+{
+    static const unsigned counts[] = { 10000, 100000, 1000000 };
+    static const unsigned NUM_FRAMES = 60;
+    static const unsigned NUM_WALLS = 5;
+
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+
+    for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        SharedPtr<Scene> scene(new Scene(context));
+        Node* node = scene->CreateChild("BenchmarkBelt");
+        AsteroidBelt* belt = node->CreateComponent<AsteroidBelt>();
+        belt->AddMesh(cache->GetResource<Model>("Models/Box.mdl"));
+        belt->AddMesh(cache->GetResource<Model>("Models/Pyramid.mdl"));
+        belt->AddMesh(cache->GetResource<Model>("Models/Cone.mdl"));
+        belt->SetReferenceOrbit(5.0f, -50.0f);
+        belt->Generate(counts[c], 8.0f, 11.0f, 5.0f, 0.005f, 0.02f, 1);
+
+        long long updateTime = 0;
+        long long cullTime = 0;
+        unsigned visible = 0;
+
+        for (unsigned frame = 0; frame < NUM_FRAMES; ++frame)
+        {
+            belt->Propagate(frame / 60.0);
+            updateTime += belt->GetLastPropagateTime();
+
+            // One camera per wall, looking outwards from above the sun
+            for (unsigned wall = 0; wall < NUM_WALLS; ++wall)
+            {
+                Frustum frustum;
+                frustum.Define(72.0f, 16.0f / 9.0f, 1.0f, 0.1f, 1000.0f,
+                    Matrix3x4(Vector3(0.0f, 5.1f, -5.0f), Quaternion(0.0f, wall * 72.0f, 0.0f), 1.0f));
+                visible += belt->Cull(frustum);
+                cullTime += belt->GetLastCullTime();
+            }
+        }
+
+        printf("asteroids=%u chunks=%u update=%.3f ms cull=%.3f ms (per frame, %u walls) visible=%u\n",
+            belt->GetNumAsteroids(), belt->GetNumChunks(), updateTime / 1000.0 / NUM_FRAMES,
+            cullTime / 1000.0 / NUM_FRAMES, NUM_WALLS, visible / NUM_FRAMES);
+    }
+}
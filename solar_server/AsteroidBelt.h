@@ -0,0 +1,163 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/Math/Frustum.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Material;
+class Model;
+struct WorkItem;
+
+}
+
+/// Contiguous range of asteroids sharing a rock mesh, culled as a unit.
+struct AsteroidChunk
+{
+    /// Index of the first asteroid.
+    unsigned start_;
+    /// Number of asteroids.
+    unsigned count_;
+    /// Rock mesh index.
+    unsigned mesh_;
+    /// World bounding box, refreshed by every propagation.
+    BoundingBox box_;
+};
+
+/// Belt of small bodies on circular inclined orbits around the sun.
+/// Orbital elements are stored as structure of arrays and propagated on the WorkQueue threads. Asteroids are sorted by
+/// (mesh, sector) into chunks; each chunk is one source batch whose world transforms are rendered with hardware
+/// instancing, and chunks outside the camera frustum are dropped per view before the batches reach the renderer.
+class AsteroidBelt : public Drawable
+{
+    URHO3D_OBJECT(AsteroidBelt, Drawable);
+
+public:
+    /// Construct.
+    AsteroidBelt(Context* context);
+    /// Destruct.
+    virtual ~AsteroidBelt();
+
+    /// Calculate distance and prepare batches for rendering. Culls chunks against the view frustum.
+    virtual void UpdateBatches(const FrameInfo& frame);
+
+    /// Add a shared rock mesh. All meshes must be added before Generate().
+    void AddMesh(Model* model);
+    /// Set the material used by all rock meshes.
+    void SetMaterial(Material* material);
+    /// Generate asteroids with semi-major axes between the two radii.
+    void Generate(unsigned count, float innerRadius, float outerRadius, float maxInclination, float minScale, float maxScale,
+        unsigned seed);
+    /// Set angular speed in degrees per second at the reference radius; speeds of other radii follow Kepler's third law.
+    void SetReferenceOrbit(float radius, float angularSpeed);
+    /// Move all asteroids to their positions at a simulation time, splitting the work across the worker threads. Positions
+    /// are evaluated in closed form, so any jump in time costs the same.
+    void Propagate(double time);
+    /// Return number of asteroids inside the frustum, marking the chunks to draw.
+    unsigned Cull(const Frustum& frustum);
+
+    /// Return number of asteroids.
+    unsigned GetNumAsteroids() const { return radius_.Size(); }
+    /// Return number of chunks.
+    unsigned GetNumChunks() const { return chunks_.Size(); }
+    /// Return duration of the last propagation in microseconds.
+    long long GetLastPropagateTime() const { return lastPropagateTime_; }
+    /// Return duration of the last cull in microseconds.
+    long long GetLastCullTime() const { return lastCullTime_; }
+
+    /// Print update and cull time for 10k, 100k and 1M asteroids.
+    static void Benchmark(Context* context);
+
+protected:
+    /// Handle node being assigned.
+    virtual void OnNodeSet(Node* node);
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+
+private:
+    /// Handle scene update event.
+    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    /// Reorder asteroids by (mesh, sector) and rebuild the chunks and batches.
+    void Rebin();
+    /// Propagate a range of chunks. Called from the worker threads.
+    void PropagateChunks(AsteroidChunk* begin, AsteroidChunk* end);
+    /// Work item entry point.
+    static void PropagateWork(const WorkItem* item, unsigned threadIndex);
+
+    /// Rock meshes.
+    Vector<SharedPtr<Model> > meshes_;
+    /// Shared material.
+    SharedPtr<Material> material_;
+    /// Orbit radius.
+    PODVector<float> radius_;
+    /// Argument of latitude at time zero in radians.
+    PODVector<float> angle_;
+    /// Angular speed in radians per second.
+    PODVector<float> speed_;
+    /// Cosine of the longitude of the ascending node.
+    PODVector<float> cosNode_;
+    /// Sine of the longitude of the ascending node.
+    PODVector<float> sinNode_;
+    /// Cosine of the inclination.
+    PODVector<float> cosInclination_;
+    /// Sine of the inclination.
+    PODVector<float> sinInclination_;
+    /// Rock mesh index.
+    PODVector<unsigned char> mesh_;
+    /// Instance transforms; rotation and scale are fixed, only the translation is rewritten by propagation.
+    PODVector<Matrix3x4> transforms_;
+    /// Chunks in (mesh, sector) order.
+    PODVector<AsteroidChunk> chunks_;
+    /// Reference orbit radius for Kepler speeds.
+    float referenceRadius_;
+    /// Angular speed at the reference radius in degrees per second.
+    float referenceSpeed_;
+    /// Inner orbit radius.
+    float innerRadius_;
+    /// Outer orbit radius.
+    float outerRadius_;
+    /// Maximum height above the ecliptic, including the rock size.
+    float halfThickness_;
+    /// Largest rock bounding radius, used to pad the chunk boxes.
+    float rockRadius_;
+    /// Angular spread accumulated by differential rotation since the last rebin, in radians.
+    float drift_;
+    /// Simulation time of the last propagation.
+    double time_;
+    /// Slowest angular speed in radians per second.
+    float minSpeed_;
+    /// Fastest angular speed in radians per second.
+    float maxSpeed_;
+    /// World position of the node, captured before propagation.
+    Vector3 origin_;
+    /// Duration of the last propagation in microseconds.
+    long long lastPropagateTime_;
+    /// Duration of the last cull in microseconds.
+    long long lastCullTime_;
+};
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Timer.h>
+
+#include "AsyncLog.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdarg>
+#include <cstdio>
+
+AsyncLog::AsyncLog() :
+    numDropped_(0),
+    numReportedDropped_(0)
+{
+    Run();
+}
+
+AsyncLog::~AsyncLog()
+{
+    Stop();
+    Flush();
+}
+
+void AsyncLog::Write(const char* format, ...)
+{
+    char line[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    MutexLock lock(bufferMutex_);
+    if (buffer_.Length() >= MAX_BUFFER_SIZE)
+    {
+        ++numDropped_;
+        return;
+    }
+    buffer_ += line;
+    buffer_ += '\n';
+}
+
+void AsyncLog::Flush()
+{
+    MutexLock writeLock(writeMutex_);
+
+    unsigned numDropped;
+    {
+        MutexLock lock(bufferMutex_);
+        writeBuffer_.Swap(buffer_);
+        numDropped = numDropped_ - numReportedDropped_;
+        numReportedDropped_ = numDropped_;
+    }
+
+    if (writeBuffer_.Empty() && !numDropped)
+        return;
+
+    fwrite(writeBuffer_.CString(), 1, writeBuffer_.Length(), stdout);
+    if (numDropped)
+        fprintf(stdout, "log: %u lines dropped\n", numDropped);
+    fflush(stdout);
+    writeBuffer_.Clear();
+}
+
+void AsyncLog::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        Time::Sleep(FLUSH_INTERVAL);
+        Flush();
+    }
+}
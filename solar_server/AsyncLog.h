@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/RefCounted.h>
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Core/Mutex.h>
+#include <Urho3D/Core/Thread.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+/// Buffered console log written by a background thread, so that the render thread never waits on console I/O.
+/// Lines are appended to a buffer under a mutex; the thread swaps the buffer out and writes it to stdout a few times per
+/// second. When the buffer reaches its limit the newest lines are dropped and counted instead of blocking.
+class AsyncLog : public RefCounted, public Thread
+{
+public:
+    /// Construct and start the writer thread.
+    AsyncLog();
+    /// Destruct. Stops the thread and writes what is left.
+    virtual ~AsyncLog();
+
+    /// Append a formatted line. A newline is added.
+    void Write(const char* format, ...);
+    /// Write the buffered lines now, from the calling thread.
+    void Flush();
+    /// Return the number of lines dropped because the buffer was full.
+    unsigned GetNumDropped() const { return numDropped_; }
+
+    /// Write the buffer periodically. Called by the thread.
+    virtual void ThreadFunction();
+
+    /// Buffered bytes above which lines are dropped.
+    static const unsigned MAX_BUFFER_SIZE = 1024 * 1024;
+    /// Milliseconds between two writes.
+    static const unsigned FLUSH_INTERVAL = 50;
+
+private:
+    /// Lines not yet written.
+    String buffer_;
+    /// Buffer swapped out for writing, kept to reuse its allocation.
+    String writeBuffer_;
+    /// Guards buffer_ and the drop counts.
+    Mutex bufferMutex_;
+    /// Serializes the writes of the thread and of Flush().
+    Mutex writeMutex_;
+    /// Lines dropped because the buffer was full.
+    unsigned numDropped_;
+    /// Dropped lines already reported in the log.
+    unsigned numReportedDropped_;
+};
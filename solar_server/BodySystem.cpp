@@ -0,0 +1,310 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "BodySystem.h"
+#include "Telemetry.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+/// Default distance from the origin past which the camera triggers a rebase.
+static const float DEFAULT_REBASE_DISTANCE = 100.0f;
+
+const double BodySystem::MAX_TIME_SCALE = 1000000.0;
+
+/// Return the angle in degrees reached at a constant angular speed, reduced to [0, 360).
+static double AngleAt(double speed, double time)
+{
+    double turns = speed * time / 360.0;
+    return (turns - floor(turns)) * 360.0;
+}
+
+BodySystem::BodySystem(Context* context) :
+    LogicComponent(context),
+    rebaseDistance_(DEFAULT_REBASE_DISTANCE),
+    time_(0.0),
+    timeScale_(1.0),
+    lastUpdateTime_(0),
+    lastRebaseTime_(0),
+    numRebases_(0)
+{
+    // Only the scene update event is needed: unsubscribe from the rest for optimization
+    SetUpdateEventMask(USE_UPDATE);
+}
+
+unsigned BodySystem::AddBody(const BodyParams& params, Node* frameNode, Node* bodyNode)
+{
+    assert(params.parent_ < (int)params_.Size());
+
+    params_.Push(params);
+    frameAngles_.Push(0.0);
+    simPositions_.Push(DoubleVector3());
+    positions_.Push(Vector3::ZERO);
+    frameRotations_.Push(Quaternion::IDENTITY);
+    frameNodes_.Push(frameNode);
+    bodyNodes_.Push(bodyNode);
+
+    if (frameNode)
+        managedNodes_.Insert(frameNode);
+    if (bodyNode)
+        managedNodes_.Insert(bodyNode);
+
+    return params_.Size() - 1;
+}
+
+void BodySystem::SetParams(unsigned index, const BodyParams& params)
+{
+    // Reparenting would break the parents-first order of the single pass
+    int parent = params_[index].parent_;
+    params_[index] = params;
+    params_[index].parent_ = parent;
+}
+
+void BodySystem::Update(float timeStep)
+{
+    // Nothing accumulates per body: the cost is the same at any time scale
+    time_ += timeStep * timeScale_;
+    UpdateTransforms();
+}
+
+void BodySystem::SetTime(double time)
+{
+    time_ = time;
+    UpdateTransforms();
+}
+
+void BodySystem::SetTimeScale(double scale)
+{
+    timeScale_ = Clamp(scale, -MAX_TIME_SCALE, MAX_TIME_SCALE);
+}
+
+double BodySystem::GetFrameAngleAt(unsigned index, double time) const
+{
+    double angle = 0.0;
+    for (int i = (int)index; i >= 0; i = params_[i].parent_)
+        angle += AngleAt(params_[i].orbitSpeed_, time);
+    return fmod(angle, 360.0);
+}
+
+DoubleVector3 BodySystem::GetSimPositionAt(unsigned index, double time) const
+{
+    const BodyParams& params = params_[index];
+    DoubleVector3 parentPosition = params.parent_ >= 0 ? GetSimPositionAt(params.parent_, time) : DoubleVector3();
+    double radians = GetFrameAngleAt(index, time) * M_DEGTORAD;
+    return parentPosition + DoubleVector3(cos(radians), 0.0, -sin(radians)) * params.orbitRadius_;
+}
+
+DoubleVector3 BodySystem::GetSimVelocityAt(unsigned index, double time) const
+{
+    // Derivative of GetSimPositionAt: the frame angle advances at the sum of the orbital speeds up the parent chain
+    const BodyParams& params = params_[index];
+    DoubleVector3 parentVelocity = params.parent_ >= 0 ? GetSimVelocityAt(params.parent_, time) : DoubleVector3();
+    double speed = 0.0;
+    for (int i = (int)index; i >= 0; i = params_[i].parent_)
+        speed += params_[i].orbitSpeed_;
+    double radians = GetFrameAngleAt(index, time) * M_DEGTORAD;
+    return parentVelocity + DoubleVector3(-sin(radians), 0.0, -cos(radians)) * (params.orbitRadius_ * speed * M_DEGTORAD);
+}
+
+void BodySystem::UpdateTransforms()
+{
+    URHO3D_PROFILE(UpdateBodyTransforms);
+
+    HiresTimer timer;
+
+    // Parents always precede their children, so a single forward pass resolves the whole hierarchy
+    for (unsigned i = 0; i < params_.Size(); ++i)
+    {
+        const BodyParams& params = params_[i];
+
+        DoubleVector3 parentPosition;
+        double parentAngle = 0.0;
+        if (params.parent_ >= 0)
+        {
+            parentPosition = simPositions_[params.parent_];
+            parentAngle = frameAngles_[params.parent_];
+        }
+
+        // Same convention as Quaternion(angle, Vector3::UP) * Vector3(radius, 0, 0), evaluated in double precision
+        double frameAngle = fmod(parentAngle + AngleAt(params.orbitSpeed_, time_), 360.0);
+        double radians = frameAngle * M_DEGTORAD;
+        DoubleVector3 simPosition = parentPosition + DoubleVector3(cos(radians), 0.0, -sin(radians)) * params.orbitRadius_;
+
+        // Only the offset from the floating origin is narrowed to float
+        Quaternion frameRotation((float)frameAngle, Vector3::UP);
+        Vector3 position = (simPosition - origin_).ToVector3();
+
+        frameAngles_[i] = frameAngle;
+        simPositions_[i] = simPosition;
+        frameRotations_[i] = frameRotation;
+        positions_[i] = position;
+
+        if (frameNodes_[i])
+            frameNodes_[i]->SetTransform(position, frameRotation);
+
+        if (bodyNodes_[i])
+        {
+            Quaternion bodyRotation = frameRotation * Quaternion(0.0f, 0.0f, params.tilt_) *
+                Quaternion((float)AngleAt(params.spinSpeed_, time_), Vector3::UP);
+            bodyNodes_[i]->SetTransform(position, bodyRotation, params.scale_);
+        }
+    }
+
+    lastUpdateTime_ = timer.GetUSec(false);
+}
+
+bool BodySystem::UpdateOrigin()
+{
+    if (!originNode_)
+        return false;
+
+    Vector3 offset = originNode_->GetWorldPosition();
+    if (offset.Length() <= rebaseDistance_)
+        return false;
+
+    SetOrigin(origin_ + DoubleVector3(offset));
+    return true;
+}
+
+void BodySystem::SetOrigin(const DoubleVector3& origin)
+{
+    URHO3D_PROFILE(RebaseOrigin);
+
+    HiresTimer timer;
+
+    DoubleVector3 delta = origin - origin_;
+    origin_ = origin;
+
+    // Shift the other root-level nodes, their children follow. The bodies are rewritten from their simulation positions
+    // instead, so that they never accumulate rounding errors
+    Scene* scene = GetScene();
+    if (scene)
+    {
+        const Vector<SharedPtr<Node> >& children = scene->GetChildren();
+        for (unsigned i = 0; i < children.Size(); ++i)
+        {
+            Node* child = children[i];
+            if (!managedNodes_.Contains(child))
+                child->SetPosition((DoubleVector3(child->GetPosition()) - delta).ToVector3());
+        }
+    }
+
+    UpdateTransforms();
+
+    lastRebaseTime_ = timer.GetUSec(false);
+    ++numRebases_;
+}
+
+String BodySystem::BuildReport() const
+{
+    String report;
+    Telemetry::AddLine(report, "origin.rebases", numRebases_);
+    Telemetry::AddLine(report, "origin.rebase.last", (unsigned long long)lastRebaseTime_);
+    return report;
+}
+
+void BodySystem::Benchmark(Context* context)
+{
+    static const unsigned counts[] = { 1000, 5000, 20000 };
+    static const unsigned NUM_FRAMES = 600;
+    // Display units per astronomical unit at true scale, Earth being drawn with a radius of 0.15
+    static const double UNITS_PER_AU = 0.15 * 149597870.7 / 6371.0;
+
+    for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        for (unsigned floating = 0; floating < 2; ++floating)
+        {
+            SharedPtr<Scene> scene(new Scene(context));
+            BodySystem* bodySystem = scene->CreateComponent<BodySystem>();
+            Node* cameraNode = scene->CreateChild("Camera");
+            bodySystem->SetOriginNode(cameraNode);
+            bodySystem->SetRebaseDistance(floating ? DEFAULT_REBASE_DISTANCE : M_INFINITY);
+
+            // Planets out to Neptune, every other body being a moon of the previous planet
+            SetRandomSeed(c + 1);
+            for (unsigned i = 0; i < counts[c]; ++i)
+            {
+                BodyParams params;
+                if (i % 2)
+                {
+                    params.parent_ = i - 1;
+                    params.orbitRadius_ = Random(0.5f, 2.0f);
+                    params.orbitSpeed_ = Random(-100.0f, -20.0f);
+                }
+                else
+                {
+                    params.orbitRadius_ = (float)(Random(0.4f, 30.0f) * UNITS_PER_AU);
+                    params.orbitSpeed_ = Random(-50.0f, -0.3f);
+                }
+                params.spinSpeed_ = -30.0f;
+                params.scale_ = 0.3f;
+                bodySystem->AddBody(params, 0, scene->CreateChild("Body"));
+            }
+
+            // Follow the outermost planet's moon from one unit above the planet
+            unsigned tracked = 0;
+            for (unsigned i = 0; i < counts[c]; i += 2)
+            {
+                if (bodySystem->GetParams(i).orbitRadius_ > bodySystem->GetParams(tracked).orbitRadius_)
+                    tracked = i;
+            }
+
+            long long updateTotal = 0;
+            long long updateMax = 0;
+            long long rebaseTotal = 0;
+            long long rebaseMax = 0;
+            unsigned numRebases = 0;
+            double errorMax = 0.0;
+
+            for (unsigned frame = 0; frame < NUM_FRAMES; ++frame)
+            {
+                bodySystem->Update(1.0f / 60.0f);
+                updateTotal += bodySystem->GetLastUpdateTime();
+                updateMax = Max(updateMax, bodySystem->GetLastUpdateTime());
+
+                DoubleVector3 cameraPosition = bodySystem->GetSimPosition(tracked) + DoubleVector3(0.0, 1.0, 0.0);
+                cameraNode->SetPosition((cameraPosition - bodySystem->GetOrigin()).ToVector3());
+                if (bodySystem->UpdateOrigin())
+                {
+                    rebaseTotal += bodySystem->GetLastRebaseTime();
+                    rebaseMax = Max(rebaseMax, bodySystem->GetLastRebaseTime());
+                    ++numRebases;
+                }
+
+                // What reaches the GPU is the node position relative to the camera node
+                Vector3 renderOffset = bodySystem->GetWorldPosition(tracked + 1) - cameraNode->GetWorldPosition();
+                DoubleVector3 exactOffset = bodySystem->GetSimPosition(tracked + 1) - cameraPosition;
+                errorMax = Max(errorMax, (DoubleVector3(renderOffset) - exactOffset).Length());
+            }
+
+            printf("bodies %u %s origin: update avg=%.1f us max=%lld us, rebases=%u avg=%.1f us max=%lld us, "
+                "camera-relative error max=%g\n", counts[c], floating ? "floating" : "fixed",
+                (float)updateTotal / NUM_FRAMES, updateMax, numRebases, numRebases ? (float)rebaseTotal / numRebases : 0.0f,
+                rebaseMax, errorMax);
+        }
+    }
+}
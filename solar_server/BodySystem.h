@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Scene/LogicComponent.h>
+
+#include "DoubleVector3.h"
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+/// Orbital parameters of a body, expressed in the orbital frame of its parent.
+struct BodyParams
+{
+    /// Construct with defaults: a body at rest on the sun.
+    BodyParams() :
+        parent_(-1),
+        orbitRadius_(0.0f),
+        orbitSpeed_(0.0f),
+        tilt_(0.0f),
+        spinSpeed_(0.0f),
+        scale_(1.0f)
+    {
+    }
+
+    /// Index of the parent body, or -1 when the body orbits the sun.
+    int parent_;
+    /// Distance to the parent along the X axis of the orbital frame.
+    float orbitRadius_;
+    /// Orbital angular speed in degrees per second (around Y).
+    float orbitSpeed_;
+    /// Axial tilt in degrees (around Z).
+    float tilt_;
+    /// Spin angular speed in degrees per second (around the tilted Y axis).
+    float spinSpeed_;
+    /// Uniform scale of the body node.
+    float scale_;
+};
+
+/// Computes the world transforms of every orbiting body in one linear pass.
+/// Replaces the Orbit -> Pos -> Inclined -> Body -> PosRot node chains: each body owns at most two root-level nodes, an
+/// optional frame node (position and orbital rotation, used as attachment point for lights and cameras) and an optional
+/// body node (frame rotation combined with tilt, spin and scale, carrying the drawable).
+/// Angles are evaluated in closed form from a double-precision simulation clock, so that any time scale costs the same
+/// and seeking to any epoch takes one pass. Positions are simulated in double precision around the sun and handed to the nodes relative to a floating origin,
+/// which is rebased on the origin node (the camera) when it moves too far. Node positions therefore stay small floats
+/// close to the viewer, even with true-scale distances.
+class BodySystem : public LogicComponent
+{
+    URHO3D_OBJECT(BodySystem, LogicComponent);
+
+public:
+    /// Construct.
+    BodySystem(Context* context);
+
+    /// Add a body and return its index. The parent must have been added before.
+    unsigned AddBody(const BodyParams& params, Node* frameNode, Node* bodyNode);
+    /// Replace the parameters of a body, keeping its parent. Takes effect at the next transform pass.
+    void SetParams(unsigned index, const BodyParams& params);
+    /// Handle scene update: advance the simulation clock by the scaled time step. Called by LogicComponent base class.
+    virtual void Update(float timeStep);
+    /// Recompute the world transforms at the current simulation time and write them to the nodes.
+    void UpdateTransforms();
+    /// Set the simulation time in seconds and move every body there.
+    void SetTime(double time);
+    /// Set the simulation seconds per real second, clamped to +/- MAX_TIME_SCALE. Negative runs backwards.
+    void SetTimeScale(double scale);
+    /// Rebase the floating origin on the origin node if it is further than the rebase distance. Return true if rebased.
+    bool UpdateOrigin();
+
+    /// Set the node the floating origin follows, normally the camera.
+    void SetOriginNode(Node* node) { originNode_ = node; }
+    /// Set the distance from the origin past which the origin node triggers a rebase.
+    void SetRebaseDistance(float distance) { rebaseDistance_ = distance; }
+    /// Move the floating origin to a simulation position. Shifts the other root-level nodes and rewrites the bodies.
+    void SetOrigin(const DoubleVector3& origin);
+
+    /// Return number of bodies.
+    unsigned GetNumBodies() const { return params_.Size(); }
+    /// Return body parameters.
+    const BodyParams& GetParams(unsigned index) const { return params_[index]; }
+    /// Return cached world position of a body, relative to the floating origin.
+    const Vector3& GetWorldPosition(unsigned index) const { return positions_[index]; }
+    /// Return cached simulation position of a body, relative to the sun.
+    const DoubleVector3& GetSimPosition(unsigned index) const { return simPositions_[index]; }
+    /// Return the simulation position of a body at any time, relative to the sun.
+    DoubleVector3 GetSimPositionAt(unsigned index, double time) const;
+    /// Return the simulation velocity of a body at any time, relative to the sun, in units per second.
+    DoubleVector3 GetSimVelocityAt(unsigned index, double time) const;
+    /// Return the orbital frame angle of a body at any time, in degrees.
+    double GetFrameAngleAt(unsigned index, double time) const;
+    /// Return the simulation time in seconds.
+    double GetTime() const { return time_; }
+    /// Return the simulation seconds per real second.
+    double GetTimeScale() const { return timeScale_; }
+    /// Return the simulation position of the floating origin.
+    const DoubleVector3& GetOrigin() const { return origin_; }
+    /// Return cached world rotation of a body's orbital frame.
+    const Quaternion& GetFrameRotation(unsigned index) const { return frameRotations_[index]; }
+    /// Return frame node of a body, may be null.
+    Node* GetFrameNode(unsigned index) const { return frameNodes_[index]; }
+    /// Return body node of a body, may be null.
+    Node* GetBodyNode(unsigned index) const { return bodyNodes_[index]; }
+    /// Return duration of the last transform pass in microseconds.
+    long long GetLastUpdateTime() const { return lastUpdateTime_; }
+    /// Return duration of the last rebase in microseconds, transform pass included.
+    long long GetLastRebaseTime() const { return lastRebaseTime_; }
+    /// Return the number of floating origin moves since startup.
+    unsigned long long GetNumRebases() const { return numRebases_; }
+    /// Build the origin moves and the last rebase time as "<key> <value>" lines for the telemetry report.
+    String BuildReport() const;
+
+    /// Largest time scale.
+    static const double MAX_TIME_SCALE;
+
+    /// Track a body across true-scale distances with thousands of bodies and print update and rebase times, and the
+    /// camera-relative position error with and without the floating origin.
+    static void Benchmark(Context* context);
+
+private:
+    /// Body parameters.
+    Vector<BodyParams> params_;
+    /// Cached orbital frame angles in degrees. Orbits lie in the ecliptic, so frame rotations are pure yaw and add up.
+    PODVector<double> frameAngles_;
+    /// Cached simulation positions.
+    PODVector<DoubleVector3> simPositions_;
+    /// Cached world positions, relative to the floating origin.
+    PODVector<Vector3> positions_;
+    /// Cached world rotations of the orbital frames.
+    PODVector<Quaternion> frameRotations_;
+    /// Frame nodes.
+    PODVector<Node*> frameNodes_;
+    /// Body nodes.
+    PODVector<Node*> bodyNodes_;
+    /// Frame and body nodes, skipped when shifting the other root-level nodes.
+    HashSet<Node*> managedNodes_;
+    /// Node the floating origin follows.
+    WeakPtr<Node> originNode_;
+    /// Simulation position of the floating origin.
+    DoubleVector3 origin_;
+    /// Distance from the origin past which the origin node triggers a rebase.
+    float rebaseDistance_;
+    /// Simulation time in seconds.
+    double time_;
+    /// Simulation seconds per real second.
+    double timeScale_;
+    /// Duration of the last transform pass in microseconds.
+    long long lastUpdateTime_;
+    /// Duration of the last rebase in microseconds.
+    long long lastRebaseTime_;
+    /// Floating origin moves since startup.
+    unsigned long long numRebases_;
+};
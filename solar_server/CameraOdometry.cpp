@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/IO/Deserializer.h>
+#include <Urho3D/Math/MathDefs.h>
+
+#include "CameraOdometry.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Return whether a value is neither infinite nor NaN: both give NaN once multiplied by zero.
+static bool IsFinite(float value)
+{
+    return !IsNaN(value * 0.0f);
+}
+
+CameraOdometry::CameraOdometry() :
+    yaw_(0.0f),
+    right_(Vector2::ZERO),
+    up_(0.0f),
+    upTurned_(Vector2::ZERO),
+    forward_(0.0f),
+    forwardTurned_(Vector2::ZERO)
+{
+}
+
+bool CameraOdometry::Read(Deserializer& source)
+{
+    yaw_ = source.ReadFloat();
+    right_ = source.ReadVector2();
+    up_ = source.ReadFloat();
+    upTurned_ = source.ReadVector2();
+    forward_ = source.ReadFloat();
+    forwardTurned_ = source.ReadVector2();
+
+    return IsFinite(yaw_) && IsFinite(right_.x_) && IsFinite(right_.y_) && IsFinite(up_) && IsFinite(upTurned_.x_) &&
+        IsFinite(upTurned_.y_) && IsFinite(forward_) && IsFinite(forwardTurned_.x_) && IsFinite(forwardTurned_.y_);
+}
+
+Vector3 CameraOdometry::GetDisplacement(float pitch) const
+{
+    // the pitch turns the up and forward velocities within the vertical plane of the camera, then the yaw turns that
+    // plane: only the horizontal part of up and forward follows the turned forward axis
+    float sinPitch = Sin(pitch);
+    float cosPitch = Cos(pitch);
+    Vector2 horizontal = right_ + upTurned_ * sinPitch + forwardTurned_ * cosPitch;
+    return Vector3(horizontal.x_, up_ * cosPitch - forward_ * sinPitch, horizontal.y_);
+}
+
+CameraSegment::CameraSegment() :
+    start_(0)
+{
+}
+
+bool CameraSegment::Read(Deserializer& source)
+{
+    start_ = source.ReadUInt();
+    return odometry_.Read(source);
+}
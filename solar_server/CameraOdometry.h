@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Math/Vector2.h>
+#include <Urho3D/Math/Vector3.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Deserializer;
+
+}
+
+/// Camera motion integrated by a controller since the start of a motion segment, in full deflection seconds. The
+/// controller integrates its velocity at its own rate and sends the result with each camera update; the walls place
+/// the camera from it rather than integrating the velocity over their own frames, so that lost packets and frames of
+/// different lengths do not leave them in different places. A move depends on the yaw turned since the start of the
+/// segment and on the pitch, which only the walls know: each velocity is integrated alone, and along the turned
+/// horizontal axes where the turn matters, so that the walls rebuild the displacement for any pitch.
+struct CameraOdometry
+{
+    /// Construct at the start of a segment.
+    CameraOdometry();
+
+    /// Read from a camera update. Return false if a value is not finite.
+    bool Read(Deserializer& source);
+    /// Return the displacement for a pitch in degrees, in the space of the camera yaw at the start of the segment.
+    Vector3 GetDisplacement(float pitch) const;
+
+    /// Turn, integrated yaw rate times the turn speed of the walls, in degrees.
+    float yaw_;
+    /// Right velocity along the turned right axis, x and z.
+    Vector2 right_;
+    /// Up velocity.
+    float up_;
+    /// Up velocity along the turned forward axis, x and z.
+    Vector2 upTurned_;
+    /// Forward velocity.
+    float forward_;
+    /// Forward velocity along the turned forward axis, x and z.
+    Vector2 forwardTurned_;
+};
+
+/// Motion segment of a controller. A segment starts when the camera starts moving and every quarter of a second while
+/// it moves, and is identified by its start time on the clock shared by the controllers.
+struct CameraSegment
+{
+    /// Construct.
+    CameraSegment();
+
+    /// Read the start time and the motion. Return false if a value is not finite.
+    bool Read(Deserializer& source);
+
+    /// Start time in ms.
+    unsigned start_;
+    /// Motion since the start.
+    CameraOdometry odometry_;
+};
@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Scene/Node.h>
+
+#include "CameraRig.h"
+
+#include <Urho3D/DebugNew.h>
+
+const float CameraRig::MIN_FLIGHT_DURATION = 1.5f;
+const float CameraRig::MAX_FLIGHT_DURATION = 6.0f;
+const float CameraRig::STEP_EASING = 0.08f;
+
+/// Height of the arc above the straight path, as a fraction of the distance.
+static const float ARC_HEIGHT = 0.3f;
+/// Displacement and turn below which the easing is over.
+static const float EASING_EPSILON = 1e-4f;
+
+CameraRig::CameraRig() :
+    flightStart_(0.0f),
+    flightDuration_(0.0f),
+    pendingMove_(Vector3::ZERO),
+    pendingYaw_(0.0f)
+{
+}
+
+void CameraRig::FlyTo(Node* target, float startTime, float duration)
+{
+    if (!camera_ || !target)
+        return;
+
+    // pending steps belong to the former view; a flight cut short leaves its destination unused
+    pendingMove_ = Vector3::ZERO;
+    if (target_)
+    {
+        if (target_ != target)
+            RemoveIfUnused(target_);
+    }
+    else
+        previousParent_ = camera_->GetParent();
+
+    target_ = target;
+    rotation_ = camera_->GetWorldRotation();
+    flightStart_ = startTime;
+
+    // in the space of the destination: start at the camera, end at the origin, control points lifted along the
+    // destination up axis so that the camera arcs over the orbital plane
+    Vector3 start = target->WorldToLocal(camera_->GetWorldPosition());
+    float distance = start.Length();
+    Vector3 lift = Vector3::UP * distance * ARC_HEIGHT;
+    path_[0] = start;
+    path_[1] = start * (2.0f / 3.0f) + lift;
+    path_[2] = start * (1.0f / 3.0f) + lift;
+    path_[3] = Vector3::ZERO;
+
+    float worldDistance = (camera_->GetWorldPosition() - target->GetWorldPosition()).Length();
+    flightDuration_ = duration > 0.0f ? duration : GetFlightDuration(worldDistance);
+}
+
+void CameraRig::Step(const Vector3& move)
+{
+    if (IsFlying())
+        Land();
+    pendingMove_ += move;
+}
+
+void CameraRig::Turn(float angle)
+{
+    if (IsFlying())
+        Land();
+    pendingYaw_ += angle;
+}
+
+void CameraRig::Update(float time, float timeStep, float pitch, float yaw)
+{
+    if (!camera_)
+        return;
+
+    if (target_)
+    {
+        // a wall that got the preset late catches up on the path instead of flying behind the others
+        float flightTime = Max(time - flightStart_, 0.0f);
+        if (flightTime >= flightDuration_)
+            Land();
+        else
+        {
+            // smoothstep: leaves and arrives at rest
+            float t = flightTime / flightDuration_;
+            t = t * t * (3.0f - 2.0f * t);
+            camera_->SetWorldPosition(target_->LocalToWorld(EvaluatePath(t)));
+            camera_->SetWorldRotation(rotation_);
+        }
+    }
+
+    // exponential easing of the steps and turns, independent of the frame rate
+    float fraction = 1.0f - expf(-timeStep / STEP_EASING);
+    if (pendingMove_ != Vector3::ZERO)
+    {
+        Vector3 move = pendingMove_.LengthSquared() < EASING_EPSILON ? pendingMove_ : pendingMove_ * fraction;
+        camera_->Translate(move, TS_PARENT);
+        pendingMove_ -= move;
+    }
+    if (pendingYaw_ != 0.0f)
+    {
+        pendingYaw_ = Abs(pendingYaw_) < EASING_EPSILON ? 0.0f : pendingYaw_ * (1.0f - fraction);
+        camera_->SetRotation(Quaternion(pitch, yaw - pendingYaw_, 0.0f));
+    }
+}
+
+void CameraRig::Land()
+{
+    if (!camera_ || !target_)
+        return;
+
+    camera_->SetParent(target_);
+    camera_->SetPosition(Vector3::ZERO);
+    camera_->SetWorldRotation(rotation_);
+
+    // the former preset node only held the camera
+    if (previousParent_ != target_)
+        RemoveIfUnused(previousParent_);
+
+    target_.Reset();
+    previousParent_.Reset();
+}
+
+void CameraRig::Stop()
+{
+    RemoveIfUnused(target_);
+    target_.Reset();
+    previousParent_.Reset();
+    pendingMove_ = Vector3::ZERO;
+    pendingYaw_ = 0.0f;
+}
+
+float CameraRig::GetFlightDuration(float distance)
+{
+    return Clamp(MIN_FLIGHT_DURATION + 0.75f * logf(1.0f + distance), MIN_FLIGHT_DURATION, MAX_FLIGHT_DURATION);
+}
+
+void CameraRig::RemoveIfUnused(Node* node)
+{
+    if (node && node->GetName().StartsWith("camera_") && !node->GetNumChildren() && !node->GetNumComponents())
+        node->Remove();
+}
+
+Vector3 CameraRig::EvaluatePath(float t) const
+{
+    float u = 1.0f - t;
+    return path_[0] * (u * u * u) + path_[1] * (3.0f * u * u * t) + path_[2] * (3.0f * u * t * t) +
+        path_[3] * (t * t * t);
+}
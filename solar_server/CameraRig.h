@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Math/Quaternion.h>
+#include <Urho3D/Math/Vector3.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Node;
+
+}
+
+/// Camera motion between inputs: fly-to transitions to the camera presets and easing of the camera steps. A flight is
+/// a cubic Bezier path precomputed in the space of the destination node when the preset is chosen, from the current
+/// camera position to the destination with an arc above the orbital plane, so that the path follows the destination
+/// as it orbits and never cuts through the sun. Each frame evaluates the path at the eased flight time, the time since
+/// the start of the flight rather than the sum of the frame times: every wall gets the same preset command, starts the
+/// flight when the controller sent it and the destination moves with the simulation time, so the walls fly the same
+/// path in step without any pose sent over the network, whatever their frame rates. The world rotation of the camera
+/// is kept during the flight, as the former snapping to the preset did.
+class CameraRig
+{
+public:
+    /// Construct.
+    CameraRig();
+
+    /// Set the camera node.
+    void SetCamera(Node* camera) { camera_ = camera; }
+    /// Fly to a destination node, reparenting the camera to it on arrival. The flight starts at a time on the time base
+    /// of Update, possibly in the past. A duration of 0 picks one from the distance.
+    void FlyTo(Node* target, float startTime, float duration = 0.0f);
+    /// Ease in a camera displacement in the parent space of the camera.
+    void Step(const Vector3& move);
+    /// Ease in a turn. The caller adds the turn to its yaw at once; the rig offsets the displayed yaw by what remains.
+    void Turn(float angle);
+    /// Place the camera on the flight path at a time and advance the easing. Sets the camera rotation from pitch and
+    /// yaw while a turn is easing in.
+    void Update(float time, float timeStep, float pitch, float yaw);
+    /// End the flight now at the destination.
+    void Land();
+    /// Cancel the flight and the easing where they are.
+    void Stop();
+
+    /// Return whether a flight is in progress.
+    bool IsFlying() const { return target_ != 0; }
+    /// Return the destination of the flight, or null.
+    Node* GetTarget() const { return target_; }
+    /// Return the displacement not yet applied, in the parent space of the camera.
+    const Vector3& GetPendingMove() const { return pendingMove_; }
+    /// Return the part of the turns not yet displayed, in degrees.
+    float GetPendingYaw() const { return pendingYaw_; }
+
+    /// Return the flight duration for a distance in scene units: longer for farther destinations, within bounds.
+    static float GetFlightDuration(float distance);
+
+    /// Shortest flight in seconds.
+    static const float MIN_FLIGHT_DURATION;
+    /// Longest flight in seconds.
+    static const float MAX_FLIGHT_DURATION;
+    /// Time constant of the step and turn easing in seconds.
+    static const float STEP_EASING;
+
+private:
+    /// Return the point of the flight path at a parameter in [0, 1], in the space of the destination.
+    Vector3 EvaluatePath(float t) const;
+    /// Remove a preset node that holds nothing, such as the destination of an abandoned flight.
+    static void RemoveIfUnused(Node* node);
+
+    /// Camera node.
+    WeakPtr<Node> camera_;
+    /// Destination of the flight, null when not flying.
+    WeakPtr<Node> target_;
+    /// Parent of the camera when the flight started, removed on arrival if it was a preset node left empty.
+    WeakPtr<Node> previousParent_;
+    /// Bezier control points in the space of the destination.
+    Vector3 path_[4];
+    /// World rotation of the camera kept during the flight.
+    Quaternion rotation_;
+    /// Start time of the flight.
+    float flightStart_;
+    /// Flight duration.
+    float flightDuration_;
+    /// Displacement not yet applied, in the parent space of the camera.
+    Vector3 pendingMove_;
+    /// Turn not yet displayed, in degrees.
+    float pendingYaw_;
+};
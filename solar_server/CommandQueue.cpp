@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Network/Connection.h>
+
+#include "CommandQueue.h"
+#include "Telemetry.h"
+
+#include <Urho3D/DebugNew.h>
+
+CommandQueue::CommandQueue() :
+    rate_(240.0f),
+    burst_(60.0f),
+    numReceived_(0),
+    numOverLimit_(0),
+    numDrained_(0),
+    numUpdates_(0),
+    lastDepth_(0),
+    maxDepth_(0)
+{
+}
+
+void CommandQueue::SetRateLimit(float rate, float burst)
+{
+    rate_ = rate;
+    burst_ = burst;
+}
+
+bool CommandQueue::Push(Connection* connection, const String& text, unsigned time,
+    const PODVector<unsigned char>& data)
+{
+    ++numReceived_;
+
+    float now = timer_.GetUSec(false) / 1000000.0f;
+    HashMap<Connection*, Bucket>::Iterator i = buckets_.Find(connection);
+    if (i == buckets_.End())
+    {
+        Bucket bucket;
+        bucket.tokens_ = burst_;
+        bucket.time_ = now;
+        i = buckets_.Insert(MakePair(connection, bucket));
+    }
+
+    Bucket& bucket = i->second_;
+    bucket.tokens_ = Min(bucket.tokens_ + (now - bucket.time_) * rate_, burst_);
+    bucket.time_ = now;
+    bucket.senderTime_ = time;
+    bool withinLimit = bucket.tokens_ >= 1.0f;
+    if (withinLimit)
+        bucket.tokens_ -= 1.0f;
+    else
+        ++numOverLimit_;
+
+    InboundCommand command;
+    command.connection_ = connection;
+    command.text_ = text;
+    command.time_ = time;
+    command.data_ = data;
+    queue_.Push(command);
+    return withinLimit;
+}
+
+unsigned CommandQueue::GetSenderTime(Connection* connection) const
+{
+    HashMap<Connection*, Bucket>::ConstIterator i = buckets_.Find(connection);
+    return i != buckets_.End() ? i->second_.senderTime_ : Time::GetSystemTime();
+}
+
+void CommandQueue::RemoveConnection(Connection* connection)
+{
+    buckets_.Erase(connection);
+}
+
+void CommandQueue::TakeAll(Vector<InboundCommand>& dest)
+{
+    lastDepth_ = queue_.Size();
+    maxDepth_ = Max(maxDepth_, lastDepth_);
+    dest.Clear();
+    dest.Swap(queue_);
+}
+
+void CommandQueue::RecordDrain(unsigned numCommands, unsigned numUpdates)
+{
+    numDrained_ += numCommands;
+    numUpdates_ += numUpdates;
+}
+
+String CommandQueue::BuildReport() const
+{
+    String report;
+    Telemetry::AddLine(report, "input.received", numReceived_);
+    Telemetry::AddLine(report, "input.overlimit", numOverLimit_);
+    Telemetry::AddLine(report, "input.queue.depth", (unsigned long long)lastDepth_);
+    Telemetry::AddLine(report, "input.queue.max", (unsigned long long)maxDepth_);
+    Telemetry::AddLine(report, "input.updates", numUpdates_);
+    // commands per transform update or command run: above 1 when camera moves were merged
+    Telemetry::AddLine(report, "input.coalescing.ratio", numUpdates_ ? (float)numDrained_ / numUpdates_ : 1.0f);
+    return report;
+}
@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Core/Timer.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Connection;
+
+}
+
+/// Text command received from a client, waiting for the next frame.
+struct InboundCommand
+{
+    /// Sender, to reply to.
+    SharedPtr<Connection> connection_;
+    /// Command text.
+    String text_;
+    /// Time stamped by the sender in ms, the same on every wall.
+    unsigned time_;
+    /// Binary payload of a scene batch, empty for a text command.
+    PODVector<unsigned char> data_;
+};
+
+/// Inbound command queue of a wall, drained once per frame. Every command changes the show, camera steps included since
+/// they add up, so none is ever dropped: each wall would drop different ones depending on its own packet arrivals. The
+/// client limits its commands before sending them to every wall; the queue only counts, with a token bucket per
+/// connection, the commands above the rate limit. It also counts what the frame loop did with the commands, so that
+/// the coalescing of camera moves can be checked from the telemetry.
+class CommandQueue
+{
+public:
+    /// Construct.
+    CommandQueue();
+
+    /// Set the sustained commands per second and burst expected per connection.
+    void SetRateLimit(float rate, float burst);
+    /// Queue a command stamped with the time of its sender, with the payload of a binary message. Return false if the
+    /// command was above the rate limit, in which case it is queued all the same.
+    bool Push(Connection* connection, const String& text, unsigned time,
+        const PODVector<unsigned char>& data = PODVector<unsigned char>());
+    /// Return the latest time stamped by a sender in ms, to stamp its binary messages in sequence with its commands, or
+    /// the time of the wall if it sent none.
+    unsigned GetSenderTime(Connection* connection) const;
+    /// Forget the bucket of a disconnected client.
+    void RemoveConnection(Connection* connection);
+    /// Move the queued commands to dest, emptying the queue.
+    void TakeAll(Vector<InboundCommand>& dest);
+    /// Record that the commands taken this frame resulted in the given number of transform updates and commands run.
+    void RecordDrain(unsigned numCommands, unsigned numUpdates);
+
+    /// Return the number of queued commands.
+    unsigned GetDepth() const { return queue_.Size(); }
+    /// Build the metrics as "<key> <value>" lines, in the format of the telemetry report.
+    String BuildReport() const;
+
+private:
+    /// Token bucket of a connection.
+    struct Bucket
+    {
+        /// Commands that may still be sent at once.
+        float tokens_;
+        /// Time of the last refill in seconds.
+        float time_;
+        /// Latest time stamped by the sender in ms.
+        unsigned senderTime_;
+    };
+
+    /// Queued commands.
+    Vector<InboundCommand> queue_;
+    /// Token buckets per connection.
+    HashMap<Connection*, Bucket> buckets_;
+    /// Time base of the buckets.
+    HiresTimer timer_;
+    /// Sustained commands per second per connection.
+    float rate_;
+    /// Commands per connection allowed at once above the rate.
+    float burst_;
+    /// Commands received since startup.
+    unsigned long long numReceived_;
+    /// Commands above the rate limit.
+    unsigned long long numOverLimit_;
+    /// Commands drained.
+    unsigned long long numDrained_;
+    /// Transform updates and commands run for the drained commands.
+    unsigned long long numUpdates_;
+    /// Queue depth at the last drain.
+    unsigned lastDepth_;
+    /// Largest queue depth at a drain.
+    unsigned maxDepth_;
+};
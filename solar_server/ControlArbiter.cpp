@@ -0,0 +1,211 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Network/Connection.h>
+
+#include "ControlArbiter.h"
+#include "Telemetry.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstring>
+
+/// Names, default priorities and permissions of the roles, in ControlRole order.
+static const char* roleNames[] = { "observer", "script", "joystick", "docent", "operator" };
+static const int rolePriorities[] = { 0, 10, 20, 20, 30 };
+static const unsigned rolePermissions[] =
+{
+    COMMAND_QUERY,
+    COMMAND_QUERY | COMMAND_CAMERA | COMMAND_SHOW,
+    COMMAND_QUERY | COMMAND_CAMERA,
+    COMMAND_QUERY | COMMAND_CAMERA | COMMAND_SHOW,
+    COMMAND_QUERY | COMMAND_CAMERA | COMMAND_SHOW | COMMAND_ADMIN
+};
+
+ControlArbiter::ControlArbiter() :
+    owner_(0),
+    ownerTime_(0),
+    lease_(2000),
+    numRejected_(0),
+    numUngranted_(0),
+    numHandovers_(0)
+{
+}
+
+void ControlArbiter::Open(Connection* connection, const String& name)
+{
+    ControlSession session;
+    session.name_ = name;
+    session.hasCameraSequence_ = false;
+    session.cameraSequence_ = 0;
+    session.cameraVelocity_ = Vector3::ZERO;
+    session.cameraYawRate_ = 0.0f;
+    session.cameraSendTime_ = 0;
+    session.cameraTime_ = -M_INFINITY;
+    session.joystickTime_ = -M_INFINITY;
+    session.numRejected_ = 0;
+    SetRole(session, ROLE_OBSERVER);
+    sessions_[connection] = session;
+}
+
+void ControlArbiter::Close(Connection* connection)
+{
+    HashMap<Connection*, ControlSession>::Iterator i = sessions_.Find(connection);
+    if (i == sessions_.End())
+        return;
+
+    if (owner_ == &i->second_)
+        owner_ = 0;
+    sessions_.Erase(i);
+}
+
+void ControlArbiter::Grant(const String& name, ControlRole role)
+{
+    grants_[name] = role;
+}
+
+bool ControlArbiter::Hello(Connection* connection, const String& arguments)
+{
+    Vector<String> fields = arguments.Split(' ');
+    if (fields.Size() < 2)
+        return false;
+
+    ControlRole role = ParseRole(fields[1]);
+    if (role == NUM_CONTROL_ROLES)
+        return false;
+
+    // the role and priority are the word of the client: trusted only for a role the configuration gave to the name
+    HashMap<String, ControlRole>::ConstIterator grant = grants_.Find(fields[0]);
+    bool granted = grant != grants_.End() && grant->second_ == role;
+    if (!granted && role != ROLE_OBSERVER)
+        ++numUngranted_;
+
+    ControlSession* session = GetSession(connection);
+    session->name_ = fields[0];
+    SetRole(*session, granted ? role : ROLE_OBSERVER);
+    if (granted && fields.Size() > 2)
+        session->priority_ = ToInt(fields[2]);
+    return true;
+}
+
+ControlSession* ControlArbiter::GetSession(Connection* connection)
+{
+    HashMap<Connection*, ControlSession>::Iterator i = sessions_.Find(connection);
+    if (i == sessions_.End())
+    {
+        Open(connection, connection ? connection->GetAddress() : String("local"));
+        i = sessions_.Find(connection);
+    }
+    return &i->second_;
+}
+
+bool ControlArbiter::Permits(ControlSession* session, CommandClass commandClass)
+{
+    if (session->permissions_ & commandClass)
+        return true;
+
+    ++session->numRejected_;
+    ++numRejected_;
+    return false;
+}
+
+void ControlArbiter::Claim(ControlSession* session, unsigned time)
+{
+    // the times wrap around: compared by difference. Input of the owner only renews its lease
+    if (session == owner_)
+    {
+        if ((int)(time - ownerTime_) > 0)
+            ownerTime_ = time;
+        return;
+    }
+
+    // the lease compares the stamps of the input, not the local clock, so that a claim near the end of the lease
+    // gets the same answer on every wall
+    if (!owner_ || Outranks(session, owner_) || (int)(time - ownerTime_) > lease_)
+    {
+        owner_ = session;
+        ownerTime_ = time;
+        ++numHandovers_;
+    }
+}
+
+bool ControlArbiter::OwnsCamera(ControlSession* session)
+{
+    if (session == owner_)
+        return true;
+
+    ++session->numRejected_;
+    ++numRejected_;
+    return false;
+}
+
+String ControlArbiter::BuildReport() const
+{
+    String report;
+    Telemetry::AddLine(report, "control.sessions", (unsigned long long)sessions_.Size());
+    Telemetry::AddLine(report, "control.rejected", numRejected_);
+    Telemetry::AddLine(report, "control.ungranted", numUngranted_);
+    Telemetry::AddLine(report, "control.handovers", numHandovers_);
+    return report;
+}
+
+CommandClass ControlArbiter::Classify(const char* command)
+{
+    if (!strcmp(command, "telemetry") || !strcmp(command, "snapshot"))
+        return COMMAND_QUERY;
+    if (!strncmp(command, "bench ", 6) || !strcmp(command, "restore"))
+        return COMMAND_ADMIN;
+    if (!strncmp(command, "warp ", 5) || !strncmp(command, "date ", 5))
+        return COMMAND_SHOW;
+    if (command[0] && strchr("zqsdolkmftSrju", command[0]))
+        return COMMAND_CAMERA;
+    return COMMAND_SHOW;
+}
+
+ControlRole ControlArbiter::ParseRole(const String& name)
+{
+    for (unsigned i = 0; i < NUM_CONTROL_ROLES; ++i)
+    {
+        if (name == roleNames[i])
+            return (ControlRole)i;
+    }
+    return NUM_CONTROL_ROLES;
+}
+
+const char* ControlArbiter::GetRoleName(ControlRole role)
+{
+    return role < NUM_CONTROL_ROLES ? roleNames[role] : "unknown";
+}
+
+void ControlArbiter::SetRole(ControlSession& session, ControlRole role)
+{
+    session.role_ = role;
+    session.priority_ = rolePriorities[role];
+    session.permissions_ = rolePermissions[role];
+}
+
+bool ControlArbiter::Outranks(const ControlSession* a, const ControlSession* b)
+{
+    if (a->priority_ != b->priority_)
+        return a->priority_ > b->priority_;
+    return a->name_ < b->name_;
+}
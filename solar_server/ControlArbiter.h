@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Math/Vector3.h>
+
+#include "CameraOdometry.h"
+#include "JoystickChannel.h"
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Connection;
+
+}
+
+/// Role of a controller, from its "hello" command. Each role has a default priority and allowed command classes.
+enum ControlRole
+{
+    ROLE_OBSERVER = 0,
+    ROLE_SCRIPT,
+    ROLE_JOYSTICK,
+    ROLE_DOCENT,
+    ROLE_OPERATOR,
+    NUM_CONTROL_ROLES
+};
+
+/// Command classes, as a permission mask.
+enum CommandClass
+{
+    /// telemetry, snapshot: read the state, allowed to every role.
+    COMMAND_QUERY = 1,
+    /// Camera steps, presets, the camera channel and the joystick. Only the camera owner is obeyed.
+    COMMAND_CAMERA = 2,
+    /// Toggles, time and objects of the show.
+    COMMAND_SHOW = 4,
+    /// Benchmarks and snapshot restores.
+    COMMAND_ADMIN = 8
+};
+
+/// Controller connected to a wall.
+struct ControlSession
+{
+    /// Name, the same on every wall so that all walls rank the controllers alike.
+    String name_;
+    /// Role.
+    ControlRole role_;
+    /// Priority, higher wins the camera.
+    int priority_;
+    /// Allowed command classes.
+    unsigned permissions_;
+    /// Whether a camera packet was applied, so that cameraSequence_ is valid.
+    bool hasCameraSequence_;
+    /// Last camera sequence number applied.
+    unsigned cameraSequence_;
+    /// Camera channel velocity along right, up and forward.
+    Vector3 cameraVelocity_;
+    /// Camera channel turn rate.
+    float cameraYawRate_;
+    /// Shared time of the last camera packet in ms.
+    unsigned cameraSendTime_;
+    /// Motion segment of the last camera packet.
+    CameraSegment cameraSegment_;
+    /// Complete motion of the segment before it, to chain the segments when a packet is lost.
+    CameraSegment previousSegment_;
+    /// Keyframe of the last camera packet: start of the run and motion of the run up to the start of its segment, to
+    /// place the segment when whole segments were lost.
+    CameraSegment keyframe_;
+    /// Local time of the last camera packet in seconds, for the input timeout.
+    float cameraTime_;
+    /// Joystick axes streamed by the controller.
+    JoystickChannel joystick_;
+    /// Local time of the last joystick frame in seconds, for the input timeout.
+    float joystickTime_;
+    /// Commands refused by permission or arbitration.
+    unsigned numRejected_;
+};
+
+/// Camera channel input, arbitrated with the text commands in the order of their stamps.
+struct CameraClaim
+{
+    /// Sender.
+    SharedPtr<Connection> connection_;
+    /// Time stamped by the sender in ms.
+    unsigned time_;
+};
+
+/// Sessions of the controllers connected to a wall and arbitration of the camera between them. A controller gets the
+/// role it asks for in its hello only if the wall configuration grants that role to its name, and is an observer
+/// otherwise. Discrete commands are checked against the role of their sender only. The camera belongs to one controller
+/// at a time: each camera input, taken in the order of the times stamped by the controllers, hands the camera to its
+/// sender if it outranks the owner or the owner has been idle for the lease time. Ranks compare priority then name,
+/// never connection order or arrival time, and the lease compares the stamps, never the time the input reached the
+/// wall or the frame it was drained in, so that every wall picks the same owner after each input. Each input costs
+/// one hash lookup and one comparison with the owner, whatever the number of controllers.
+class ControlArbiter
+{
+public:
+    /// Construct.
+    ControlArbiter();
+
+    /// Open the session of a new connection, as an observer named after its address until it says hello.
+    void Open(Connection* connection, const String& name);
+    /// Close the session of a connection. Frees the camera if it owned it.
+    void Close(Connection* connection);
+    /// Grant a role to the controllers of a name.
+    void Grant(const String& name, ControlRole role);
+    /// Apply a "hello <name> <role> [priority]" command. The session gets the role and priority only if the role is
+    /// granted to the name, and is an observer otherwise. Return false if the role is unknown.
+    bool Hello(Connection* connection, const String& arguments);
+    /// Return the session of a connection, opening a default one if needed.
+    ControlSession* GetSession(Connection* connection);
+
+    /// Return whether the role of the session allows the command class. Counts a rejection otherwise.
+    bool Permits(ControlSession* session, CommandClass commandClass);
+    /// Arbitrate camera input of a session, stamped with the shared time in ms: renew the lease of the owner, or hand
+    /// the camera to the session if it outranks the owner or the lease has expired. Call in stamp order.
+    void Claim(ControlSession* session, unsigned time);
+    /// Return whether the session owns the camera. Counts a rejection otherwise.
+    bool OwnsCamera(ControlSession* session);
+    /// Return the camera owner, or null.
+    ControlSession* GetCameraOwner() const { return owner_; }
+    /// Return the shared time of the latest input of the camera owner in ms.
+    unsigned GetOwnerTime() const { return ownerTime_; }
+    /// Return the local time base of the input timeouts in seconds.
+    float GetTime() const { return timer_.GetUSec(false) / 1000000.0f; }
+
+    /// Set how long the owner keeps the camera after its last input.
+    void SetLease(float seconds) { lease_ = (int)(seconds * 1000.0f); }
+    /// Build the metrics as "<key> <value>" lines, in the format of the telemetry report.
+    String BuildReport() const;
+
+    /// Return the class of a text command.
+    static CommandClass Classify(const char* command);
+    /// Return the role of a name, or NUM_CONTROL_ROLES if unknown.
+    static ControlRole ParseRole(const String& name);
+    /// Return the name of a role.
+    static const char* GetRoleName(ControlRole role);
+
+private:
+    /// Give a session the defaults of a role.
+    static void SetRole(ControlSession& session, ControlRole role);
+    /// Return whether a outranks b.
+    static bool Outranks(const ControlSession* a, const ControlSession* b);
+
+    /// Sessions per connection.
+    HashMap<Connection*, ControlSession> sessions_;
+    /// Roles granted per controller name.
+    HashMap<String, ControlRole> grants_;
+    /// Camera owner.
+    ControlSession* owner_;
+    /// Shared time of the latest input of the owner in ms.
+    unsigned ownerTime_;
+    /// How long the owner keeps the camera after its last input, in ms.
+    int lease_;
+    /// Time base.
+    HiresTimer timer_;
+    /// Commands refused by permission or arbitration.
+    unsigned long long numRejected_;
+    /// Hellos asking for a role not granted to their name.
+    unsigned long long numUngranted_;
+    /// Camera hand-overs.
+    unsigned long long numHandovers_;
+};
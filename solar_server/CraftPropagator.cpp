@@ -0,0 +1,617 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "BodySystem.h"
+#include "CraftPropagator.h"
+#include "Telemetry.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+/// First step of an arc, as a fraction of its dynamical time sqrt(r^3 / mu).
+static const double INITIAL_STEP = 0.01;
+/// Smallest step, accepted whatever its error.
+static const double MIN_STEP = 1e-9;
+/// Iterations of the bisection locating a sphere of influence crossing.
+static const unsigned CROSSING_ITERATIONS = 40;
+/// Most Newton iterations of the departure shooting.
+static const unsigned MAX_SHOOTING_ITERATIONS = 10;
+/// Arrival miss, as a fraction of the sphere of influence of the arrival body, below which the shooting stops.
+static const double SHOOTING_TOLERANCE = 0.05;
+
+const double CraftPropagator::DEFAULT_TOLERANCE = 1e-10;
+
+/// Return the acceleration towards a body at the origin.
+static inline DoubleVector3 GravityAt(const DoubleVector3& position, double mu)
+{
+    double distanceSquared = position.LengthSquared();
+    return position * (-mu / (distanceSquared * sqrt(distanceSquared)));
+}
+
+/// Take a Runge-Kutta-Fehlberg 4(5) step, continuing with the fifth order solution. Return the error estimate relative
+/// to the tolerance, below 1 when the step is accurate enough.
+static double FehlbergStep(double mu, const DoubleVector3& position, const DoubleVector3& velocity, double step,
+    double tolerance, DoubleVector3& newPosition, DoubleVector3& newVelocity)
+{
+    const DoubleVector3& r = position;
+    const DoubleVector3& v = velocity;
+    double h = step;
+
+    DoubleVector3 k1r = v;
+    DoubleVector3 k1v = GravityAt(r, mu);
+    DoubleVector3 k2r = v + k1v * (h / 4.0);
+    DoubleVector3 k2v = GravityAt(r + k1r * (h / 4.0), mu);
+    DoubleVector3 k3r = v + (k1v * (3.0 / 32.0) + k2v * (9.0 / 32.0)) * h;
+    DoubleVector3 k3v = GravityAt(r + (k1r * (3.0 / 32.0) + k2r * (9.0 / 32.0)) * h, mu);
+    DoubleVector3 k4r = v + (k1v * (1932.0 / 2197.0) + k2v * (-7200.0 / 2197.0) + k3v * (7296.0 / 2197.0)) * h;
+    DoubleVector3 k4v = GravityAt(r + (k1r * (1932.0 / 2197.0) + k2r * (-7200.0 / 2197.0) + k3r * (7296.0 / 2197.0)) * h,
+        mu);
+    DoubleVector3 k5r = v + (k1v * (439.0 / 216.0) + k2v * -8.0 + k3v * (3680.0 / 513.0) + k4v * (-845.0 / 4104.0)) * h;
+    DoubleVector3 k5v = GravityAt(r + (k1r * (439.0 / 216.0) + k2r * -8.0 + k3r * (3680.0 / 513.0) +
+        k4r * (-845.0 / 4104.0)) * h, mu);
+    DoubleVector3 k6r = v + (k1v * (-8.0 / 27.0) + k2v * 2.0 + k3v * (-3544.0 / 2565.0) + k4v * (1859.0 / 4104.0) +
+        k5v * (-11.0 / 40.0)) * h;
+    DoubleVector3 k6v = GravityAt(r + (k1r * (-8.0 / 27.0) + k2r * 2.0 + k3r * (-3544.0 / 2565.0) +
+        k4r * (1859.0 / 4104.0) + k5r * (-11.0 / 40.0)) * h, mu);
+
+    newPosition = r + (k1r * (16.0 / 135.0) + k3r * (6656.0 / 12825.0) + k4r * (28561.0 / 56430.0) +
+        k5r * (-9.0 / 50.0) + k6r * (2.0 / 55.0)) * h;
+    newVelocity = v + (k1v * (16.0 / 135.0) + k3v * (6656.0 / 12825.0) + k4v * (28561.0 / 56430.0) +
+        k5v * (-9.0 / 50.0) + k6v * (2.0 / 55.0)) * h;
+
+    // Difference between the fifth and fourth order solutions
+    DoubleVector3 positionError = (k1r * (1.0 / 360.0) + k3r * (-128.0 / 4275.0) + k4r * (-2197.0 / 75240.0) +
+        k5r * (1.0 / 50.0) + k6r * (2.0 / 55.0)) * h;
+    DoubleVector3 velocityError = (k1v * (1.0 / 360.0) + k3v * (-128.0 / 4275.0) + k4v * (-2197.0 / 75240.0) +
+        k5v * (1.0 / 50.0) + k6v * (2.0 / 55.0)) * h;
+
+    // Velocities are compared with the circular speed as well, so that a craft at rest still has a scale
+    double radius = r.Length();
+    double speedScale = v.Length() + sqrt(mu / radius);
+    return Max(positionError.Length() / (tolerance * radius), velocityError.Length() / (tolerance * speedScale));
+}
+
+/// Rotate a vector perpendicular to a unit axis by an angle in radians.
+static DoubleVector3 RotateAround(const DoubleVector3& vector, const DoubleVector3& axis, double angle)
+{
+    return vector * cos(angle) + axis.CrossProduct(vector) * sin(angle);
+}
+
+/// Compute the periapsis state of a departure hyperbola from a parking radius whose outgoing asymptote follows a
+/// direction, the orbit turning around a unit normal.
+static void MakeHyperbola(double mu, double parkingRadius, double excess, const DoubleVector3& direction,
+    const DoubleVector3& normal, DoubleVector3& position, DoubleVector3& velocity)
+{
+    // The asymptote is reached at the true anomaly acos(-1 / e) past the periapsis
+    double eccentricity = 1.0 + parkingRadius * excess * excess / mu;
+    DoubleVector3 periapsis = RotateAround(direction, normal, -acos(-1.0 / eccentricity));
+    position = periapsis * parkingRadius;
+    velocity = normal.CrossProduct(periapsis) * sqrt(excess * excess + 2.0 * mu / parkingRadius);
+}
+
+CraftPropagator::CraftPropagator(Context* context) :
+    Component(context),
+    tolerance_(DEFAULT_TOLERANCE),
+    numSteps_(0),
+    numRejected_(0),
+    numTransitions_(0)
+{
+    GravityBody sun;
+    sun.body_ = -1;
+    sun.parent_ = -1;
+    sun.mu_ = 1.0;
+    sun.soiRadius_ = M_INFINITY;
+    sun.orbitRadius_ = 0.0;
+    bodies_.Push(sun);
+}
+
+CraftPropagator::~CraftPropagator()
+{
+}
+
+void CraftPropagator::SetBodySystem(BodySystem* bodySystem)
+{
+    bodySystem_ = bodySystem;
+}
+
+void CraftPropagator::SetSunGravity(double mu)
+{
+    bodies_[0].mu_ = mu;
+}
+
+unsigned CraftPropagator::AddBody(unsigned body, double massRatio)
+{
+    assert(bodySystem_);
+
+    const BodyParams& params = bodySystem_->GetParams(body);
+    unsigned parent = params.parent_ >= 0 ? GetGravityIndex(params.parent_) : 0;
+    if (parent == M_MAX_UNSIGNED)
+        return M_MAX_UNSIGNED;
+
+    GravityBody gravity;
+    gravity.body_ = body;
+    gravity.parent_ = parent;
+    gravity.mu_ = bodies_[parent].mu_ * massRatio;
+    gravity.orbitRadius_ = Abs(params.orbitRadius_);
+    gravity.soiRadius_ = gravity.orbitRadius_ * pow(massRatio, 0.4);
+
+    // A moon whose sphere sticks out of its planet's would be seen from neither
+    if (gravity.orbitRadius_ + gravity.soiRadius_ > bodies_[parent].soiRadius_)
+        return M_MAX_UNSIGNED;
+
+    bodies_.Push(gravity);
+    return bodies_.Size() - 1;
+}
+
+unsigned CraftPropagator::AddCraft(unsigned central, const DoubleVector3& position, const DoubleVector3& velocity,
+    double time)
+{
+    craft_.Resize(craft_.Size() + 1);
+    ResetCraft(craft_.Back(), central, position, velocity, time);
+    return craft_.Size() - 1;
+}
+
+void CraftPropagator::SetCraft(unsigned index, unsigned central, const DoubleVector3& position,
+    const DoubleVector3& velocity, double time)
+{
+    ResetCraft(craft_[index], central, position, velocity, time);
+}
+
+void CraftPropagator::RemoveAllCraft()
+{
+    craft_.Clear();
+}
+
+void CraftPropagator::Propagate(double time)
+{
+    URHO3D_PROFILE(PropagateCraft);
+
+    for (unsigned i = 0; i < craft_.Size(); ++i)
+        Advance(craft_[i], time);
+}
+
+void CraftPropagator::ResetCraft(Craft& craft, unsigned central, const DoubleVector3& position,
+    const DoubleVector3& velocity, double time) const
+{
+    double mu = bodies_[central].mu_;
+    double radius = position.Length();
+
+    craft.central_ = central;
+    craft.nextCentral_ = central;
+    craft.startTime_ = time;
+    craft.endTime_ = time;
+    craft.startPosition_ = position;
+    craft.startVelocity_ = velocity;
+    craft.endPosition_ = position;
+    craft.endVelocity_ = velocity;
+    craft.step_ = INITIAL_STEP * sqrt(radius * radius * radius / mu);
+    craft.energy_ = 0.5 * velocity.LengthSquared() - mu / radius;
+    craft.energyError_ = 0.0;
+}
+
+void CraftPropagator::Advance(Craft& craft, double time)
+{
+    for (unsigned i = 0; i < MAX_STEPS && craft.endTime_ < time; ++i)
+        Step(craft);
+}
+
+void CraftPropagator::Step(Craft& craft)
+{
+    double time = craft.endTime_;
+    DoubleVector3 position = craft.endPosition_;
+    DoubleVector3 velocity = craft.endVelocity_;
+
+    // After a crossing the step starts again around the new body
+    if (craft.nextCentral_ != craft.central_)
+    {
+        position += GetBodyPosition(craft.central_, time) - GetBodyPosition(craft.nextCentral_, time);
+        velocity += GetBodyVelocity(craft.central_, time) - GetBodyVelocity(craft.nextCentral_, time);
+        double energyError = craft.energyError_;
+        ResetCraft(craft, craft.nextCentral_, position, velocity, time);
+        craft.energyError_ = energyError;
+    }
+
+    craft.startTime_ = time;
+    craft.startPosition_ = position;
+    craft.startVelocity_ = velocity;
+
+    unsigned central = craft.central_;
+    double mu = bodies_[central].mu_;
+    double step = LimitStep(craft, craft.step_);
+    DoubleVector3 newPosition;
+    DoubleVector3 newVelocity;
+    double error;
+    for (;;)
+    {
+        error = FehlbergStep(mu, position, velocity, step, tolerance_, newPosition, newVelocity);
+        if (error <= 1.0 || step <= MIN_STEP)
+            break;
+        ++numRejected_;
+        step = Max(step * Max(0.9 * pow(error, -0.2), 0.2), MIN_STEP);
+    }
+
+    ++numSteps_;
+    craft.endTime_ = time + step;
+    craft.endPosition_ = newPosition;
+    craft.endVelocity_ = newVelocity;
+    craft.step_ = step * Clamp(0.9 * pow(Max(error, 1e-10), -0.2), 0.2, 5.0);
+
+    double energy = 0.5 * newVelocity.LengthSquared() - mu / newPosition.Length();
+    if (craft.energy_ != 0.0)
+        craft.energyError_ = Max(craft.energyError_, Abs((energy - craft.energy_) / craft.energy_));
+
+    // Leaving the sphere of the central body, or entering the sphere of one of its children. The step is cut at the
+    // crossing so that the interpolant stays in the frame it was integrated in
+    unsigned next = M_MAX_UNSIGNED;
+    bool leaving = false;
+    if (bodies_[central].parent_ >= 0 && newPosition.Length() > bodies_[central].soiRadius_)
+    {
+        next = bodies_[central].parent_;
+        leaving = true;
+    }
+    else
+    {
+        double radius = newPosition.Length();
+        for (unsigned i = 1; i < bodies_.Size(); ++i)
+        {
+            const GravityBody& child = bodies_[i];
+            if (child.parent_ != (int)central || Abs(radius - child.orbitRadius_) > child.soiRadius_)
+                continue;
+            DoubleVector3 offset = newPosition - (GetBodyPosition(i, craft.endTime_) - GetBodyPosition(central,
+                craft.endTime_));
+            if (offset.Length() < child.soiRadius_)
+            {
+                next = i;
+                break;
+            }
+        }
+    }
+
+    if (next != M_MAX_UNSIGNED)
+    {
+        double crossingTime = FindCrossing(craft, leaving ? central : next, leaving);
+        DoubleVector3 crossingPosition = InterpolatePosition(craft, crossingTime);
+        DoubleVector3 crossingVelocity = InterpolateVelocity(craft, crossingTime);
+        craft.endTime_ = crossingTime;
+        craft.endPosition_ = crossingPosition;
+        craft.endVelocity_ = crossingVelocity;
+        craft.nextCentral_ = next;
+        ++numTransitions_;
+    }
+}
+
+double CraftPropagator::LimitStep(const Craft& craft, double step) const
+{
+    unsigned central = craft.central_;
+    double radius = craft.startPosition_.Length();
+    double speed = craft.startVelocity_.Length();
+
+    for (unsigned i = 1; i < bodies_.Size(); ++i)
+    {
+        const GravityBody& child = bodies_[i];
+        if (child.parent_ != (int)central)
+            continue;
+        // The distance to the orbit of the child only changes as fast as the craft moves
+        if (Abs(radius - child.orbitRadius_) - child.soiRadius_ > speed * step)
+            continue;
+
+        DoubleVector3 offset = craft.startPosition_ - (GetBodyPosition(i, craft.startTime_) -
+            GetBodyPosition(central, craft.startTime_));
+        DoubleVector3 relativeVelocity = craft.startVelocity_ - (GetBodyVelocity(i, craft.startTime_) -
+            GetBodyVelocity(central, craft.startTime_));
+        double relativeSpeed = relativeVelocity.Length();
+        if (relativeSpeed > 0.0)
+            step = Min(step, Max(offset.Length() - child.soiRadius_, 0.5 * child.soiRadius_) / relativeSpeed);
+    }
+
+    return Max(step, MIN_STEP);
+}
+
+double CraftPropagator::FindCrossing(const Craft& craft, unsigned body, bool leaving) const
+{
+    // The start of the step is on the near side of the sphere and the end on the far side
+    double before = craft.startTime_;
+    double after = craft.endTime_;
+    for (unsigned i = 0; i < CROSSING_ITERATIONS; ++i)
+    {
+        double time = 0.5 * (before + after);
+        DoubleVector3 position = InterpolatePosition(craft, time);
+        if (!leaving)
+            position -= GetBodyPosition(body, time) - GetBodyPosition(craft.central_, time);
+        bool inside = position.Length() < bodies_[body].soiRadius_;
+        if (inside == leaving)
+            before = time;
+        else
+            after = time;
+    }
+    return after;
+}
+
+DoubleVector3 CraftPropagator::InterpolatePosition(const Craft& craft, double time) const
+{
+    double step = craft.endTime_ - craft.startTime_;
+    if (step <= 0.0)
+        return craft.endPosition_;
+
+    double s = Clamp((time - craft.startTime_) / step, 0.0, 1.0);
+    double s2 = s * s;
+    double s3 = s2 * s;
+    return craft.startPosition_ * (2.0 * s3 - 3.0 * s2 + 1.0) + craft.startVelocity_ * ((s3 - 2.0 * s2 + s) * step) +
+        craft.endPosition_ * (3.0 * s2 - 2.0 * s3) + craft.endVelocity_ * ((s3 - s2) * step);
+}
+
+DoubleVector3 CraftPropagator::InterpolateVelocity(const Craft& craft, double time) const
+{
+    double step = craft.endTime_ - craft.startTime_;
+    if (step <= 0.0)
+        return craft.endVelocity_;
+
+    double s = Clamp((time - craft.startTime_) / step, 0.0, 1.0);
+    double s2 = s * s;
+    return (craft.endPosition_ - craft.startPosition_) * ((6.0 * s - 6.0 * s2) / step) +
+        craft.startVelocity_ * (3.0 * s2 - 4.0 * s + 1.0) + craft.endVelocity_ * (3.0 * s2 - 2.0 * s);
+}
+
+DoubleVector3 CraftPropagator::GetBodyPosition(unsigned index, double time) const
+{
+    int body = bodies_[index].body_;
+    return body >= 0 ? bodySystem_->GetSimPositionAt(body, time) : DoubleVector3();
+}
+
+DoubleVector3 CraftPropagator::GetBodyVelocity(unsigned index, double time) const
+{
+    int body = bodies_[index].body_;
+    return body >= 0 ? bodySystem_->GetSimVelocityAt(body, time) : DoubleVector3();
+}
+
+unsigned CraftPropagator::GetGravityIndex(unsigned body) const
+{
+    for (unsigned i = 1; i < bodies_.Size(); ++i)
+    {
+        if (bodies_[i].body_ == (int)body)
+            return i;
+    }
+    return M_MAX_UNSIGNED;
+}
+
+DoubleVector3 CraftPropagator::GetSimPosition(unsigned index, double time) const
+{
+    const Craft& craft = craft_[index];
+    time = Clamp(time, craft.startTime_, craft.endTime_);
+    return InterpolatePosition(craft, time) + GetBodyPosition(craft.central_, time);
+}
+
+DoubleVector3 CraftPropagator::GetSimVelocity(unsigned index, double time) const
+{
+    const Craft& craft = craft_[index];
+    time = Clamp(time, craft.startTime_, craft.endTime_);
+    return InterpolateVelocity(craft, time) + GetBodyVelocity(craft.central_, time);
+}
+
+DoubleVector3 CraftPropagator::GetArrivalOffset(unsigned from, unsigned to, double launchTime, double flightTime,
+    const DoubleVector3& position, const DoubleVector3& velocity)
+{
+    Craft craft;
+    ResetCraft(craft, from, position, velocity, launchTime);
+    double arrivalTime = launchTime + flightTime;
+    Advance(craft, arrivalTime);
+    return InterpolatePosition(craft, arrivalTime) + GetBodyPosition(craft.central_, arrivalTime) -
+        GetBodyPosition(to, arrivalTime);
+}
+
+bool CraftPropagator::FindDeparture(unsigned from, unsigned to, double launchTime, double flightTime,
+    double parkingRadius, DoubleVector3& position, DoubleVector3& velocity)
+{
+    const GravityBody& departure = bodies_[from];
+    const GravityBody& arrival = bodies_[to];
+    if (!bodySystem_ || departure.parent_ < 0 || departure.parent_ != arrival.parent_)
+        return false;
+
+    // Orbit of the departure body around the common parent at launch
+    unsigned parent = departure.parent_;
+    DoubleVector3 bodyPosition = GetBodyPosition(from, launchTime) - GetBodyPosition(parent, launchTime);
+    DoubleVector3 bodyVelocity = GetBodyVelocity(from, launchTime) - GetBodyVelocity(parent, launchTime);
+    DoubleVector3 normal = bodyPosition.CrossProduct(bodyVelocity).Normalized();
+    DoubleVector3 prograde = bodyVelocity.Normalized();
+    DoubleVector3 radial = bodyPosition.Normalized();
+    DoubleVector3 transverse = normal.CrossProduct(radial);
+
+    // Hohmann guess: the excess velocity adds to the orbital velocity of the departure body. The unknowns are the
+    // excess speed and the turn of its direction in the orbit plane; the residual is the in-plane arrival miss
+    double mu = bodies_[parent].mu_;
+    double r1 = departure.orbitRadius_;
+    double r2 = arrival.orbitRadius_;
+    double excess = sqrt(mu * (2.0 / r1 - 2.0 / (r1 + r2))) - bodyVelocity.Length();
+    double turn = excess < 0.0 ? M_PI : 0.0;
+    excess = Abs(excess);
+
+    double bestMiss = M_INFINITY;
+    for (unsigned i = 0; i < MAX_SHOOTING_ITERATIONS; ++i)
+    {
+        DoubleVector3 trialPosition;
+        DoubleVector3 trialVelocity;
+        MakeHyperbola(departure.mu_, parkingRadius, excess, RotateAround(prograde, normal, turn), normal,
+            trialPosition, trialVelocity);
+        DoubleVector3 miss = GetArrivalOffset(from, to, launchTime, flightTime, trialPosition, trialVelocity);
+        if (miss.Length() < bestMiss)
+        {
+            bestMiss = miss.Length();
+            position = trialPosition;
+            velocity = trialVelocity;
+        }
+        if (bestMiss < SHOOTING_TOLERANCE * arrival.soiRadius_)
+            return true;
+
+        // Jacobian by forward differences
+        double excessDelta = Max(excess, 1e-3) * 1e-5;
+        double turnDelta = 1e-5;
+        MakeHyperbola(departure.mu_, parkingRadius, excess + excessDelta, RotateAround(prograde, normal, turn), normal,
+            trialPosition, trialVelocity);
+        DoubleVector3 excessMiss = GetArrivalOffset(from, to, launchTime, flightTime, trialPosition, trialVelocity);
+        MakeHyperbola(departure.mu_, parkingRadius, excess, RotateAround(prograde, normal, turn + turnDelta), normal,
+            trialPosition, trialVelocity);
+        DoubleVector3 turnMiss = GetArrivalOffset(from, to, launchTime, flightTime, trialPosition, trialVelocity);
+
+        double f0 = miss.DotProduct(radial);
+        double f1 = miss.DotProduct(transverse);
+        double a = (excessMiss.DotProduct(radial) - f0) / excessDelta;
+        double b = (turnMiss.DotProduct(radial) - f0) / turnDelta;
+        double c = (excessMiss.DotProduct(transverse) - f1) / excessDelta;
+        double d = (turnMiss.DotProduct(transverse) - f1) / turnDelta;
+        double determinant = a * d - b * c;
+        if (determinant == 0.0)
+            break;
+
+        excess = Abs(excess - (d * f0 - b * f1) / determinant);
+        turn -= (a * f1 - c * f0) / determinant;
+    }
+
+    return false;
+}
+
+String CraftPropagator::BuildReport() const
+{
+    double energyError = 0.0;
+    for (unsigned i = 0; i < craft_.Size(); ++i)
+        energyError = Max(energyError, craft_[i].energyError_);
+
+    String report;
+    Telemetry::AddLine(report, "craft.count", (unsigned long long)craft_.Size());
+    Telemetry::AddLine(report, "craft.steps", numSteps_);
+    Telemetry::AddLine(report, "craft.rejected", numRejected_);
+    Telemetry::AddLine(report, "craft.transitions", numTransitions_);
+    Telemetry::AddLine(report, "craft.energy.error.max", energyError);
+    return report;
+}
+
+void CraftPropagator::Benchmark(Context* context)
+{
+    static const unsigned counts[] = { 100, 1000, 10000 };
+    static const double tolerances[] = { 1e-6, 1e-8, 1e-10 };
+    static const unsigned NUM_FRAMES = 600;
+    static const double FRAME_TIME = 1.0 / 60.0;
+    static const double SUN_MU = 100.0;
+
+    // Planets on Keplerian circular orbits, with their masses relative to the sun
+    static const double orbitRadii[] = { 5.0, 7.5, 11.5, 17.5 };
+    static const double massRatios[] = { 3.003e-6, 3.227e-7, 9.546e-4, 2.858e-4 };
+    static const unsigned NUM_PLANETS = sizeof(orbitRadii) / sizeof(orbitRadii[0]);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    BodySystem* bodySystem = scene->CreateComponent<BodySystem>();
+    for (unsigned i = 0; i < NUM_PLANETS; ++i)
+    {
+        BodyParams params;
+        params.orbitRadius_ = (float)orbitRadii[i];
+        params.orbitSpeed_ = (float)(-sqrt(SUN_MU / (orbitRadii[i] * orbitRadii[i] * orbitRadii[i])) * M_RADTODEG);
+        bodySystem->AddBody(params, 0, 0);
+    }
+
+    for (unsigned t = 0; t < sizeof(tolerances) / sizeof(tolerances[0]); ++t)
+    {
+        for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+        {
+            CraftPropagator* propagator = scene->CreateComponent<CraftPropagator>();
+            propagator->SetBodySystem(bodySystem);
+            propagator->SetSunGravity(SUN_MU);
+            propagator->SetTolerance(tolerances[t]);
+            for (unsigned i = 0; i < NUM_PLANETS; ++i)
+                propagator->AddBody(i, massRatios[i]);
+
+            // Three quarters on solar ellipses crossing the planet orbits, the rest around the planets, some of them
+            // fast enough to escape
+            SetRandomSeed(c + 1);
+            for (unsigned i = 0; i < counts[c]; ++i)
+            {
+                double angle = Random(360.0f) * M_DEGTORAD;
+                DoubleVector3 radial(cos(angle), 0.0, -sin(angle));
+                DoubleVector3 prograde(sin(angle), Random(-0.05f, 0.05f), cos(angle));
+                if (i % 4)
+                {
+                    double axis = Random(3.0f, 20.0f);
+                    double eccentricity = Random(0.5f);
+                    double periapsis = axis * (1.0 - eccentricity);
+                    propagator->AddCraft(0, radial * periapsis,
+                        prograde * sqrt(SUN_MU * (1.0 + eccentricity) / periapsis), 0.0);
+                }
+                else
+                {
+                    unsigned planet = 1 + Rand() % NUM_PLANETS;
+                    double radius = propagator->GetSoiRadius(planet) * Random(0.2f, 0.8f);
+                    propagator->AddCraft(planet, radial * radius,
+                        prograde * (sqrt(propagator->GetGravity(planet) / radius) * Random(0.9f, 1.5f)), 0.0);
+                }
+            }
+
+            HiresTimer timer;
+            for (unsigned frame = 1; frame <= NUM_FRAMES; ++frame)
+                propagator->Propagate(frame * FRAME_TIME);
+            long long elapsed = timer.GetUSec(false);
+
+            double energyMax = 0.0;
+            double energyTotal = 0.0;
+            for (unsigned i = 0; i < counts[c]; ++i)
+            {
+                energyMax = Max(energyMax, propagator->GetEnergyError(i));
+                energyTotal += propagator->GetEnergyError(i);
+            }
+
+            printf("craft %u tolerance %g: %.0f craft-steps/s, %.1f steps per craft, rejected %.1f%%, crossings %llu, "
+                "energy drift max=%.2e mean=%.2e\n", counts[c], tolerances[t],
+                propagator->GetNumSteps() * 1000000.0 / Max(elapsed, 1LL), (double)propagator->GetNumSteps() / counts[c],
+                100.0 * propagator->GetNumRejected() / Max(propagator->GetNumSteps() + propagator->GetNumRejected(), 1ULL),
+                propagator->GetNumTransitions(), energyMax, energyTotal / counts[c]);
+
+            propagator->Remove();
+        }
+    }
+
+    // Earth to Mars transfer launched when Mars leads by the Hohmann angle, from a parking orbit at half the sphere
+    CraftPropagator* propagator = scene->CreateComponent<CraftPropagator>();
+    propagator->SetBodySystem(bodySystem);
+    propagator->SetSunGravity(SUN_MU);
+    for (unsigned i = 0; i < NUM_PLANETS; ++i)
+        propagator->AddBody(i, massRatios[i]);
+
+    double axis = 0.5 * (orbitRadii[0] + orbitRadii[1]);
+    double flightTime = M_PI * sqrt(axis * axis * axis / SUN_MU);
+    double earthSpeed = bodySystem->GetParams(0).orbitSpeed_;
+    double marsSpeed = bodySystem->GetParams(1).orbitSpeed_;
+    double lead = 180.0 - Abs(marsSpeed) * flightTime;
+    double launchTime = (360.0 - lead) / (marsSpeed - earthSpeed);
+
+    DoubleVector3 position;
+    DoubleVector3 velocity;
+    HiresTimer timer;
+    bool found = propagator->FindDeparture(1, 2, launchTime, flightTime, 0.5 * propagator->GetSoiRadius(1), position,
+        velocity);
+    long long elapsed = timer.GetUSec(false);
+    DoubleVector3 miss = propagator->GetArrivalOffset(1, 2, launchTime, flightTime, position, velocity);
+    printf("departure Earth-Mars: %s in %.2f ms, arrival miss %.3g (sphere of influence %.3g)\n",
+        found ? "converged" : "not converged", elapsed / 1000.0f, miss.Length(), propagator->GetSoiRadius(2));
+}
@@ -0,0 +1,199 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Scene/Component.h>
+
+#include "DoubleVector3.h"
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+class BodySystem;
+
+/// Spacecraft dynamics by patched conics. Every gravitating body has a sphere of influence (Laplace radius
+/// a * (m / M)^(2/5)); a craft only feels the body whose sphere it is in, and its state is integrated relative to that
+/// body by an embedded Runge-Kutta-Fehlberg 4(5) method with adaptive steps. Leaving the sphere hands the craft to the
+/// parent body, entering the sphere of a child hands it to the child; the crossing is located on the cubic Hermite
+/// interpolant of the step, which also gives the state at any time inside a step. The bodies themselves keep their
+/// closed-form circular orbits from BodySystem.
+///
+/// Steps do not depend on the times the craft are sampled at, so that every wall integrates the same trajectory
+/// whatever its frame rate. Each step is capped so that a craft can not cross more than half of a sphere of influence,
+/// and the specific orbital energy, which a two-body arc conserves, is checked after every step. Craft go through the
+/// bodies: there are no surfaces.
+class CraftPropagator : public Component
+{
+    URHO3D_OBJECT(CraftPropagator, Component);
+
+public:
+    /// Construct. The sun is gravity body 0, with a gravitational parameter of 1.
+    CraftPropagator(Context* context);
+    /// Destruct.
+    virtual ~CraftPropagator();
+
+    /// Set the body system giving the positions of the bodies. Must be set before adding bodies.
+    void SetBodySystem(BodySystem* bodySystem);
+    /// Set the gravitational parameter of the sun, in cubic units per square second. Must be set before adding bodies.
+    void SetSunGravity(double mu);
+    /// Make a body of the body system attract, with its mass relative to its parent. Return its gravity body index, or
+    /// M_MAX_UNSIGNED if its parent does not attract or its sphere of influence does not fit in its parent's.
+    unsigned AddBody(unsigned body, double massRatio);
+    /// Set the relative accuracy of a step.
+    void SetTolerance(double tolerance) { tolerance_ = tolerance; }
+
+    /// Add a craft with a state relative to a gravity body at a time. Return its index.
+    unsigned AddCraft(unsigned central, const DoubleVector3& position, const DoubleVector3& velocity, double time);
+    /// Reset a craft to a state relative to a gravity body at a time.
+    void SetCraft(unsigned index, unsigned central, const DoubleVector3& position, const DoubleVector3& velocity,
+        double time);
+    /// Remove every craft.
+    void RemoveAllCraft();
+    /// Integrate every craft until its current step covers a time. A craft can not go back before its current step.
+    void Propagate(double time);
+
+    /// Find a departure from a parking orbit of a body to arrive on a sibling body after a flight time: a hyperbola from
+    /// the parking orbit, starting from the Hohmann transfer and corrected by shooting on the arrival position. Write
+    /// the periapsis state relative to the departure body. Return false if the bodies are not siblings or the shooting
+    /// did not converge, the state being then the best found.
+    bool FindDeparture(unsigned from, unsigned to, double launchTime, double flightTime, double parkingRadius,
+        DoubleVector3& position, DoubleVector3& velocity);
+
+    /// Return the gravity body index of a body of the body system, or M_MAX_UNSIGNED if it does not attract.
+    unsigned GetGravityIndex(unsigned body) const;
+    /// Return the gravitational parameter of a gravity body.
+    double GetGravity(unsigned index) const { return bodies_[index].mu_; }
+    /// Return the sphere of influence radius of a gravity body.
+    double GetSoiRadius(unsigned index) const { return bodies_[index].soiRadius_; }
+    /// Return number of craft.
+    unsigned GetNumCraft() const { return craft_.Size(); }
+    /// Return the simulation position of a craft at a time inside its current step, relative to the sun.
+    DoubleVector3 GetSimPosition(unsigned index, double time) const;
+    /// Return the simulation velocity of a craft at a time inside its current step, relative to the sun.
+    DoubleVector3 GetSimVelocity(unsigned index, double time) const;
+    /// Return the start time of the current step of a craft, before which it can not be sampled.
+    double GetStartTime(unsigned index) const { return craft_[index].startTime_; }
+    /// Return the gravity body a craft is integrated around.
+    unsigned GetCentralBody(unsigned index) const { return craft_[index].central_; }
+    /// Return the largest relative drift of the specific orbital energy of a craft since it was set.
+    double GetEnergyError(unsigned index) const { return craft_[index].energyError_; }
+    /// Return the number of accepted steps.
+    unsigned long long GetNumSteps() const { return numSteps_; }
+    /// Return the number of rejected steps.
+    unsigned long long GetNumRejected() const { return numRejected_; }
+    /// Return the number of sphere of influence crossings.
+    unsigned long long GetNumTransitions() const { return numTransitions_; }
+    /// Build the craft count, steps, crossings and energy drift as "<key> <value>" lines for the telemetry report.
+    String BuildReport() const;
+
+    /// Print the craft-steps per second and the energy drift of 100 to 10000 craft on planetary and solar orbits, for
+    /// several tolerances, and the departure shooting of an Earth-Mars transfer.
+    static void Benchmark(Context* context);
+
+    /// Default relative accuracy of a step.
+    static const double DEFAULT_TOLERANCE;
+    /// Most steps of a craft in one Propagate call.
+    static const unsigned MAX_STEPS = 100000;
+
+private:
+    /// Gravitating body.
+    struct GravityBody
+    {
+        /// Index in the body system, -1 for the sun.
+        int body_;
+        /// Gravity body index of the parent, -1 for the sun.
+        int parent_;
+        /// Gravitational parameter.
+        double mu_;
+        /// Sphere of influence radius, infinite for the sun.
+        double soiRadius_;
+        /// Orbit radius around the parent.
+        double orbitRadius_;
+    };
+
+    /// Craft and its current step.
+    struct Craft
+    {
+        /// Gravity body of the current step.
+        unsigned central_;
+        /// Gravity body of the next step, after a sphere of influence crossing.
+        unsigned nextCentral_;
+        /// Step start time.
+        double startTime_;
+        /// Step end time.
+        double endTime_;
+        /// Step start position relative to the central body.
+        DoubleVector3 startPosition_;
+        /// Step start velocity relative to the central body.
+        DoubleVector3 startVelocity_;
+        /// Step end position relative to the central body.
+        DoubleVector3 endPosition_;
+        /// Step end velocity relative to the central body.
+        DoubleVector3 endVelocity_;
+        /// Size of the next step.
+        double step_;
+        /// Specific orbital energy at the start of the arc around the central body.
+        double energy_;
+        /// Largest relative energy drift.
+        double energyError_;
+    };
+
+    /// Set a craft to a state relative to a gravity body at a time.
+    void ResetCraft(Craft& craft, unsigned central, const DoubleVector3& position, const DoubleVector3& velocity,
+        double time) const;
+    /// Integrate a craft until its current step covers a time.
+    void Advance(Craft& craft, double time);
+    /// Take one accepted step, ending early on a sphere of influence crossing.
+    void Step(Craft& craft);
+    /// Return the step size that keeps a craft from crossing more than half of the sphere of a child of its central body.
+    double LimitStep(const Craft& craft, double step) const;
+    /// Return the time of a sphere of influence crossing inside the current step, the crossing being at the step end.
+    double FindCrossing(const Craft& craft, unsigned body, bool leaving) const;
+    /// Return the position relative to the central body on the Hermite interpolant of the current step.
+    DoubleVector3 InterpolatePosition(const Craft& craft, double time) const;
+    /// Return the velocity relative to the central body on the Hermite interpolant of the current step.
+    DoubleVector3 InterpolateVelocity(const Craft& craft, double time) const;
+    /// Return the position of a gravity body relative to the sun.
+    DoubleVector3 GetBodyPosition(unsigned index, double time) const;
+    /// Return the velocity of a gravity body relative to the sun.
+    DoubleVector3 GetBodyVelocity(unsigned index, double time) const;
+    /// Integrate a departure to the arrival time and return the position relative to the arrival body.
+    DoubleVector3 GetArrivalOffset(unsigned from, unsigned to, double launchTime, double flightTime,
+        const DoubleVector3& position, const DoubleVector3& velocity);
+
+    /// Body system.
+    WeakPtr<BodySystem> bodySystem_;
+    /// Gravitating bodies, parents first.
+    PODVector<GravityBody> bodies_;
+    /// Craft.
+    PODVector<Craft> craft_;
+    /// Relative accuracy of a step.
+    double tolerance_;
+    /// Accepted steps.
+    unsigned long long numSteps_;
+    /// Rejected steps.
+    unsigned long long numRejected_;
+    /// Sphere of influence crossings.
+    unsigned long long numTransitions_;
+};
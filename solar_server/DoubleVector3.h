@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Math/Vector3.h>
+
+#include <cmath>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+/// Double-precision three-dimensional vector for simulation coordinates. Only offsets relative to the floating origin are
+/// converted to Vector3 and handed to Urho3D.
+class DoubleVector3
+{
+public:
+    /// Construct a zero vector.
+    DoubleVector3() :
+        x_(0.0),
+        y_(0.0),
+        z_(0.0)
+    {
+    }
+
+    /// Construct from coordinates.
+    DoubleVector3(double x, double y, double z) :
+        x_(x),
+        y_(y),
+        z_(z)
+    {
+    }
+
+    /// Construct from a single-precision vector.
+    explicit DoubleVector3(const Vector3& vector) :
+        x_(vector.x_),
+        y_(vector.y_),
+        z_(vector.z_)
+    {
+    }
+
+    /// Add a vector.
+    DoubleVector3 operator +(const DoubleVector3& rhs) const { return DoubleVector3(x_ + rhs.x_, y_ + rhs.y_, z_ + rhs.z_); }
+    /// Subtract a vector.
+    DoubleVector3 operator -(const DoubleVector3& rhs) const { return DoubleVector3(x_ - rhs.x_, y_ - rhs.y_, z_ - rhs.z_); }
+    /// Multiply with a scalar.
+    DoubleVector3 operator *(double rhs) const { return DoubleVector3(x_ * rhs, y_ * rhs, z_ * rhs); }
+
+    /// Add-assign a vector.
+    DoubleVector3& operator +=(const DoubleVector3& rhs)
+    {
+        x_ += rhs.x_;
+        y_ += rhs.y_;
+        z_ += rhs.z_;
+        return *this;
+    }
+
+    /// Subtract-assign a vector.
+    DoubleVector3& operator -=(const DoubleVector3& rhs)
+    {
+        x_ -= rhs.x_;
+        y_ -= rhs.y_;
+        z_ -= rhs.z_;
+        return *this;
+    }
+
+    /// Return length.
+    double Length() const { return sqrt(x_ * x_ + y_ * y_ + z_ * z_); }
+    /// Return squared length.
+    double LengthSquared() const { return x_ * x_ + y_ * y_ + z_ * z_; }
+    /// Calculate dot product.
+    double DotProduct(const DoubleVector3& rhs) const { return x_ * rhs.x_ + y_ * rhs.y_ + z_ * rhs.z_; }
+    /// Calculate cross product.
+    DoubleVector3 CrossProduct(const DoubleVector3& rhs) const
+    {
+        return DoubleVector3(y_ * rhs.z_ - z_ * rhs.y_, z_ * rhs.x_ - x_ * rhs.z_, x_ * rhs.y_ - y_ * rhs.x_);
+    }
+    /// Return normalized to unit length.
+    DoubleVector3 Normalized() const
+    {
+        double length = Length();
+        return length > 0.0 ? *this * (1.0 / length) : *this;
+    }
+    /// Return as a single-precision vector.
+    Vector3 ToVector3() const { return Vector3((float)x_, (float)y_, (float)z_); }
+
+    /// X coordinate.
+    double x_;
+    /// Y coordinate.
+    double y_;
+    /// Z coordinate.
+    double z_;
+};
@@ -0,0 +1,308 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/Graphics/TextureCube.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/FileWatcher.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/Image.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+#include "HotReload.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+/// Frames a material waits for its new textures before it is applied anyway.
+static const unsigned MAX_TEXTURE_WAIT_FRAMES = 120;
+
+static bool IsImageName(const String& name)
+{
+    String extension = GetExtension(name);
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".dds" ||
+        extension == ".tga" || extension == ".bmp" || extension == ".ktx" || extension == ".pvr";
+}
+
+HotReload::HotReload(Context* context) :
+    Object(context),
+    numReloads_(0),
+    lastApplyTime_(0)
+{
+}
+
+HotReload::~HotReload()
+{
+    // The workers write into the loads, let them finish
+    for (unsigned i = 0; i < loads_.Size(); ++i)
+    {
+        if (!loads_[i]->item_->completed_)
+        {
+            GetSubsystem<WorkQueue>()->Complete(0);
+            break;
+        }
+    }
+    for (unsigned i = 0; i < loads_.Size(); ++i)
+        delete loads_[i];
+}
+
+bool HotReload::Start()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    const Vector<String>& dirs = cache->GetResourceDirs();
+
+    for (unsigned i = 0; i < dirs.Size(); ++i)
+    {
+        SharedPtr<FileWatcher> watcher(new FileWatcher(context_));
+        if (watcher->StartWatching(dirs[i], true))
+            watchers_.Push(watcher);
+    }
+
+    if (watchers_.Empty())
+        return false;
+
+    SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(HotReload, HandleBeginFrame));
+    SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(HotReload, HandleBackgroundLoaded));
+    return true;
+}
+
+void HotReload::SwapMaterial(StaticModel* model, const String& name)
+{
+    Swap(model, Material::GetTypeStatic(), name);
+}
+
+void HotReload::SwapModel(StaticModel* model, const String& name)
+{
+    Swap(model, Model::GetTypeStatic(), name);
+}
+
+void HotReload::Swap(StaticModel* model, StringHash type, const String& name)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Resource* resource = cache->GetExistingResource(type, name);
+    if (resource)
+    {
+        if (type == Model::GetTypeStatic())
+            model->SetModel(static_cast<Model*>(resource));
+        else
+            model->SetMaterial(static_cast<Material*>(resource));
+        return;
+    }
+
+    HotReloadSwap swap;
+    swap.model_ = model;
+    swap.type_ = type;
+    swap.name_ = name;
+    swaps_.Push(swap);
+    cache->BackgroundLoadResource(type, name);
+}
+
+void HotReload::HandleBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    const String& name = eventData[P_RESOURCENAME].GetString();
+    Resource* resource = static_cast<Resource*>(eventData[P_RESOURCE].GetPtr());
+    bool success = eventData[P_SUCCESS].GetBool();
+
+    for (unsigned i = swaps_.Size() - 1; i < swaps_.Size(); --i)
+    {
+        HotReloadSwap& swap = swaps_[i];
+        if (swap.name_ != name)
+            continue;
+
+        if (success && resource && swap.model_)
+        {
+            if (swap.type_ == Model::GetTypeStatic())
+                swap.model_->SetModel(static_cast<Model*>(resource));
+            else
+                swap.model_->SetMaterial(static_cast<Material*>(resource));
+            printf("hot reload: %s swapped in\n", name.CString());
+        }
+        else if (!success)
+            URHO3D_LOGERROR("Hot reload could not load " + name);
+        swaps_.Erase(i);
+    }
+}
+
+void HotReload::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    for (unsigned i = 0; i < watchers_.Size(); ++i)
+    {
+        String fileName;
+        while (watchers_[i]->GetNextChange(fileName))
+        {
+            StartLoad(fileName);
+
+            // the cache does not watch the files itself: tell the other users, as it would with auto reload
+            using namespace FileChanged;
+            VariantMap& changed = GetEventDataMap();
+            changed[P_FILENAME] = watchers_[i]->GetPath() + fileName;
+            changed[P_RESOURCENAME] = fileName;
+            SendEvent(E_FILECHANGED, changed);
+        }
+    }
+
+    for (unsigned i = 0; i < loads_.Size();)
+    {
+        HotReloadLoad* load = loads_[i];
+        if (!load->item_->completed_)
+        {
+            ++i;
+            continue;
+        }
+
+        HiresTimer timer;
+        if (Apply(*load))
+        {
+            lastApplyTime_ = timer.GetUSec(false);
+            printf("hot reload: %s applied in %lld us\n", load->name_.CString(), lastApplyTime_);
+            delete load;
+            loads_.Erase(i);
+        }
+        else
+            ++i;
+    }
+}
+
+void HotReload::StartLoad(const String& fileName)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    String name = cache->SanitateResourceName(fileName);
+
+    // A file saved twice in a row is read once
+    for (unsigned i = 0; i < loads_.Size(); ++i)
+    {
+        if (loads_[i]->name_ == name && !loads_[i]->item_->completed_)
+            return;
+    }
+
+    SharedPtr<Resource> resource;
+    if (name == descriptionName_)
+        resource = new XMLFile(context_);
+    else if (IsImageName(name) && cache->GetExistingResource<Texture2D>(name))
+        resource = new Image(context_);
+    else if (GetExtension(name) == ".xml" && cache->GetExistingResource<Material>(name))
+        resource = new XMLFile(context_);
+    else
+        return;
+
+    SharedPtr<File> file = cache->GetFile(name, false);
+    if (!file)
+        return;
+
+    HotReloadLoad* load = new HotReloadLoad();
+    load->name_ = name;
+    load->file_ = file;
+    load->resource_ = resource;
+    load->success_ = false;
+    load->waitFrames_ = 0;
+
+    load->item_ = new WorkItem();
+    load->item_->workFunction_ = LoadWork;
+    load->item_->aux_ = load;
+    // Lowest priority, so that the frame never waits for the disk
+    load->item_->priority_ = 0;
+    loads_.Push(load);
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue->GetNumThreads())
+        queue->AddWorkItem(load->item_);
+    else
+    {
+        LoadWork(load->item_, 0);
+        load->item_->completed_ = true;
+    }
+}
+
+bool HotReload::Apply(HotReloadLoad& load)
+{
+    if (!load.success_)
+    {
+        URHO3D_LOGERROR("Hot reload could not read " + load.name_);
+        return true;
+    }
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    if (load.name_ == descriptionName_)
+    {
+        using namespace SceneDescriptionChanged;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_FILE] = load.resource_.Get();
+        SendEvent(E_SCENEDESCRIPTIONCHANGED, eventData);
+    }
+    else if (load.resource_->GetType() == Image::GetTypeStatic())
+    {
+        // Only the upload is left for the main thread
+        Texture2D* texture = cache->GetExistingResource<Texture2D>(load.name_);
+        if (!texture || !texture->SetData(static_cast<Image*>(load.resource_.Get())))
+            return true;
+    }
+    else
+    {
+        Material* material = cache->GetExistingResource<Material>(load.name_);
+        if (!material)
+            return true;
+
+        // New textures are loaded in the background first, so that Material::Load() finds them in the cache
+        XMLElement root = static_cast<XMLFile*>(load.resource_.Get())->GetRoot();
+        bool waiting = false;
+        for (XMLElement textureElem = root.GetChild("texture"); textureElem; textureElem = textureElem.GetNext("texture"))
+        {
+            String textureName = textureElem.GetAttribute("name");
+            StringHash type = GetExtension(textureName) == ".xml" ? TextureCube::GetTypeStatic() : Texture2D::GetTypeStatic();
+            if (!textureName.Empty() && !cache->GetExistingResource(type, textureName))
+            {
+                if (!load.waitFrames_)
+                    cache->BackgroundLoadResource(type, textureName);
+                waiting = true;
+            }
+        }
+        if (waiting && ++load.waitFrames_ < MAX_TEXTURE_WAIT_FRAMES)
+            return false;
+
+        if (!material->Load(root))
+            return true;
+    }
+
+    ++numReloads_;
+    return true;
+}
+
+void HotReload::LoadWork(const WorkItem* item, unsigned threadIndex)
+{
+    HotReloadLoad* load = reinterpret_cast<HotReloadLoad*>(item->aux_);
+    load->success_ = load->resource_->Load(*load->file_);
+}
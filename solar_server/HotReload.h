@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class File;
+class FileWatcher;
+class Resource;
+class StaticModel;
+struct WorkItem;
+
+}
+
+/// Scene description file changed on disk and parsed on a worker thread.
+URHO3D_EVENT(E_SCENEDESCRIPTIONCHANGED, SceneDescriptionChanged)
+{
+    URHO3D_PARAM(P_FILE, File);                 // XMLFile pointer
+}
+
+/// Resource file being read on a worker thread.
+struct HotReloadLoad
+{
+    /// Resource name.
+    String name_;
+    /// Opened file.
+    SharedPtr<File> file_;
+    /// New copy of the resource (Image or XMLFile), loaded by the worker.
+    SharedPtr<Resource> resource_;
+    /// Work item.
+    SharedPtr<WorkItem> item_;
+    /// Whether the worker loaded the resource.
+    bool success_;
+    /// Frames spent waiting for the textures of a material.
+    unsigned waitFrames_;
+};
+
+/// Resource swap on a static model, waiting for its resource to load in the background.
+struct HotReloadSwap
+{
+    /// Target.
+    WeakPtr<StaticModel> model_;
+    /// Resource type, Model or Material.
+    StringHash type_;
+    /// Resource name.
+    String name_;
+};
+
+/// Hot reload of the scene description, materials and textures while the show runs, without restarting the servers.
+/// Watches the resource directories. A changed texture or material is read and parsed on a worker thread, then swapped
+/// into the resource already in the cache, so every user of it sees the change: the main thread only uploads the image or
+/// re-reads the parsed material. Textures a material newly refers to are background-loaded first. A changed scene
+/// description is parsed the same way and handed to the application with E_SCENEDESCRIPTIONCHANGED, which diffs it
+/// against the live scene and swaps the changed models and materials through SwapModel() and SwapMaterial(). Every
+/// changed file is also announced with E_FILECHANGED, as the cache does with auto reload.
+class HotReload : public Object
+{
+    URHO3D_OBJECT(HotReload, Object);
+
+public:
+    /// Construct.
+    HotReload(Context* context);
+    /// Destruct. Waits for the pending loads.
+    virtual ~HotReload();
+
+    /// Start watching the resource directories of the cache. Return true if at least one is watched.
+    bool Start();
+    /// Set the resource name of the scene description.
+    void SetDescriptionName(const String& name) { descriptionName_ = name; }
+    /// Set the material of a static model once it is loaded, without blocking the frame.
+    void SwapMaterial(StaticModel* model, const String& name);
+    /// Set the model of a static model once it is loaded, without blocking the frame.
+    void SwapModel(StaticModel* model, const String& name);
+
+    /// Return the resource name of the scene description.
+    const String& GetDescriptionName() const { return descriptionName_; }
+    /// Return the number of resources reloaded.
+    unsigned GetNumReloads() const { return numReloads_; }
+    /// Return the main-thread cost of the last reload in microseconds.
+    long long GetLastApplyTime() const { return lastApplyTime_; }
+
+private:
+    /// Poll the file watchers, start the worker loads and apply the finished ones.
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    /// Apply the background-loaded resources of the pending swaps.
+    void HandleBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+    /// Read a changed file on a worker thread if the cache holds it or it is the scene description.
+    void StartLoad(const String& name);
+    /// Swap a loaded resource in. Return false if it still waits for textures to load.
+    bool Apply(HotReloadLoad& load);
+    /// Queue a swap and background-load its resource.
+    void Swap(StaticModel* model, StringHash type, const String& name);
+    /// Read a resource from its file, on a worker thread.
+    static void LoadWork(const WorkItem* item, unsigned threadIndex);
+
+    /// Watchers of the resource directories.
+    Vector<SharedPtr<FileWatcher> > watchers_;
+    /// Loads in flight or waiting to be applied.
+    Vector<HotReloadLoad*> loads_;
+    /// Swaps waiting for their resource.
+    Vector<HotReloadSwap> swaps_;
+    /// Resource name of the scene description.
+    String descriptionName_;
+    /// Number of resources reloaded.
+    unsigned numReloads_;
+    /// Main-thread cost of the last reload in microseconds.
+    long long lastApplyTime_;
+};
@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/IO/Deserializer.h>
+#include <Urho3D/Math/MathDefs.h>
+
+#include "JoystickChannel.h"
+
+#include <Urho3D/DebugNew.h>
+
+const float JoystickChannel::DEADBAND = 0.12f;
+const float JoystickChannel::SMOOTHING = 0.02f;
+
+static float ApplyDeadband(signed char value)
+{
+    float axis = Clamp(value / 127.0f, -1.0f, 1.0f);
+    float magnitude = Abs(axis);
+    if (magnitude < JoystickChannel::DEADBAND)
+        return 0.0f;
+    float rescaled = (magnitude - JoystickChannel::DEADBAND) / (1.0f - JoystickChannel::DEADBAND);
+    return axis < 0.0f ? -rescaled : rescaled;
+}
+
+JoystickChannel::JoystickChannel()
+{
+    Reset();
+}
+
+void JoystickChannel::Reset()
+{
+    hasSequence_ = false;
+    hasKeyframe_ = false;
+    hasProbe_ = false;
+    sequence_ = 0;
+    keySequence_ = 0;
+    probeTime_ = 0;
+    numAxes_ = 0;
+    for (unsigned i = 0; i < MAX_AXES; ++i)
+    {
+        keyValues_[i] = 0;
+        targets_[i] = 0.0f;
+        smoothed_[i] = 0.0f;
+    }
+}
+
+bool JoystickChannel::Decode(Deserializer& source)
+{
+    unsigned short sequence = source.ReadUShort();
+    unsigned char header = source.ReadUByte();
+    if (hasSequence_ && (short)(sequence - sequence_) <= 0)
+        return false;
+
+    unsigned numAxes = Min((unsigned)(header & 0x0f), MAX_AXES);
+    unsigned short probeTime = (header & PROBE) ? source.ReadUShort() : 0;
+    signed char values[MAX_AXES];
+
+    if (header & KEYFRAME)
+    {
+        for (unsigned i = 0; i < numAxes; ++i)
+            values[i] = (signed char)source.ReadByte();
+        for (unsigned i = 0; i < numAxes; ++i)
+            keyValues_[i] = values[i];
+        keySequence_ = sequence;
+        hasKeyframe_ = true;
+    }
+    else
+    {
+        unsigned char distance = source.ReadUByte();
+        unsigned char mask = source.ReadUByte();
+        if (!hasKeyframe_ || (unsigned short)(sequence - distance) != keySequence_)
+            return false;
+
+        for (unsigned i = 0; i < numAxes; ++i)
+            values[i] = (signed char)(keyValues_[i] + ((mask & (1 << i)) ? source.ReadByte() : 0));
+    }
+
+    hasSequence_ = true;
+    sequence_ = sequence;
+    hasProbe_ = (header & PROBE) != 0;
+    probeTime_ = probeTime;
+    numAxes_ = numAxes;
+    for (unsigned i = 0; i < MAX_AXES; ++i)
+        targets_[i] = i < numAxes ? ApplyDeadband(values[i]) : 0.0f;
+    return true;
+}
+
+void JoystickChannel::Update(float timeStep)
+{
+    float fraction = 1.0f - expf(-timeStep / SMOOTHING);
+    for (unsigned i = 0; i < MAX_AXES; ++i)
+        smoothed_[i] += (targets_[i] - smoothed_[i]) * fraction;
+}
+
+bool JoystickChannel::IsDeflected() const
+{
+    for (unsigned i = 0; i < numAxes_; ++i)
+    {
+        if (targets_[i] != 0.0f)
+            return true;
+    }
+    return false;
+}
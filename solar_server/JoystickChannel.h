@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Deserializer;
+
+}
+
+/// Axis frames of a joystick sampled on the client, received on the unreliable channel. A frame is either a keyframe
+/// holding every axis quantized to a signed byte, or a delta frame holding the axes that changed since a recent
+/// keyframe. Deltas refer to a keyframe rather than to the previous frame, so that a lost frame never corrupts the
+/// following ones; a delta frame whose keyframe was lost is dropped until the next keyframe. The axes then go through
+/// a deadband and exponential smoothing on the wall.
+///
+/// Frame layout, little endian:
+/// - uint16 sequence number;
+/// - uint8 header: axis count in bits 0-3, keyframe bit 4, latency probe bit 5;
+/// - uint16 client time in milliseconds, if probe;
+/// - keyframe: int8 value per axis;
+/// - delta frame: uint8 distance to the keyframe sequence, uint8 mask of the changed axes, int8 delta per changed axis.
+class JoystickChannel
+{
+public:
+    /// Construct.
+    JoystickChannel();
+
+    /// Decode a frame. Return false if it is older than the last one or its keyframe is unknown.
+    bool Decode(Deserializer& source);
+    /// Advance the smoothing by a time step.
+    void Update(float timeStep);
+    /// Forget the axes and the sequence, for a new stream.
+    void Reset();
+
+    /// Return an axis after deadband and smoothing, in [-1, 1].
+    float GetAxis(unsigned index) const { return index < MAX_AXES ? smoothed_[index] : 0.0f; }
+    /// Return whether an axis is deflected beyond the deadband in the last frame.
+    bool IsDeflected() const;
+    /// Return whether the last frame carried a latency probe.
+    bool HasProbe() const { return hasProbe_; }
+    /// Return the sequence number of the last frame.
+    unsigned short GetSequence() const { return sequence_; }
+    /// Return the client time of the last probe.
+    unsigned short GetProbeTime() const { return probeTime_; }
+
+    /// Most axes per frame.
+    static const unsigned MAX_AXES = 8;
+    /// Keyframe bit of the header.
+    static const unsigned char KEYFRAME = 0x10;
+    /// Probe bit of the header.
+    static const unsigned char PROBE = 0x20;
+    /// Deflection below which an axis reads 0, the rest being rescaled to [0, 1].
+    static const float DEADBAND;
+    /// Time constant of the smoothing in seconds.
+    static const float SMOOTHING;
+
+private:
+    /// Whether a frame was decoded, so that sequence_ is valid.
+    bool hasSequence_;
+    /// Whether a keyframe was decoded, so that keyValues_ is valid.
+    bool hasKeyframe_;
+    /// Whether the last frame carried a probe.
+    bool hasProbe_;
+    /// Sequence number of the last frame.
+    unsigned short sequence_;
+    /// Sequence number of the last keyframe.
+    unsigned short keySequence_;
+    /// Client time of the last probe.
+    unsigned short probeTime_;
+    /// Number of axes.
+    unsigned numAxes_;
+    /// Quantized axes of the last keyframe.
+    signed char keyValues_[MAX_AXES];
+    /// Axes of the last frame after deadband.
+    float targets_[MAX_AXES];
+    /// Smoothed axes.
+    float smoothed_[MAX_AXES];
+};
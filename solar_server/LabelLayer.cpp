@@ -0,0 +1,434 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/IndexBuffer.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/UI/Font.h>
+#include <Urho3D/UI/FontFace.h>
+
+#include "LabelLayer.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+/// Size of the overlap grid cells in pixels.
+static const int GRID_CELL = 64;
+/// Gap between a body and its label, and between the header and the wall corner, in pixels.
+static const float LABEL_PADDING = 6.0f;
+/// Floats per glyph: four vertices of position, color and texture coordinates.
+static const unsigned FLOATS_PER_GLYPH = 4 * 6;
+/// Number of code points copied from the font.
+static const unsigned NUM_GLYPHS = 128;
+
+/// Write one glyph vertex.
+static inline void WriteVertex(float* dest, float x, float y, unsigned color, float u, float v)
+{
+    dest[0] = x;
+    dest[1] = y;
+    dest[2] = 0.0f;
+    *reinterpret_cast<unsigned*>(dest + 3) = color;
+    dest[4] = u;
+    dest[5] = v;
+}
+
+LabelLayer::LabelLayer(Context* context) :
+    Drawable(context, DRAWABLE_GEOMETRY),
+    vertexBuffer_(new VertexBuffer(context)),
+    indexBuffer_(new IndexBuffer(context)),
+    geometry_(new Geometry(context)),
+    gridWidth_(0),
+    gridHeight_(0),
+    textSize_(18.0f),
+    unitsPerAU_(1.0f),
+    rowHeight_(1.0f),
+    pixelToNdc_(Vector2::ZERO),
+    numPlaced_(0),
+    numGlyphs_(0),
+    lastLayoutTime_(0),
+    geometryDirty_(false)
+{
+    geometry_->SetVertexBuffer(0, vertexBuffer_, MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1);
+    geometry_->SetIndexBuffer(indexBuffer_);
+
+    batches_.Resize(1);
+    batches_[0].geometry_ = geometry_;
+    batches_[0].worldTransform_ = &Matrix3x4::IDENTITY;
+    batches_[0].numWorldTransforms_ = 0;
+}
+
+LabelLayer::~LabelLayer()
+{
+}
+
+void LabelLayer::UpdateBatches(const FrameInfo& frame)
+{
+    distance_ = 0.0f;
+    Layout(frame.camera_, frame.viewSize_);
+
+    batches_[0].distance_ = 0.0f;
+    batches_[0].worldTransform_ = &Matrix3x4::IDENTITY;
+    batches_[0].numWorldTransforms_ = numGlyphs_ ? 1 : 0;
+}
+
+void LabelLayer::UpdateGeometry(const FrameInfo& frame)
+{
+    geometryDirty_ = false;
+    if (!numGlyphs_)
+        return;
+
+    // Grow both buffers by powers of two; the indices never change once written
+    if (vertexBuffer_->GetVertexCount() < numGlyphs_ * 4)
+    {
+        unsigned capacity = NextPowerOfTwo(numGlyphs_);
+        vertexBuffer_->SetSize(capacity * 4, MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1, true);
+
+        PODVector<unsigned> indices(capacity * 6);
+        for (unsigned i = 0; i < capacity; ++i)
+        {
+            unsigned* quad = &indices[i * 6];
+            quad[0] = i * 4;
+            quad[1] = i * 4 + 1;
+            quad[2] = i * 4 + 2;
+            quad[3] = i * 4 + 2;
+            quad[4] = i * 4 + 3;
+            quad[5] = i * 4;
+        }
+        indexBuffer_->SetSize(capacity * 6, true);
+        indexBuffer_->SetData(&indices[0]);
+    }
+
+    vertexBuffer_->SetDataRange(&vertexData_[0], 0, numGlyphs_ * 4);
+    geometry_->SetDrawRange(TRIANGLE_LIST, 0, numGlyphs_ * 6, 0, numGlyphs_ * 4);
+}
+
+UpdateGeometryType LabelLayer::GetUpdateGeometryType()
+{
+    return geometryDirty_ ? UPDATE_MAIN_THREAD : UPDATE_NONE;
+}
+
+void LabelLayer::SetFont(Font* font, Material* material)
+{
+    glyphs_.Clear();
+    material_ = material;
+    batches_[0].material_ = material_;
+
+    FontFace* face = font ? font->GetFace(12) : 0;
+    if (!face || face->GetTextures().Empty())
+        return;
+
+    Texture2D* texture = face->GetTextures()[0];
+    if (material_)
+        material_->SetTexture(TU_DIFFUSE, texture);
+
+    // Distance field atlases hold a single page; glyphs on other pages are left out
+    Vector2 invSize(1.0f / texture->GetWidth(), 1.0f / texture->GetHeight());
+    glyphs_.Resize(NUM_GLYPHS);
+    for (unsigned c = 0; c < NUM_GLYPHS; ++c)
+    {
+        const FontGlyph* fontGlyph = face->GetGlyph(c);
+        Glyph& glyph = glyphs_[c];
+        if (!fontGlyph || fontGlyph->page_ != 0)
+        {
+            glyph.texCoords_ = Rect::ZERO;
+            glyph.offset_ = glyph.size_ = Vector2::ZERO;
+            glyph.advance_ = 0.0f;
+            continue;
+        }
+
+        glyph.texCoords_ = Rect(fontGlyph->x_ * invSize.x_, fontGlyph->y_ * invSize.y_,
+            (fontGlyph->x_ + fontGlyph->width_) * invSize.x_, (fontGlyph->y_ + fontGlyph->height_) * invSize.y_);
+        glyph.offset_ = Vector2(fontGlyph->offsetX_, fontGlyph->offsetY_);
+        glyph.size_ = Vector2(fontGlyph->width_, fontGlyph->height_);
+        glyph.advance_ = fontGlyph->advanceX_;
+    }
+    rowHeight_ = (float)Max(face->GetRowHeight(), 1);
+
+    for (unsigned i = 0; i < labels_.Size(); ++i)
+        labels_[i].width_ = MeasureText(labels_[i].text_.CString());
+}
+
+void LabelLayer::AddLabel(Node* node, const String& text, float radius, const Color& color)
+{
+    if (!node)
+        return;
+
+    Label label;
+    label.node_ = node;
+    label.text_ = text;
+    label.width_ = MeasureText(text.CString());
+    label.radius_ = radius;
+    label.color_ = color.ToUInt();
+    labels_.Push(label);
+}
+
+void LabelLayer::RemoveLabel(Node* node)
+{
+    for (unsigned i = labels_.Size() - 1; i < labels_.Size(); --i)
+    {
+        if (labels_[i].node_ == node)
+            labels_.Erase(i);
+    }
+}
+
+unsigned LabelLayer::Layout(Camera* camera, const IntVector2& viewSize)
+{
+    URHO3D_PROFILE(LayoutLabels);
+
+    HiresTimer timer;
+
+    candidates_.Clear();
+    placed_.Clear();
+    entryRects_.Clear();
+    entryNext_.Clear();
+    vertexData_.Clear();
+    numPlaced_ = 0;
+    numGlyphs_ = 0;
+    geometryDirty_ = true;
+
+    if (!camera || glyphs_.Empty() || viewSize.x_ <= 0 || viewSize.y_ <= 0)
+        return 0;
+
+    gridWidth_ = (viewSize.x_ + GRID_CELL - 1) / GRID_CELL;
+    gridHeight_ = (viewSize.y_ + GRID_CELL - 1) / GRID_CELL;
+    cellHeads_.Resize(gridWidth_ * gridHeight_);
+    for (unsigned i = 0; i < cellHeads_.Size(); ++i)
+        cellHeads_[i] = M_MAX_UNSIGNED;
+
+    const Matrix4& projection = camera->GetProjection();
+    Matrix4 viewProj = projection * camera->GetView();
+    Vector3 cameraPosition = camera->GetNode()->GetWorldPosition();
+    float halfWidth = viewSize.x_ * 0.5f;
+    float halfHeight = viewSize.y_ * 0.5f;
+    float scale = textSize_ / rowHeight_;
+    pixelToNdc_ = Vector2(1.0f / halfWidth, 1.0f / halfHeight);
+
+    // A label belongs to the wall whose view contains its anchor; the other walls drop it
+    for (unsigned i = 0; i < labels_.Size(); ++i)
+    {
+        const Label& label = labels_[i];
+        Node* node = label.node_;
+        if (!node || !node->IsEnabled())
+            continue;
+
+        Vector3 world = node->GetWorldPosition();
+        Vector4 clip = viewProj * Vector4(world, 1.0f);
+        if (clip.w_ <= 0.0f)
+            continue;
+
+        float invW = 1.0f / clip.w_;
+        float x = clip.x_ * invW;
+        float y = clip.y_ * invW;
+        if (x < -1.0f || x > 1.0f || y < -1.0f || y > 1.0f)
+            continue;
+
+        Candidate candidate;
+        candidate.distance_ = (world - cameraPosition).Length();
+        candidate.index_ = i;
+        candidate.screen_ = Vector2((x + 1.0f) * halfWidth, (1.0f - y) * halfHeight);
+        candidate.screenRadius_ = label.radius_ * projection.m11_ * invW * halfHeight;
+        candidates_.Push(candidate);
+    }
+
+    // Closest bodies are placed first and win the overlaps
+    Sort(candidates_.Begin(), candidates_.End(), CompareCandidates);
+
+    if (!header_.Empty())
+    {
+        float width = MeasureText(header_.CString()) * scale;
+        Reserve(Rect(LABEL_PADDING, LABEL_PADDING, LABEL_PADDING + width, LABEL_PADDING + textSize_));
+        EmitText(header_.CString(), LABEL_PADDING, LABEL_PADDING, scale, Color::WHITE.ToUInt());
+    }
+
+    char distanceText[32];
+    for (unsigned i = 0; i < candidates_.Size(); ++i)
+    {
+        const Candidate& candidate = candidates_[i];
+        const Label& label = labels_[candidate.index_];
+
+        sprintf(distanceText, "%.3f UA", candidate.distance_ / unitsPerAU_);
+        float width = Max(label.width_, MeasureText(distanceText)) * scale;
+        float height = 2.0f * textSize_;
+
+        // Right of the body, vertically centred, then pushed back inside the wall so that no label is cut at the edge
+        float x = Max(Min(candidate.screen_.x_ + candidate.screenRadius_ + LABEL_PADDING, viewSize.x_ - width), 0.0f);
+        float y = Max(Min(candidate.screen_.y_ - 0.5f * height, viewSize.y_ - height), 0.0f);
+        if (!Reserve(Rect(x, y, x + width, y + height)))
+            continue;
+
+        EmitText(label.text_.CString(), x, y, scale, label.color_);
+        EmitText(distanceText, x, y + textSize_, scale, (label.color_ & 0x00ffffff) | 0xb0000000);
+        ++numPlaced_;
+    }
+
+    numGlyphs_ = vertexData_.Size() / FLOATS_PER_GLYPH;
+    lastLayoutTime_ = timer.GetUSec(false);
+    return numPlaced_;
+}
+
+void LabelLayer::OnWorldBoundingBoxUpdate()
+{
+    // Drawn in screen space over every view
+    worldBoundingBox_.Define(-M_LARGE_VALUE, M_LARGE_VALUE);
+}
+
+bool LabelLayer::CompareCandidates(const Candidate& lhs, const Candidate& rhs)
+{
+    return lhs.distance_ < rhs.distance_;
+}
+
+float LabelLayer::MeasureText(const char* text) const
+{
+    float width = 0.0f;
+    if (glyphs_.Empty())
+        return width;
+
+    for (const unsigned char* c = (const unsigned char*)text; *c; ++c)
+    {
+        if (*c < NUM_GLYPHS)
+            width += glyphs_[*c].advance_;
+    }
+    return width;
+}
+
+bool LabelLayer::Reserve(const Rect& rect)
+{
+    int left = Clamp((int)rect.min_.x_ / GRID_CELL, 0, gridWidth_ - 1);
+    int right = Clamp((int)rect.max_.x_ / GRID_CELL, 0, gridWidth_ - 1);
+    int top = Clamp((int)rect.min_.y_ / GRID_CELL, 0, gridHeight_ - 1);
+    int bottom = Clamp((int)rect.max_.y_ / GRID_CELL, 0, gridHeight_ - 1);
+
+    for (int cy = top; cy <= bottom; ++cy)
+    {
+        for (int cx = left; cx <= right; ++cx)
+        {
+            for (unsigned e = cellHeads_[cy * gridWidth_ + cx]; e != M_MAX_UNSIGNED; e = entryNext_[e])
+            {
+                const Rect& other = placed_[entryRects_[e]];
+                if (rect.min_.x_ < other.max_.x_ && rect.max_.x_ > other.min_.x_ && rect.min_.y_ < other.max_.y_ &&
+                    rect.max_.y_ > other.min_.y_)
+                    return false;
+            }
+        }
+    }
+
+    unsigned index = placed_.Size();
+    placed_.Push(rect);
+    for (int cy = top; cy <= bottom; ++cy)
+    {
+        for (int cx = left; cx <= right; ++cx)
+        {
+            unsigned& head = cellHeads_[cy * gridWidth_ + cx];
+            entryRects_.Push(index);
+            entryNext_.Push(head);
+            head = entryRects_.Size() - 1;
+        }
+    }
+    return true;
+}
+
+void LabelLayer::EmitText(const char* text, float x, float y, float scale, unsigned color)
+{
+    for (const unsigned char* c = (const unsigned char*)text; *c; ++c)
+    {
+        if (*c >= NUM_GLYPHS)
+            continue;
+
+        const Glyph& glyph = glyphs_[*c];
+        if (glyph.size_.x_ > 0.0f && glyph.size_.y_ > 0.0f)
+        {
+            // Pixels, Y down, to normalized device coordinates
+            float left = (x + glyph.offset_.x_ * scale) * pixelToNdc_.x_ - 1.0f;
+            float top = 1.0f - (y + glyph.offset_.y_ * scale) * pixelToNdc_.y_;
+            float right = left + glyph.size_.x_ * scale * pixelToNdc_.x_;
+            float bottom = top - glyph.size_.y_ * scale * pixelToNdc_.y_;
+            const Rect& uv = glyph.texCoords_;
+
+            unsigned start = vertexData_.Size();
+            vertexData_.Resize(start + FLOATS_PER_GLYPH);
+            float* dest = &vertexData_[start];
+
+            WriteVertex(dest, left, top, color, uv.min_.x_, uv.min_.y_);
+            WriteVertex(dest + 6, right, top, color, uv.max_.x_, uv.min_.y_);
+            WriteVertex(dest + 12, right, bottom, color, uv.max_.x_, uv.max_.y_);
+            WriteVertex(dest + 18, left, bottom, color, uv.min_.x_, uv.max_.y_);
+        }
+
+        x += glyph.advance_ * scale;
+    }
+}
+
+void LabelLayer::Benchmark(Context* context)
+{
+    static const unsigned counts[] = { 1000, 10000, 20000 };
+    static const unsigned NUM_FRAMES = 60;
+    static const IntVector2 VIEW_SIZE(1920, 1080);
+
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+
+    for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        SharedPtr<Scene> scene(new Scene(context));
+        Node* cameraNode = scene->CreateChild("BenchmarkCamera");
+        Camera* camera = cameraNode->CreateComponent<Camera>();
+        camera->SetAspectRatio((float)VIEW_SIZE.x_ / VIEW_SIZE.y_);
+
+        LabelLayer* labels = scene->CreateChild("BenchmarkLabels")->CreateComponent<LabelLayer>();
+        labels->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.sdf"), cache->GetResource<Material>("Materials/labels.xml"));
+        labels->SetDistanceScale(5.0f);
+
+        // Bodies spread in front of the camera, like a belt seen from above the sun
+        SetRandomSeed(c + 1);
+        for (unsigned i = 0; i < counts[c]; ++i)
+        {
+            Node* node = scene->CreateChild();
+            node->SetPosition(Vector3(Random(-60.0f, 60.0f), Random(-30.0f, 30.0f), Random(5.0f, 100.0f)));
+            labels->AddLabel(node, "Asteroide " + String(i), Random(0.01f, 0.3f));
+        }
+
+        long long layoutTime = 0;
+        unsigned placed = 0;
+        unsigned glyphs = 0;
+        for (unsigned frame = 0; frame < NUM_FRAMES; ++frame)
+        {
+            labels->SetHeader("2000-01-01 x" + String(frame));
+            cameraNode->SetRotation(Quaternion(0.0f, frame * 0.2f, 0.0f));
+            placed += labels->Layout(camera, VIEW_SIZE);
+            layoutTime += labels->GetLastLayoutTime();
+            glyphs += labels->GetNumGlyphs();
+        }
+
+        printf("labels=%u layout=%.3f ms placed=%u glyphs=%u (per frame, %dx%d wall)\n", counts[c],
+            layoutTime / 1000.0 / NUM_FRAMES, placed / NUM_FRAMES, glyphs / NUM_FRAMES, VIEW_SIZE.x_, VIEW_SIZE.y_);
+    }
+}
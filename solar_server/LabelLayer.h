@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Graphics/Drawable.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Camera;
+class Font;
+class Geometry;
+class IndexBuffer;
+class Material;
+class VertexBuffer;
+
+}
+
+/// Screen-space names and distances of scene nodes, drawn with a signed distance field font.
+/// Layout runs in UpdateBatches on the view worker threads: anchors are projected, labels are sorted by distance and
+/// placed greedily, skipping those that overlap an already placed label (tested on a coarse screen grid), and are kept
+/// inside the wall of their anchor so that no label is cut at a screen edge. All glyph quads go into one dynamic vertex
+/// buffer, uploaded once per frame from the main thread and drawn in one batch. Assumes one view per frame, as on the
+/// walls.
+class LabelLayer : public Drawable
+{
+    URHO3D_OBJECT(LabelLayer, Drawable);
+
+public:
+    /// Construct.
+    LabelLayer(Context* context);
+    /// Destruct.
+    virtual ~LabelLayer();
+
+    /// Calculate distance and prepare batches for rendering. Lays out the labels for the view.
+    virtual void UpdateBatches(const FrameInfo& frame);
+    /// Upload the glyph quads of the last layout. Called from the main thread.
+    virtual void UpdateGeometry(const FrameInfo& frame);
+    /// Return whether the geometry needs an upload.
+    virtual UpdateGeometryType GetUpdateGeometryType();
+
+    /// Set the font, which should be a signed distance field font, and the material drawing it.
+    void SetFont(Font* font, Material* material);
+    /// Set text height in pixels.
+    void SetTextSize(float pixels) { textSize_ = pixels; }
+    /// Set scene units per astronomical unit, for the distance line.
+    void SetDistanceScale(float unitsPerAU) { unitsPerAU_ = unitsPerAU; }
+    /// Add a label following a node. The radius offsets the label from the anchor by the apparent size of the body.
+    void AddLabel(Node* node, const String& text, float radius, const Color& color = Color::WHITE);
+    /// Remove the labels of a node.
+    void RemoveLabel(Node* node);
+    /// Set the text shown in the top left corner of every wall, e.g. the date.
+    void SetHeader(const String& text) { header_ = text; }
+    /// Lay out the labels for a camera and view size. Return number of labels placed.
+    unsigned Layout(Camera* camera, const IntVector2& viewSize);
+
+    /// Return number of labels.
+    unsigned GetNumLabels() const { return labels_.Size(); }
+    /// Return number of labels placed by the last layout.
+    unsigned GetNumPlaced() const { return numPlaced_; }
+    /// Return number of glyphs of the last layout.
+    unsigned GetNumGlyphs() const { return numGlyphs_; }
+    /// Return duration of the last layout in microseconds.
+    long long GetLastLayoutTime() const { return lastLayoutTime_; }
+
+    /// Print layout time and placed labels for 1k to 20k labels in view.
+    static void Benchmark(Context* context);
+
+protected:
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+
+private:
+    /// Label following a node.
+    struct Label
+    {
+        /// Node.
+        WeakPtr<Node> node_;
+        /// First line.
+        String text_;
+        /// Width of the first line in font pixels.
+        float width_;
+        /// Body radius.
+        float radius_;
+        /// Packed color.
+        unsigned color_;
+    };
+
+    /// Glyph of the atlas, in font pixels.
+    struct Glyph
+    {
+        /// Texture coordinates.
+        Rect texCoords_;
+        /// Offset from the pen position to the top left corner.
+        Vector2 offset_;
+        /// Size.
+        Vector2 size_;
+        /// Pen advance.
+        float advance_;
+    };
+
+    /// Label in view, sorted by distance.
+    struct Candidate
+    {
+        /// Distance to the camera.
+        float distance_;
+        /// Label index.
+        unsigned index_;
+        /// Anchor in pixels.
+        Vector2 screen_;
+        /// Apparent body radius in pixels.
+        float screenRadius_;
+    };
+
+    /// Order candidates by distance.
+    static bool CompareCandidates(const Candidate& lhs, const Candidate& rhs);
+    /// Return width of a text in font pixels.
+    float MeasureText(const char* text) const;
+    /// Return whether a pixel rectangle is free, and reserve it if so.
+    bool Reserve(const Rect& rect);
+    /// Append the glyph quads of one line of text at a pixel position.
+    void EmitText(const char* text, float x, float y, float scale, unsigned color);
+
+    /// Glyphs of the first 128 code points, copied from the font face so that layout never touches the font.
+    PODVector<Glyph> glyphs_;
+    /// Material.
+    SharedPtr<Material> material_;
+    /// Vertex buffer.
+    SharedPtr<VertexBuffer> vertexBuffer_;
+    /// Index buffer, six indices per glyph.
+    SharedPtr<IndexBuffer> indexBuffer_;
+    /// Geometry.
+    SharedPtr<Geometry> geometry_;
+    /// Labels.
+    Vector<Label> labels_;
+    /// Labels in view, reused every layout.
+    PODVector<Candidate> candidates_;
+    /// Placed rectangles in pixels.
+    PODVector<Rect> placed_;
+    /// First entry of every grid cell, M_MAX_UNSIGNED when empty.
+    PODVector<unsigned> cellHeads_;
+    /// Placed rectangle of every grid entry.
+    PODVector<unsigned> entryRects_;
+    /// Next entry in the same cell.
+    PODVector<unsigned> entryNext_;
+    /// Glyph vertices in normalized device coordinates.
+    PODVector<float> vertexData_;
+    /// Header text.
+    String header_;
+    /// Grid cells along X.
+    int gridWidth_;
+    /// Grid cells along Y.
+    int gridHeight_;
+    /// Text height in pixels.
+    float textSize_;
+    /// Scene units per astronomical unit.
+    float unitsPerAU_;
+    /// Height of a text line in font pixels.
+    float rowHeight_;
+    /// Scale from pixels to normalized device coordinates for the current layout.
+    Vector2 pixelToNdc_;
+    /// Number of labels placed by the last layout.
+    unsigned numPlaced_;
+    /// Number of glyphs of the last layout.
+    unsigned numGlyphs_;
+    /// Duration of the last layout in microseconds.
+    long long lastLayoutTime_;
+    /// Whether the last layout has not been uploaded yet.
+    bool geometryDirty_;
+};
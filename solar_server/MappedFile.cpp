@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/MathDefs.h>
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+    data_(0),
+    size_(0),
+#ifdef _WIN32
+    fileHandle_(INVALID_HANDLE_VALUE),
+    mappingHandle_(0)
+#else
+    fd_(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const String& fileName)
+{
+    Close();
+
+#ifdef _WIN32
+    fileHandle_ = CreateFileA(fileName.CString(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (fileHandle_ == INVALID_HANDLE_VALUE)
+        return false;
+
+    size_ = GetFileSize(fileHandle_, 0);
+    if (size_ == 0 || size_ == INVALID_FILE_SIZE)
+    {
+        Close();
+        return false;
+    }
+
+    mappingHandle_ = CreateFileMappingA(fileHandle_, 0, PAGE_READONLY, 0, 0, 0);
+    if (!mappingHandle_)
+    {
+        Close();
+        return false;
+    }
+
+    data_ = (unsigned char*)MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0);
+#else
+    fd_ = open(fileName.CString(), O_RDONLY);
+    if (fd_ < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || st.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+    size_ = (unsigned)st.st_size;
+
+    void* data = mmap(0, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    data_ = data == MAP_FAILED ? 0 : (unsigned char*)data;
+#endif
+
+    if (!data_)
+    {
+        Close();
+        return false;
+    }
+
+    fileName_ = fileName;
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mappingHandle_)
+        CloseHandle(mappingHandle_);
+    if (fileHandle_ != INVALID_HANDLE_VALUE)
+        CloseHandle(fileHandle_);
+    mappingHandle_ = 0;
+    fileHandle_ = INVALID_HANDLE_VALUE;
+#else
+    if (data_)
+        munmap(data_, size_);
+    if (fd_ >= 0)
+        close(fd_);
+    fd_ = -1;
+#endif
+
+    data_ = 0;
+    size_ = 0;
+    fileName_.Clear();
+}
+
+unsigned MappedFile::GetResidentSize() const
+{
+    if (!data_)
+        return 0;
+
+#ifdef _WIN32
+    // No cheap residency query, report the whole mapping
+    return size_;
+#else
+    unsigned pageSize = (unsigned)sysconf(_SC_PAGESIZE);
+    unsigned numPages = (size_ + pageSize - 1) / pageSize;
+    PODVector<unsigned char> pages(numPages);
+#ifdef __APPLE__
+    if (mincore(data_, size_, (char*)&pages[0]) != 0)
+#else
+    if (mincore(data_, size_, &pages[0]) != 0)
+#endif
+        return size_;
+
+    unsigned resident = 0;
+    for (unsigned i = 0; i < numPages; ++i)
+    {
+        if (pages[i] & 1)
+            resident += pageSize;
+    }
+    return Min(resident, size_);
+#endif
+}
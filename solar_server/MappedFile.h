@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+/// Read-only memory mapping of a whole file. Pages are only read from disk when they are touched.
+class MappedFile
+{
+public:
+    /// Construct.
+    MappedFile();
+    /// Destruct. Unmaps the file.
+    ~MappedFile();
+
+    /// Map a file. Return true on success.
+    bool Open(const String& fileName);
+    /// Unmap the file.
+    void Close();
+
+    /// Return whether a file is mapped.
+    bool IsOpen() const { return data_ != 0; }
+    /// Return the mapped bytes.
+    const unsigned char* GetData() const { return data_; }
+    /// Return the file size.
+    unsigned GetSize() const { return size_; }
+    /// Return the file name.
+    const String& GetName() const { return fileName_; }
+    /// Return how many mapped bytes are resident in memory, i.e. were touched or already in the page cache.
+    unsigned GetResidentSize() const;
+
+private:
+    /// Prevent copy construction.
+    MappedFile(const MappedFile& rhs);
+    /// Prevent assignment.
+    MappedFile& operator =(const MappedFile& rhs);
+
+    /// File name.
+    String fileName_;
+    /// Mapped bytes.
+    unsigned char* data_;
+    /// File size.
+    unsigned size_;
+#ifdef _WIN32
+    /// File handle.
+    void* fileHandle_;
+    /// File mapping handle.
+    void* mappingHandle_;
+#else
+    /// File descriptor.
+    int fd_;
+#endif
+};
@@ -0,0 +1,324 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+
+#include "OrbitTrails.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+/// Vertex elements matching TrailVertex.
+static const unsigned TRAIL_ELEMENT_MASK = MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1;
+/// Append time of the orbit vertices, never faded.
+static const float ORBIT_TIME = M_LARGE_VALUE;
+/// Append time of unused trail vertices, always fully faded.
+static const float UNUSED_TIME = -M_LARGE_VALUE;
+
+OrbitTrails::OrbitTrails(Context* context) :
+    Drawable(context, DRAWABLE_GEOMETRY),
+    vertexBuffer_(new VertexBuffer(context)),
+    geometry_(new Geometry(context)),
+    trailLength_(256),
+    head_(0),
+    appendInterval_(0.1f),
+    appendTimer_(0.0f),
+    lastAppendSize_(0),
+    bufferDirty_(false)
+{
+    geometry_->SetVertexBuffer(0, vertexBuffer_, TRAIL_ELEMENT_MASK);
+    boundingBox_.Define(Vector3::ZERO);
+
+    batches_.Resize(1);
+    batches_[0].geometry_ = geometry_;
+    batches_[0].worldTransform_ = &Matrix3x4::IDENTITY;
+}
+
+OrbitTrails::~OrbitTrails()
+{
+}
+
+void OrbitTrails::UpdateBatches(const FrameInfo& frame)
+{
+    const BoundingBox& worldBoundingBox = GetWorldBoundingBox();
+    distance_ = frame.camera_->GetDistance(worldBoundingBox.Center());
+
+    batches_[0].distance_ = distance_;
+    batches_[0].worldTransform_ = &node_->GetWorldTransform();
+    batches_[0].numWorldTransforms_ = geometry_->GetVertexCount() ? 1 : 0;
+}
+
+void OrbitTrails::AddOrbit(float radius, const Color& color)
+{
+    unsigned start = orbitVertices_.Size();
+    orbitVertices_.Resize(start + ORBIT_SEGMENTS * 2);
+    WriteOrbit(&orbitVertices_[start], radius, color.ToUInt());
+    bufferDirty_ = true;
+}
+
+void OrbitTrails::SetOrbitRadius(unsigned index, float radius)
+{
+    unsigned start = index * ORBIT_SEGMENTS * 2;
+    if (start >= orbitVertices_.Size())
+        return;
+
+    WriteOrbit(&orbitVertices_[start], radius, orbitVertices_[start].color_);
+    // Only this orbit is uploaded, the trails in the ring are kept
+    if (vertexBuffer_ && !bufferDirty_)
+        vertexBuffer_->SetDataRange(&orbitVertices_[start], start, ORBIT_SEGMENTS * 2);
+}
+
+void OrbitTrails::WriteOrbit(TrailVertex* vertices, float radius, unsigned color)
+{
+    for (unsigned i = 0; i < ORBIT_SEGMENTS; ++i)
+    {
+        float angle0 = 360.0f * i / ORBIT_SEGMENTS;
+        float angle1 = 360.0f * (i + 1) / ORBIT_SEGMENTS;
+
+        // Same convention as the bodies: Quaternion(angle, Vector3::UP) * Vector3(radius, 0, 0)
+        TrailVertex* segment = vertices + i * 2;
+        segment[0].position_ = Vector3(radius * Cos(angle0), 0.0f, -radius * Sin(angle0));
+        segment[1].position_ = Vector3(radius * Cos(angle1), 0.0f, -radius * Sin(angle1));
+        for (unsigned j = 0; j < 2; ++j)
+        {
+            segment[j].color_ = color;
+            segment[j].time_ = Vector2(ORBIT_TIME, 0.0f);
+        }
+    }
+
+    boundingBox_.Merge(BoundingBox(Vector3(-radius, 0.0f, -radius), Vector3(radius, 0.0f, radius)));
+    OnMarkedDirty(node_);
+}
+
+unsigned OrbitTrails::AddTrail(Node* target, const Color& color)
+{
+    Trail trail;
+    trail.target_ = target;
+    trail.color_ = color.ToUInt();
+    trail.lastPosition_ = Vector3::ZERO;
+    trail.lastTime_ = UNUSED_TIME;
+    trail.started_ = false;
+    trails_.Push(trail);
+
+    bufferDirty_ = true;
+    return trails_.Size() - 1;
+}
+
+void OrbitTrails::SetTrailLength(unsigned segments)
+{
+    trailLength_ = Max(segments, 1U);
+    ClearTrails();
+}
+
+void OrbitTrails::SetMaterial(Material* material)
+{
+    batches_[0].material_ = material;
+}
+
+void OrbitTrails::Append()
+{
+    if (!node_ || trails_.Empty())
+        return;
+
+    URHO3D_PROFILE(AppendTrails);
+
+    if (bufferDirty_)
+        Rebuild();
+
+    Scene* scene = GetScene();
+    float time = scene ? scene->GetElapsedTime() : 0.0f;
+    Matrix3x4 worldToLocal = node_->GetWorldTransform().Inverse();
+    BoundingBox appendBox;
+
+    for (unsigned i = 0; i < trails_.Size(); ++i)
+    {
+        Trail& trail = trails_[i];
+        TrailVertex* vertices = &appendVertices_[i * 2];
+
+        if (!trail.target_)
+        {
+            // Degenerate segment, faded out
+            vertices[0].position_ = vertices[1].position_ = trail.lastPosition_;
+            vertices[0].time_ = vertices[1].time_ = Vector2(UNUSED_TIME, 0.0f);
+            continue;
+        }
+
+        Vector3 position = worldToLocal * trail.target_->GetWorldPosition();
+        if (!trail.started_)
+        {
+            trail.lastPosition_ = position;
+            trail.lastTime_ = time;
+            trail.started_ = true;
+        }
+
+        vertices[0].position_ = trail.lastPosition_;
+        vertices[0].time_ = Vector2(trail.lastTime_, 0.0f);
+        vertices[1].position_ = position;
+        vertices[1].time_ = Vector2(time, 0.0f);
+        appendBox.Merge(position);
+
+        trail.lastPosition_ = position;
+        trail.lastTime_ = time;
+    }
+
+    // One upload for the whole slot, the oldest segment of every trail
+    unsigned start = orbitVertices_.Size() + head_ * trails_.Size() * 2;
+    vertexBuffer_->SetDataRange(&appendVertices_[0], start, appendVertices_.Size());
+    lastAppendSize_ = appendVertices_.Size() * sizeof(TrailVertex);
+    head_ = (head_ + 1) % trailLength_;
+
+    if (appendBox.Defined() && boundingBox_.IsInside(appendBox) != INSIDE)
+    {
+        boundingBox_.Merge(appendBox);
+        OnMarkedDirty(node_);
+    }
+}
+
+void OrbitTrails::ClearTrails()
+{
+    for (unsigned i = 0; i < trails_.Size(); ++i)
+        trails_[i].started_ = false;
+    bufferDirty_ = true;
+}
+
+void OrbitTrails::OnNodeSet(Node* node)
+{
+    Drawable::OnNodeSet(node);
+
+    if (node)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+            SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(OrbitTrails, HandleSceneUpdate));
+    }
+}
+
+void OrbitTrails::OnWorldBoundingBoxUpdate()
+{
+    worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+}
+
+void OrbitTrails::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace SceneUpdate;
+
+    if (bufferDirty_)
+        Rebuild();
+
+    appendTimer_ += eventData[P_TIMESTEP].GetFloat();
+    if (appendTimer_ >= appendInterval_)
+    {
+        appendTimer_ = fmodf(appendTimer_, Max(appendInterval_, M_EPSILON));
+        Append();
+    }
+}
+
+void OrbitTrails::Rebuild()
+{
+    URHO3D_PROFILE(RebuildTrails);
+
+    unsigned numTrailVertices = trails_.Size() * 2 * trailLength_;
+    unsigned numVertices = orbitVertices_.Size() + numTrailVertices;
+
+    PODVector<TrailVertex> vertices(numVertices);
+    if (!orbitVertices_.Empty())
+        memcpy(&vertices[0], &orbitVertices_[0], orbitVertices_.Size() * sizeof(TrailVertex));
+    for (unsigned i = orbitVertices_.Size(); i < numVertices; ++i)
+    {
+        vertices[i].position_ = Vector3::ZERO;
+        vertices[i].color_ = trails_[((i - orbitVertices_.Size()) / 2) % trails_.Size()].color_;
+        vertices[i].time_ = Vector2(UNUSED_TIME, 0.0f);
+    }
+
+    // The ring is rewritten every append, the orbits never
+    vertexBuffer_->SetSize(numVertices, TRAIL_ELEMENT_MASK, !trails_.Empty());
+    if (numVertices)
+        vertexBuffer_->SetData(&vertices[0]);
+    geometry_->SetDrawRange(LINE_LIST, 0, 0, 0, numVertices);
+
+    appendVertices_.Resize(trails_.Size() * 2);
+    for (unsigned i = 0; i < trails_.Size(); ++i)
+        appendVertices_[i * 2].color_ = appendVertices_[i * 2 + 1].color_ = trails_[i].color_;
+
+    head_ = 0;
+    bufferDirty_ = false;
+}
+
+void OrbitTrails::Benchmark(Context* context)
+{
+    static const unsigned counts[] = { 1000, 5000, 20000 };
+    static const unsigned NUM_APPENDS = 600;
+    static const unsigned NUM_REBUILDS = 10;
+
+    for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        SharedPtr<Scene> scene(new Scene(context));
+        OrbitTrails* trails = scene->CreateChild("BenchmarkTrails")->CreateComponent<OrbitTrails>();
+        trails->SetTrailLength(256);
+
+        // Targets on circular orbits, moved by hand before every append
+        PODVector<Node*> targets(counts[c]);
+        SetRandomSeed(c + 1);
+        for (unsigned i = 0; i < counts[c]; ++i)
+        {
+            targets[i] = scene->CreateChild("Target");
+            trails->AddTrail(targets[i], Color(Random(1.0f), Random(1.0f), Random(1.0f)));
+            trails->AddOrbit(Random(2.0f, 40.0f), Color::GRAY);
+        }
+
+        HiresTimer timer;
+        long long appendTime = 0;
+        for (unsigned frame = 0; frame < NUM_APPENDS; ++frame)
+        {
+            for (unsigned i = 0; i < counts[c]; ++i)
+            {
+                float radius = 2.0f + (i % 40);
+                float angle = (frame + i) * 0.5f;
+                targets[i]->SetPosition(Vector3(radius * Cos(angle), 0.0f, -radius * Sin(angle)));
+            }
+
+            timer.Reset();
+            trails->Append();
+            appendTime += timer.GetUSec(false);
+        }
+
+        // What regenerating the trails every tick would cost instead
+        timer.Reset();
+        for (unsigned i = 0; i < NUM_REBUILDS; ++i)
+            trails->Rebuild();
+        long long rebuildTime = timer.GetUSec(false);
+
+        unsigned bufferSize = trails->vertexBuffer_->GetVertexCount() * sizeof(TrailVertex);
+        printf("trails=%u segments=%u append=%.3f ms (%u bytes) regenerate=%.3f ms (%u bytes), 1 batch\n", counts[c],
+            trails->GetTrailLength(), appendTime / 1000.0 / NUM_APPENDS, trails->GetLastAppendSize(),
+            rebuildTime / 1000.0 / NUM_REBUILDS, bufferSize);
+    }
+}
@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Graphics/Drawable.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Geometry;
+class Material;
+class VertexBuffer;
+
+}
+
+/// Orbit and trail vertex: position relative to the component's node, color and append time (in the first texture
+/// coordinate) from which the shader fades the trails out.
+struct TrailVertex
+{
+    /// Position.
+    Vector3 position_;
+    /// Packed color.
+    unsigned color_;
+    /// Scene time at which the vertex was appended, in X.
+    Vector2 time_;
+};
+
+/// Trail following a node.
+struct Trail
+{
+    /// Followed node.
+    WeakPtr<Node> target_;
+    /// Packed color.
+    unsigned color_;
+    /// Last appended position.
+    Vector3 lastPosition_;
+    /// Scene time of the last appended position.
+    float lastTime_;
+    /// Whether a position has been appended yet.
+    bool started_;
+};
+
+/// Orbit lines and trails of the bodies, drawn as one line list in a single batch.
+/// The circular orbits are generated once from the orbit radii at the start of the vertex buffer. The trails fill a
+/// fixed-size ring behind them: every append writes one segment per trail into the oldest slot with a single
+/// SetDataRange() call, so nothing is regenerated and the upload size does not depend on the trail length. Trail segments
+/// are laid out slot by slot so that the segments of one append are contiguous. The node should be placed at the sun,
+/// whose orbits are centred on it.
+class OrbitTrails : public Drawable
+{
+    URHO3D_OBJECT(OrbitTrails, Drawable);
+
+public:
+    /// Construct.
+    OrbitTrails(Context* context);
+    /// Destruct.
+    virtual ~OrbitTrails();
+
+    /// Calculate distance and prepare batches for rendering.
+    virtual void UpdateBatches(const FrameInfo& frame);
+
+    /// Add a circular orbit in the XZ plane around the node.
+    void AddOrbit(float radius, const Color& color);
+    /// Change the radius of an orbit, in the order the orbits were added.
+    void SetOrbitRadius(unsigned index, float radius);
+    /// Add a trail following a node and return its index.
+    unsigned AddTrail(Node* target, const Color& color);
+    /// Set the number of segments kept per trail. Clears the trails.
+    void SetTrailLength(unsigned segments);
+    /// Set the time between two appends in seconds.
+    void SetAppendInterval(float interval) { appendInterval_ = interval; }
+    /// Set the material.
+    void SetMaterial(Material* material);
+    /// Append the current target positions to every trail, overwriting the oldest segments.
+    void Append();
+    /// Restart every trail from its target's current position, after a jump in time.
+    void ClearTrails();
+
+    /// Return number of trails.
+    unsigned GetNumTrails() const { return trails_.Size(); }
+    /// Return number of segments kept per trail.
+    unsigned GetTrailLength() const { return trailLength_; }
+    /// Return bytes uploaded by the last append.
+    unsigned GetLastAppendSize() const { return lastAppendSize_; }
+
+    /// Feed thousands of trails and print the append cost against regenerating the whole ring.
+    static void Benchmark(Context* context);
+
+    /// Number of segments of an orbit circle.
+    static const unsigned ORBIT_SEGMENTS = 128;
+
+protected:
+    /// Handle node being assigned.
+    virtual void OnNodeSet(Node* node);
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+
+private:
+    /// Handle scene update: append at the configured interval.
+    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    /// Recreate the vertex buffer after orbits or trails were added.
+    void Rebuild();
+    /// Write the vertices of an orbit circle and grow the bounding box.
+    void WriteOrbit(TrailVertex* vertices, float radius, unsigned color);
+
+    /// Vertex buffer holding the orbits then the trail ring.
+    SharedPtr<VertexBuffer> vertexBuffer_;
+    /// Geometry drawing the whole buffer.
+    SharedPtr<Geometry> geometry_;
+    /// Orbit vertices, kept to rebuild the buffer.
+    PODVector<TrailVertex> orbitVertices_;
+    /// Trails.
+    Vector<Trail> trails_;
+    /// Segments of one append, one per trail.
+    PODVector<TrailVertex> appendVertices_;
+    /// Local bounding box of the orbits and trails.
+    BoundingBox boundingBox_;
+    /// Segments kept per trail.
+    unsigned trailLength_;
+    /// Ring slot written by the next append.
+    unsigned head_;
+    /// Time between two appends.
+    float appendInterval_;
+    /// Time since the last append.
+    float appendTimer_;
+    /// Bytes uploaded by the last append.
+    unsigned lastAppendSize_;
+    /// Vertex buffer needs to be recreated.
+    bool bufferDirty_;
+};
@@ -0,0 +1,324 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Shader.h>
+#include <Urho3D/Graphics/Technique.h>
+#include <Urho3D/Graphics/Texture.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/PackageFile.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+#include "ResourceBundle.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+const char* ResourceBundle::MANIFEST_NAME = "Bundle/Manifest.txt";
+
+/// Shader source location, the walls only run OpenGL.
+static const char* SHADER_PATH = "Shaders/GLSL/";
+static const char* SHADER_EXTENSION = ".glsl";
+/// Alignment of the file data inside the bundle.
+static const unsigned DATA_ALIGNMENT = 16;
+
+/// Manifest groups, in the order the resources must be preloaded so that dependencies come first.
+enum ManifestGroup
+{
+    GROUP_SHADER = 0,
+    GROUP_TECHNIQUE,
+    GROUP_TEXTURE,
+    GROUP_OTHER,
+    GROUP_MATERIAL,
+    NUM_GROUPS
+};
+
+static void AddFile(Vector<String>& files, const String& name)
+{
+    if (!files.Contains(name))
+        files.Push(name);
+}
+
+static void AddManifestEntry(Vector<String>* groups, ManifestGroup group, const String& type, const String& name)
+{
+    String entry = type + " " + name;
+    if (!groups[group].Contains(entry))
+        groups[group].Push(entry);
+}
+
+static void AddShader(ResourceCache* cache, Vector<String>& files, const String& name)
+{
+    if (files.Contains(name))
+        return;
+
+    SharedPtr<File> file = cache->GetFile(name, false);
+    if (!file)
+        return;
+    files.Push(name);
+
+    // Follow the includes the same way Shader does, relative to the including file
+    while (!file->IsEof())
+    {
+        String line = file->ReadLine();
+        if (line.StartsWith("#include"))
+            AddShader(cache, files, GetPath(name) + line.Substring(9).Replaced("\"", "").Trimmed());
+    }
+}
+
+ResourceBundle::ResourceBundle(Context* context) :
+    Object(context)
+{
+}
+
+ResourceBundle::~ResourceBundle()
+{
+}
+
+bool ResourceBundle::Open(const String& fileName)
+{
+    package_ = new PackageFile(context_);
+    if (!package_->Open(fileName) || package_->IsCompressed() || !package_->Exists(MANIFEST_NAME))
+    {
+        URHO3D_LOGERROR("Invalid resource bundle " + fileName);
+        package_.Reset();
+        return false;
+    }
+    if (!file_.Open(fileName))
+    {
+        URHO3D_LOGERROR("Could not map resource bundle " + fileName);
+        package_.Reset();
+        return false;
+    }
+
+    GetSubsystem<ResourceCache>()->AddPackageFile(package_, 0);
+    return true;
+}
+
+unsigned ResourceBundle::Preload()
+{
+    if (!package_)
+        return 0;
+
+    URHO3D_PROFILE(PreloadBundle);
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    const PackageEntry* manifestEntry = package_->GetEntry(MANIFEST_NAME);
+    String manifest((const char*)file_.GetData() + manifestEntry->offset_, manifestEntry->size_);
+    Vector<String> lines = manifest.Split('\n');
+    unsigned numLoaded = 0;
+
+    for (unsigned i = 0; i < lines.Size(); ++i)
+    {
+        unsigned separator = lines[i].Find(' ');
+        if (separator == String::NPOS)
+            continue;
+
+        StringHash type(lines[i].Substring(0, separator));
+        String name = lines[i].Substring(separator + 1);
+
+        // Already pulled in as a dependency of an earlier entry
+        if (cache->GetExistingResource(type, name))
+            continue;
+
+        const PackageEntry* entry = package_->GetEntry(name);
+        SharedPtr<Resource> resource = DynamicCast<Resource>(context_->CreateObject(type));
+        if (!entry || !resource)
+        {
+            URHO3D_LOGERROR("Could not preload " + lines[i] + " from " + GetFileName());
+            continue;
+        }
+
+        // Read in place from the mapping, no copy of the file data
+        resource->SetName(name);
+        MemoryBuffer buffer(file_.GetData() + entry->offset_, entry->size_);
+        if (!resource->Load(buffer))
+        {
+            URHO3D_LOGERROR("Could not preload " + lines[i] + " from " + GetFileName());
+            continue;
+        }
+
+        cache->AddManualResource(resource);
+        ++numLoaded;
+    }
+
+    return numLoaded;
+}
+
+unsigned ResourceBundle::GetNumFiles() const
+{
+    return package_ ? package_->GetNumFiles() : 0;
+}
+
+void ResourceBundle::CollectFiles(Context* context, Vector<String>& files, Vector<String>& manifest)
+{
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    const HashMap<StringHash, ResourceGroup>& resourceGroups = cache->GetAllResources();
+    Vector<String> groups[NUM_GROUPS];
+
+    for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups.Begin(); i != resourceGroups.End(); ++i)
+    {
+        const HashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
+        for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin(); j != resources.End(); ++j)
+        {
+            Resource* resource = j->second_;
+            const String& name = resource->GetName();
+            // Skip resources created in code
+            if (name.Empty() || !cache->Exists(name))
+                continue;
+
+            ManifestGroup group = GROUP_OTHER;
+            if (resource->GetType() == Shader::GetTypeStatic())
+            {
+                AddShader(cache, files, name);
+                group = GROUP_SHADER;
+            }
+            else if (resource->GetType() == Technique::GetTypeStatic())
+            {
+                // Pull in the shaders of every pass, including the ones not rendered yet
+                PODVector<Pass*> passes = static_cast<Technique*>(resource)->GetPasses();
+                for (unsigned k = 0; k < passes.Size(); ++k)
+                {
+                    String shaderNames[2] = { passes[k]->GetVertexShader(), passes[k]->GetPixelShader() };
+                    for (unsigned l = 0; l < 2; ++l)
+                    {
+                        String shaderName = SHADER_PATH + shaderNames[l] + SHADER_EXTENSION;
+                        if (cache->Exists(shaderName))
+                        {
+                            AddShader(cache, files, shaderName);
+                            AddManifestEntry(groups, GROUP_SHADER, Shader::GetTypeNameStatic(), shaderName);
+                        }
+                    }
+                }
+                group = GROUP_TECHNIQUE;
+            }
+            else if (resource->IsInstanceOf<Texture>())
+            {
+                String parameters = ReplaceExtension(name, ".xml");
+                if (cache->Exists(parameters))
+                    AddFile(files, parameters);
+                group = GROUP_TEXTURE;
+            }
+            else if (resource->GetType() == Material::GetTypeStatic())
+                group = GROUP_MATERIAL;
+
+            AddFile(files, name);
+            AddManifestEntry(groups, group, resource->GetTypeName(), name);
+        }
+    }
+
+    manifest.Clear();
+    for (unsigned i = 0; i < NUM_GROUPS; ++i)
+        manifest.Push(groups[i]);
+}
+
+bool ResourceBundle::Write(Context* context, const String& fileName)
+{
+    URHO3D_PROFILE(WriteBundle);
+
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    Vector<String> files;
+    Vector<String> manifest;
+    CollectFiles(context, files, manifest);
+
+    // Read everything first so that the index can be written ahead of the data
+    String manifestText;
+    manifestText.Join(manifest, "\n");
+    Vector<PODVector<unsigned char> > contents;
+    Vector<String> names;
+    for (unsigned i = 0; i < files.Size(); ++i)
+    {
+        SharedPtr<File> file = cache->GetFile(files[i]);
+        if (!file)
+            continue;
+
+        names.Push(files[i]);
+        contents.Resize(contents.Size() + 1);
+        contents.Back().Resize(file->GetSize());
+        if (file->GetSize())
+            file->Read(&contents.Back()[0], file->GetSize());
+    }
+    names.Push(MANIFEST_NAME);
+    contents.Resize(contents.Size() + 1);
+    contents.Back().Resize(manifestText.Length());
+    if (manifestText.Length())
+        memcpy(&contents.Back()[0], manifestText.CString(), manifestText.Length());
+
+    // Same layout as an uncompressed PackageTool package
+    unsigned indexSize = 3 * sizeof(unsigned);
+    for (unsigned i = 0; i < names.Size(); ++i)
+        indexSize += names[i].Length() + 1 + 3 * sizeof(unsigned);
+
+    PODVector<unsigned> offsets(names.Size());
+    PODVector<unsigned> checksums(names.Size());
+    unsigned offset = indexSize;
+    unsigned totalChecksum = 0;
+    for (unsigned i = 0; i < names.Size(); ++i)
+    {
+        offset = (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+        offsets[i] = offset;
+        offset += contents[i].Size();
+
+        checksums[i] = 0;
+        for (unsigned j = 0; j < contents[i].Size(); ++j)
+        {
+            checksums[i] = SDBMHash(checksums[i], contents[i][j]);
+            totalChecksum = SDBMHash(totalChecksum, contents[i][j]);
+        }
+    }
+
+    File dest(context, fileName, FILE_WRITE);
+    if (!dest.IsOpen())
+    {
+        URHO3D_LOGERROR("Could not open " + fileName + " for writing");
+        return false;
+    }
+
+    dest.WriteFileID("UPAK");
+    dest.WriteUInt(names.Size());
+    dest.WriteUInt(totalChecksum);
+    for (unsigned i = 0; i < names.Size(); ++i)
+    {
+        dest.WriteString(names[i]);
+        dest.WriteUInt(offsets[i]);
+        dest.WriteUInt(contents[i].Size());
+        dest.WriteUInt(checksums[i]);
+    }
+
+    static const unsigned char padding[DATA_ALIGNMENT] = { 0 };
+    for (unsigned i = 0; i < names.Size(); ++i)
+    {
+        dest.Write(padding, offsets[i] - dest.GetPosition());
+        if (contents[i].Size())
+            dest.Write(&contents[i][0], contents[i].Size());
+    }
+
+    printf("resource bundle %s: files=%u resources=%u size=%.1f MB\n", fileName.CString(), names.Size(), manifest.Size(),
+        dest.GetSize() / (1024.0f * 1024.0f));
+    return true;
+}
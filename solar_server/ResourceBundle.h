@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+#include "MappedFile.h"
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class PackageFile;
+
+}
+
+/// Single-file bundle of the resources the scene actually uses, for a fast cold start on every wall.
+/// The file is a regular uncompressed Urho3D package, so its index is built once at pack time and read by PackageFile.
+/// At run time the bundle is also memory-mapped: the resources listed in its manifest are loaded straight from the
+/// mapping, and the package is mounted in the resource cache for the files loaded indirectly (shader includes, texture
+/// parameters). Anything missing from the bundle still comes from the loose resource directories.
+class ResourceBundle : public Object
+{
+    URHO3D_OBJECT(ResourceBundle, Object);
+
+public:
+    /// Construct.
+    ResourceBundle(Context* context);
+    /// Destruct.
+    virtual ~ResourceBundle();
+
+    /// Map a bundle and mount it in the resource cache ahead of the resource directories. Return true on success.
+    bool Open(const String& fileName);
+    /// Load every resource of the manifest from the mapping into the resource cache. Needs the graphics subsystem.
+    /// Return the number of resources loaded.
+    unsigned Preload();
+
+    /// Return the bundle file name.
+    const String& GetFileName() const { return file_.GetName(); }
+    /// Return the number of files in the bundle.
+    unsigned GetNumFiles() const;
+    /// Return the mapped size in bytes.
+    unsigned GetMappedSize() const { return file_.GetSize(); }
+    /// Return how many mapped bytes are resident in memory.
+    unsigned GetResidentSize() const { return file_.GetResidentSize(); }
+
+    /// Collect the files behind the resources currently in the cache, with the shader sources of their techniques,
+    /// shader includes and texture parameter files. The manifest lists "<type> <name>" in dependency order.
+    static void CollectFiles(Context* context, Vector<String>& files, Vector<String>& manifest);
+    /// Write a bundle of the resources currently in the cache. Return true on success.
+    static bool Write(Context* context, const String& fileName);
+
+    /// Name of the manifest inside the bundle.
+    static const char* MANIFEST_NAME;
+
+private:
+    /// Package index.
+    SharedPtr<PackageFile> package_;
+    /// Mapping of the package.
+    MappedFile file_;
+};
@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+
+#include "ResourceHandles.h"
+#include "Telemetry.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstring>
+
+/// Most names remembered as failed to load; further failures are retried at each request.
+static const unsigned MAX_FAILED_NAMES = 1024;
+
+static unsigned HashName(unsigned hash, const char* str)
+{
+    while (*str)
+        hash = SDBMHash(hash, (unsigned char)*str++);
+    return hash;
+}
+
+ResourceHandles::ResourceHandles(Context* context) :
+    Object(context),
+    numHits_(0),
+    numMisses_(0),
+    numFailures_(0),
+    numFailedNames_(0),
+    generation_(0)
+{
+    SubscribeToEvent(E_FILECHANGED, URHO3D_HANDLER(ResourceHandles, HandleFileChanged));
+}
+
+unsigned ResourceHandles::Find(StringHash type, const char* directory, const char* name) const
+{
+    unsigned hash = HashName(HashName(type.Value(), directory), name);
+    unsigned directoryLength = strlen(directory);
+
+    HashMap<unsigned, unsigned>::ConstIterator bucket = buckets_.Find(hash);
+    unsigned first = bucket != buckets_.End() ? bucket->second_ : M_MAX_UNSIGNED;
+    for (unsigned index = first; index != M_MAX_UNSIGNED; index = entries_[index].next_)
+    {
+        const Entry& entry = entries_[index];
+        const char* entryName = entry.name_.CString();
+        if (entry.type_ == type && !strncmp(entryName, directory, directoryLength) &&
+            !strcmp(entryName + directoryLength, name))
+            return index;
+    }
+    return M_MAX_UNSIGNED;
+}
+
+unsigned ResourceHandles::FindOrLoad(StringHash type, const char* directory, const char* name)
+{
+    unsigned index = Find(type, directory, name);
+    if (index != M_MAX_UNSIGNED)
+    {
+        const Entry& entry = entries_[index];
+        if (entry.resource_ || entry.failedGeneration_ == generation_)
+        {
+            ++numHits_;
+            return entry.resource_ ? index : M_MAX_UNSIGNED;
+        }
+    }
+
+    ++numMisses_;
+    String fullName(directory);
+    fullName += name;
+    Resource* resource = GetSubsystem<ResourceCache>()->GetResource(type, fullName);
+    if (!resource)
+        ++numFailures_;
+
+    // a failed name retried after a file change keeps its entry, and its handle if it loads now
+    if (index != M_MAX_UNSIGNED)
+    {
+        Entry& entry = entries_[index];
+        entry.resource_ = resource;
+        entry.failedGeneration_ = generation_;
+        if (!resource)
+            return M_MAX_UNSIGNED;
+        --numFailedNames_;
+        return index;
+    }
+
+    if (!resource)
+    {
+        if (numFailedNames_ >= MAX_FAILED_NAMES)
+            return M_MAX_UNSIGNED;
+        ++numFailedNames_;
+    }
+
+    unsigned hash = HashName(HashName(type.Value(), directory), name);
+    HashMap<unsigned, unsigned>::ConstIterator bucket = buckets_.Find(hash);
+    Entry entry;
+    entry.type_ = type;
+    entry.name_ = fullName;
+    entry.resource_ = resource;
+    entry.failedGeneration_ = generation_;
+    entry.next_ = bucket != buckets_.End() ? bucket->second_ : M_MAX_UNSIGNED;
+    entries_.Push(entry);
+    buckets_[hash] = entries_.Size() - 1;
+    return resource ? entries_.Size() - 1 : M_MAX_UNSIGNED;
+}
+
+bool ResourceHandles::Holds(Resource* resource) const
+{
+    // the hash runs over the directory then the name, so the full name finds the entry whatever its split
+    unsigned index = Find(resource->GetType(), "", resource->GetName().CString());
+    return index != M_MAX_UNSIGNED && entries_[index].resource_.Get() == resource;
+}
+
+bool ResourceHandles::IsInDirectory(const String& name, const char* directory)
+{
+    return name.StartsWith(directory) && name.Length() > strlen(directory) && !name.Contains("..");
+}
+
+void ResourceHandles::HandleFileChanged(StringHash eventType, VariantMap& eventData)
+{
+    ++generation_;
+}
+
+String ResourceHandles::BuildReport() const
+{
+    String report;
+    Telemetry::AddLine(report, "resources.handles", (unsigned long long)entries_.Size());
+    Telemetry::AddLine(report, "resources.hits", numHits_);
+    Telemetry::AddLine(report, "resources.misses", numMisses_);
+    Telemetry::AddLine(report, "resources.failures", numFailures_);
+    Telemetry::AddLine(report, "resources.failed.names", (unsigned long long)numFailedNames_);
+    return report;
+}
@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Resource/Resource.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+/// Stable index of a resource in a ResourceHandles table, typed by the resource class.
+template <class T> class ResourceHandle
+{
+public:
+    /// Construct an invalid handle.
+    ResourceHandle() : index_(M_MAX_UNSIGNED) {}
+    /// Construct from a table index.
+    explicit ResourceHandle(unsigned index) : index_(index) {}
+
+    /// Return whether the handle refers to a resource.
+    bool IsValid() const { return index_ != M_MAX_UNSIGNED; }
+    /// Return the table index.
+    unsigned GetIndex() const { return index_; }
+
+private:
+    /// Table index, M_MAX_UNSIGNED when invalid.
+    unsigned index_;
+};
+
+/// Table resolving each model, material and other scene resource name once to a stable handle, shared by the scene
+/// code and the network commands. A name is looked up as a directory and a file name, hashed together without building
+/// the full name, so that a command naming "Sphere.mdl" finds "Models/Sphere.mdl" without allocating. The first
+/// request loads the resource through the resource cache; later ones are a hash probe. Handles are never reused and
+/// the table holds a reference to every resource, which the resource cache reloads in place when its file changes. A
+/// name that fails to load gets no handle but a negative entry, so that a client repeating it does not go to the disk
+/// each time. The negative entries are retried after the next E_FILECHANGED, once the file may exist, and only a
+/// bounded number of them is kept, so that made-up names can not grow the table without bound.
+class ResourceHandles : public Object
+{
+    URHO3D_OBJECT(ResourceHandles, Object);
+
+public:
+    /// Construct.
+    ResourceHandles(Context* context);
+
+    /// Return the handle of a resource named by a directory and a file name, loading it on the first request. Return
+    /// an invalid handle if it can not be loaded.
+    template <class T> ResourceHandle<T> GetHandle(const char* directory, const char* name)
+    {
+        return ResourceHandle<T>(FindOrLoad(T::GetTypeStatic(), directory, name));
+    }
+    /// Return the handle of a resource named by its full name.
+    template <class T> ResourceHandle<T> GetHandle(const String& name) { return GetHandle<T>("", name.CString()); }
+    /// Return the resource of a handle, or null for an invalid handle.
+    template <class T> T* Get(ResourceHandle<T> handle) const
+    {
+        return handle.IsValid() ? static_cast<T*>(entries_[handle.GetIndex()].resource_.Get()) : 0;
+    }
+    /// Return a resource named by a directory and a file name, or null if it can not be loaded.
+    template <class T> T* GetResource(const char* directory, const char* name)
+    {
+        return Get(GetHandle<T>(directory, name));
+    }
+    /// Return a resource named by its full name, or null if it can not be loaded.
+    template <class T> T* GetResource(const String& name) { return Get(GetHandle<T>(name)); }
+
+    /// Return the number of handles.
+    unsigned GetNumHandles() const { return entries_.Size(); }
+    /// Return whether the table holds a reference to a resource, so that the telemetry does not count it as in use.
+    bool Holds(Resource* resource) const;
+    /// Return whether a resource name sent by a client names a file of a resource directory, such as "Models/".
+    static bool IsInDirectory(const String& name, const char* directory);
+    /// Build the handle count, hits, misses and failed loads as "<key> <value>" lines for the telemetry report.
+    String BuildReport() const;
+
+private:
+    /// Retry the names that failed to load, a resource file having changed.
+    void HandleFileChanged(StringHash eventType, VariantMap& eventData);
+
+    /// Resource of a handle.
+    struct Entry
+    {
+        /// Resource type.
+        StringHash type_;
+        /// Full resource name.
+        String name_;
+        /// Resource, null for a name that failed to load.
+        SharedPtr<Resource> resource_;
+        /// File change count when the name failed to load.
+        unsigned failedGeneration_;
+        /// Next handle with the same hash, or M_MAX_UNSIGNED.
+        unsigned next_;
+    };
+
+    /// Return the index of a resource already in the table, or M_MAX_UNSIGNED.
+    unsigned Find(StringHash type, const char* directory, const char* name) const;
+    /// Return the index of a resource, loading it on the first request, or M_MAX_UNSIGNED if it can not be loaded or
+    /// failed to load since the last file change.
+    unsigned FindOrLoad(StringHash type, const char* directory, const char* name);
+
+    /// Handles by index.
+    Vector<Entry> entries_;
+    /// First handle of each hash of type, directory and name.
+    HashMap<unsigned, unsigned> buckets_;
+    /// Requests answered by the table.
+    unsigned long long numHits_;
+    /// Requests that went to the resource cache.
+    unsigned long long numMisses_;
+    /// Misses the resource cache could not load.
+    unsigned long long numFailures_;
+    /// Names that failed to load and have a negative entry.
+    unsigned numFailedNames_;
+    /// Resource file changes seen, to retry the names that failed before.
+    unsigned generation_;
+};
@@ -162,6 +162,8 @@ void Sample::SetWindowTitleAndIcon()
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
     Graphics* graphics = GetSubsystem<Graphics>();
+    if (!graphics)
+        return;
     Image* icon = cache->GetResource<Image>("Textures/UrhoIcon.png");
     graphics->SetWindowIcon(icon);
     graphics->SetWindowTitle("Urho3D Sample");
@@ -176,7 +178,10 @@ void Sample::CreateConsoleAndDebugHud()
     XMLFile* xmlFile = cache->GetResource<XMLFile>("UI/DefaultStyle.xml");
 
     // Create console
+    // Neither exists in headless mode
     Console* console = engine_->CreateConsole();
+    if (!console)
+        return;
     console->SetDefaultStyle(xmlFile);
     console->GetBackground()->SetOpacity(0.8f);
 
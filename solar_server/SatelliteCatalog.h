@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+/// Binary satellite catalog layout, shared by the converter tool and SatelliteField. The file is a header followed by
+/// `count_` records and is read in place through a memory mapping, so the layout must stay free of padding.
+/// Elements are mean elements of the TLE, all brought to the same epoch by the converter.
+
+/// Magic bytes at the start of a catalog.
+static const char SATELLITE_CATALOG_MAGIC[4] = { 'S', 'A', 'T', 'S' };
+/// Current catalog version.
+static const unsigned SATELLITE_CATALOG_VERSION = 1;
+
+/// Earth equatorial radius in km (WGS-72, as used with TLEs).
+static const double SATELLITE_EARTH_RADIUS = 6378.135;
+/// Earth gravitational parameter in km^3/min^2.
+static const double SATELLITE_EARTH_MU = 398600.8 * 3600.0;
+/// Second zonal harmonic of the geopotential.
+static const double SATELLITE_J2 = 1.082616e-3;
+
+/// Kind of tracked object, from the TLE name line.
+enum SatelliteKind
+{
+    SATELLITE_PAYLOAD = 0,
+    SATELLITE_ROCKET_BODY,
+    SATELLITE_DEBRIS
+};
+
+/// Catalog header.
+struct SatelliteCatalogHeader
+{
+    /// Magic bytes, SATELLITE_CATALOG_MAGIC.
+    char magic_[4];
+    /// Format version, SATELLITE_CATALOG_VERSION.
+    unsigned version_;
+    /// Number of records following the header.
+    unsigned count_;
+    /// Size of one record in bytes, for forward compatibility.
+    unsigned recordSize_;
+};
+
+/// Mean orbital elements of one object. Angles in radians.
+struct SatelliteRecord
+{
+    /// Inclination to the equator.
+    float inclination_;
+    /// Right ascension of the ascending node.
+    float raan_;
+    /// Eccentricity.
+    float eccentricity_;
+    /// Argument of perigee.
+    float argPerigee_;
+    /// Mean anomaly at the catalog epoch.
+    float meanAnomaly_;
+    /// Mean motion in radians per minute.
+    float meanMotion_;
+    /// SatelliteKind.
+    unsigned kind_;
+};
+
+/// Secular drift of the elements under J2, the dominant term of the simplified perturbation models.
+struct SatelliteRates
+{
+    /// Semi-major axis in km.
+    double semiMajorAxis_;
+    /// Node regression in radians per minute.
+    double raanRate_;
+    /// Apsidal rotation in radians per minute.
+    double argPerigeeRate_;
+    /// Mean anomaly rate in radians per minute, including the J2 correction.
+    double meanAnomalyRate_;
+};
+
+/// Return the J2 secular rates of an object.
+inline SatelliteRates GetSatelliteRates(const SatelliteRecord& record)
+{
+    double n = record.meanMotion_;
+    double e = record.eccentricity_;
+    double cosI = cos((double)record.inclination_);
+    double beta = sqrt(1.0 - e * e);
+
+    SatelliteRates rates;
+    rates.semiMajorAxis_ = pow(SATELLITE_EARTH_MU / (n * n), 1.0 / 3.0);
+
+    double p = rates.semiMajorAxis_ * (1.0 - e * e);
+    double k = 1.5 * SATELLITE_J2 * (SATELLITE_EARTH_RADIUS / p) * (SATELLITE_EARTH_RADIUS / p) * n;
+    rates.raanRate_ = -k * cosI;
+    rates.argPerigeeRate_ = 0.5 * k * (5.0 * cosI * cosI - 1.0);
+    rates.meanAnomalyRate_ = n + 0.5 * k * beta * (3.0 * cosI * cosI - 1.0);
+    return rates;
+}
+
+/// Return whether a mapped block holds a valid catalog.
+inline bool IsValidSatelliteCatalog(const unsigned char* data, unsigned size)
+{
+    if (size < sizeof(SatelliteCatalogHeader))
+        return false;
+
+    const SatelliteCatalogHeader* header = reinterpret_cast<const SatelliteCatalogHeader*>(data);
+    return memcmp(header->magic_, SATELLITE_CATALOG_MAGIC, 4) == 0 && header->version_ == SATELLITE_CATALOG_VERSION &&
+        header->recordSize_ == sizeof(SatelliteRecord) &&
+        size >= sizeof(SatelliteCatalogHeader) + (unsigned long long)header->count_ * sizeof(SatelliteRecord);
+}
+
+/// Write a catalog to a file. Return true on success.
+inline bool WriteSatelliteCatalog(const char* fileName, const SatelliteRecord* records, unsigned count)
+{
+    FILE* file = fopen(fileName, "wb");
+    if (!file)
+        return false;
+
+    SatelliteCatalogHeader header;
+    memcpy(header.magic_, SATELLITE_CATALOG_MAGIC, 4);
+    header.version_ = SATELLITE_CATALOG_VERSION;
+    header.count_ = count;
+    header.recordSize_ = sizeof(SatelliteRecord);
+
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        (count == 0 || fwrite(records, sizeof(SatelliteRecord), count, file) == count);
+    fclose(file);
+    return success;
+}
@@ -0,0 +1,559 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+
+#include "BodySystem.h"
+#include "MappedFile.h"
+#include "SatelliteCatalog.h"
+#include "SatelliteField.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
+/// Newton iterations on Kepler's equation, enough for transfer orbit eccentricities.
+static const unsigned KEPLER_ITERATIONS = 5;
+/// Orbit minutes the float angles may run from their epoch before they are recomputed in double precision.
+static const double EPOCH_SPAN = 720.0;
+/// Number of work items per thread.
+static const unsigned ITEMS_PER_THREAD = 4;
+
+/// Point colors by SatelliteKind; alpha scales the point size.
+static const Color kindColors[] =
+{
+    Color(0.4f, 0.9f, 1.0f, 1.0f),
+    Color(0.85f, 0.85f, 0.85f, 0.8f),
+    Color(1.0f, 0.45f, 0.2f, 0.6f)
+};
+
+/// Return an angle at an orbit time, wrapped to [0, 2 pi).
+static inline float AngleAt(float angle0, float rate, double time)
+{
+    const double twoPi = 2.0 * M_PI;
+    double turns = (angle0 + rate * time) / twoPi;
+    return (float)((turns - floor(turns)) * twoPi);
+}
+
+#ifdef URHO3D_SSE
+/// Sine and cosine of four angles: Cody-Waite reduction to [-pi/4, pi/4] and the single precision polynomials of Cephes.
+static inline void SinCos4(__m128 x, __m128& s, __m128& c)
+{
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+
+    __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(2.0f / M_PI)));
+    __m128 qf = _mm_cvtepi32_ps(q);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(1.5703125f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(4.837512969970703125e-4f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(7.54978995489188216e-8f)));
+    __m128 r2 = _mm_mul_ps(r, r);
+
+    __m128 sr = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f), _mm_mul_ps(r2, _mm_set1_ps(-1.9515295891e-4f)));
+    sr = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f), _mm_mul_ps(r2, sr));
+    sr = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), sr));
+
+    __m128 cr = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f), _mm_mul_ps(r2, _mm_set1_ps(2.443315711809948e-5f)));
+    cr = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f), _mm_mul_ps(r2, cr));
+    cr = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), cr));
+
+    // Odd quadrants swap sine and cosine; the quadrant bits give the signs
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30));
+    s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cr), _mm_andnot_ps(swap, sr)), sinSign);
+    c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sr), _mm_andnot_ps(swap, cr)), cosSign);
+}
+
+/// Return a + b * c.
+static inline __m128 MulAdd(__m128 a, __m128 b, __m128 c)
+{
+    return _mm_add_ps(a, _mm_mul_ps(b, c));
+}
+#endif
+
+SatelliteField::SatelliteField(Context* context) :
+    Drawable(context, DRAWABLE_GEOMETRY),
+    geometry_(new Geometry(context)),
+    numObjects_(0),
+    numBlocks_(0),
+    maxRadius_(0.0f),
+    timeScale_(4.5f),
+    epoch_(0.0),
+    time_(0.0),
+    elapsed_(0.0f),
+    rebase_(true),
+    vectorized_(true),
+    lastPropagateTime_(0),
+    lastUploadTime_(0)
+{
+    batches_.Resize(1);
+    batches_[0].geometry_ = geometry_;
+}
+
+SatelliteField::~SatelliteField()
+{
+}
+
+bool SatelliteField::Load(const String& fileName)
+{
+    URHO3D_PROFILE(LoadSatelliteField);
+
+    HiresTimer timer;
+
+    MappedFile file;
+    if (!file.Open(fileName))
+    {
+        URHO3D_LOGERROR("Could not map satellite catalog " + fileName);
+        return false;
+    }
+    if (!IsValidSatelliteCatalog(file.GetData(), file.GetSize()))
+    {
+        URHO3D_LOGERROR("Invalid satellite catalog " + fileName);
+        return false;
+    }
+
+    const SatelliteCatalogHeader* header = reinterpret_cast<const SatelliteCatalogHeader*>(file.GetData());
+    SetElements(reinterpret_cast<const SatelliteRecord*>(file.GetData() + sizeof(SatelliteCatalogHeader)), header->count_);
+
+    printf("satellite field %s: objects=%u load=%.1f ms\n", fileName.CString(), numObjects_,
+        timer.GetUSec(false) / 1000.0f);
+
+    return true;
+}
+
+void SatelliteField::Generate(unsigned count, unsigned seed)
+{
+    // Every wall generates the same population from the same seed
+    SetRandomSeed(seed);
+
+    static const float debrisInclinations[] = { 74.0f, 82.5f, 86.4f, 98.2f, 71.0f, 65.0f };
+    const float radius = (float)SATELLITE_EARTH_RADIUS;
+
+    PODVector<SatelliteRecord> records(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        SatelliteRecord& record = records[i];
+        float a;
+        float roll = Random(1.0f);
+
+        record.raan_ = Random(2.0f * M_PI);
+        record.argPerigee_ = Random(2.0f * M_PI);
+        record.meanAnomaly_ = Random(2.0f * M_PI);
+        record.eccentricity_ = Random(0.0001f, 0.002f);
+
+        if (roll < 0.45f)
+        {
+            // Broadband constellation shell: 72 planes at 53 degrees
+            a = radius + 550.0f;
+            record.inclination_ = 53.0f * M_DEGTORAD;
+            record.raan_ = Random(72) * 2.0f * M_PI / 72.0f;
+            record.eccentricity_ = 0.0001f;
+            record.kind_ = SATELLITE_PAYLOAD;
+        }
+        else if (roll < 0.55f)
+        {
+            // Sun-synchronous imaging orbits
+            a = radius + Random(500.0f, 800.0f);
+            record.inclination_ = Random(97.4f, 98.6f) * M_DEGTORAD;
+            record.kind_ = SATELLITE_PAYLOAD;
+        }
+        else if (roll < 0.59f)
+        {
+            // Navigation constellations in six planes
+            a = 26560.0f;
+            record.inclination_ = Random(54.0f, 56.0f) * M_DEGTORAD;
+            record.raan_ = Random(6) * 2.0f * M_PI / 6.0f;
+            record.kind_ = SATELLITE_PAYLOAD;
+        }
+        else if (roll < 0.62f)
+        {
+            // Geostationary ring
+            a = 42164.0f;
+            record.inclination_ = Random(1.0f) * M_DEGTORAD;
+            record.eccentricity_ = 0.0002f;
+            record.kind_ = SATELLITE_PAYLOAD;
+        }
+        else if (roll < 0.65f)
+        {
+            // Upper stages left on geostationary transfer orbits
+            a = radius + (250.0f + 35786.0f) * 0.5f;
+            record.eccentricity_ = (35786.0f - 250.0f) / (2.0f * a);
+            record.inclination_ = Random(7.0f, 28.5f) * M_DEGTORAD;
+            record.kind_ = SATELLITE_ROCKET_BODY;
+        }
+        else if (roll < 0.7f)
+        {
+            a = radius + Random(600.0f, 1000.0f);
+            record.inclination_ = Random(70.0f, 83.0f) * M_DEGTORAD;
+            record.kind_ = SATELLITE_ROCKET_BODY;
+        }
+        else
+        {
+            // Fragmentation clouds keep the inclination of their parent and spread in altitude
+            float altitude = 850.0f + 350.0f * (Random(1.0f) + Random(1.0f) - 1.0f);
+            a = radius + altitude;
+            unsigned cloud = (unsigned)Random((int)(sizeof(debrisInclinations) / sizeof(debrisInclinations[0])));
+            record.inclination_ = (debrisInclinations[cloud] + Random(-1.0f, 1.0f)) * M_DEGTORAD;
+            record.eccentricity_ = Random(0.0f, 0.02f);
+            record.kind_ = SATELLITE_DEBRIS;
+        }
+
+        record.meanMotion_ = (float)sqrt(SATELLITE_EARTH_MU / ((double)a * a * a));
+    }
+
+    SetElements(count ? &records[0] : 0, count);
+}
+
+void SatelliteField::SetMaterial(Material* material)
+{
+    material_ = material;
+    batches_[0].material_ = material_;
+}
+
+bool SatelliteField::IsVectorized() const
+{
+#ifdef URHO3D_SSE
+    return vectorized_;
+#else
+    return false;
+#endif
+}
+
+void SatelliteField::Propagate(double time)
+{
+    if (!numObjects_)
+        return;
+
+    URHO3D_PROFILE(PropagateSatellites);
+
+    HiresTimer timer;
+
+    // The float angles are relative to an epoch close to the current time; a long run or a seek moves the epoch
+    double orbitTime = time * timeScale_;
+    if (Abs(orbitTime - epoch_) > EPOCH_SPAN)
+    {
+        epoch_ = orbitTime;
+        rebase_ = true;
+    }
+    time_ = time;
+    elapsed_ = (float)(orbitTime - epoch_);
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numItems = (queue->GetNumThreads() + 1) * ITEMS_PER_THREAD;
+    unsigned blocksPerItem = (numBlocks_ + numItems - 1) / numItems;
+
+    for (unsigned start = 0; start < numBlocks_; start += blocksPerItem)
+    {
+        unsigned end = Min(start + blocksPerItem, numBlocks_);
+
+        SharedPtr<WorkItem> item(new WorkItem());
+        item->workFunction_ = PropagateWork;
+        item->start_ = reinterpret_cast<void*>((size_t)start);
+        item->end_ = reinterpret_cast<void*>((size_t)end);
+        item->aux_ = this;
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+    rebase_ = false;
+
+    lastPropagateTime_ = timer.GetUSec(true);
+
+    vertexBuffer_->SetData(&vertexData_[0]);
+    lastUploadTime_ = timer.GetUSec(false);
+}
+
+void SatelliteField::OnNodeSet(Node* node)
+{
+    Drawable::OnNodeSet(node);
+
+    if (node)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+            SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(SatelliteField, HandleSceneUpdate));
+    }
+}
+
+void SatelliteField::OnWorldBoundingBoxUpdate()
+{
+    BoundingBox localBox(-maxRadius_, maxRadius_);
+    worldBoundingBox_ = localBox.Transformed(node_->GetWorldTransform());
+}
+
+void SatelliteField::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace SceneUpdate;
+
+    // Same clock as the bodies, so that time warp and date seeks apply to the satellites too
+    BodySystem* bodySystem = GetScene()->GetComponent<BodySystem>();
+    Propagate(bodySystem ? bodySystem->GetTime() : time_ + eventData[P_TIMESTEP].GetFloat());
+}
+
+void SatelliteField::SetElements(const SatelliteRecord* records, unsigned count)
+{
+    numObjects_ = count;
+    numBlocks_ = (count + 3) / 4;
+
+    // Padding objects have a null orbit and are never written to the vertices
+    unsigned padded = numBlocks_ * 4;
+    semiMajorAxis_.Resize(padded);
+    semiMinorAxis_.Resize(padded);
+    eccentricity_.Resize(padded);
+    cosInclination_.Resize(padded);
+    sinInclination_.Resize(padded);
+    raan0_.Resize(padded);
+    argPerigee0_.Resize(padded);
+    meanAnomaly0_.Resize(padded);
+    raanRate_.Resize(padded);
+    argPerigeeRate_.Resize(padded);
+    meanAnomalyRate_.Resize(padded);
+    raan_.Resize(padded);
+    argPerigee_.Resize(padded);
+    meanAnomaly_.Resize(padded);
+    vertexData_.Resize(count * 4);
+
+    maxRadius_ = 0.0f;
+    for (unsigned i = 0; i < padded; ++i)
+    {
+        if (i >= count)
+        {
+            semiMajorAxis_[i] = semiMinorAxis_[i] = eccentricity_[i] = 0.0f;
+            cosInclination_[i] = 1.0f;
+            sinInclination_[i] = 0.0f;
+            raan0_[i] = argPerigee0_[i] = meanAnomaly0_[i] = 0.0f;
+            raanRate_[i] = argPerigeeRate_[i] = meanAnomalyRate_[i] = 0.0f;
+            continue;
+        }
+
+        const SatelliteRecord& record = records[i];
+        SatelliteRates rates = GetSatelliteRates(record);
+        float a = (float)rates.semiMajorAxis_;
+        float e = record.eccentricity_;
+
+        semiMajorAxis_[i] = a;
+        semiMinorAxis_[i] = a * sqrtf(1.0f - e * e);
+        eccentricity_[i] = e;
+        cosInclination_[i] = cosf(record.inclination_);
+        sinInclination_[i] = sinf(record.inclination_);
+        raan0_[i] = record.raan_;
+        argPerigee0_[i] = record.argPerigee_;
+        meanAnomaly0_[i] = record.meanAnomaly_;
+        raanRate_[i] = (float)rates.raanRate_;
+        argPerigeeRate_[i] = (float)rates.argPerigeeRate_;
+        meanAnomalyRate_[i] = (float)rates.meanAnomalyRate_;
+
+        float* vertex = &vertexData_[i * 4];
+        vertex[0] = vertex[1] = vertex[2] = 0.0f;
+        *reinterpret_cast<unsigned*>(vertex + 3) = kindColors[Min(record.kind_, (unsigned)SATELLITE_DEBRIS)].ToUInt();
+
+        maxRadius_ = Max(maxRadius_, a * (1.0f + e));
+    }
+
+    if (!vertexBuffer_)
+        vertexBuffer_ = new VertexBuffer(context_);
+    vertexBuffer_->SetSize(count, MASK_POSITION | MASK_COLOR, true);
+    geometry_->SetVertexBuffer(0, vertexBuffer_, MASK_POSITION | MASK_COLOR);
+    geometry_->SetDrawRange(POINT_LIST, 0, 0, 0, count);
+
+    rebase_ = true;
+    Propagate(time_);
+    OnMarkedDirty(node_);
+}
+
+void SatelliteField::RebaseBlocks(unsigned begin, unsigned end)
+{
+    const double epoch = epoch_;
+
+    for (unsigned i = begin * 4; i < end * 4; ++i)
+    {
+        raan_[i] = AngleAt(raan0_[i], raanRate_[i], epoch);
+        argPerigee_[i] = AngleAt(argPerigee0_[i], argPerigeeRate_[i], epoch);
+        meanAnomaly_[i] = AngleAt(meanAnomaly0_[i], meanAnomalyRate_[i], epoch);
+    }
+}
+
+void SatelliteField::PropagateBlocks(unsigned begin, unsigned end)
+{
+    const float dt = elapsed_;
+    const unsigned last = Min(end * 4, numObjects_);
+
+    for (unsigned i = begin * 4; i < last; ++i)
+    {
+        float e = eccentricity_[i];
+        float m = meanAnomaly_[i] + meanAnomalyRate_[i] * dt;
+        float raan = raan_[i] + raanRate_[i] * dt;
+        float argPerigee = argPerigee_[i] + argPerigeeRate_[i] * dt;
+
+        // Kepler's equation by Newton's method
+        float ecc = m + e * sinf(m);
+        for (unsigned k = 0; k < KEPLER_ITERATIONS; ++k)
+            ecc -= (ecc - e * sinf(ecc) - m) / (1.0f - e * cosf(ecc));
+
+        float x = semiMajorAxis_[i] * (cosf(ecc) - e);
+        float y = semiMinorAxis_[i] * sinf(ecc);
+
+        float cosNode = cosf(raan);
+        float sinNode = sinf(raan);
+        float cosArg = cosf(argPerigee);
+        float sinArg = sinf(argPerigee);
+        float cosI = cosInclination_[i];
+        float sinI = sinInclination_[i];
+
+        // Perifocal to equatorial axes; the north pole is +Y of the node
+        float* vertex = &vertexData_[i * 4];
+        vertex[0] = x * (cosNode * cosArg - sinNode * sinArg * cosI) - y * (cosNode * sinArg + sinNode * cosArg * cosI);
+        vertex[2] = x * (sinNode * cosArg + cosNode * sinArg * cosI) - y * (sinNode * sinArg - cosNode * cosArg * cosI);
+        vertex[1] = x * sinArg * sinI + y * cosArg * sinI;
+    }
+}
+
+void SatelliteField::PropagateBlocksSSE(unsigned begin, unsigned end)
+{
+#ifdef URHO3D_SSE
+    const __m128 dt = _mm_set1_ps(elapsed_);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 twoPi = _mm_set1_ps(2.0f * M_PI);
+    const __m128 invTwoPi = _mm_set1_ps(0.5f / M_PI);
+
+    for (unsigned block = begin; block < end; ++block)
+    {
+        unsigned i = block * 4;
+
+        __m128 e = _mm_loadu_ps(&eccentricity_[i]);
+        __m128 m = MulAdd(_mm_loadu_ps(&meanAnomaly_[i]), _mm_loadu_ps(&meanAnomalyRate_[i]), dt);
+        __m128 raan = MulAdd(_mm_loadu_ps(&raan_[i]), _mm_loadu_ps(&raanRate_[i]), dt);
+        __m128 argPerigee = MulAdd(_mm_loadu_ps(&argPerigee_[i]), _mm_loadu_ps(&argPerigeeRate_[i]), dt);
+
+        // Mean anomaly back to [-pi, pi] so that Newton starts close to the root
+        m = _mm_sub_ps(m, _mm_mul_ps(twoPi, _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(m, invTwoPi)))));
+
+        __m128 s, c;
+        SinCos4(m, s, c);
+        __m128 ecc = MulAdd(m, e, s);
+        for (unsigned k = 0; k < KEPLER_ITERATIONS; ++k)
+        {
+            SinCos4(ecc, s, c);
+            __m128 f = _mm_sub_ps(_mm_sub_ps(ecc, _mm_mul_ps(e, s)), m);
+            __m128 df = _mm_sub_ps(one, _mm_mul_ps(e, c));
+            ecc = _mm_sub_ps(ecc, _mm_div_ps(f, df));
+        }
+        SinCos4(ecc, s, c);
+
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(&semiMajorAxis_[i]), _mm_sub_ps(c, e));
+        __m128 y = _mm_mul_ps(_mm_loadu_ps(&semiMinorAxis_[i]), s);
+
+        __m128 cosNode, sinNode, cosArg, sinArg;
+        SinCos4(raan, sinNode, cosNode);
+        SinCos4(argPerigee, sinArg, cosArg);
+        __m128 cosI = _mm_loadu_ps(&cosInclination_[i]);
+        __m128 sinI = _mm_loadu_ps(&sinInclination_[i]);
+
+        // Perifocal to equatorial axes; the north pole is +Y of the node
+        __m128 sinArgCosI = _mm_mul_ps(sinArg, cosI);
+        __m128 cosArgCosI = _mm_mul_ps(cosArg, cosI);
+        __m128 px = _mm_sub_ps(_mm_mul_ps(cosNode, cosArg), _mm_mul_ps(sinNode, sinArgCosI));
+        __m128 pz = MulAdd(_mm_mul_ps(sinNode, cosArg), cosNode, sinArgCosI);
+        __m128 qx = _mm_add_ps(_mm_mul_ps(cosNode, sinArg), _mm_mul_ps(sinNode, cosArgCosI));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sinNode, sinArg), _mm_mul_ps(cosNode, cosArgCosI));
+
+        float px4[4], py4[4], pz4[4];
+        _mm_storeu_ps(px4, _mm_sub_ps(_mm_mul_ps(x, px), _mm_mul_ps(y, qx)));
+        _mm_storeu_ps(py4, _mm_mul_ps(MulAdd(_mm_mul_ps(x, sinArg), y, cosArg), sinI));
+        _mm_storeu_ps(pz4, _mm_sub_ps(_mm_mul_ps(x, pz), _mm_mul_ps(y, qz)));
+
+        unsigned count = Min(numObjects_ - i, 4U);
+        for (unsigned j = 0; j < count; ++j)
+        {
+            float* vertex = &vertexData_[(i + j) * 4];
+            vertex[0] = px4[j];
+            vertex[1] = py4[j];
+            vertex[2] = pz4[j];
+        }
+    }
+#else
+    PropagateBlocks(begin, end);
+#endif
+}
+
+void SatelliteField::PropagateWork(const WorkItem* item, unsigned threadIndex)
+{
+    SatelliteField* field = reinterpret_cast<SatelliteField*>(item->aux_);
+    unsigned begin = (unsigned)reinterpret_cast<size_t>(item->start_);
+    unsigned end = (unsigned)reinterpret_cast<size_t>(item->end_);
+
+    if (field->rebase_)
+        field->RebaseBlocks(begin, end);
+
+    if (field->vectorized_)
+        field->PropagateBlocksSSE(begin, end);
+    else
+        field->PropagateBlocks(begin, end);
+}
+
+void SatelliteField::Benchmark(Context* context)
+{
+    static const unsigned counts[] = { 10000, 50000, 100000, 200000 };
+    static const unsigned NUM_TICKS = 60;
+
+    for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        SharedPtr<Scene> scene(new Scene(context));
+        SatelliteField* field = scene->CreateChild("BenchmarkSatellites")->CreateComponent<SatelliteField>();
+        field->Generate(counts[c], 1);
+
+        for (unsigned pass = 0; pass < 2; ++pass)
+        {
+            field->SetVectorized(pass == 1);
+            if (pass == 1 && !field->IsVectorized())
+                break;
+
+            long long propagateTime = 0;
+            long long uploadTime = 0;
+            for (unsigned tick = 0; tick < NUM_TICKS; ++tick)
+            {
+                field->Propagate(tick / 60.0);
+                propagateTime += field->GetLastPropagateTime();
+                uploadTime += field->GetLastUploadTime();
+            }
+
+            double perTick = propagateTime / 1000.0 / NUM_TICKS;
+            printf("satellites=%u %s propagate=%.3f ms per tick (%.1f us per 10k) upload=%.3f ms\n", field->GetNumObjects(),
+                field->IsVectorized() ? "sse" : "scalar", perTick, perTick * 1000.0 * 10000.0 / field->GetNumObjects(),
+                uploadTime / 1000.0 / NUM_TICKS);
+        }
+    }
+}
@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Graphics/Drawable.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Geometry;
+class Material;
+class VertexBuffer;
+struct WorkItem;
+
+}
+
+struct SatelliteRecord;
+
+/// Satellites and debris around the Earth, drawn as points from one dynamic vertex buffer.
+/// Node-local coordinates are kilometres in the equatorial frame (Y towards the north pole), so the node carries the
+/// axial tilt and the km to scene unit scale. Elements are stored as structure of arrays and propagated in closed form
+/// with the J2 secular drift, four objects at a time with SSE, across the WorkQueue threads.
+class SatelliteField : public Drawable
+{
+    URHO3D_OBJECT(SatelliteField, Drawable);
+
+public:
+    /// Construct.
+    SatelliteField(Context* context);
+    /// Destruct.
+    virtual ~SatelliteField();
+
+    /// Load a binary satellite catalog. Return true on success.
+    bool Load(const String& fileName);
+    /// Generate a synthetic population: constellation shells, sun-synchronous and navigation orbits, the geostationary
+    /// ring, transfer orbit rocket bodies and fragmentation debris.
+    void Generate(unsigned count, unsigned seed);
+    /// Set the material.
+    void SetMaterial(Material* material);
+    /// Set how many orbit minutes elapse per second of simulation time. Real rates would turn a low orbit hundreds of
+    /// times per simulated second.
+    void SetTimeScale(float minutesPerSecond) { timeScale_ = minutesPerSecond; }
+    /// Set whether to use the SSE path when it is compiled in.
+    void SetVectorized(bool enable) { vectorized_ = enable; }
+    /// Move all objects to their positions at a simulation time and upload the vertex buffer.
+    void Propagate(double time);
+
+    /// Return number of objects.
+    unsigned GetNumObjects() const { return numObjects_; }
+    /// Return orbit minutes per second of simulation time.
+    float GetTimeScale() const { return timeScale_; }
+    /// Return whether the SSE path is in use.
+    bool IsVectorized() const;
+    /// Return duration of the last propagation in microseconds, vertex upload excluded.
+    long long GetLastPropagateTime() const { return lastPropagateTime_; }
+    /// Return duration of the last vertex upload in microseconds.
+    long long GetLastUploadTime() const { return lastUploadTime_; }
+
+    /// Print propagation time per tick and per 10k objects for 10k to 200k objects, scalar and vectorized.
+    static void Benchmark(Context* context);
+
+protected:
+    /// Handle node being assigned.
+    virtual void OnNodeSet(Node* node);
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+
+private:
+    /// Handle scene update event.
+    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    /// Build the element arrays and the vertex buffer from catalog records.
+    void SetElements(const SatelliteRecord* records, unsigned count);
+    /// Recompute the angles at the epoch of a range of blocks of four objects, in double precision.
+    void RebaseBlocks(unsigned begin, unsigned end);
+    /// Propagate a range of blocks of four objects with scalar code.
+    void PropagateBlocks(unsigned begin, unsigned end);
+    /// Propagate a range of blocks of four objects with SSE.
+    void PropagateBlocksSSE(unsigned begin, unsigned end);
+    /// Work item entry point.
+    static void PropagateWork(const WorkItem* item, unsigned threadIndex);
+
+    /// Vertex buffer, rewritten every tick.
+    SharedPtr<VertexBuffer> vertexBuffer_;
+    /// Point list geometry.
+    SharedPtr<Geometry> geometry_;
+    /// Material.
+    SharedPtr<Material> material_;
+    /// Semi-major axis in km.
+    PODVector<float> semiMajorAxis_;
+    /// Semi-minor axis in km.
+    PODVector<float> semiMinorAxis_;
+    /// Eccentricity.
+    PODVector<float> eccentricity_;
+    /// Cosine of the inclination.
+    PODVector<float> cosInclination_;
+    /// Sine of the inclination.
+    PODVector<float> sinInclination_;
+    /// Right ascension of the ascending node at time zero.
+    PODVector<float> raan0_;
+    /// Argument of perigee at time zero.
+    PODVector<float> argPerigee0_;
+    /// Mean anomaly at time zero.
+    PODVector<float> meanAnomaly0_;
+    /// Node regression in radians per minute.
+    PODVector<float> raanRate_;
+    /// Apsidal rotation in radians per minute.
+    PODVector<float> argPerigeeRate_;
+    /// Mean anomaly rate in radians per minute.
+    PODVector<float> meanAnomalyRate_;
+    /// Right ascension of the ascending node at the epoch.
+    PODVector<float> raan_;
+    /// Argument of perigee at the epoch.
+    PODVector<float> argPerigee_;
+    /// Mean anomaly at the epoch.
+    PODVector<float> meanAnomaly_;
+    /// Vertices: position and color.
+    PODVector<float> vertexData_;
+    /// Number of objects.
+    unsigned numObjects_;
+    /// Number of blocks of four objects; the arrays are padded to whole blocks.
+    unsigned numBlocks_;
+    /// Largest apogee radius in km.
+    float maxRadius_;
+    /// Orbit minutes per second of simulation time.
+    float timeScale_;
+    /// Orbit time of the epoch the float angles are relative to, in minutes.
+    double epoch_;
+    /// Simulation time of the last propagation.
+    double time_;
+    /// Orbit minutes from the epoch to the last propagation.
+    float elapsed_;
+    /// Whether the angles at the epoch must be recomputed during the next propagation.
+    bool rebase_;
+    /// Whether to use the SSE path.
+    bool vectorized_;
+    /// Duration of the last propagation in microseconds.
+    long long lastPropagateTime_;
+    /// Duration of the last vertex upload in microseconds.
+    long long lastUploadTime_;
+};
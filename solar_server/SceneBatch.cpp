@@ -0,0 +1,146 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/IO/Deserializer.h>
+#include <Urho3D/IO/Serializer.h>
+
+#include "SceneBatch.h"
+
+#include <Urho3D/DebugNew.h>
+
+static unsigned AddName(Vector<String>& names, const String& name)
+{
+    for (unsigned i = 0; i < names.Size(); ++i)
+    {
+        if (names[i] == name)
+            return i;
+    }
+    names.Push(name);
+    return names.Size() - 1;
+}
+
+static bool ReadNames(Deserializer& source, Vector<String>& names)
+{
+    unsigned count = source.ReadVLE();
+    if (count > SceneBatch::MAX_RESOURCES)
+        return false;
+
+    names.Resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        names[i] = source.ReadString();
+        if (names[i].Empty() || names[i].Contains(".."))
+            return false;
+    }
+    return true;
+}
+
+/// Return whether a value is neither infinite nor NaN: both give NaN once multiplied by zero.
+static bool IsFinite(float value)
+{
+    return !IsNaN(value * 0.0f);
+}
+
+static bool IsFinite(const Vector3& vector)
+{
+    return IsFinite(vector.x_) && IsFinite(vector.y_) && IsFinite(vector.z_);
+}
+
+static bool IsFinite(const Quaternion& quaternion)
+{
+    return IsFinite(quaternion.w_) && IsFinite(quaternion.x_) && IsFinite(quaternion.y_) && IsFinite(quaternion.z_);
+}
+
+SceneBatch::SceneBatch()
+{
+}
+
+void SceneBatch::Clear()
+{
+    prefix_.Clear();
+    models_.Clear();
+    materials_.Clear();
+    objects_.Clear();
+}
+
+unsigned SceneBatch::AddModel(const String& name)
+{
+    return AddName(models_, name);
+}
+
+unsigned SceneBatch::AddMaterial(const String& name)
+{
+    return AddName(materials_, name);
+}
+
+void SceneBatch::Write(Serializer& dest) const
+{
+    dest.WriteString(prefix_);
+    dest.WriteVLE(models_.Size());
+    for (unsigned i = 0; i < models_.Size(); ++i)
+        dest.WriteString(models_[i]);
+    dest.WriteVLE(materials_.Size());
+    for (unsigned i = 0; i < materials_.Size(); ++i)
+        dest.WriteString(materials_[i]);
+
+    dest.WriteVLE(objects_.Size());
+    for (unsigned i = 0; i < objects_.Size(); ++i)
+    {
+        const SceneBatchObject& object = objects_[i];
+        dest.WriteVLE(object.id_);
+        dest.WriteVector3(object.position_);
+        dest.WriteQuaternion(object.rotation_);
+        dest.WriteVector3(object.scale_);
+        dest.WriteVLE(object.model_);
+        dest.WriteVLE(object.material_);
+    }
+}
+
+bool SceneBatch::Read(Deserializer& source)
+{
+    prefix_ = source.ReadString();
+    if (prefix_.Empty() || !ReadNames(source, models_) || !ReadNames(source, materials_))
+        return false;
+
+    // the smallest object takes 43 bytes: a truncated batch is rejected before the objects are read
+    unsigned count = source.ReadVLE();
+    if (count > MAX_OBJECTS || count * 43 > source.GetSize() - source.GetPosition())
+        return false;
+
+    objects_.Resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        SceneBatchObject& object = objects_[i];
+        object.id_ = source.ReadVLE();
+        object.position_ = source.ReadVector3();
+        object.rotation_ = source.ReadQuaternion();
+        object.scale_ = source.ReadVector3();
+        object.model_ = source.ReadVLE();
+        object.material_ = source.ReadVLE();
+
+        if (object.model_ >= models_.Size() || object.material_ >= materials_.Size() ||
+            !IsFinite(object.position_) || !IsFinite(object.rotation_) || !IsFinite(object.scale_))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,114 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Math/Quaternion.h>
+#include <Urho3D/Math/Vector3.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Deserializer;
+class Serializer;
+
+}
+
+/// Object of a scene batch.
+struct SceneBatchObject
+{
+    /// Id, the object being named after the batch prefix followed by the id.
+    unsigned id_;
+    /// Position.
+    Vector3 position_;
+    /// Rotation.
+    Quaternion rotation_;
+    /// Scale.
+    Vector3 scale_;
+    /// Index of the model in the batch.
+    unsigned model_;
+    /// Index of the material in the batch.
+    unsigned material_;
+};
+
+/// Objects created or updated by one scene batch message, instead of one "CO" text command per object. Models and
+/// materials are listed once and referred to by index, so that the wall resolves each resource once per batch. An
+/// object whose name already exists is updated in place.
+///
+/// Layout, in the Urho3D serialization:
+/// - String name prefix;
+/// - VLE model count, String model name (under Models/) per model;
+/// - VLE material count, String material name (under Materials/) per material;
+/// - VLE object count, then per object VLE id, Vector3 position, Quaternion rotation, Vector3 scale, VLE model index
+///   and VLE material index.
+class SceneBatch
+{
+public:
+    /// Construct.
+    SceneBatch();
+
+    /// Empty the batch for reuse, keeping its allocations.
+    void Clear();
+    /// Set the name prefix of the objects.
+    void SetPrefix(const String& prefix) { prefix_ = prefix; }
+    /// Return the index of a model, adding it if needed.
+    unsigned AddModel(const String& name);
+    /// Return the index of a material, adding it if needed.
+    unsigned AddMaterial(const String& name);
+    /// Add an object.
+    void AddObject(const SceneBatchObject& object) { objects_.Push(object); }
+
+    /// Write the batch.
+    void Write(Serializer& dest) const;
+    /// Read a batch, reusing the allocations of the previous one. Return false if it is truncated, too large, has a
+    /// resource name holding "..", an index out of range or a transform that is not finite.
+    bool Read(Deserializer& source);
+
+    /// Return the name prefix of the objects.
+    const String& GetPrefix() const { return prefix_; }
+    /// Return the model names.
+    const Vector<String>& GetModels() const { return models_; }
+    /// Return the material names.
+    const Vector<String>& GetMaterials() const { return materials_; }
+    /// Return the objects.
+    const PODVector<SceneBatchObject>& GetObjects() const { return objects_; }
+
+    /// Most objects per batch.
+    static const unsigned MAX_OBJECTS = 65536;
+    /// Most models or materials per batch.
+    static const unsigned MAX_RESOURCES = 256;
+
+private:
+    /// Name prefix of the objects.
+    String prefix_;
+    /// Model names.
+    Vector<String> models_;
+    /// Material names.
+    Vector<String> materials_;
+    /// Objects.
+    PODVector<SceneBatchObject> objects_;
+};
@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+/// Scene edit commands received from the clients, parsed without Urho3D so that tools/SceneCommandFuzzer can run the
+/// parser alone. Words are separated by spaces:
+/// - "CO <name> <x> <y> <z> <sx> <sy> <sz> <pitch> <yaw> <roll> <model> <material> <hidden material> <visible>"
+///   creates an object, replacing an object of the same name;
+/// - "CA <name> <point> <sx> <sy> <sz> <pitch> <yaw> <roll> <model> <material> <hidden material> <visible>" creates
+///   an object at a point;
+/// - "CP <name> <x> <y> <z>" creates or moves a point;
+/// - "MO <name> <point>" moves an object to a point.
+/// A command with a missing or extra word, a word longer than SCENE_NAME_LENGTH - 1 characters, a number that is not
+/// finite or a resource name holding ".." is rejected as a whole.
+
+/// Size of the name buffers, terminating null included.
+static const unsigned SCENE_NAME_LENGTH = 100;
+
+/// Scene edit command types.
+enum SceneCommandType
+{
+    SCENE_CREATE_OBJECT = 0,
+    SCENE_CREATE_OBJECT_AT_POINT,
+    SCENE_CREATE_POINT,
+    SCENE_MOVE_OBJECT
+};
+
+/// Parsed scene edit command. Only the fields of its type are set.
+struct SceneCommand
+{
+    /// Command type.
+    SceneCommandType type_;
+    /// Object or point name.
+    char name_[SCENE_NAME_LENGTH];
+    /// Point the object is created at or moved to.
+    char point_[SCENE_NAME_LENGTH];
+    /// Position of the object or the point.
+    float position_[3];
+    /// Scale of the object.
+    float scale_[3];
+    /// Rotation of the object, Euler angles in degrees.
+    float rotation_[3];
+    /// Model, under Models/.
+    char model_[SCENE_NAME_LENGTH];
+    /// Material when visible, under Materials/.
+    char material_[SCENE_NAME_LENGTH];
+    /// Material when hidden, under Materials/.
+    char hiddenMaterial_[SCENE_NAME_LENGTH];
+    /// Whether the object shows its visible material.
+    bool visible_;
+};
+
+/// Read the next word into a buffer of SCENE_NAME_LENGTH characters. Return false if there is none or it is too long.
+inline bool ReadSceneWord(const char*& text, char* dest)
+{
+    while (*text == ' ')
+        ++text;
+    unsigned length = 0;
+    while (text[length] && text[length] != ' ')
+    {
+        if (length == SCENE_NAME_LENGTH - 1)
+            return false;
+        dest[length] = text[length];
+        ++length;
+    }
+    dest[length] = 0;
+    text += length;
+    return length > 0;
+}
+
+/// Read the next word as a resource name: no parent directory.
+inline bool ReadSceneResource(const char*& text, char* dest)
+{
+    return ReadSceneWord(text, dest) && !strstr(dest, "..");
+}
+
+/// Read the next words as finite numbers.
+inline bool ReadSceneFloats(const char*& text, float* dest, unsigned count)
+{
+    char word[SCENE_NAME_LENGTH];
+    for (unsigned i = 0; i < count; ++i)
+    {
+        char* end;
+        if (!ReadSceneWord(text, word))
+            return false;
+        dest[i] = strtof(word, &end);
+        if (*end || !std::isfinite(dest[i]))
+            return false;
+    }
+    return true;
+}
+
+/// Read the next word as an integer flag.
+inline bool ReadSceneFlag(const char*& text, bool& dest)
+{
+    char word[SCENE_NAME_LENGTH];
+    char* end;
+    if (!ReadSceneWord(text, word))
+        return false;
+    long value = strtol(word, &end, 10);
+    dest = value == 1;
+    return !*end;
+}
+
+/// Return whether a command is a scene edit command, from its prefix.
+inline bool IsSceneCommand(const char* text)
+{
+    return (text[0] == 'C' && (text[1] == 'O' || text[1] == 'A' || text[1] == 'P') && text[2] == ' ') ||
+        (text[0] == 'M' && text[1] == 'O' && text[2] == ' ');
+}
+
+/// Parse a scene edit command. Return false if it is malformed, dest then being partly written.
+inline bool ParseSceneCommand(const char* text, SceneCommand& dest)
+{
+    if (!IsSceneCommand(text))
+        return false;
+
+    if (text[0] == 'M')
+        dest.type_ = SCENE_MOVE_OBJECT;
+    else if (text[1] == 'O')
+        dest.type_ = SCENE_CREATE_OBJECT;
+    else if (text[1] == 'A')
+        dest.type_ = SCENE_CREATE_OBJECT_AT_POINT;
+    else
+        dest.type_ = SCENE_CREATE_POINT;
+    text += 3;
+
+    if (!ReadSceneWord(text, dest.name_))
+        return false;
+
+    bool ok = true;
+    switch (dest.type_)
+    {
+    case SCENE_CREATE_OBJECT:
+    case SCENE_CREATE_OBJECT_AT_POINT:
+        if (dest.type_ == SCENE_CREATE_OBJECT)
+            ok = ReadSceneFloats(text, dest.position_, 3);
+        else
+            ok = ReadSceneWord(text, dest.point_);
+        ok = ok && ReadSceneFloats(text, dest.scale_, 3) && ReadSceneFloats(text, dest.rotation_, 3) &&
+            ReadSceneResource(text, dest.model_) && ReadSceneResource(text, dest.material_) &&
+            ReadSceneResource(text, dest.hiddenMaterial_) && ReadSceneFlag(text, dest.visible_);
+        break;
+
+    case SCENE_CREATE_POINT:
+        ok = ReadSceneFloats(text, dest.position_, 3);
+        break;
+
+    case SCENE_MOVE_OBJECT:
+        ok = ReadSceneWord(text, dest.point_);
+        break;
+    }
+
+    // nothing but spaces may follow
+    while (*text == ' ')
+        ++text;
+    return ok && !*text;
+}
@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+
+#include "SceneSnapshot.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+#include <ctime>
+
+SceneSnapshot::SceneSnapshot(Context* context) :
+    Object(context),
+    numWrites_(0)
+{
+}
+
+SceneSnapshot::~SceneSnapshot()
+{
+    // The worker reads buffer_, let it finish
+    if (IsWriting())
+        GetSubsystem<WorkQueue>()->Complete(0);
+}
+
+bool SceneSnapshot::IsWriting() const
+{
+    return item_ && !item_->completed_;
+}
+
+bool SceneSnapshot::WriteAsync(const VectorBuffer& data)
+{
+    if (fileName_.Empty() || IsWriting())
+        return false;
+
+    buffer_.SetData(data.GetData(), data.GetSize());
+    ++numWrites_;
+
+    item_ = new WorkItem();
+    item_->workFunction_ = WriteWork;
+    item_->aux_ = this;
+    // Lowest priority, so that the frame never waits for the disk
+    item_->priority_ = 0;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue->GetNumThreads())
+        queue->AddWorkItem(item_);
+    else
+    {
+        WriteWork(item_, 0);
+        item_->completed_ = true;
+    }
+    return true;
+}
+
+bool SceneSnapshot::Read(VectorBuffer& dest, unsigned maxAge) const
+{
+    FileSystem* fileSystem = GetSubsystem<FileSystem>();
+    if (fileName_.Empty() || !fileSystem->FileExists(fileName_))
+        return false;
+
+    // A snapshot left over from an earlier show must not hijack a normal start
+    unsigned modified = fileSystem->GetLastModifiedTime(fileName_);
+    unsigned now = (unsigned)time(0);
+    if (now > modified && now - modified > maxAge)
+        return false;
+
+    File file(context_, fileName_);
+    if (!file.IsOpen())
+        return false;
+
+    dest.SetData(file, file.GetSize());
+    return dest.GetSize() == file.GetSize();
+}
+
+void SceneSnapshot::WriteWork(const WorkItem* item, unsigned threadIndex)
+{
+    SceneSnapshot* snapshot = reinterpret_cast<SceneSnapshot*>(item->aux_);
+    String tempName = snapshot->fileName_ + ".tmp";
+
+    FILE* file = fopen(tempName.CString(), "wb");
+    if (!file)
+        return;
+
+    bool success = fwrite(snapshot->buffer_.GetData(), 1, snapshot->buffer_.GetSize(), file) == snapshot->buffer_.GetSize();
+    success &= fclose(file) == 0;
+    if (!success)
+    {
+        remove(tempName.CString());
+        return;
+    }
+
+#ifdef _WIN32
+    remove(snapshot->fileName_.CString());
+#endif
+    rename(tempName.CString(), snapshot->fileName_.CString());
+}
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+struct WorkItem;
+
+}
+
+/// File identifier at the start of a snapshot.
+static const char* SNAPSHOT_ID = "SNAP";
+/// Current snapshot version.
+static const unsigned SNAPSHOT_VERSION = 1;
+
+/// Periodic binary snapshot of the simulation state of a wall, so that a restarted wall resumes the show at once.
+/// The application serializes its state into a buffer on the main thread, which takes microseconds; the buffer is then
+/// written on a worker thread to a temporary file renamed over the previous snapshot, so that a crash during the write
+/// never leaves a truncated snapshot behind.
+class SceneSnapshot : public Object
+{
+    URHO3D_OBJECT(SceneSnapshot, Object);
+
+public:
+    /// Construct.
+    SceneSnapshot(Context* context);
+    /// Destruct. Waits for a pending write.
+    virtual ~SceneSnapshot();
+
+    /// Set the snapshot file name.
+    void SetFileName(const String& fileName) { fileName_ = fileName; }
+    /// Start writing a snapshot in the background. Return false if the previous write is still running.
+    bool WriteAsync(const VectorBuffer& data);
+    /// Read the snapshot file if it is younger than maxAge seconds. Return true on success.
+    bool Read(VectorBuffer& dest, unsigned maxAge) const;
+
+    /// Return the snapshot file name.
+    const String& GetFileName() const { return fileName_; }
+    /// Return whether a write is running.
+    bool IsWriting() const;
+    /// Return the number of snapshots written.
+    unsigned GetNumWrites() const { return numWrites_; }
+
+private:
+    /// Write the buffer to the file, on a worker thread.
+    static void WriteWork(const WorkItem* item, unsigned threadIndex);
+
+    /// Snapshot file name.
+    String fileName_;
+    /// Data being written.
+    VectorBuffer buffer_;
+    /// Pending write.
+    SharedPtr<WorkItem> item_;
+    /// Number of snapshots written.
+    unsigned numWrites_;
+};
@@ -0,0 +1,737 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Math/Frustum.h>
+#include <Urho3D/Math/Ray.h>
+#include <Urho3D/Math/Sphere.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "BodySystem.h"
+#include "SpatialIndex.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+/// Leaf box enlargement as a fraction of the sphere radius.
+static const float FAT_RADIUS_RATIO = 0.5f;
+/// Leaf box enlargement along the displacement, in frames of motion.
+static const float FAT_DISPLACEMENT_FRAMES = 4.0f;
+/// Traversal stack size, far above the height of a balanced tree.
+static const unsigned STACK_SIZE = 256;
+
+/// Return the surface area of a box, the insertion cost.
+static inline float SurfaceArea(const BoundingBox& box)
+{
+    Vector3 size = box.max_ - box.min_;
+    return 2.0f * (size.x_ * size.y_ + size.y_ * size.z_ + size.z_ * size.x_);
+}
+
+/// Return the union of two boxes.
+static inline BoundingBox Union(const BoundingBox& a, const BoundingBox& b)
+{
+    BoundingBox box(a);
+    box.Merge(b);
+    return box;
+}
+
+/// Return the squared distance from a point to a box, zero inside.
+static inline float DistanceSquared(const BoundingBox& box, const Vector3& point)
+{
+    Vector3 closest(Clamp(point.x_, box.min_.x_, box.max_.x_), Clamp(point.y_, box.min_.y_, box.max_.y_),
+        Clamp(point.z_, box.min_.z_, box.max_.z_));
+    return (point - closest).LengthSquared();
+}
+
+SpatialIndex::SpatialIndex(Context* context) :
+    Component(context),
+    root_(-1),
+    freeList_(-1),
+    lastUpdateTime_(0),
+    lastReinsertCount_(0)
+{
+}
+
+SpatialIndex::~SpatialIndex()
+{
+}
+
+void SpatialIndex::AddNode(Node* node, float radius)
+{
+    if (!node)
+        return;
+    // A destroyed node whose proxy is not collected yet may share its address with the new one
+    HashMap<Node*, unsigned>::Iterator i = proxyMap_.Find(node);
+    if (i != proxyMap_.End())
+    {
+        if (proxies_[i->second_].node_)
+            return;
+        RemoveProxy(i->second_);
+    }
+
+    // Boxes are stored relative to the floating origin current when the tree is started
+    if (proxyMap_.Empty())
+    {
+        BodySystem* bodySystem = GetScene() ? GetScene()->GetComponent<BodySystem>() : 0;
+        origin_ = bodySystem ? bodySystem->GetOrigin() : DoubleVector3();
+    }
+
+    unsigned index;
+    if (freeProxies_.Empty())
+    {
+        index = proxies_.Size();
+        proxies_.Resize(index + 1);
+    }
+    else
+    {
+        index = freeProxies_.Back();
+        freeProxies_.Pop();
+    }
+
+    Proxy& proxy = proxies_[index];
+    proxy.node_ = node;
+    proxy.key_ = node;
+    proxy.radius_ = radius;
+    proxy.center_ = node->GetWorldPosition();
+    proxy.leaf_ = AllocateNode();
+
+    TreeNode& leaf = nodes_[proxy.leaf_];
+    leaf.box_ = FatBox(proxy.center_, radius, Vector3::ZERO);
+    leaf.proxy_ = index;
+    leaf.height_ = 0;
+    InsertLeaf(proxy.leaf_);
+
+    proxyMap_[node] = index;
+}
+
+void SpatialIndex::RemoveNode(Node* node)
+{
+    HashMap<Node*, unsigned>::Iterator i = proxyMap_.Find(node);
+    if (i != proxyMap_.End())
+        RemoveProxy(i->second_);
+}
+
+void SpatialIndex::Update()
+{
+    URHO3D_PROFILE(UpdateSpatialIndex);
+
+    HiresTimer timer;
+
+    // Follow a floating origin rebase: the tree shape is unchanged, every box moves by the same offset
+    BodySystem* bodySystem = GetScene() ? GetScene()->GetComponent<BodySystem>() : 0;
+    if (bodySystem)
+    {
+        const DoubleVector3& origin = bodySystem->GetOrigin();
+        if (origin.x_ != origin_.x_ || origin.y_ != origin_.y_ || origin.z_ != origin_.z_)
+        {
+            Vector3 shift = (origin_ - origin).ToVector3();
+            for (unsigned i = 0; i < nodes_.Size(); ++i)
+            {
+                if (nodes_[i].height_ >= 0)
+                {
+                    nodes_[i].box_.min_ += shift;
+                    nodes_[i].box_.max_ += shift;
+                }
+            }
+            for (unsigned i = 0; i < proxies_.Size(); ++i)
+                proxies_[i].center_ += shift;
+            origin_ = origin;
+        }
+    }
+
+    lastReinsertCount_ = 0;
+    for (unsigned i = 0; i < proxies_.Size(); ++i)
+    {
+        Proxy& proxy = proxies_[i];
+        if (proxy.leaf_ < 0)
+            continue;
+
+        Node* node = proxy.node_;
+        if (!node)
+        {
+            RemoveProxy(i);
+            continue;
+        }
+
+        Vector3 center = node->GetWorldPosition();
+        Vector3 displacement = center - proxy.center_;
+        proxy.center_ = center;
+
+        Vector3 extent(proxy.radius_, proxy.radius_, proxy.radius_);
+        if (nodes_[proxy.leaf_].box_.IsInside(BoundingBox(center - extent, center + extent)) == INSIDE)
+            continue;
+
+        // Left its enlarged box: reinsert with a box stretched along the motion
+        RemoveLeaf(proxy.leaf_);
+        nodes_[proxy.leaf_].box_ = FatBox(center, proxy.radius_, displacement);
+        InsertLeaf(proxy.leaf_);
+        ++lastReinsertCount_;
+    }
+
+    lastUpdateTime_ = timer.GetUSec(false);
+}
+
+bool SpatialIndex::QueryNearest(const Vector3& point, float maxDistance, SpatialQueryResult& result, Node* exclude) const
+{
+    result.node_ = 0;
+    if (root_ < 0)
+        return false;
+
+    // Branch and bound: the distance to a box bounds the distance to any sphere inside, clamped at the surface
+    float best = maxDistance;
+    int stack[STACK_SIZE];
+    unsigned size = 0;
+    stack[size++] = root_;
+
+    while (size)
+    {
+        const TreeNode& node = nodes_[stack[--size]];
+        float boxDistance = sqrtf(DistanceSquared(node.box_, point));
+        if (boxDistance > Max(best, 0.0f))
+            continue;
+
+        if (node.child1_ < 0)
+        {
+            const Proxy& proxy = proxies_[node.proxy_];
+            if (proxy.node_ == exclude)
+                continue;
+            float distance = (proxy.center_ - point).Length() - proxy.radius_;
+            if (distance <= best)
+            {
+                best = distance;
+                result.node_ = proxy.node_;
+                result.radius_ = proxy.radius_;
+                result.distance_ = distance;
+            }
+            continue;
+        }
+
+        if (size + 2 > STACK_SIZE)
+            continue;
+
+        // Visit the closer child first so that the bound tightens early
+        const TreeNode& child1 = nodes_[node.child1_];
+        const TreeNode& child2 = nodes_[node.child2_];
+        if (DistanceSquared(child1.box_, point) < DistanceSquared(child2.box_, point))
+        {
+            stack[size++] = node.child2_;
+            stack[size++] = node.child1_;
+        }
+        else
+        {
+            stack[size++] = node.child1_;
+            stack[size++] = node.child2_;
+        }
+    }
+
+    return result.node_ != 0;
+}
+
+bool SpatialIndex::Raycast(const Ray& ray, float maxDistance, SpatialQueryResult& result, Node* exclude) const
+{
+    result.node_ = 0;
+    if (root_ < 0)
+        return false;
+
+    float best = maxDistance;
+    int stack[STACK_SIZE];
+    unsigned size = 0;
+    stack[size++] = root_;
+
+    while (size)
+    {
+        const TreeNode& node = nodes_[stack[--size]];
+        float boxDistance = ray.HitDistance(node.box_);
+        if (boxDistance == M_INFINITY || boxDistance > best)
+            continue;
+
+        if (node.child1_ < 0)
+        {
+            const Proxy& proxy = proxies_[node.proxy_];
+            if (proxy.node_ == exclude)
+                continue;
+            float distance = ray.HitDistance(Sphere(proxy.center_, proxy.radius_));
+            if (distance < best)
+            {
+                best = distance;
+                result.node_ = proxy.node_;
+                result.radius_ = proxy.radius_;
+                result.distance_ = distance;
+            }
+            continue;
+        }
+
+        if (size + 2 > STACK_SIZE)
+            continue;
+        stack[size++] = node.child1_;
+        stack[size++] = node.child2_;
+    }
+
+    return result.node_ != 0;
+}
+
+void SpatialIndex::QueryRadius(const Vector3& center, float radius, PODVector<Node*>& result) const
+{
+    if (root_ < 0)
+        return;
+
+    int stack[STACK_SIZE];
+    unsigned size = 0;
+    stack[size++] = root_;
+
+    while (size)
+    {
+        const TreeNode& node = nodes_[stack[--size]];
+        if (DistanceSquared(node.box_, center) > radius * radius)
+            continue;
+
+        if (node.child1_ < 0)
+        {
+            const Proxy& proxy = proxies_[node.proxy_];
+            float reach = radius + proxy.radius_;
+            if ((proxy.center_ - center).LengthSquared() <= reach * reach)
+                result.Push(proxy.node_);
+            continue;
+        }
+
+        if (size + 2 > STACK_SIZE)
+            continue;
+        stack[size++] = node.child1_;
+        stack[size++] = node.child2_;
+    }
+}
+
+void SpatialIndex::QueryFrustum(const Frustum& frustum, PODVector<Node*>& result) const
+{
+    if (root_ < 0)
+        return;
+
+    int stack[STACK_SIZE];
+    unsigned size = 0;
+    stack[size++] = root_;
+
+    while (size)
+    {
+        const TreeNode& node = nodes_[stack[--size]];
+        if (frustum.IsInsideFast(node.box_) == OUTSIDE)
+            continue;
+
+        if (node.child1_ < 0)
+        {
+            result.Push(proxies_[node.proxy_].node_);
+            continue;
+        }
+
+        if (size + 2 > STACK_SIZE)
+            continue;
+        stack[size++] = node.child1_;
+        stack[size++] = node.child2_;
+    }
+}
+
+int SpatialIndex::GetHeight() const
+{
+    return root_ >= 0 ? nodes_[root_].height_ : 0;
+}
+
+int SpatialIndex::AllocateNode()
+{
+    int index;
+    if (freeList_ >= 0)
+    {
+        index = freeList_;
+        freeList_ = nodes_[index].parent_;
+    }
+    else
+    {
+        index = (int)nodes_.Size();
+        nodes_.Resize(nodes_.Size() + 1);
+    }
+
+    TreeNode& node = nodes_[index];
+    node.parent_ = -1;
+    node.child1_ = -1;
+    node.child2_ = -1;
+    node.height_ = 0;
+    node.proxy_ = M_MAX_UNSIGNED;
+    return index;
+}
+
+void SpatialIndex::FreeNode(int index)
+{
+    nodes_[index].parent_ = freeList_;
+    nodes_[index].height_ = -1;
+    freeList_ = index;
+}
+
+void SpatialIndex::InsertLeaf(int leaf)
+{
+    if (root_ < 0)
+    {
+        root_ = leaf;
+        nodes_[leaf].parent_ = -1;
+        return;
+    }
+
+    // Descend towards the sibling that minimizes the total surface area added to the tree
+    BoundingBox leafBox = nodes_[leaf].box_;
+    int index = root_;
+    while (nodes_[index].child1_ >= 0)
+    {
+        const TreeNode& node = nodes_[index];
+        float area = SurfaceArea(node.box_);
+        float combinedArea = SurfaceArea(Union(node.box_, leafBox));
+
+        // Cost of pairing the leaf with this node, and of pushing it further down
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        const TreeNode& child1 = nodes_[node.child1_];
+        float cost1 = SurfaceArea(Union(child1.box_, leafBox)) + inheritanceCost;
+        if (child1.child1_ >= 0)
+            cost1 -= SurfaceArea(child1.box_);
+
+        const TreeNode& child2 = nodes_[node.child2_];
+        float cost2 = SurfaceArea(Union(child2.box_, leafBox)) + inheritanceCost;
+        if (child2.child1_ >= 0)
+            cost2 -= SurfaceArea(child2.box_);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? node.child1_ : node.child2_;
+    }
+
+    int sibling = index;
+    int oldParent = nodes_[sibling].parent_;
+    int newParent = AllocateNode();
+
+    TreeNode& parent = nodes_[newParent];
+    parent.parent_ = oldParent;
+    parent.box_ = Union(leafBox, nodes_[sibling].box_);
+    parent.height_ = nodes_[sibling].height_ + 1;
+    parent.child1_ = sibling;
+    parent.child2_ = leaf;
+    nodes_[sibling].parent_ = newParent;
+    nodes_[leaf].parent_ = newParent;
+
+    if (oldParent >= 0)
+    {
+        if (nodes_[oldParent].child1_ == sibling)
+            nodes_[oldParent].child1_ = newParent;
+        else
+            nodes_[oldParent].child2_ = newParent;
+    }
+    else
+        root_ = newParent;
+
+    Refit(nodes_[leaf].parent_);
+}
+
+void SpatialIndex::RemoveLeaf(int leaf)
+{
+    if (leaf == root_)
+    {
+        root_ = -1;
+        return;
+    }
+
+    int parent = nodes_[leaf].parent_;
+    int grandParent = nodes_[parent].parent_;
+    int sibling = nodes_[parent].child1_ == leaf ? nodes_[parent].child2_ : nodes_[parent].child1_;
+
+    if (grandParent >= 0)
+    {
+        if (nodes_[grandParent].child1_ == parent)
+            nodes_[grandParent].child1_ = sibling;
+        else
+            nodes_[grandParent].child2_ = sibling;
+        nodes_[sibling].parent_ = grandParent;
+        FreeNode(parent);
+        Refit(grandParent);
+    }
+    else
+    {
+        root_ = sibling;
+        nodes_[sibling].parent_ = -1;
+        FreeNode(parent);
+    }
+}
+
+void SpatialIndex::Refit(int index)
+{
+    while (index >= 0)
+    {
+        index = Balance(index);
+
+        TreeNode& node = nodes_[index];
+        const TreeNode& child1 = nodes_[node.child1_];
+        const TreeNode& child2 = nodes_[node.child2_];
+        node.height_ = 1 + Max(child1.height_, child2.height_);
+        node.box_ = Union(child1.box_, child2.box_);
+
+        index = node.parent_;
+    }
+}
+
+int SpatialIndex::Balance(int iA)
+{
+    TreeNode& a = nodes_[iA];
+    if (a.child1_ < 0 || a.height_ < 2)
+        return iA;
+
+    int iB = a.child1_;
+    int iC = a.child2_;
+    TreeNode& b = nodes_[iB];
+    TreeNode& c = nodes_[iC];
+    int balance = c.height_ - b.height_;
+
+    if (balance > 1)
+    {
+        // Rotate C up
+        int iF = c.child1_;
+        int iG = c.child2_;
+        TreeNode& f = nodes_[iF];
+        TreeNode& g = nodes_[iG];
+
+        c.child1_ = iA;
+        c.parent_ = a.parent_;
+        a.parent_ = iC;
+
+        if (c.parent_ >= 0)
+        {
+            if (nodes_[c.parent_].child1_ == iA)
+                nodes_[c.parent_].child1_ = iC;
+            else
+                nodes_[c.parent_].child2_ = iC;
+        }
+        else
+            root_ = iC;
+
+        if (f.height_ > g.height_)
+        {
+            c.child2_ = iF;
+            a.child2_ = iG;
+            g.parent_ = iA;
+            a.box_ = Union(b.box_, g.box_);
+            c.box_ = Union(a.box_, f.box_);
+            a.height_ = 1 + Max(b.height_, g.height_);
+            c.height_ = 1 + Max(a.height_, f.height_);
+        }
+        else
+        {
+            c.child2_ = iG;
+            a.child2_ = iF;
+            f.parent_ = iA;
+            a.box_ = Union(b.box_, f.box_);
+            c.box_ = Union(a.box_, g.box_);
+            a.height_ = 1 + Max(b.height_, f.height_);
+            c.height_ = 1 + Max(a.height_, g.height_);
+        }
+        return iC;
+    }
+
+    if (balance < -1)
+    {
+        // Rotate B up
+        int iD = b.child1_;
+        int iE = b.child2_;
+        TreeNode& d = nodes_[iD];
+        TreeNode& e = nodes_[iE];
+
+        b.child1_ = iA;
+        b.parent_ = a.parent_;
+        a.parent_ = iB;
+
+        if (b.parent_ >= 0)
+        {
+            if (nodes_[b.parent_].child1_ == iA)
+                nodes_[b.parent_].child1_ = iB;
+            else
+                nodes_[b.parent_].child2_ = iB;
+        }
+        else
+            root_ = iB;
+
+        if (d.height_ > e.height_)
+        {
+            b.child2_ = iD;
+            a.child1_ = iE;
+            e.parent_ = iA;
+            a.box_ = Union(c.box_, e.box_);
+            b.box_ = Union(a.box_, d.box_);
+            a.height_ = 1 + Max(c.height_, e.height_);
+            b.height_ = 1 + Max(a.height_, d.height_);
+        }
+        else
+        {
+            b.child2_ = iE;
+            a.child1_ = iD;
+            d.parent_ = iA;
+            a.box_ = Union(c.box_, d.box_);
+            b.box_ = Union(a.box_, e.box_);
+            a.height_ = 1 + Max(c.height_, d.height_);
+            b.height_ = 1 + Max(a.height_, e.height_);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+void SpatialIndex::RemoveProxy(unsigned index)
+{
+    Proxy& proxy = proxies_[index];
+    if (proxy.leaf_ < 0)
+        return;
+
+    RemoveLeaf(proxy.leaf_);
+    FreeNode(proxy.leaf_);
+    proxy.leaf_ = -1;
+
+    proxyMap_.Erase(proxy.key_);
+    proxy.node_.Reset();
+    proxy.key_ = 0;
+    freeProxies_.Push(index);
+}
+
+BoundingBox SpatialIndex::FatBox(const Vector3& center, float radius, const Vector3& displacement)
+{
+    float margin = radius * (1.0f + FAT_RADIUS_RATIO);
+    BoundingBox box(center - Vector3(margin, margin, margin), center + Vector3(margin, margin, margin));
+
+    // Stretch towards where the sphere is heading
+    Vector3 ahead = displacement * FAT_DISPLACEMENT_FRAMES;
+    if (ahead.x_ < 0.0f)
+        box.min_.x_ += ahead.x_;
+    else
+        box.max_.x_ += ahead.x_;
+    if (ahead.y_ < 0.0f)
+        box.min_.y_ += ahead.y_;
+    else
+        box.max_.y_ += ahead.y_;
+    if (ahead.z_ < 0.0f)
+        box.min_.z_ += ahead.z_;
+    else
+        box.max_.z_ += ahead.z_;
+    return box;
+}
+
+void SpatialIndex::Benchmark(Context* context)
+{
+    static const unsigned counts[] = { 1000, 10000, 100000 };
+    static const unsigned NUM_FRAMES = 60;
+    static const unsigned NUM_QUERIES = 10000;
+
+    for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        unsigned count = counts[c];
+        SharedPtr<Scene> scene(new Scene(context));
+        SpatialIndex* index = scene->CreateComponent<SpatialIndex>();
+        SetRandomSeed(c + 1);
+
+        // Bodies on circular orbits in a thin disk, like the belts and the spacecraft around the planets
+        PODVector<Node*> nodes(count);
+        PODVector<float> orbitRadius(count);
+        PODVector<float> phase(count);
+        PODVector<float> speed(count);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            nodes[i] = scene->CreateChild();
+            orbitRadius[i] = Random(2.0f, 100.0f);
+            phase[i] = Random(360.0f);
+            speed[i] = -50.0f * powf(orbitRadius[i] / 5.0f, -1.5f);
+            nodes[i]->SetPosition(Quaternion(phase[i], Vector3::UP) * Vector3(orbitRadius[i], Random(-0.5f, 0.5f), 0.0f));
+            index->AddNode(nodes[i], Random(0.01f, 0.5f));
+        }
+
+        long long updateTime = 0;
+        unsigned reinserts = 0;
+        for (unsigned frame = 0; frame < NUM_FRAMES; ++frame)
+        {
+            float time = frame / 60.0f;
+            for (unsigned i = 0; i < count; ++i)
+            {
+                Vector3 position = nodes[i]->GetPosition();
+                float y = position.y_;
+                position = Quaternion(phase[i] + speed[i] * time, Vector3::UP) * Vector3(orbitRadius[i], 0.0f, 0.0f);
+                position.y_ = y;
+                nodes[i]->SetPosition(position);
+            }
+            index->Update();
+            updateTime += index->GetLastUpdateTime();
+            reinserts += index->GetLastReinsertCount();
+        }
+
+        PODVector<Vector3> points(NUM_QUERIES);
+        PODVector<Ray> rays(NUM_QUERIES);
+        for (unsigned q = 0; q < NUM_QUERIES; ++q)
+        {
+            points[q] = Vector3(Random(-100.0f, 100.0f), Random(-1.0f, 1.0f), Random(-100.0f, 100.0f));
+            Vector3 direction(Random(-1.0f, 1.0f), Random(-0.1f, 0.1f), Random(-1.0f, 1.0f));
+            rays[q] = Ray(points[q], direction.LengthSquared() > M_EPSILON ? direction.Normalized() : Vector3::FORWARD);
+        }
+
+        HiresTimer timer;
+        unsigned found = 0;
+        SpatialQueryResult result;
+        for (unsigned q = 0; q < NUM_QUERIES; ++q)
+            found += index->QueryNearest(points[q], M_INFINITY, result) ? 1 : 0;
+        long long nearestTime = timer.GetUSec(true);
+
+        // Brute force reference, also checking that the tree finds the same distances
+        unsigned mismatches = 0;
+        for (unsigned q = 0; q < NUM_QUERIES; ++q)
+        {
+            float best = M_INFINITY;
+            for (unsigned i = 0; i < count; ++i)
+                best = Min(best, (index->proxies_[i].center_ - points[q]).Length() - index->proxies_[i].radius_);
+            index->QueryNearest(points[q], M_INFINITY, result);
+            if (Abs(best - result.distance_) > 1e-4f)
+                ++mismatches;
+        }
+        long long bruteTime = timer.GetUSec(true) - nearestTime;
+
+        PODVector<Node*> inside;
+        for (unsigned q = 0; q < NUM_QUERIES; ++q)
+        {
+            inside.Clear();
+            index->QueryRadius(points[q], 2.0f, inside);
+        }
+        long long radiusTime = timer.GetUSec(true);
+
+        unsigned hits = 0;
+        for (unsigned q = 0; q < NUM_QUERIES; ++q)
+            hits += index->Raycast(rays[q], 200.0f, result) ? 1 : 0;
+        long long rayTime = timer.GetUSec(false);
+
+        printf("spatial index bodies=%u height=%d update=%.3f ms reinserts=%u (per frame)\n", count, index->GetHeight(),
+            updateTime / 1000.0 / NUM_FRAMES, reinserts / NUM_FRAMES);
+        printf("  queries per second: nearest=%.0f (brute force %.0f, %u mismatches) radius=%.0f ray=%.0f (%u hits)\n",
+            NUM_QUERIES * 1e6 / Max(nearestTime, 1LL), NUM_QUERIES * 1e6 / Max(bruteTime, 1LL), mismatches,
+            NUM_QUERIES * 1e6 / Max(radiusTime, 1LL), NUM_QUERIES * 1e6 / Max(rayTime, 1LL), hits);
+    }
+}
@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Math/BoundingBox.h>
+#include <Urho3D/Scene/Component.h>
+
+#include "DoubleVector3.h"
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Frustum;
+class Ray;
+
+}
+
+/// Result of a nearest or ray query.
+struct SpatialQueryResult
+{
+    /// Node found.
+    Node* node_;
+    /// Sphere radius of the node.
+    float radius_;
+    /// Distance from the query point to the sphere surface, negative inside; or distance along the ray to the hit.
+    float distance_;
+};
+
+/// Dynamic bounding volume hierarchy over spheres following scene nodes, for picking, proximity and label queries.
+/// Leaves hold enlarged boxes that absorb several frames of motion; Update() only reinserts the nodes that left their
+/// box, and the tree is kept height-balanced by rotations, so orbiting bodies cost a few reinsertions per frame instead
+/// of a rebuild. A floating origin rebase translates every box in place.
+class SpatialIndex : public Component
+{
+    URHO3D_OBJECT(SpatialIndex, Component);
+
+public:
+    /// Construct.
+    SpatialIndex(Context* context);
+    /// Destruct.
+    virtual ~SpatialIndex();
+
+    /// Add a node as a sphere of the given world radius around its world position.
+    void AddNode(Node* node, float radius);
+    /// Remove a node.
+    void RemoveNode(Node* node);
+    /// Refit the tree to the current world positions of the nodes. Removed nodes are dropped.
+    void Update();
+
+    /// Find the sphere closest to a point, within a maximum surface distance. Return true if found.
+    bool QueryNearest(const Vector3& point, float maxDistance, SpatialQueryResult& result, Node* exclude = 0) const;
+    /// Find the first sphere hit by a ray within a maximum distance. Return true if found.
+    bool Raycast(const Ray& ray, float maxDistance, SpatialQueryResult& result, Node* exclude = 0) const;
+    /// Collect the nodes whose sphere intersects a sphere.
+    void QueryRadius(const Vector3& center, float radius, PODVector<Node*>& result) const;
+    /// Collect the nodes whose box intersects a frustum.
+    void QueryFrustum(const Frustum& frustum, PODVector<Node*>& result) const;
+
+    /// Return number of indexed nodes.
+    unsigned GetNumNodes() const { return proxyMap_.Size(); }
+    /// Return tree height.
+    int GetHeight() const;
+    /// Return duration of the last update in microseconds.
+    long long GetLastUpdateTime() const { return lastUpdateTime_; }
+    /// Return number of nodes reinserted by the last update.
+    unsigned GetLastReinsertCount() const { return lastReinsertCount_; }
+
+    /// Print update time and nearest, radius and ray query throughput for 1k to 100k moving spheres, against brute force.
+    static void Benchmark(Context* context);
+
+private:
+    /// Tree node. Leaves have no children and reference a proxy.
+    struct TreeNode
+    {
+        /// Box enclosing the children, or the enlarged box of a leaf.
+        BoundingBox box_;
+        /// Parent index, or next free index when unused.
+        int parent_;
+        /// First child index, -1 for a leaf.
+        int child1_;
+        /// Second child index, -1 for a leaf.
+        int child2_;
+        /// Height above the leaves, -1 when unused.
+        int height_;
+        /// Proxy index of a leaf.
+        unsigned proxy_;
+    };
+
+    /// Indexed node.
+    struct Proxy
+    {
+        /// Node.
+        WeakPtr<Node> node_;
+        /// Key in proxyMap_, kept raw so that the entry can be erased after the node is destroyed.
+        Node* key_;
+        /// Sphere radius.
+        float radius_;
+        /// Sphere center at the last update.
+        Vector3 center_;
+        /// Leaf index, -1 when unused.
+        int leaf_;
+    };
+
+    /// Allocate a tree node from the free list.
+    int AllocateNode();
+    /// Return a tree node to the free list.
+    void FreeNode(int index);
+    /// Insert a leaf, descending along the cheapest surface area increase.
+    void InsertLeaf(int leaf);
+    /// Remove a leaf from the tree without freeing it.
+    void RemoveLeaf(int leaf);
+    /// Rotate a subtree whose children heights differ by more than one. Return the new subtree root.
+    int Balance(int index);
+    /// Refit boxes and heights from a node up to the root, balancing on the way.
+    void Refit(int index);
+    /// Remove a proxy and its leaf.
+    void RemoveProxy(unsigned index);
+    /// Return the enlarged leaf box of a sphere moving by a displacement.
+    static BoundingBox FatBox(const Vector3& center, float radius, const Vector3& displacement);
+
+    /// Tree nodes.
+    PODVector<TreeNode> nodes_;
+    /// Proxies.
+    Vector<Proxy> proxies_;
+    /// Unused proxy indices.
+    PODVector<unsigned> freeProxies_;
+    /// Proxy index by node.
+    HashMap<Node*, unsigned> proxyMap_;
+    /// Root index, -1 when empty.
+    int root_;
+    /// First unused tree node index, -1 when none.
+    int freeList_;
+    /// Floating origin the boxes are relative to.
+    DoubleVector3 origin_;
+    /// Duration of the last update in microseconds.
+    long long lastUpdateTime_;
+    /// Number of nodes reinserted by the last update.
+    unsigned lastReinsertCount_;
+};
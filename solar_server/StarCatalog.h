@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+
+/// Binary star catalog layout, shared by the converter tool and StarField. The file is a header followed by `count_`
+/// records and is read in place through a memory mapping, so the layout must stay free of padding.
+/// Coordinates use the scene axes: Y towards the north ecliptic pole, the vernal equinox along +X.
+
+/// Magic bytes at the start of a catalog.
+static const char STAR_CATALOG_MAGIC[4] = { 'S', 'T', 'A', 'R' };
+/// Current catalog version.
+static const unsigned STAR_CATALOG_VERSION = 1;
+
+/// Catalog header.
+struct StarCatalogHeader
+{
+    /// Magic bytes, STAR_CATALOG_MAGIC.
+    char magic_[4];
+    /// Format version, STAR_CATALOG_VERSION.
+    unsigned version_;
+    /// Number of records following the header.
+    unsigned count_;
+    /// Size of one record in bytes, for forward compatibility.
+    unsigned recordSize_;
+};
+
+/// One star.
+struct StarRecord
+{
+    /// Unit direction X.
+    float x_;
+    /// Unit direction Y.
+    float y_;
+    /// Unit direction Z.
+    float z_;
+    /// Apparent visual magnitude.
+    float magnitude_;
+    /// B-V color index.
+    float colorIndex_;
+};
+
+/// Return whether a mapped block holds a valid catalog.
+inline bool IsValidStarCatalog(const unsigned char* data, unsigned size)
+{
+    if (size < sizeof(StarCatalogHeader))
+        return false;
+
+    const StarCatalogHeader* header = reinterpret_cast<const StarCatalogHeader*>(data);
+    return memcmp(header->magic_, STAR_CATALOG_MAGIC, 4) == 0 && header->version_ == STAR_CATALOG_VERSION &&
+        header->recordSize_ == sizeof(StarRecord) &&
+        size >= sizeof(StarCatalogHeader) + (unsigned long long)header->count_ * sizeof(StarRecord);
+}
+
+/// Write a catalog to a file. Return true on success.
+inline bool WriteStarCatalog(const char* fileName, const StarRecord* records, unsigned count)
+{
+    FILE* file = fopen(fileName, "wb");
+    if (!file)
+        return false;
+
+    StarCatalogHeader header;
+    memcpy(header.magic_, STAR_CATALOG_MAGIC, 4);
+    header.version_ = STAR_CATALOG_VERSION;
+    header.count_ = count;
+    header.recordSize_ = sizeof(StarRecord);
+
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        (count == 0 || fwrite(records, sizeof(StarRecord), count, file) == count);
+    fclose(file);
+    return success;
+}
@@ -0,0 +1,283 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "MappedFile.h"
+#include "StarCatalog.h"
+#include "StarField.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+/// Magnitude drawn at full brightness.
+static const float BRIGHT_MAGNITUDE = -1.0f;
+/// Dimmest brightness, so that faint stars remain visible on the walls.
+static const float MIN_BRIGHTNESS = 0.1f;
+
+/// Star color by B-V color index, from blue giants to red dwarfs.
+static const float colorIndexKeys[] = { -0.4f, 0.0f, 0.6f, 1.2f, 2.0f };
+static const Color colorIndexColors[] =
+{
+    Color(0.61f, 0.71f, 1.0f),
+    Color(0.93f, 0.94f, 1.0f),
+    Color(1.0f, 0.96f, 0.86f),
+    Color(1.0f, 0.82f, 0.63f),
+    Color(1.0f, 0.7f, 0.4f)
+};
+
+static unsigned StarColor(float colorIndex, float magnitude)
+{
+    static const unsigned numKeys = sizeof(colorIndexKeys) / sizeof(colorIndexKeys[0]);
+
+    Color color = colorIndexColors[numKeys - 1];
+    if (colorIndex <= colorIndexKeys[0])
+        color = colorIndexColors[0];
+    else
+    {
+        for (unsigned i = 1; i < numKeys; ++i)
+        {
+            if (colorIndex < colorIndexKeys[i])
+            {
+                float t = (colorIndex - colorIndexKeys[i - 1]) / (colorIndexKeys[i] - colorIndexKeys[i - 1]);
+                color = colorIndexColors[i - 1].Lerp(colorIndexColors[i], t);
+                break;
+            }
+        }
+    }
+
+    // Alpha carries the brightness: square root of the flux ratio, which keeps faint stars readable
+    color.a_ = Clamp(powf(10.0f, -0.2f * (magnitude - BRIGHT_MAGNITUDE)), MIN_BRIGHTNESS, 1.0f);
+    return color.ToUInt();
+}
+
+static unsigned StarRegion(const StarRecord& star)
+{
+    float azimuth = atan2f(star.z_, star.x_) + M_PI;
+    float elevation = asinf(Clamp(star.y_, -1.0f, 1.0f)) + 0.5f * M_PI;
+
+    unsigned a = Min((unsigned)(azimuth / (2.0f * M_PI) * StarField::NUM_AZIMUTH_REGIONS),
+        StarField::NUM_AZIMUTH_REGIONS - 1);
+    unsigned e = Min((unsigned)(elevation / M_PI * StarField::NUM_ELEVATION_REGIONS), StarField::NUM_ELEVATION_REGIONS - 1);
+    return a * StarField::NUM_ELEVATION_REGIONS + e;
+}
+
+StarField::StarField(Context* context) :
+    Drawable(context, DRAWABLE_GEOMETRY),
+    viewTransform_(Matrix3x4::IDENTITY),
+    magnitudeLimit_(7.0f),
+    numStars_(0),
+    loadTime_(0.0f)
+{
+}
+
+StarField::~StarField()
+{
+}
+
+void StarField::UpdateBatches(const FrameInfo& frame)
+{
+    // Like a skybox, the sphere follows the camera; the shader pushes the points to the far plane
+    Camera* camera = frame.camera_;
+    Vector3 cameraPosition = camera->GetNode()->GetWorldPosition();
+    float radius = camera->GetFarClip() * 0.5f;
+    viewTransform_ = Matrix3x4(cameraPosition, Quaternion::IDENTITY, radius);
+
+    const Frustum& frustum = camera->GetFrustum();
+    distance_ = 0.0f;
+
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+    {
+        const BoundingBox& box = regionBoxes_[i];
+        BoundingBox worldBox(box.min_ * radius + cameraPosition, box.max_ * radius + cameraPosition);
+
+        batches_[i].distance_ = 0.0f;
+        batches_[i].worldTransform_ = &viewTransform_;
+        batches_[i].numWorldTransforms_ = frustum.IsInsideFast(worldBox) != OUTSIDE ? 1 : 0;
+    }
+}
+
+bool StarField::Load(const String& fileName)
+{
+    URHO3D_PROFILE(LoadStarField);
+
+    HiresTimer timer;
+
+    MappedFile file;
+    if (!file.Open(fileName))
+    {
+        URHO3D_LOGERROR("Could not map star catalog " + fileName);
+        return false;
+    }
+    if (!IsValidStarCatalog(file.GetData(), file.GetSize()))
+    {
+        URHO3D_LOGERROR("Invalid star catalog " + fileName);
+        return false;
+    }
+
+    const StarCatalogHeader* header = reinterpret_cast<const StarCatalogHeader*>(file.GetData());
+    const StarRecord* stars = reinterpret_cast<const StarRecord*>(file.GetData() + sizeof(StarCatalogHeader));
+    const unsigned numRegions = NUM_AZIMUTH_REGIONS * NUM_ELEVATION_REGIONS;
+
+    // First pass over the mapping: count the stars of every region
+    PODVector<unsigned short> regions(header->count_);
+    PODVector<unsigned> offsets(numRegions + 1);
+    for (unsigned i = 0; i < offsets.Size(); ++i)
+        offsets[i] = 0;
+
+    for (unsigned i = 0; i < header->count_; ++i)
+    {
+        if (stars[i].magnitude_ > magnitudeLimit_)
+        {
+            regions[i] = numRegions;
+            continue;
+        }
+        regions[i] = (unsigned short)StarRegion(stars[i]);
+        ++offsets[regions[i] + 1];
+    }
+    for (unsigned r = 1; r <= numRegions; ++r)
+        offsets[r] += offsets[r - 1];
+
+    // Second pass: write the vertices grouped by region
+    numStars_ = offsets[numRegions];
+    PODVector<unsigned char> vertexData(numStars_ * VERTEX_SIZE);
+    PODVector<unsigned> cursor(offsets);
+    PODVector<BoundingBox> boxes(numRegions);
+    for (unsigned r = 0; r < numRegions; ++r)
+        boxes[r].Clear();
+
+    for (unsigned i = 0; i < header->count_; ++i)
+    {
+        unsigned region = regions[i];
+        if (region == numRegions)
+            continue;
+
+        const StarRecord& star = stars[i];
+        float* dest = reinterpret_cast<float*>(&vertexData[cursor[region]++ * VERTEX_SIZE]);
+        dest[0] = star.x_;
+        dest[1] = star.y_;
+        dest[2] = star.z_;
+        *reinterpret_cast<unsigned*>(dest + 3) = StarColor(star.colorIndex_, star.magnitude_);
+
+        boxes[region].Merge(Vector3(star.x_, star.y_, star.z_));
+    }
+
+    vertexBuffers_.Clear();
+    geometries_.Clear();
+    regionBoxes_.Clear();
+    batches_.Clear();
+
+    for (unsigned r = 0; r < numRegions; ++r)
+    {
+        unsigned count = offsets[r + 1] - offsets[r];
+        if (!count)
+            continue;
+
+        SharedPtr<VertexBuffer> vertexBuffer(new VertexBuffer(context_));
+        vertexBuffer->SetSize(count, MASK_POSITION | MASK_COLOR);
+        vertexBuffer->SetData(&vertexData[offsets[r] * VERTEX_SIZE]);
+
+        SharedPtr<Geometry> geometry(new Geometry(context_));
+        geometry->SetVertexBuffer(0, vertexBuffer, MASK_POSITION | MASK_COLOR);
+        geometry->SetDrawRange(POINT_LIST, 0, 0, 0, count);
+
+        SourceBatch batch;
+        batch.geometry_ = geometry;
+        batch.material_ = material_;
+        batch.worldTransform_ = &viewTransform_;
+
+        vertexBuffers_.Push(vertexBuffer);
+        geometries_.Push(geometry);
+        regionBoxes_.Push(boxes[r]);
+        batches_.Push(batch);
+    }
+
+    loadTime_ = timer.GetUSec(false) / 1000.0f;
+
+    printf("star field %s: stars=%u regions=%u load=%.1f ms vertex memory=%.1f MB (catalog %u stars, %.1f MB mapped)\n",
+        fileName.CString(), numStars_, batches_.Size(), loadTime_, GetVertexMemory() / (1024.0f * 1024.0f), header->count_,
+        file.GetSize() / (1024.0f * 1024.0f));
+
+    return true;
+}
+
+void StarField::SetMaterial(Material* material)
+{
+    material_ = material;
+
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+        batches_[i].material_ = material_;
+}
+
+void StarField::OnWorldBoundingBoxUpdate()
+{
+    // The stars surround the camera wherever it is
+    worldBoundingBox_.Define(-M_LARGE_VALUE, M_LARGE_VALUE);
+}
+
+void StarField::Benchmark(Context* context)
+{
+    static const unsigned counts[] = { 100000, 500000, 1000000, 2000000 };
+
+    FileSystem* fileSystem = context->GetSubsystem<FileSystem>();
+    String fileName = fileSystem->GetAppPreferencesDir("urho3d", "temp") + "StarFieldBenchmark.bin";
+
+    for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        // Uniform directions, magnitudes skewed towards faint stars like a real catalog
+        PODVector<StarRecord> stars(counts[c]);
+        SetRandomSeed(c + 1);
+        for (unsigned i = 0; i < counts[c]; ++i)
+        {
+            Vector3 direction(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+            direction = direction.LengthSquared() > M_EPSILON ? direction.Normalized() : Vector3::UP;
+            stars[i].x_ = direction.x_;
+            stars[i].y_ = direction.y_;
+            stars[i].z_ = direction.z_;
+            stars[i].magnitude_ = 12.0f - 13.5f * powf(Random(1.0f), 4.0f);
+            stars[i].colorIndex_ = Random(-0.4f, 2.0f);
+        }
+
+        if (!WriteStarCatalog(fileName.CString(), &stars[0], stars.Size()))
+        {
+            printf("could not write %s\n", fileName.CString());
+            return;
+        }
+
+        SharedPtr<Scene> scene(new Scene(context));
+        StarField* starField = scene->CreateChild("BenchmarkStars")->CreateComponent<StarField>();
+        starField->SetMagnitudeLimit(M_INFINITY);
+        starField->Load(fileName);
+    }
+
+    fileSystem->Delete(fileName);
+}
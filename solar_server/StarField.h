@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Graphics/Drawable.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Geometry;
+class Material;
+class VertexBuffer;
+
+}
+
+/// Star catalog rendered as points on a sphere centred on the camera, drawn behind everything like a skybox.
+/// The catalog is memory-mapped and split into sky regions, each with its own static vertex buffer and bounding box, so
+/// that a wall only submits the regions inside its view frustum.
+class StarField : public Drawable
+{
+    URHO3D_OBJECT(StarField, Drawable);
+
+public:
+    /// Construct.
+    StarField(Context* context);
+    /// Destruct.
+    virtual ~StarField();
+
+    /// Calculate distance and prepare batches for rendering. Culls the sky regions against the view frustum.
+    virtual void UpdateBatches(const FrameInfo& frame);
+
+    /// Load a binary star catalog and build the region vertex buffers. Return true on success.
+    bool Load(const String& fileName);
+    /// Set the material.
+    void SetMaterial(Material* material);
+    /// Set faintest magnitude kept when building the vertex buffers.
+    void SetMagnitudeLimit(float magnitude) { magnitudeLimit_ = magnitude; }
+
+    /// Return number of stars in the vertex buffers.
+    unsigned GetNumStars() const { return numStars_; }
+    /// Return vertex memory use in bytes.
+    unsigned GetVertexMemory() const { return numStars_ * VERTEX_SIZE; }
+    /// Return duration of the last load in milliseconds.
+    float GetLoadTime() const { return loadTime_; }
+
+    /// Write synthetic catalogs of 100k to 2M stars and print load time and vertex memory for each.
+    static void Benchmark(Context* context);
+
+    /// Number of regions along the azimuth.
+    static const unsigned NUM_AZIMUTH_REGIONS = 20;
+    /// Number of regions along the elevation.
+    static const unsigned NUM_ELEVATION_REGIONS = 6;
+    /// Size of one vertex: position and color.
+    static const unsigned VERTEX_SIZE = 16;
+
+protected:
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+
+private:
+    /// Vertex buffers, one per region.
+    Vector<SharedPtr<VertexBuffer> > vertexBuffers_;
+    /// Geometries, one per non-empty region.
+    Vector<SharedPtr<Geometry> > geometries_;
+    /// Unit-sphere bounding boxes of the regions.
+    PODVector<BoundingBox> regionBoxes_;
+    /// Material.
+    SharedPtr<Material> material_;
+    /// Per-camera world transform, keeping the sphere centred on the viewer.
+    Matrix3x4 viewTransform_;
+    /// Faintest magnitude kept.
+    float magnitudeLimit_;
+    /// Number of stars in the vertex buffers.
+    unsigned numStars_;
+    /// Duration of the last load in milliseconds.
+    float loadTime_;
+};
@@ -21,6 +21,7 @@
 //
 
 #include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/Engine/Engine.h>
 #include <Urho3D/Graphics/Camera.h>
 #include <Urho3D/Graphics/Graphics.h>
@@ -32,12 +33,16 @@
 #include <Urho3D/Graphics/StaticModel.h>
 #include <Urho3D/Input/Input.h>
 #include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
 #include <Urho3D/Scene/Scene.h>
 #include <Urho3D/UI/Font.h>
 #include <Urho3D/UI/Text.h>
 #include <Urho3D/UI/UI.h>
 
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
 #include <Urho3D/IO/Log.h>
 #include <Urho3D/Network/Connection.h>
 #include <Urho3D/Network/Network.h>
@@ -45,62 +50,292 @@
 
 #include "StaticScene.h"
 #include "Rotator.h"
+#include "BodySystem.h"
+#include "AsteroidBelt.h"
+#include "StarField.h"
+#include "ResourceBundle.h"
+#include "OrbitTrails.h"
+#include "SatelliteCatalog.h"
+#include "SatelliteField.h"
+#include "SpatialIndex.h"
+#include "LabelLayer.h"
+#include "Telemetry.h"
+#include "SceneSnapshot.h"
+#include "HotReload.h"
+#include "SunBenchmark.h"
+#include "CraftPropagator.h"
+#include "ResourceHandles.h"
+#include "AsyncLog.h"
+#include "SceneBatch.h"
+#include "SceneCommands.h"
 
 #include <Urho3D/DebugNew.h>
 
+#include <algorithm>
+
 #define PI 3.14159265
 #define SUN_R 3.0f
 #define UA 5.0f 
 #define RES_T -50.0f
+// unites d'affichage par unite astronomique en vraie echelle, la Terre (echelle 0.3) ayant un rayon de 0.15
+#define TRUE_SCALE_UA (0.15f * 149597870.7f / 6371.0f)
+#define ASTEROID_COUNT 200000
+#define KUIPER_COUNT 100000
+#define SATELLITE_COUNT 30000
+// distance minimale entre la camera et la surface d'un astre
+#define CAMERA_CLEARANCE 0.05f
 
 const int MSG_GAME = 32;
+// reponse a la commande telemetry, envoyee au client qui l'a demandee
+const int MSG_TELEMETRY = 33;
+// etat complet de la simulation, envoye en reponse a la commande snapshot et charge a la reception
+const int MSG_SNAPSHOT = 34;
+// camera, non fiable et non ordonnee : numero de sequence, vitesse (droite, haut, avant), rotation, heure de l'envoi,
+// drapeaux puis segment de mouvement en cours et segment precedent complet (voir CameraOdometry) ; un paquet plus
+// ancien que le dernier applique est ignore
+const int MSG_CAMERA = 35;
+// axes du joystick du poste client, non fiables : trames cles et trames delta (voir JoystickChannel)
+const int MSG_JOYSTICK = 36;
+// reponse a une trame sonde du joystick, envoyee une fois l'image qui l'a appliquee affichee
+const int MSG_JOYSTICK_ECHO = 37;
+// lot d'objets crees ou mis a jour d'un coup, fiable et ordonne avec les commandes texte (voir SceneBatch)
+const int MSG_SCENE_BATCH = 38;
+// deplacement en unites par seconde et rotation en degres par seconde a pleine deflexion
+#define CAMERA_MOVE_SPEED 300.0f
+#define CAMERA_TURN_SPEED 90.0f
+// secondes sans mise a jour apres lesquelles la camera s'arrete, si le client a disparu ou que l'arret s'est perdu
+#define CAMERA_INPUT_TIMEOUT 0.25f
+// drapeau du canal camera : le joystick du controleur est incline, il demande donc la camera
+#define CAMERA_FLAG_JOYSTICK 1
+// taille d'un paquet du canal camera, deux segments et l'image cle compris
+#define CAMERA_PACKET_SIZE 145
+// pas des commandes 'z', 'q', 's', 'd', 'o', 'l' en unites et des commandes 'k', 'm' en degres
+#define CAMERA_STEP 5.0f
+#define CAMERA_STEP_ANGLE 30.0f
+// commandes par seconde et rafale attendues par client, limitees par le client ; au-dela elles sont comptees
+#define INPUT_RATE_LIMIT 240.0f
+#define INPUT_BURST 60.0f
+// secondes pendant lesquelles le controleur qui a la camera la garde apres sa derniere commande
+#define CONTROL_LEASE 2.0f
+// secondes entre deux instantanes ecrits sur le disque
+#define SNAPSHOT_INTERVAL 1.0f
+// age maximal en secondes d'un instantane repris au demarrage
+#define SNAPSHOT_MAX_AGE 300
+// parametres reglables des astres, relus a chaud
+#define SCENE_DESCRIPTION "Scenes/SolarSystem.xml"
+// astres que la camera peut suivre ('f', 't', 'S', 'r', 'j', 'u'), dans l'ordre de l'instantane
+#define NUM_CAMERA_ANCHORS 6
 const unsigned short GAME_SERVER_PORT = 32000;
 
+/// Description of an orbiting body, in BodyId order so that parents precede their children.
+struct BodyDesc
+{
+    const char* name;
+    const char* frameName;
+    const char* model;
+    const char* material;
+    bool light;
+    int parent;
+    float orbitRadius;
+    /// distance reelle au parent en UA, utilisee avec -truescale
+    float trueOrbitRadius;
+    float orbitSpeed;
+    float tilt;
+    float spinSpeed;
+    float scale;
+    /// masse relative au parent pour la dynamique de la fusee, 0 pour un point sans gravite
+    double massRatio;
+};
+
+static const BodyDesc bodyDescs[NUM_BODIES] =
+{
+    { "Earth",   "EarthPos",           "Models/Sphere.mdl", "Materials/earthmap.xml",             false, -1,          5.0f,                            1.0f,     RES_T,         23.0f, -30.0f, 0.3f,  3.003e-6 },
+    { "Moon",    0,                    "Models/Sphere.mdl", "Materials/moonmap.xml",              false, BODY_EARTH,  0.3f,                            0.00257f, -100.0f,       0.0f,  -30.0f, 0.05f, 0.0123   },
+    { "mercure", 0,                    "Models/Sphere.mdl", "bin/Data/Materials/mercuremap.xml",  false, -1,          0.4f * 5.0f,                     0.387f,   RES_T * 10.0f, 23.0f, 0.0f,   0.15f, 1.660e-7 },
+    { "venus",   0,                    "Models/Sphere.mdl", "bin/Data/Materials/venusmap.xml",    false, -1,          0.7f * 5.0f,                     0.723f,   RES_T * 1.62f, 23.0f, 0.0f,   0.28f, 2.448e-6 },
+    { "Mars",    "marsPos",            "Models/Sphere.mdl", "bin/Data/Materials/marsmap.xml",     false, -1,          1.5f * 5.0f,                     1.524f,   RES_T * 0.55f, 23.0f, 0.0f,   0.25f, 3.227e-7 },
+    { "jupiter", "jupiterPos",         "Models/Sphere.mdl", "bin/Data/Materials/jupitermap.xml",  true,  -1,          2.3f * UA,                       5.203f,   RES_T / 12,    23.0f, 0.0f,   1.0f,  9.546e-4 },
+    { "saturne", "saturnePos",         "Models/Sphere.mdl", "bin/Data/Materials/saturnemap.xml",  true,  -1,          3.5f * UA,                       9.537f,   RES_T / 29,    23.0f, 0.0f,   0.9f,  2.858e-4 },
+    { "uranus",  "uranusPos",          "Models/Sphere.mdl", "bin/Data/Materials/uranusmap.xml",   true,  -1,          5.0f * UA,                       19.19f,   RES_T / 84,    23.0f, 0.0f,   0.57f, 4.366e-5 },
+    { "neptune", "neptunePos",         "Models/Sphere.mdl", "bin/Data/Materials/neptunemap.xml",  true,  -1,          7.5f * UA,                       30.07f,   RES_T / 165,   23.0f, 0.0f,   0.53f, 5.151e-5 },
+    // centre de la trajectoire de la fusee, tourne avec la terre
+    { 0,         "rocket_traj_center", 0,                   0,                                    false, -1,          -((5.0f + 1.5f * 5.0f) / 2 - 5), -0.262f,  RES_T,         0.0f,  0.0f,   1.0f,  0.0      }
+};
+
+/// Return the send time stamped by the client after a message, in ms of the system clock of the controller machines
+/// (kept in sync by NTP), or the time of the wall if the message has none. Unlike the arrival time, it is the same on
+/// every wall.
+static unsigned ReadSenderTime(MemoryBuffer& msg)
+{
+    return msg.GetSize() - msg.GetPosition() >= 4 ? msg.ReadUInt() : Time::GetSystemTime();
+}
+
+/// Return whether a was sent before b, from the times stamped by their senders in ms, which wrap around.
+template <class A, class B> static bool IsSentBefore(const A& a, const B& b)
+{
+    return (int)(a.time_ - b.time_) < 0;
+}
+
+/// Return the number of days since 1970-01-01 of a date of the proleptic Gregorian calendar.
+static int DaysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/// Return the date of the proleptic Gregorian calendar of a number of days since 1970-01-01.
+static void CivilFromDays(int days, int& year, int& month, int& day)
+{
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int dayOfEra = days - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = yearOfEra + era * 400 + (month <= 2);
+}
+
+/// Names shown on the walls, in BodyId order.
+static const char* bodyLabels[NUM_BODIES] =
+{
+    "Terre", "Lune", "Mercure", "Venus", "Mars", "Jupiter", "Saturne", "Uranus", "Neptune", 0
+};
+
+/// Point created on demand, read from a snapshot.
+struct SnapshotPoint
+{
+    String name_;
+    Vector3 position_;
+};
+
+/// Object created on demand, read from a snapshot.
+struct SnapshotObject
+{
+    String name_;
+    Vector3 position_;
+    Quaternion rotation_;
+    Vector3 scale_;
+    String model_;
+    String material_;
+};
+
 URHO3D_DEFINE_APPLICATION_MAIN(StaticScene)
 
 StaticScene::StaticScene(Context* context) :
     Sample(context)
 {
     context->RegisterFactory<Rotator>();
-    autorised = true;
-    tkt = 0;
+    context->RegisterFactory<BodySystem>();
+    context->RegisterFactory<AsteroidBelt>();
+    context->RegisterFactory<StarField>();
+    context->RegisterFactory<OrbitTrails>();
+    context->RegisterFactory<SatelliteField>();
+    context->RegisterFactory<SpatialIndex>();
+    context->RegisterFactory<LabelLayer>();
+    context->RegisterFactory<CraftPropagator>();
     sky = true;
     secret = false;
+    sky_secret = false;
+    bundleFrames = 0;
+    trueScale = false;
+    headless = false;
+    snapshotTimer = 0.0f;
+    rocketLaunchTime = -M_INFINITY;
+    controlArbiter.SetLease(CONTROL_LEASE);
+    anchorSession = 0;
+    cameraAnchored = false;
+    anchorTime = 0;
+    anchorWholeSegment = true;
+    anchorStart = 0;
+    anchorRun = 0;
+    anchorPosition = Vector3::ZERO;
+    anchorYaw = 0.0f;
+    extrapolatedSequence = 0;
+    extrapolatedMove = Vector3::ZERO;
+    extrapolatedTurn = 0.0f;
+    commandLog = new AsyncLog();
+    commandQueue.SetRateLimit(INPUT_RATE_LIMIT, INPUT_BURST);
+    sunMaterial = "Materials/sun.xml";
     
     const Vector<String>& arguments=GetArguments();
 
     sscanf(arguments[0].CString(),"%d",&myPort);
     sscanf(arguments[1].CString(),"%d",&myAngle);
 
+    // -bundle <fichier> : demarre depuis le paquet, -makebundle <fichier> : ecrit le paquet des ressources utilisees
+    // -truescale : distances reelles, rendues sans tremblement grace a l'origine flottante de BodySystem
+    // -headless : sans fenetre ni rendu, pour les essais locaux de plusieurs murs (solar_client/harness) ; le mur part
+    // alors d'un etat neuf et n'ecrit pas d'instantane
+    // -grant <nom>:<role> : accorde un role au client de ce nom, qui reste observateur sans cela (repetable)
+    for (unsigned i = 2; i < arguments.Size(); ++i)
+    {
+        if (arguments[i] == "-bundle" && i + 1 < arguments.Size())
+            bundleName = arguments[++i];
+        else if (arguments[i] == "-makebundle" && i + 1 < arguments.Size())
+            makeBundleName = arguments[++i];
+        else if (arguments[i] == "-truescale")
+            trueScale = true;
+        else if (arguments[i] == "-headless")
+            headless = true;
+        else if (arguments[i] == "-grant" && i + 1 < arguments.Size())
+        {
+            Vector<String> grant = arguments[++i].Split(':');
+            ControlRole role = grant.Size() == 2 ? ControlArbiter::ParseRole(grant[1]) : NUM_CONTROL_ROLES;
+            if (role != NUM_CONTROL_ROLES)
+                controlArbiter.Grant(grant[0], role);
+            else
+                printf("bad grant: %s\n", arguments[i].CString());
+        }
+    }
+
     printf("myPort=%d myAngle=%d\n",myPort, myAngle);
 }
 
+void StaticScene::Setup()
+{
+    Sample::Setup();
+    if (headless)
+        engineParameters_["Headless"] = true;
+
+    // Mount the bundle before the engine initializes, so that the renderer already reads its files from it
+    if (!bundleName.Empty())
+    {
+        bundle = new ResourceBundle(context_);
+        if (!bundle->Open(bundleName))
+            bundle.Reset();
+    }
+}
+
 void StaticScene::Start()
 {
     // Execute base class startup
     Sample::Start();
 
+    unsigned numPreloaded = bundle ? bundle->Preload() : 0;
+
     SetLogoVisible(false);
 
     cache = GetSubsystem<ResourceCache>();
 
-    input = GetSubsystem<Input>();
-    nbJoysticks=input->GetNumJoysticks();
-    if (nbJoysticks>0)
-    js=input->GetJoystickByIndex(0);
-    else
-    js=NULL;
+    // modeles et materiaux resolus une fois par nom, pour la scene comme pour les commandes reseau ; ceux des
+    // touches 'b', '*' et 'y' sont charges des le demarrage plutot qu'a la premiere pression
+    resourceHandles = new ResourceHandles(context_);
+    boxModel = resourceHandles->GetHandle<Model>("Models/", "Box.mdl");
+    sphereModel = resourceHandles->GetHandle<Model>("Models/", "Sphere.mdl");
+    starsSkyMaterial = resourceHandles->GetHandle<Material>("Materials/", "skybox_stars.xml");
+    secretSkyMaterial = resourceHandles->GetHandle<Material>("Materials/", "pecheux_sky.xml");
+    secretSunMaterial = resourceHandles->GetHandle<Material>("Materials/", "pecheux.xml");
 
-    if (nbJoysticks>0)
-    printf("Il y a un joystick.\n");
+    input = GetSubsystem<Input>();
 
     pitch_ = 60.0f;
 
-    xpos=1;
-    ypos=1;
-
-    cursorLocation=0;
-
     // Create the scene content
     CreateScene();
 
@@ -112,6 +347,65 @@ void StaticScene::Start()
 
     // Hook up to the frame update events
     SubscribeToEvents();
+
+    // temps d'image et memoire, renvoyes au client par la commande telemetry
+    telemetry = new Telemetry(context_);
+
+    // orbites, echelles et materiaux modifiables sans relancer les serveurs (les fichiers du paquet ne changent pas)
+    hotReload = new HotReload(context_);
+    hotReload->SetDescriptionName(SCENE_DESCRIPTION);
+    if (!bundle && hotReload->Start())
+        SubscribeToEvent(E_SCENEDESCRIPTIONCHANGED, URHO3D_HANDLER(StaticScene, HandleSceneDescriptionChanged));
+
+    // un mur relance apres un plantage reprend le spectacle la ou il l'avait laisse
+    snapshot = new SceneSnapshot(context_);
+    snapshot->SetFileName(GetSubsystem<FileSystem>()->GetAppPreferencesDir("urho3d", "solar") + "snapshot" +
+        String(myPort) + ".bin");
+    VectorBuffer snapshotData;
+    if (!headless && snapshot->Read(snapshotData, SNAPSHOT_MAX_AGE))
+    {
+        HiresTimer restoreTimer;
+        if (LoadSnapshot(snapshotData))
+            printf("snapshot %s restored in %lld us\n", snapshot->GetFileName().CString(), restoreTimer.GetUSec(false));
+    }
+
+    // Cold start report, to compare the bundle with the loose directories
+    float startupTime = startupTimer.GetUSec(false) / 1000.0f;
+    if (bundle)
+    {
+        printf("startup %.1f ms from bundle %s: %u resources preloaded, %u files, %.1f MB mapped, %.1f MB resident\n",
+            startupTime, bundle->GetFileName().CString(), numPreloaded, bundle->GetNumFiles(),
+            bundle->GetMappedSize() / (1024.0f * 1024.0f), bundle->GetResidentSize() / (1024.0f * 1024.0f));
+    }
+    else
+    {
+        Vector<String> files;
+        Vector<String> manifest;
+        ResourceBundle::CollectFiles(context_, files, manifest);
+        unsigned bytes = 0;
+        for (unsigned i = 0; i < files.Size(); ++i)
+        {
+            SharedPtr<File> file = cache->GetFile(files[i], false);
+            if (file)
+                bytes += file->GetSize();
+        }
+        printf("startup %.1f ms from loose directories: %u files, %.1f MB read\n", startupTime, files.Size(),
+            bytes / (1024.0f * 1024.0f));
+    }
+
+    // HandleMakeBundle writes the bundle after a few frames (bundleFrames), once the renderer has loaded its own
+    // resources
+}
+
+void StaticScene::HandleMakeBundle(StringHash eventType, VariantMap& eventData)
+{
+    if (++bundleFrames < 3)
+        return;
+
+    String fileName = makeBundleName;
+    makeBundleName.Clear();
+    ResourceBundle::Write(context_, fileName);
+    engine_->Exit();
 }
 
 void StaticScene::CreateScene()
@@ -130,16 +424,28 @@ void StaticScene::CreateScene()
 
     //skybox creation
     skyNode = scene_->CreateChild("skybox");
-    Skybox* skybox = skyNode->CreateComponent<Skybox>();
-    skybox->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
-    skybox->SetMaterial(cache->GetResource<Material>("Materials/skybox_stars.xml"));
+
+    // catalogue d'etoiles affiche en points (converti par StarCatalogConverter), la skybox 8k ne sert que s'il manque
+    starNode = scene_->CreateChild("stars");
+    StarField* starField = starNode->CreateComponent<StarField>();
+    starField->SetMaterial(resourceHandles->GetResource<Material>("Materials/", "starfield.xml"));
+    String starCatalog = cache->GetResourceFileName("Stars/stars.bin");
+    if (starCatalog.Empty() || !starField->Load(starCatalog))
+    {
+        starNode->Remove();
+        starNode = 0;
+
+        Skybox* skybox = skyNode->CreateComponent<Skybox>();
+        skybox->SetModel(resourceHandles->Get(boxModel));
+        skybox->SetMaterial(resourceHandles->Get(starsSkyMaterial));
+    }
 
 
     Node* planeNode = scene_->CreateChild("Plane");
     planeNode->SetScale(Vector3(5.0f, 1.0f, 5.0f));
     StaticModel* planeObject = planeNode->CreateComponent<StaticModel>();
-    planeObject->SetModel(cache->GetResource<Model>("Models/Disk.mdl"));
-    planeObject->SetMaterial(cache->GetResource<Material>("Materials/GreenTransparent.xml"));
+    planeObject->SetModel(resourceHandles->GetResource<Model>("Models/", "Disk.mdl"));
+    planeObject->SetMaterial(resourceHandles->GetResource<Material>("Materials/", "GreenTransparent.xml"));
 
     sunPosNode = scene_->CreateChild("SunPos");
     sunPosNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
@@ -150,8 +456,8 @@ void StaticScene::CreateScene()
     Sun_graphic->SetScale(Vector3(SUN_R, SUN_R, SUN_R));
 
     StaticModel* sunObject = Sun_graphic->CreateComponent<StaticModel>();  
-    sunObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    sunObject->SetMaterial(cache->GetResource<Material>("Materials/sun.xml"));
+    sunObject->SetModel(resourceHandles->Get(sphereModel));
+    sunObject->SetMaterial(resourceHandles->GetResource<Material>(sunMaterial));
 
     //secret
     Node * pecheux_graphic = sunPosNode->CreateChild("pecheux_graphic");
@@ -159,398 +465,139 @@ void StaticScene::CreateScene()
     pecheux_graphic->SetScale(Vector3(1.0f, 1.0f, 1.0f));
 
     StaticModel* pecheuxObject = pecheux_graphic->CreateComponent<StaticModel>();  
-    pecheuxObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    pecheuxObject->SetMaterial(cache->GetResource<Material>("Materials/pecheux.xml"));
+    pecheuxObject->SetModel(resourceHandles->Get(sphereModel));
+    pecheuxObject->SetMaterial(resourceHandles->Get(secretSunMaterial));
+
+    // Orbiting bodies: every planet gets a frame node (position + orbital rotation, attachment point for lights, cameras
+    // and the rocket) and a body node (tilt, spin and scale), both directly under the scene root. BodySystem computes
+    // their world transforms in one pass instead of letting the Orbit -> Pos -> Inclined -> Body chains propagate.
+    bodySystem = scene_->CreateComponent<BodySystem>();
 
-    sunPosRotNode = sunPosNode->CreateChild("SunPosRot");
-    sunPosRotNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorSunPosRot = sunPosRotNode->CreateComponent<Rotator>();
-    rotatorSunPosRot->SetRotationSpeed(Vector3(0.0f, RES_T, 0.0f));
+    for (unsigned i = 0; i < NUM_BODIES; ++i)
+    {
+        const BodyDesc& desc = bodyDescs[i];
 
+        Node* frameNode = desc.frameName ? scene_->CreateChild(desc.frameName) : 0;
+        Node* bodyNode = 0;
+        if (desc.model)
+        {
+            bodyNode = scene_->CreateChild(desc.name);
+            StaticModel* bodyObject = bodyNode->CreateComponent<StaticModel>();
+            bodyObject->SetModel(resourceHandles->GetResource<Model>("", desc.model));
+            if (desc.material)
+                bodyObject->SetMaterial(resourceHandles->GetResource<Material>("", desc.material));
+        }
 
-    // creation terre + axe de rotation + lune
-    earthPosNode = sunPosRotNode->CreateChild("EarthPos");
-    earthPosNode->SetPosition(Vector3(5.0f, 0.0f, 0.0f));
-    //earthPosNode->SetScale(Vector3(1.0f, 1.0f, 1.0f));
-    //Rotator* rotatorEarthPos = earthPosNode->CreateComponent<Rotator>();
-    //rotatorEarthPos->SetRotationSpeed(Vector3(0.0f, -10.0f, 0.0f));
+        if (desc.light)
+        {
+            Node* lightNode = frameNode->CreateChild("DirectionalLight");
+            lightNode->SetPosition(Vector3( -1.5, 0.0f, 0.0f));
+            Light* light = lightNode->CreateComponent<Light>();
+            light->SetBrightness(1.0);
+        }
 
+        BodyParams params;
+        params.parent_ = desc.parent;
+        params.orbitRadius_ = trueScale ? desc.trueOrbitRadius * TRUE_SCALE_UA : desc.orbitRadius;
+        params.orbitSpeed_ = desc.orbitSpeed;
+        params.tilt_ = desc.tilt;
+        params.spinSpeed_ = desc.spinSpeed;
+        params.scale_ = desc.scale;
+        bodySystem->AddBody(params, frameNode, bodyNode);
+    }
 
-    //axe non horizontale de la terre 
-    Node* earthInclinedNode = earthPosNode->CreateChild("EarthInclined");
-    earthInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    earthInclinedNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
+    earthPosNode = bodySystem->GetFrameNode(BODY_EARTH);
+    marsPosNode = bodySystem->GetFrameNode(BODY_MARS);
+    jupiterPosNode = bodySystem->GetFrameNode(BODY_JUPITER);
+    uranusPosNode = bodySystem->GetFrameNode(BODY_URANUS);
+    rocket_traj_center = bodySystem->GetFrameNode(BODY_ROCKET_TRAJ_CENTER);
 
-    Node* cylinderInclinedNode = earthInclinedNode->CreateChild("cylinderInclined");
-    cylinderInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
+    //axe non horizontale de la terre
+    Node* cylinderInclinedNode = earthPosNode->CreateChild("cylinderInclined");
+    cylinderInclinedNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
     cylinderInclinedNode->SetScale(Vector3(0.01f, 2.0f, 0.01f));
     StaticModel* cylinderInclinedObject = cylinderInclinedNode->CreateComponent<StaticModel>();
-    cylinderInclinedObject->SetModel(cache->GetResource<Model>("Models/Cylinder.mdl"));
-
-    Node* earthNode = earthInclinedNode->CreateChild("Earth");
-    //Node* earthNode = earthPosNode->CreateChild("Earth");
-    earthNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    earthNode->SetScale(Vector3(0.3f, 0.3f, 0.3f));
-    StaticModel* earthObject = earthNode->CreateComponent<StaticModel>();
-    earthObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    earthObject->SetMaterial(cache->GetResource<Material>("Materials/earthmap.xml"));
-    Rotator* rotator = earthNode->CreateComponent<Rotator>();
-    rotator->SetRotationSpeed(Vector3(0.0f, -30.0f, 0.0f));
-
-    // rotation de la terre autour du soleil
-    Node* earthPosRotNode = earthPosNode->CreateChild("EarthPosRot");
-    earthPosRotNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorEarthPosRot = earthPosRotNode->CreateComponent<Rotator>();
-    rotatorEarthPosRot->SetRotationSpeed(Vector3(0.0f, -100.0f, 0.0f));
-
-
-    //creation de la lune
-    Node* moonNode = earthPosRotNode->CreateChild("Moon");
-    moonNode->SetPosition(Vector3(0.3f, 0.0f, 0.0f));
-    moonNode->SetScale(Vector3(0.05f, 0.05f, 0.05f));
-    StaticModel* moonObject = moonNode->CreateComponent<StaticModel>();
-    moonObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    moonObject->SetMaterial(cache->GetResource<Material>("Materials/moonmap.xml"));
-    //rotaion de la lune autoure de la terre
-    Rotator* rotatorMoon = moonNode->CreateComponent<Rotator>();
-    rotatorMoon->SetRotationSpeed(Vector3(0.0f, -30.0f, 0.0f));
-
-
-    // creation Mars
-    Node * Mars_orbit = sunPosNode->CreateChild("MarsOrbit");
-    Mars_orbit->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorMars = Mars_orbit->CreateComponent<Rotator>();
-    rotatorMars->SetRotationSpeed(Vector3(0.0f, RES_T *0.55f, 0.0f));
-
-
-    marsPosNode = Mars_orbit->CreateChild("marsPos");
-    marsPosNode->SetPosition(Vector3(1.5 * 5.0f, 0.0f, 0.0f));
-    //earthPosNode->SetScale(Vector3(1.0f, 1.0f, 1.0f));
-    //Rotator* rotatorEarthPos = earthPosNode->CreateComponent<Rotator>();
-    //rotatorEarthPos->SetRotationSpeed(Vector3(0.0f, -10.0f, 0.0f));
-
-
-    //axe non horizontale de Mars
-    Node* marsInclinedNode = marsPosNode->CreateChild("marsInclined");
-    marsInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    marsInclinedNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
-
-    Node* Mars_cylinderInclinedNode = marsInclinedNode->CreateChild("MarscylinderInclined");
-    Mars_cylinderInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Mars_cylinderInclinedNode->SetScale(Vector3(0.01f, 2.0f, 0.01f));
-    //StaticModel* Mars_cylinderInclinedObject = Mars_cylinderInclinedNode->CreateComponent<StaticModel>();
-    //Mars_cylinderInclinedObject->SetModel(cache->GetResource<Model>("Models/Cylinder.mdl"));
-
-    Node* marsNode = marsInclinedNode->CreateChild("Mars");
-    marsNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    marsNode->SetScale(Vector3(0.25f, 0.25f, 0.25f));
-    StaticModel* marsObject = marsNode->CreateComponent<StaticModel>();
-    marsObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    marsObject->SetMaterial(cache->GetResource<Material>("bin/Data/Materials/marsmap.xml"));
-
-    // rotation de Mars autour du soleil
-    Node* marsPosRotNode = marsPosNode->CreateChild("MarsPosRot");
-    marsPosRotNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorMarsPosRot = marsPosRotNode->CreateComponent<Rotator>();
-    rotatorMarsPosRot->SetRotationSpeed(Vector3(0.0f, 10.0f, 0.0f));
-
-
-
-
-
-     //###################### creation mercure #############################
-    Node * mercure_orbit = sunPosNode->CreateChild("mercureOrbit");
-    mercure_orbit->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatormercure = mercure_orbit->CreateComponent<Rotator>();
-    rotatormercure->SetRotationSpeed(Vector3(0.0f, RES_T*10.0f, 0.0f));
-
-
-    Node * mercurePosNode = mercure_orbit->CreateChild("mercurePos");
-    mercurePosNode->SetPosition(Vector3(0.4 * 5.0f, 0.0f, 0.0f));
-    //earthPosNode->SetScale(Vector3(1.0f, 1.0f, 1.0f));
-    //Rotator* rotatorEarthPos = earthPosNode->CreateComponent<Rotator>();
-    //rotatorEarthPos->SetRotationSpeed(Vector3(0.0f, -10.0f, 0.0f));
-
-    // Node * mercure_orbitTorus = mercure_orbit->CreateChild("mercurOrbit_Torus");
-    // mercure_orbitTorus->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    // mercure_orbitTorus->SetScale(Vector3(0.4 * 5.0f, 0.1f, 0.4 * 5.0f));
-    // StaticModel* mercure_orbitObject = mercure_orbitTorus->CreateComponent<StaticModel>();
-    // mercure_orbitObject->SetModel(cache->GetResource<Model>("Models/Torus.mdl"));
-    //mercure_orbitObject->SetMaterial(cache->GetResource<Material>("bin/Data/Materials/mercuremap.xml"));
-
-
-    //axe non horizontale de mercure
-    Node* mercureInclinedNode = mercurePosNode->CreateChild("mercureInclined");
-    mercureInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    mercureInclinedNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
-
-    Node* mercure_cylinderInclinedNode = mercureInclinedNode->CreateChild("mercurecylinderInclined");
-    mercure_cylinderInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    mercure_cylinderInclinedNode->SetScale(Vector3(0.01f, 2.0f, 0.01f));
-    //StaticModel* mercure_cylinderInclinedObject = mercure_cylinderInclinedNode->CreateComponent<StaticModel>();
-    //mercure_cylinderInclinedObject->SetModel(cache->GetResource<Model>("Models/Cylinder.mdl"));
-
-    Node* mercureNode = mercureInclinedNode->CreateChild("mercure");
-    mercureNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    mercureNode->SetScale(Vector3(0.15f, 0.15f, 0.15f));
-    StaticModel* mercureObject = mercureNode->CreateComponent<StaticModel>();
-    mercureObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    mercureObject->SetMaterial(cache->GetResource<Material>("bin/Data/Materials/mercuremap.xml"));
-
-    // rotation de mercure autour du soleil
-    Node* mercurePosRotNode = mercurePosNode->CreateChild("mercurePosRot");
-    mercurePosRotNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatormercurePosRot = mercurePosRotNode->CreateComponent<Rotator>();
-    rotatormercurePosRot->SetRotationSpeed(Vector3(0.0f, 10.0f, 0.0f));
-
-
-
-
-
-    //###################### creation venus #############################
-    Node * venus_orbit = sunPosNode->CreateChild("venusOrbit");
-    venus_orbit->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorvenus = venus_orbit->CreateComponent<Rotator>();
-    rotatorvenus->SetRotationSpeed(Vector3(0.0f, RES_T * 1.62f, 0.0f));
-
-
-    Node * venusPosNode = venus_orbit->CreateChild("venusPos");
-    venusPosNode->SetPosition(Vector3(0.7 * 5.0f, 0.0f, 0.0f));
-    //earthPosNode->SetScale(Vector3(1.0f, 1.0f, 1.0f));
-    //Rotator* rotatorEarthPos = earthPosNode->CreateComponent<Rotator>();
-    //rotatorEarthPos->SetRotationSpeed(Vector3(0.0f, -10.0f, 0.0f));
-
-
-    //axe non horizontale de venus
-    Node* venusInclinedNode = venusPosNode->CreateChild("venusInclined");
-    venusInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    venusInclinedNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
+    cylinderInclinedObject->SetModel(resourceHandles->GetResource<Model>("Models/", "Cylinder.mdl"));
 
-    Node* venus_cylinderInclinedNode = venusInclinedNode->CreateChild("venuscylinderInclined");
-    venus_cylinderInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    venus_cylinderInclinedNode->SetScale(Vector3(0.01f, 2.0f, 0.01f));
-    //StaticModel* venus_cylinderInclinedObject = venus_cylinderInclinedNode->CreateComponent<StaticModel>();
-    //venus_cylinderInclinedObject->SetModel(cache->GetResource<Model>("Models/Cylinder.mdl"));
-
-    Node* venusNode = venusInclinedNode->CreateChild("venus");
-    venusNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    venusNode->SetScale(Vector3(0.28f, 0.28f, 0.28f));
-    StaticModel* venusObject = venusNode->CreateComponent<StaticModel>();
-    venusObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    venusObject->SetMaterial(cache->GetResource<Material>("bin/Data/Materials/venusmap.xml"));
-
-    // rotation de venus autour du soleil
-    Node* venusPosRotNode = venusPosNode->CreateChild("venusPosRot");
-    venusPosRotNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorvenusPosRot = venusPosRotNode->CreateComponent<Rotator>();
-    rotatorvenusPosRot->SetRotationSpeed(Vector3(0.0f, 10.0f, 0.0f));
-
-
-
-
-
-    //############## creation jupiter ###################
-    Node * jupiter_orbit = sunPosNode->CreateChild("jupiterOrbit");
-    jupiter_orbit->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorjupiter = jupiter_orbit->CreateComponent<Rotator>();
-    rotatorjupiter->SetRotationSpeed(Vector3(0.0f, RES_T /12 , 0.0f));
-
-
-    jupiterPosNode = jupiter_orbit->CreateChild("jupiterPos");
-    jupiterPosNode->SetPosition(Vector3(2.3f * UA, 0.0f, 0.0f));
-
-    Node* lightNode_jupiter = jupiterPosNode->CreateChild("DirectionalLight");
-    lightNode_jupiter->SetPosition(Vector3( -1.5, 0.0f, 0.0f));
-    Light* light_jupiter = lightNode_jupiter->CreateComponent<Light>();
-    light_jupiter->SetBrightness(1.0);
-    //earthPosNode->SetScale(Vector3(1.0f, 1.0f, 1.0f));
-    //Rotator* rotatorEarthPos = earthPosNode->CreateComponent<Rotator>();
-    //rotatorEarthPos->SetRotationSpeed(Vector3(0.0f, -10.0f, 0.0f));
-
-
-    //axe non horizontale de jupiter
-    Node* jupiterInclinedNode = jupiterPosNode->CreateChild("jupiterInclined");
-    jupiterInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    jupiterInclinedNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
-
-    Node* jupiter_cylinderInclinedNode = jupiterInclinedNode->CreateChild("jupitercylinderInclined");
-    jupiter_cylinderInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    jupiter_cylinderInclinedNode->SetScale(Vector3(0.01f, 2.0f, 0.01f));
-    //StaticModel* jupiter_cylinderInclinedObject = jupiter_cylinderInclinedNode->CreateComponent<StaticModel>();
-    //jupiter_cylinderInclinedObject->SetModel(cache->GetResource<Model>("Models/Cylinder.mdl"));
-
-    Node* jupiterNode = jupiterInclinedNode->CreateChild("jupiter");
-    jupiterNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    jupiterNode->SetScale(Vector3(1.0f, 1.0f, 1.0f));
-    StaticModel* jupiterObject = jupiterNode->CreateComponent<StaticModel>();
-    jupiterObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    jupiterObject->SetMaterial(cache->GetResource<Material>("bin/Data/Materials/jupitermap.xml"));
-
-    // rotation de jupiter autour du soleil
-    Node* jupiterPosRotNode = jupiterPosNode->CreateChild("jupiterPosRot");
-    jupiterPosRotNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorjupiterPosRot = jupiterPosRotNode->CreateComponent<Rotator>();
-    rotatorjupiterPosRot->SetRotationSpeed(Vector3(0.0f, 10.0f, 0.0f));
-
-
-
-
-
-
-
-     //############## creation saturne ###################
-    Node * saturne_orbit = sunPosNode->CreateChild("saturneOrbit");
-    saturne_orbit->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorsaturne = saturne_orbit->CreateComponent<Rotator>();
-    rotatorsaturne->SetRotationSpeed(Vector3(0.0f, RES_T /29 , 0.0f));
-
-
-    Node * saturnePosNode = saturne_orbit->CreateChild("saturnePos");
-    saturnePosNode->SetPosition(Vector3(3.5f * UA, 0.0f, 0.0f));
-
-    Node* lightNode_saturne = saturnePosNode->CreateChild("DirectionalLight");
-    lightNode_saturne->SetPosition(Vector3( -1.5, 0.0f, 0.0f));
-    Light* light_saturne = lightNode_saturne->CreateComponent<Light>();
-    light_saturne->SetBrightness(1.0);
-    //earthPosNode->SetScale(Vector3(1.0f, 1.0f, 1.0f));
-    //Rotator* rotatorEarthPos = earthPosNode->CreateComponent<Rotator>();
-    //rotatorEarthPos->SetRotationSpeed(Vector3(0.0f, -10.0f, 0.0f));
-
-
-    //axe non horizontale de saturne
-    Node* saturneInclinedNode = saturnePosNode->CreateChild("saturneInclined");
-    saturneInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    saturneInclinedNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
-
-    Node* saturne_cylinderInclinedNode = saturneInclinedNode->CreateChild("saturnecylinderInclined");
-    saturne_cylinderInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    saturne_cylinderInclinedNode->SetScale(Vector3(0.01f, 2.0f, 0.01f));
-    //StaticModel* saturne_cylinderInclinedObject = saturne_cylinderInclinedNode->CreateComponent<StaticModel>();
-    //saturne_cylinderInclinedObject->SetModel(cache->GetResource<Model>("Models/Cylinder.mdl"));
-
-    Node* saturneNode = saturneInclinedNode->CreateChild("saturne");
-    saturneNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    saturneNode->SetScale(Vector3(0.9f, 0.9f, 0.9f));
-    StaticModel* saturneObject = saturneNode->CreateComponent<StaticModel>();
-    saturneObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    saturneObject->SetMaterial(cache->GetResource<Material>("bin/Data/Materials/saturnemap.xml"));
-
-
-    Node * saturn_ring = saturneInclinedNode->CreateChild("ring");
-    saturn_ring->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
+    // anneau de saturne, incline avec la planete mais sans rotation propre
+    Node * saturn_ring = bodySystem->GetFrameNode(BODY_SATURNE)->CreateChild("ring");
+    saturn_ring->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
     saturn_ring->SetScale(Vector3(1.5f, 0.01f, 1.5f));
     StaticModel* saturn_ringObject = saturn_ring->CreateComponent<StaticModel>();
-    saturn_ringObject->SetModel(cache->GetResource<Model>("Models/Torus.mdl"));
+    saturn_ringObject->SetModel(resourceHandles->GetResource<Model>("Models/", "Torus.mdl"));
     //saturn_ringObject->SetMaterial(cache->GetResource<Material>("bin/Data/Materials/ring_saturne.xml"));
 
-    // rotation de saturne autour du soleil
-    Node* saturnePosRotNode = saturnePosNode->CreateChild("saturnePosRot");
-    saturnePosRotNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorsaturnePosRot = saturnePosRotNode->CreateComponent<Rotator>();
-    rotatorsaturnePosRot->SetRotationSpeed(Vector3(0.0f, 10.0f, 0.0f));
-
+    // valeurs du fichier de description, qui est ensuite surveille
+    if (cache->Exists(SCENE_DESCRIPTION))
+        ApplySceneDescription(resourceHandles->GetResource<XMLFile>(SCENE_DESCRIPTION), true);
 
+    bodySystem->UpdateTransforms();
 
 
+    //################# ceintures d'asteroides ######################
+    // ceinture principale entre les orbites de Mars et de Jupiter, ceinture de Kuiper au-dela de Neptune
+    float marsR = bodySystem->GetParams(BODY_MARS).orbitRadius_;
+    float jupiterR = bodySystem->GetParams(BODY_JUPITER).orbitRadius_;
+    float neptuneR = bodySystem->GetParams(BODY_NEPTUNE).orbitRadius_;
 
-     //############## creation uranus ###################
-    Node * uranus_orbit = sunPosNode->CreateChild("uranusOrbit");
-    uranus_orbit->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatoruranus = uranus_orbit->CreateComponent<Rotator>();
-    rotatoruranus->SetRotationSpeed(Vector3(0.0f, RES_T /84 , 0.0f));
-
-
-    uranusPosNode = uranus_orbit->CreateChild("uranusPos");
-    uranusPosNode->SetPosition(Vector3(5.0f * UA, 0.0f, 0.0f));
-
-    Node* lightNode_uranus = uranusPosNode->CreateChild("DirectionalLight");
-    lightNode_uranus->SetPosition(Vector3( -1.5, 0.0f, 0.0f));
-    Light* light_uranus = lightNode_uranus->CreateComponent<Light>();
-    light_uranus->SetBrightness(1.0);
-    //earthPosNode->SetScale(Vector3(1.0f, 1.0f, 1.0f));
-    //Rotator* rotatorEarthPos = earthPosNode->CreateComponent<Rotator>();
-    //rotatorEarthPos->SetRotationSpeed(Vector3(0.0f, -10.0f, 0.0f));
-
-
-    //axe non horizontale de uranus
-    Node* uranusInclinedNode = uranusPosNode->CreateChild("uranusInclined");
-    uranusInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    uranusInclinedNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
-
-    Node* uranus_cylinderInclinedNode = uranusInclinedNode->CreateChild("uranuscylinderInclined");
-    uranus_cylinderInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    uranus_cylinderInclinedNode->SetScale(Vector3(0.01f, 2.0f, 0.01f));
-    //StaticModel* uranus_cylinderInclinedObject = uranus_cylinderInclinedNode->CreateComponent<StaticModel>();
-    //uranus_cylinderInclinedObject->SetModel(cache->GetResource<Model>("Models/Cylinder.mdl"));
-
-    Node* uranusNode = uranusInclinedNode->CreateChild("uranus");
-    uranusNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    uranusNode->SetScale(Vector3(0.57f, 0.57f, 0.57f));
-    StaticModel* uranusObject = uranusNode->CreateComponent<StaticModel>();
-    uranusObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    uranusObject->SetMaterial(cache->GetResource<Material>("bin/Data/Materials/uranusmap.xml"));
-
-    // rotation de uranus autour du soleil
-    Node* uranusPosRotNode = uranusPosNode->CreateChild("uranusPosRot");
-    uranusPosRotNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatoruranusPosRot = uranusPosRotNode->CreateComponent<Rotator>();
-    rotatoruranusPosRot->SetRotationSpeed(Vector3(0.0f, 10.0f, 0.0f));
-
-
-
-
-
-     //############## creation neptune ###################
-    Node * neptune_orbit = sunPosNode->CreateChild("neptuneOrbit");
-    neptune_orbit->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorneptune = neptune_orbit->CreateComponent<Rotator>();
-    rotatorneptune->SetRotationSpeed(Vector3(0.0f, RES_T /165 , 0.0f));
-
-
-    Node * neptunePosNode = neptune_orbit->CreateChild("neptunePos");
-    neptunePosNode->SetPosition(Vector3(7.5f * UA, 0.0f, 0.0f));
-
-    Node* lightNode_neptune = neptunePosNode->CreateChild("DirectionalLight");
-    lightNode_neptune->SetPosition(Vector3( -1.5, 0.0f, 0.0f));
-    Light* light_neptune = lightNode_neptune->CreateComponent<Light>();
-    light_neptune->SetBrightness(1.0);
-    //earthPosNode->SetScale(Vector3(1.0f, 1.0f, 1.0f));
-    //Rotator* rotatorEarthPos = earthPosNode->CreateComponent<Rotator>();
-    //rotatorEarthPos->SetRotationSpeed(Vector3(0.0f, -10.0f, 0.0f));
-
-
-    //axe non horizontale de neptune
-    Node* neptuneInclinedNode = neptunePosNode->CreateChild("neptuneInclined");
-    neptuneInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    neptuneInclinedNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
-
-    Node* neptune_cylinderInclinedNode = neptuneInclinedNode->CreateChild("neptunecylinderInclined");
-    neptune_cylinderInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    neptune_cylinderInclinedNode->SetScale(Vector3(0.01f, 2.0f, 0.01f));
-    //StaticModel* neptune_cylinderInclinedObject = neptune_cylinderInclinedNode->CreateComponent<StaticModel>();
-    //neptune_cylinderInclinedObject->SetModel(cache->GetResource<Model>("Models/Cylinder.mdl"));
-
-    Node* neptuneNode = neptuneInclinedNode->CreateChild("neptune");
-    neptuneNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    neptuneNode->SetScale(Vector3(0.53f, 0.53f, 0.53f));
-    StaticModel* neptuneObject = neptuneNode->CreateComponent<StaticModel>();
-    neptuneObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-    neptuneObject->SetMaterial(cache->GetResource<Material>("bin/Data/Materials/neptunemap.xml"));
-
-    // rotation de neptune autour du soleil
-    Node* neptunePosRotNode = neptunePosNode->CreateChild("neptunePosRot");
-    neptunePosRotNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-    Rotator* rotatorneptunePosRot = neptunePosRotNode->CreateComponent<Rotator>();
-    rotatorneptunePosRot->SetRotationSpeed(Vector3(0.0f, 10.0f, 0.0f));
-
+    // memes formes et materiau pour les deux ceintures
+    Model* asteroidMeshes[] =
+    {
+        resourceHandles->Get(boxModel),
+        resourceHandles->GetResource<Model>("Models/", "Pyramid.mdl"),
+        resourceHandles->GetResource<Model>("Models/", "Cone.mdl")
+    };
+    Material* asteroidMaterial = resourceHandles->GetResource<Material>("Materials/", "asteroid.xml");
+
+    Node* asteroidNode = scene_->CreateChild("AsteroidBelt");
+    AsteroidBelt* asteroids = asteroidNode->CreateComponent<AsteroidBelt>();
+    for (unsigned i = 0; i < sizeof(asteroidMeshes) / sizeof(asteroidMeshes[0]); ++i)
+        asteroids->AddMesh(asteroidMeshes[i]);
+    asteroids->SetMaterial(asteroidMaterial);
+    asteroids->SetReferenceOrbit(bodySystem->GetParams(BODY_EARTH).orbitRadius_, RES_T);
+    asteroids->Generate(ASTEROID_COUNT, marsR + 0.15f * (jupiterR - marsR), jupiterR - 0.3f * (jupiterR - marsR), 8.0f,
+        0.005f, 0.02f, 1);
+
+    Node* kuiperNode = scene_->CreateChild("KuiperBelt");
+    AsteroidBelt* kuiper = kuiperNode->CreateComponent<AsteroidBelt>();
+    for (unsigned i = 0; i < sizeof(asteroidMeshes) / sizeof(asteroidMeshes[0]); ++i)
+        kuiper->AddMesh(asteroidMeshes[i]);
+    kuiper->SetMaterial(asteroidMaterial);
+    kuiper->SetReferenceOrbit(bodySystem->GetParams(BODY_EARTH).orbitRadius_, RES_T);
+    kuiper->Generate(KUIPER_COUNT, neptuneR * 1.1f, neptuneR * 1.4f, 15.0f, 0.02f, 0.06f, 2);
+
+
+    //################# satellites et debris ######################
+    // en km dans le repere equatorial de la terre (catalogue TLE converti par SatelliteCatalogConverter), incline comme
+    // son axe; population synthetique s'il n'y a pas de catalogue
+    Node* satelliteNode = earthPosNode->CreateChild("satellites");
+    satelliteNode->SetRotation(Quaternion(0.0f, 0.0f, 23.0f));
+    satelliteNode->SetScale(bodySystem->GetParams(BODY_EARTH).scale_ * 0.5f / (float)SATELLITE_EARTH_RADIUS);
+    SatelliteField* satellites = satelliteNode->CreateComponent<SatelliteField>();
+    satellites->SetMaterial(resourceHandles->GetResource<Material>("Materials/", "satellites.xml"));
+    String satelliteCatalog = cache->GetResourceFileName("Satellites/satellites.bin");
+    if (satelliteCatalog.Empty() || !satellites->Load(satelliteCatalog))
+        satellites->Generate(SATELLITE_COUNT, 3);
 
 
     //################# material for rocket ######################
-    rocket_traj_center = sunPosRotNode->CreateChild("rocket_traj_center");
-    rocket_traj_center->SetPosition(Vector3( -((5.0f + 1.5*5.0f)/2 -5), 0.0f, 0.0f));
+    // dynamique de la fusee en coniques raccordees, placee par rocketLaunch(). Le Soleil a la gravite qui rend
+    // keplerienne l'orbite dessinee de la Terre ; les autres astres attirent selon leur masse, la Lune seulement si son
+    // orbite tient dans la sphere d'influence de la Terre (vraie echelle)
+    craftPropagator = scene_->CreateComponent<CraftPropagator>();
+    craftPropagator->SetBodySystem(bodySystem);
+    const BodyParams& earthParams = bodySystem->GetParams(BODY_EARTH);
+    double earthSpeed = earthParams.orbitSpeed_ * M_DEGTORAD;
+    double earthRadius = earthParams.orbitRadius_;
+    craftPropagator->SetSunGravity(earthSpeed * earthSpeed * earthRadius * earthRadius * earthRadius);
+    for (unsigned i = 0; i < NUM_BODIES; ++i)
+    {
+        if (bodyDescs[i].massRatio > 0.0)
+            craftPropagator->AddBody(i, bodyDescs[i].massRatio);
+    }
+    rocketCraft = craftPropagator->AddCraft(0, DoubleVector3(1.0, 0.0, 0.0), DoubleVector3(), 0.0);
 
     rocketPosNode = earthPosNode->CreateChild("rocketPos");
-    //rocketPosNode->SetParent(rocket_orbit);
 
     Node* rocketInclinedNode = rocketPosNode->CreateChild("rocketInclined");
     rocketInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
@@ -562,8 +609,50 @@ void StaticScene::CreateScene()
     rocketNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
     rocketNode->SetScale(Vector3(0.02f, 0.02f, 0.02f));
     StaticModel* rocketObject = rocketNode->CreateComponent<StaticModel>();
-    rocketObject->SetModel(cache->GetResource<Model>("Models/fusee.mdl"));
-    rocketObject->SetMaterial(cache->GetResource<Material>("Materials/fusee.xml"));
+    rocketObject->SetModel(resourceHandles->GetResource<Model>("Models/", "fusee.mdl"));
+    rocketObject->SetMaterial(resourceHandles->GetResource<Material>("Materials/", "fusee.xml"));
+
+
+    //################# orbites et traces ######################
+    // orbites des planetes generees une fois autour du soleil, traces de la lune et de la fusee en anneau
+    orbitTrails = sunPosNode->CreateComponent<OrbitTrails>();
+    orbitTrails->SetMaterial(resourceHandles->GetResource<Material>("Materials/", "orbittrails.xml"));
+    orbitTrails->SetTrailLength(512);
+    orbitTrails->SetAppendInterval(0.05f);
+    for (unsigned i = 0; i < NUM_BODIES; ++i)
+    {
+        if (bodyDescs[i].model && bodyDescs[i].parent < 0)
+            orbitTrails->AddOrbit(bodySystem->GetParams(i).orbitRadius_, Color(0.3f, 0.4f, 0.6f, 0.6f));
+    }
+    orbitTrails->AddTrail(bodySystem->GetBodyNode(BODY_MOON), Color(0.7f, 0.7f, 0.7f));
+    orbitTrails->AddTrail(rocketPosNode, Color(1.0f, 0.5f, 0.1f));
+
+
+    //################# index spatial ######################
+    // spheres des astres et de la fusee, pour les requetes de proximite, de rayon et de visee (camera, etiquettes)
+    spatialIndex = scene_->CreateComponent<SpatialIndex>();
+    spatialIndex->AddNode(Sun_graphic, SUN_R * 0.5f);
+    for (unsigned i = 0; i < NUM_BODIES; ++i)
+    {
+        if (bodySystem->GetBodyNode(i))
+            spatialIndex->AddNode(bodySystem->GetBodyNode(i), bodySystem->GetParams(i).scale_ * 0.5f);
+    }
+    spatialIndex->AddNode(rocketPosNode, 0.02f);
+
+
+    //################# etiquettes ######################
+    // noms et distances a la camera en police SDF, date en haut a gauche de chaque mur ; 'n' les masque
+    labelLayer = scene_->CreateChild("labels")->CreateComponent<LabelLayer>();
+    labelLayer->SetFont(resourceHandles->GetResource<Font>("Fonts/", "Anonymous Pro.sdf"),
+        resourceHandles->GetResource<Material>("Materials/", "labels.xml"));
+    labelLayer->SetDistanceScale(trueScale ? TRUE_SCALE_UA : UA);
+    labelLayer->AddLabel(Sun_graphic, "Soleil", SUN_R * 0.5f, Color(1.0f, 0.9f, 0.6f));
+    for (unsigned i = 0; i < NUM_BODIES; ++i)
+    {
+        if (bodyLabels[i] && bodySystem->GetBodyNode(i))
+            labelLayer->AddLabel(bodySystem->GetBodyNode(i), bodyLabels[i], bodySystem->GetParams(i).scale_ * 0.5f);
+    }
+    labelLayer->AddLabel(rocketPosNode, "Fusee", 0.02f, Color(1.0f, 0.5f, 0.1f));
 
 
 
@@ -611,10 +700,15 @@ void StaticScene::CreateScene()
     // Create a scene node for the camera, which we will move around
     // The camera will use default settings (1000 far clip distance, 45 degrees FOV, set aspect ratio automatically)
     cameraNode_ = scene_->CreateChild("Camera");
+    cameraRig.SetCamera(cameraNode_);
     cameraNode_->CreateComponent<Camera>();
 
     // Set an initial position for the camera scene node above the plane
     cameraNode_->SetPosition(Vector3(0.0f, 15.0f, 0.0f));
+    // l'origine de la scene suit la camera, seules les positions relatives a la camera arrivent en float aux noeuds
+    bodySystem->SetOriginNode(cameraNode_);
+    if (trueScale)
+        cameraNode_->GetComponent<Camera>()->SetFarClip(2.0f * bodySystem->GetParams(BODY_NEPTUNE).orbitRadius_);
     //cameraNode_->SetRotation(Quaternion(90.0f, 90.0f, 90.0f));
     
 }
@@ -641,6 +735,8 @@ void StaticScene::CreateInstructions()
 void StaticScene::SetupViewport()
 {
     Renderer* renderer = GetSubsystem<Renderer>();
+    if (!renderer)
+        return;
 
     // Set up a viewport to the Renderer subsystem so that the 3D scene can be seen. We need to define the scene and the camera
     // at minimum. Additionally we could configure the viewport screen size and the rendering path (eg. forward / deferred) to
@@ -650,102 +746,64 @@ void StaticScene::SetupViewport()
 }
 
 
-float StaticScene::Dist( Vector3 a, Vector3 b){
-    return sqrt( pow(a.x_ - b.x_,2) + pow(a.y_ - b.y_,2) + pow(a.z_ - b.z_,2) );
-}
-
 void StaticScene::rocketLaunch(){
-    Vector3 earthPos = earthPosNode->GetWorldPosition();
-    Vector3 marsPos  = marsPosNode->GetWorldPosition();
-    Vector3 sunPos   = sunPosNode->GetWorldPosition();
-
-    float terre_soleil = Dist(earthPos, sunPos) ;
-    float mars_soleil  = Dist(marsPos , sunPos) ;
-    float terre_mars   = Dist(earthPos, marsPos);
-
-    //int angle_terre_mars = acos(terre_soleil/mars_soleil)* 180.0 / PI;
-    int angle_terre_mars = acos( (pow(terre_soleil,2) + pow(mars_soleil,2) - pow(terre_mars,2))/(2*terre_soleil*mars_soleil)   )* 180.0 / PI;
-
-
-    // printf("%d\n",angle_terre_mars );
-    // ResourceCache* cache = GetSubsystem<ResourceCache>();
-    // UI* ui = GetSubsystem<UI>();
-    // Text* instructionText = ui->GetRoot()->CreateChild<Text>();
-    // char buffer [50];
-    // instructionText->SetText(buffer);
-    // instructionText->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
-    
-    // sprintf(buffer, "%d", angle_terre_mars);
-    // instructionText->SetText(buffer);
-    // instructionText->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
-
-
-
-    if (angle_terre_mars != 44 and !autorised ){
-        autorised = true;
-    }
-
-    if (angle_terre_mars == 44 and autorised ){
-        autorised = false;
-        tkt++;
-        if(tkt%2 == 0){
-
-            //create center of rocket orbit
-            Node * trajectory_center = scene_->CreateChild("trajectory_center");
-            Vector3 ctrPos = rocket_traj_center->GetWorldPosition();
-            trajectory_center->SetPosition(ctrPos);
-
-            //create rocket position
-            Node * rocket_orbit = trajectory_center->CreateChild("rocket_orbit");
-            rocket_orbit->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-            Rotator* rotatorRocket = rocket_orbit->CreateComponent<Rotator>();
-            rotatorRocket->SetRotationSpeed(Vector3(0.0f, RES_T * 0.73 , 0.0f));
-
-
-            // Node * rocketPosNode = rocket_orbit->CreateChild("rocketPos");
-            // rocketPosNode->SetPosition(Vector3( (5.0f + 1.5*5.0f)/2, 0.0f, 0.0f));
-            rocketPosNode->SetParent(earthPosNode);
-            rocketPosNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-            rocketPosNode->SetParent(rocket_orbit);
-
-         //    rocketInclinedNode->SetParent(rocketPosNode);
-         //    rocketInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-            // rocketInclinedNode->SetRotation(Quaternion(90.0f, 90.0f, 90.0f));
-
-
-            // rocketNode->SetParent(rocketInclinedNode);
-         //    rocketNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-         //    rocketNode->SetScale(Vector3(0.02f, 0.02f, 0.02f));
-            // StaticModel* rocketObject = rocketNode->CreateComponent<StaticModel>();
-            // rocketObject->SetModel(cache->GetResource<Model>("Models/fusee.mdl"));
-            // rocketObject->SetMaterial(cache->GetResource<Material>("Materials/fusee.xml"));
+    // transfert de Hohmann vers Mars lance une fois par periode synodique, quand Mars a l'avance voulue sur la Terre
+    // (42 degres pour les vitesses actuelles). Le vol est integre par CraftPropagator depuis une orbite basse de la
+    // Terre, le depart etant ajuste par tir pour arriver sur Mars. Il ne depend que du temps de simulation : toutes les
+    // vitesses du temps donnent la meme trajectoire, et un saut en arriere relance le vol depuis le depart
+    const BodyParams& earth = bodySystem->GetParams(BODY_EARTH);
+    const BodyParams& mars  = bodySystem->GetParams(BODY_MARS);
+    double time = bodySystem->GetTime();
+
+    double transferAxis = 0.5 * (fabs(earth.orbitRadius_) + fabs(mars.orbitRadius_));
+    double flightTime = M_PI * sqrt(transferAxis * transferAxis * transferAxis / craftPropagator->GetGravity(0));
+    double lead = 180.0 - fabs(mars.orbitSpeed_) * flightTime;
+    double leadRate = (mars.orbitSpeed_ - earth.orbitSpeed_) * (earth.orbitSpeed_ < 0.0f ? -1.0 : 1.0);
+    double period = 360.0 / fabs(leadRate);
+    double firstLaunch = fmod(lead / leadRate, period);
+    if (firstLaunch < 0.0)
+        firstLaunch += period;
+
+    Node* parent = earthPosNode;
+    if (time >= firstLaunch)
+    {
+        double launchTime = firstLaunch + floor((time - firstLaunch) / period) * period;
+        double flight = time - launchTime;
+        if (flight < flightTime)
+        {
+            unsigned earthGravity = craftPropagator->GetGravityIndex(BODY_EARTH);
+            if (launchTime != rocketLaunchTime)
+            {
+                // orbite de parking au ras de la Terre dessinee, sans sortir de sa sphere d'influence
+                double parkingRadius = Min(1.05 * 0.5 * earth.scale_, 0.5 * craftPropagator->GetSoiRadius(earthGravity));
+                if (!craftPropagator->FindDeparture(earthGravity, craftPropagator->GetGravityIndex(BODY_MARS),
+                    launchTime, flightTime, parkingRadius, rocketDeparturePosition, rocketDepartureVelocity))
+                    URHO3D_LOGWARNING("Rocket departure did not converge");
+                rocketLaunchTime = launchTime;
+                craftPropagator->SetCraft(rocketCraft, earthGravity, rocketDeparturePosition, rocketDepartureVelocity,
+                    launchTime);
+            }
+            else if (time < craftPropagator->GetStartTime(rocketCraft))
+                craftPropagator->SetCraft(rocketCraft, earthGravity, rocketDeparturePosition, rocketDepartureVelocity,
+                    launchTime);
+            craftPropagator->Propagate(time);
+
+            // en vol : sous la racine de la scene, oriente comme au repos sur la Terre par rapport a sa vitesse
+            DoubleVector3 position = craftPropagator->GetSimPosition(rocketCraft, time);
+            DoubleVector3 velocity = craftPropagator->GetSimVelocity(rocketCraft, time);
+            if (rocketPosNode->GetParent() != scene_)
+                rocketPosNode->SetParent(scene_);
+            rocketPosNode->SetTransform((position - bodySystem->GetOrigin()).ToVector3(),
+                Quaternion((float)(atan2(-velocity.z_, velocity.x_) * M_RADTODEG + 90.0), Vector3::UP));
+            return;
         }
-
-
-    }
-
-    Vector3 rocketPos = rocketPosNode->GetWorldPosition();
-
-    if(Dist(rocketPos,marsPos) < 0.01){
-        rocketPosNode->SetParent(marsPosNode);
-        rocketPosNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-
-        //rocketInclinedNode = rocketPosNode->CreateChild("rocketInclined");
-     //    rocketInclinedNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-     //    rocketInclinedNode->SetRotation(Quaternion(90.0f, 90.0f, 90.0f));
-
-
-        // //Node* rocketNode = rocketInclinedNode->CreateChild("rocket");
-     //    rocketNode->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-     //    rocketNode->SetScale(Vector3(0.02f, 0.02f, 0.02f));
-     //    // StaticModel* rocketObject = rocketNode->CreateComponent<StaticModel>();
-        // rocketObject->SetModel(cache->GetResource<Model>("Models/fusee.mdl"));
-        // rocketObject->SetMaterial(cache->GetResource<Material>("Materials/fusee.xml"));
-
+        parent = marsPosNode;
     }
 
-    
-
+    // avant le premier lancement sur la Terre, apres l'arrivee sur Mars
+    if (rocketPosNode->GetParent() != parent)
+        rocketPosNode->SetParent(parent);
+    rocketPosNode->SetTransform(Vector3::ZERO, Quaternion::IDENTITY);
 }
 
 
@@ -820,9 +878,6 @@ void StaticScene::MoveCamera(float timeStep)
                 //cameraNode_->SetPosition(cpos);
                 earthPosNode->SetPosition(cpos);
         }
-
-    if (nbJoysticks>0)
-        ManageJoystick(timeStep);
 */
     if (input->GetKeyPress('I'))
         {
@@ -844,133 +899,6 @@ void StaticScene::MoveCamera(float timeStep)
 
 }
 
-void StaticScene::ManageJoystick(float timeStep)
-{
-    const float MOVE_SPEED = 20.0f;
-    Vector3 cpos=cameraNode_->GetPosition();
-    //Vector3 posn=posNode->GetPosition();
-
-    double xJ0=js->GetAxisPosition(0);
-    double yJ0=js->GetAxisPosition(1);
-    double xJ1=js->GetAxisPosition(2);
-    double yJ1=js->GetAxisPosition(3);
-
-        if (xJ0>0.1)
-            {
-                    float dx=MOVE_SPEED* xJ0 * timeStep;
-                    cpos.x_=cpos.x_+dx;
-                    cameraNode_->SetPosition(cpos);
-            }
-        if (xJ0<-0.1)
-            {
-                    float dx=MOVE_SPEED * xJ0 * timeStep;
-                    cpos.x_=cpos.x_+dx;
-                    cameraNode_->SetPosition(cpos);
-            }
-        if (yJ0<-0.1)
-            {
-                    float dz=MOVE_SPEED * yJ0 * timeStep;
-                    cpos.z_=cpos.z_-dz;
-                    cameraNode_->SetPosition(cpos);
-            }
-        if (yJ0>0.1)
-            {
-                    float dz=MOVE_SPEED * yJ0 * timeStep;
-                    cpos.z_=cpos.z_-dz;
-                    cameraNode_->SetPosition(cpos);
-            }
-
-/*
-    printf("Buttons=%d\n",js->GetNumButtons());
-    printf("01234567890123456789\n");
-    printf("00000000001111111111\n");
-    for (int i=0;i<js->GetNumButtons();i++)
-        if (js->GetButtonDown(i)==true)
-            printf("1");
-        else
-            printf("0");
-    printf("\n");
-    printf("Hats=%d\n",js->GetNumHats());
-
-    printf("%f %f\n", (float)js->GetAxisPosition(2), (float)js->GetAxisPosition(3)); 
-*/
-    
-        if (xJ1>0.1)
-            {
-                    float dy=MOVE_SPEED * 2.0 * xJ1 * timeStep;
-                    cpos.y_=cpos.y_-dy;
-                    cameraNode_->SetPosition(cpos);
-            }
-        if (xJ1<-0.1)
-            {
-                    float dy=MOVE_SPEED * 2.0 * xJ1 * timeStep;
-                    cpos.y_=cpos.y_-dy;
-                    cameraNode_->SetPosition(cpos);
-            }
-
-        if (yJ1>0.1)
-            {
-                    float amount=MOVE_SPEED * 2.0 * yJ1 * timeStep;
-            printf("amount=%f\n",amount);
-            pitch_ +=amount;
-            }
-        if (yJ1<-0.1)
-            {
-                    float amount=MOVE_SPEED * 2.0 * yJ1 * timeStep;
-            printf("amount=%f\n",amount);
-            pitch_ +=amount;
-            }
-
-    if (js->GetButtonPress(13))
-            {
-            std::cout << "--------------------------------------------------------- bouton 13" << std::endl;
-            if (possibleDirections[cursorLocation].wt!=-1)
-            {
-                moveObjectToPoint((char*)"MoralePawn",possibleDirections[cursorLocation].w);
-                cursorLocation=possibleDirections[cursorLocation].wt;
-            }
-            }
-    if (js->GetButtonPress(14))
-            {
-            std::cout << "--------------------------------------------------------- bouton 14" << std::endl;
-            if (possibleDirections[cursorLocation].et!=-1)
-            {
-                moveObjectToPoint((char*)"MoralePawn",possibleDirections[cursorLocation].e);
-                cursorLocation=possibleDirections[cursorLocation].et;
-            }
-            }
-    if (js->GetButtonPress(11))
-            {
-            std::cout << "--------------------------------------------------------- bouton 11" << std::endl;
-            if (possibleDirections[cursorLocation].nt!=-1)
-            {
-                moveObjectToPoint((char*)"MoralePawn",possibleDirections[cursorLocation].n);
-                cursorLocation=possibleDirections[cursorLocation].nt;
-            }
-            }
-    if (js->GetButtonPress(12))
-            {
-            std::cout << "--------------------------------------------------------- bouton 12" << std::endl;
-            if (possibleDirections[cursorLocation].st!=-1)
-            {
-                moveObjectToPoint((char*)"MoralePawn",possibleDirections[cursorLocation].s);
-                cursorLocation=possibleDirections[cursorLocation].st;
-            }
-            }
-
-        pitch_ = Clamp(pitch_, -90.0f, 90.0f);
-
-    if (js->GetButtonPress(4))
-            {
-                    cpos.x_=0.0;
-                    cpos.y_=15.0;
-                    cpos.z_=0.0;
-            pitch_=60.0;
-                    cameraNode_->SetPosition(cpos);
-            }
-
-}
-
 void StaticScene::SubscribeToEvents()
 {
     // Subscribe HandleUpdate() function for processing update events
@@ -986,6 +914,7 @@ void StaticScene::SubscribeToEvents()
         SubscribeToEvent(E_CLIENTCONNECTED, URHO3D_HANDLER(StaticScene, HandleClientConnected));
         SubscribeToEvent(E_CLIENTDISCONNECTED, URHO3D_HANDLER(StaticScene, HandleClientDisconnected));
         SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(StaticScene, HandleNetworkMessage));
+        SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(StaticScene, HandleEndFrame));
 
 }
 
@@ -998,18 +927,231 @@ void StaticScene::HandleUpdate(StringHash eventType, VariantMap& eventData)
 
     // Move the camera, scale movement with time step
     
+    DrainCommands();
     MoveCamera(timeStep);
+    ApplyCameraVelocity(timeStep);
+    cameraRig.Update(controlArbiter.GetTime(), timeStep, pitch_, yaw_);
+    bodySystem->UpdateOrigin();
+    RebaseCameraAnchor();
     rocketLaunch();
-}
-
-void StaticScene::HandleClientConnected(StringHash eventType, VariantMap& eventData)
-{
-        printf("Client connected\n");
-}
+    spatialIndex->Update();
+
+    // instantane periodique, serialise ici et ecrit sur le disque par un thread de travail
+    snapshotTimer += timeStep;
+    if (snapshotTimer >= SNAPSHOT_INTERVAL && !headless && !snapshot->IsWriting())
+    {
+        snapshotTimer = 0.0f;
+        VectorBuffer snapshotData;
+        SaveSnapshot(snapshotData);
+        snapshot->WriteAsync(snapshotData);
+    }
+
+    // date de la simulation (1 an = 360/|RES_T| secondes, origine au 2000-01-01) et vitesse du temps
+    int year, month, day;
+    double days = bodySystem->GetTime() * fabs(RES_T) / 360.0 * 365.25;
+    CivilFromDays(DaysFromCivil(2000, 1, 1) + (int)floor(days), year, month, day);
+    labelLayer->SetHeader(String(year) + "-" + (month < 10 ? "0" : "") + String(month) + "-" + (day < 10 ? "0" : "") +
+        String(day) + "  x" + String(bodySystem->GetTimeScale()));
+
+    // la camera ne traverse pas les astres : on la ressort a la surface de l'astre le plus proche
+    SpatialQueryResult nearest;
+    Vector3 cameraPos = cameraNode_->GetWorldPosition();
+    if (spatialIndex->QueryNearest(cameraPos, CAMERA_CLEARANCE, nearest) && nearest.distance_ < CAMERA_CLEARANCE)
+    {
+        Vector3 center = nearest.node_->GetWorldPosition();
+        Vector3 away = cameraPos - center;
+        away = away.LengthSquared() > M_EPSILON ? away.Normalized() : Vector3::BACK;
+        cameraNode_->SetWorldPosition(center + away * (nearest.radius_ + CAMERA_CLEARANCE));
+    }
+}
+
+void StaticScene::ApplyCameraVelocity(float timeStep)
+{
+    // seule la camera du controleur qui l'a compte
+    ControlSession* owner = controlArbiter.GetCameraOwner();
+    if (!owner || !owner->hasCameraSequence_)
+        return;
+
+    float now = controlArbiter.GetTime();
+    bool live = now - owner->cameraTime_ <= CAMERA_INPUT_TIMEOUT;
+    const CameraSegment& segment = owner->cameraSegment_;
+    const CameraSegment& previous = owner->previousSegment_;
+    const CameraSegment& keyframe = owner->keyframe_;
+    bool hasPrevious = previous.start_ != segment.start_;
+
+    // segment suivant de la meme course : l'image cle, dans chaque paquet, le place depuis le debut de la course,
+    // meme si des segments entiers se sont perdus. Au debut d'une autre course, le segment precedent, complet dans
+    // chaque paquet, s'ajoute a l'ancre ; s'il s'est perdu aussi, la camera repart d'ou elle est au segment suivant
+    if (cameraAnchored && segment.start_ != anchorStart)
+    {
+        if (keyframe.start_ == anchorRun)
+        {
+            float runYaw = anchorYaw - anchorKeyframe.yaw_;
+            Quaternion runRotation(runYaw, Vector3::UP);
+            anchorPosition += runRotation * (keyframe.odometry_.GetDisplacement(pitch_) -
+                anchorKeyframe.GetDisplacement(pitch_)) * CAMERA_MOVE_SPEED;
+            anchorYaw = runYaw + keyframe.odometry_.yaw_;
+            anchorStart = segment.start_;
+            anchorKeyframe = keyframe.odometry_;
+        }
+        else if (hasPrevious && previous.start_ == anchorStart)
+        {
+            anchorPosition += Quaternion(anchorYaw, Vector3::UP) * previous.odometry_.GetDisplacement(pitch_) *
+                CAMERA_MOVE_SPEED;
+            anchorYaw += previous.odometry_.yaw_;
+            anchorStart = segment.start_;
+            anchorRun = keyframe.start_;
+            anchorKeyframe = keyframe.odometry_;
+        }
+        else
+            ReleaseCameraAnchor(segment.start_ + 1, false);
+    }
+
+    // ancrage sur le premier segment qui suit la derniere commande de camera ou le changement de proprietaire, le
+    // meme sur tous les murs puisque choisi par l'heure de l'envoi : la camera en part d'ou elle est, vol et pas
+    // termines
+    if (!cameraAnchored)
+    {
+        const CameraSegment* first = 0;
+        if (anchorWholeSegment)
+        {
+            if ((int)(owner->cameraSendTime_ - anchorTime) >= 0)
+                first = &segment;
+        }
+        else if (hasPrevious && (int)(previous.start_ - anchorTime) >= 0)
+            first = &previous;
+        else if ((int)(segment.start_ - anchorTime) >= 0)
+            first = &segment;
+        if (!first || !live)
+            return;
+
+        if (cameraRig.IsFlying())
+            cameraRig.Land();
+        anchorPosition = cameraNode_->GetPosition() + cameraRig.GetPendingMove();
+        anchorOrigin = bodySystem->GetOrigin();
+        anchorYaw = yaw_ - myAngle;
+        cameraRig.Stop();
+        anchorStart = segment.start_;
+        anchorRun = keyframe.start_;
+        anchorKeyframe = keyframe.odometry_;
+        cameraAnchored = true;
+        if (first == &previous)
+        {
+            anchorPosition += Quaternion(anchorYaw, Vector3::UP) * previous.odometry_.GetDisplacement(pitch_) *
+                CAMERA_MOVE_SPEED;
+            anchorYaw += previous.odometry_.yaw_;
+        }
+    }
+
+    // pose du dernier paquet, fonction du segment seul et non des images de ce mur ; memes axes que les commandes
+    // 'z', 'q', 's', 'd', 'o', 'l' (tous les murs dans la meme direction) et 'k', 'm'
+    Vector3 position = anchorPosition + Quaternion(anchorYaw, Vector3::UP) *
+        segment.odometry_.GetDisplacement(pitch_) * CAMERA_MOVE_SPEED;
+    float yaw = anchorYaw + segment.odometry_.yaw_;
+
+    // extrapolee jusqu'au paquet suivant avec la vitesse du clavier et du joystick : stick gauche pour avancer et
+    // glisser, stick droit pour tourner et monter
+    if (owner->cameraSequence_ != extrapolatedSequence || !live)
+    {
+        extrapolatedSequence = owner->cameraSequence_;
+        extrapolatedMove = Vector3::ZERO;
+        extrapolatedTurn = 0.0f;
+    }
+    if (live)
+    {
+        Vector3 velocity = owner->cameraVelocity_;
+        float yawRate = owner->cameraYawRate_;
+        if (now - owner->joystickTime_ <= CAMERA_INPUT_TIMEOUT)
+        {
+            JoystickChannel& joystick = owner->joystick_;
+            joystick.Update(timeStep);
+            velocity += Vector3(joystick.GetAxis(0), -joystick.GetAxis(3), -joystick.GetAxis(1));
+            yawRate += joystick.GetAxis(2);
+        }
+        extrapolatedMove += Quaternion(pitch_, yaw + extrapolatedTurn, 0.0f) * velocity * CAMERA_MOVE_SPEED *
+            timeStep;
+        extrapolatedTurn += yawRate * CAMERA_TURN_SPEED * timeStep;
+    }
+
+    cameraNode_->SetPosition(position + extrapolatedMove);
+    yaw_ = yaw + extrapolatedTurn + myAngle;
+    cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
+
+    // fin du mouvement : la camera reste a la pose du dernier paquet et les pas retrouvent leur lissage
+    if (!live)
+        ReleaseCameraAnchor(anchorStart + 1, false);
+}
+
+void StaticScene::ReleaseCameraAnchor(unsigned time, bool wholeSegment)
+{
+    // la camera reste a la pose du dernier paquet, la meme sur tous les murs, sans l'extrapolation propre a ce mur
+    if (cameraAnchored)
+    {
+        cameraNode_->SetPosition(cameraNode_->GetPosition() - extrapolatedMove);
+        yaw_ -= extrapolatedTurn;
+        cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
+        extrapolatedMove = Vector3::ZERO;
+        extrapolatedTurn = 0.0f;
+    }
+    cameraAnchored = false;
+    anchorTime = time;
+    anchorWholeSegment = wholeSegment;
+}
+
+void StaticScene::RebaseCameraAnchor()
+{
+    // la camera a la racine a ete deplacee avec l'origine (BodySystem::SetOrigin) : sans cela la pose suivante la
+    // ramenerait au-dela de la distance de recentrage, recentree a nouveau a chaque image
+    const DoubleVector3& origin = bodySystem->GetOrigin();
+    if (cameraAnchored && cameraNode_->GetParent() == scene_)
+        anchorPosition += (anchorOrigin - origin).ToVector3();
+    anchorOrigin = origin;
+}
+
+void StaticScene::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+        if (!makeBundleName.Empty())
+            HandleMakeBundle(eventType, eventData);
+
+        // l'image qui a applique les sondes du joystick vient d'etre presentee : le client en deduit le delai entre
+        // l'entree et l'affichage
+        for (unsigned i = 0; i < joystickProbes.Size(); ++i)
+        {
+            const JoystickProbe& probe = joystickProbes[i];
+            VectorBuffer echo;
+            echo.WriteUShort(probe.sequence_);
+            echo.WriteUShort(probe.clientTime_);
+            echo.WriteUInt((unsigned)(probeTimer.GetUSec(false) - probe.receiveTime_));
+            probe.connection_->SendMessage(MSG_JOYSTICK_ECHO, false, false, echo);
+        }
+        joystickProbes.Clear();
+}
+
+void StaticScene::HandleClientConnected(StringHash eventType, VariantMap& eventData)
+{
+        using namespace ClientConnected;
+
+        // observateur au nom de son adresse jusqu'a sa commande hello
+        Connection* connection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
+        controlArbiter.Open(connection, connection->GetAddress());
+        commandLog->Write("Client connected: %s", connection->GetAddress().CString());
+}
 
 void StaticScene::HandleClientDisconnected(StringHash eventType, VariantMap& eventData)
 {
-        printf("Client disconnected\n");
+        using namespace ClientDisconnected;
+
+        commandLog->Write("Client disconnected");
+        Connection* connection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
+        controlArbiter.Close(connection);
+        // la camera n'a plus de proprietaire s'il s'agissait du sien : le suivant repartira de la ou elle est
+        anchorSession = controlArbiter.GetCameraOwner();
+        commandQueue.RemoveConnection(connection);
+        for (unsigned i = cameraClaims.Size(); i-- > 0;)
+        {
+            if (cameraClaims[i].connection_ == connection)
+                cameraClaims.Erase(i);
+        }
 }
 
 void StaticScene::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
@@ -1026,388 +1168,1136 @@ void StaticScene::HandleNetworkMessage(StringHash eventType, VariantMap& eventDa
         int msgID = eventData[P_MESSAGEID].GetInt();
         Connection* remoteSender = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
 
-        std::cout << "HandleNetworkMessage" << std::endl;
+        // canal camera : la derniere vitesse gagne, sans trace a chaque paquet
+        if (msgID == MSG_CAMERA)
+        {
+            ControlSession* session = controlArbiter.GetSession(remoteSender);
+            if (!controlArbiter.Permits(session, COMMAND_CAMERA))
+                return;
+
+            MemoryBuffer msg(eventData[P_DATA].GetBuffer());
+            if (msg.GetSize() < CAMERA_PACKET_SIZE)
+                return;
+            unsigned sequence = msg.ReadUInt();
+            if (session->hasCameraSequence_ && (int)(sequence - session->cameraSequence_) <= 0)
+                return;
+
+            Vector3 velocity = msg.ReadVector3();
+            float yawRate = msg.ReadFloat();
+            unsigned time = msg.ReadUInt();
+            unsigned char flags = msg.ReadUByte();
+            CameraSegment segment;
+            CameraSegment previous;
+            CameraSegment keyframe;
+            if (!segment.Read(msg) || !previous.Read(msg) || !keyframe.Read(msg))
+                return;
+
+            session->hasCameraSequence_ = true;
+            session->cameraSequence_ = sequence;
+            session->cameraVelocity_ = velocity;
+            session->cameraYawRate_ = yawRate;
+            session->cameraTime_ = controlArbiter.GetTime();
+            session->cameraSendTime_ = time;
+            session->cameraSegment_ = segment;
+            session->previousSegment_ = previous;
+            session->keyframe_ = keyframe;
+            // la camera est arbitree avec les commandes, dans l'ordre des heures d'envoi
+            if (velocity != Vector3::ZERO || yawRate != 0.0f || (flags & CAMERA_FLAG_JOYSTICK))
+            {
+                CameraClaim claim;
+                claim.connection_ = remoteSender;
+                claim.time_ = time;
+                cameraClaims.Push(claim);
+            }
+            return;
+        }
+
+        // joystick : les trames perimees ou dont la trame cle s'est perdue sont ignorees. Elles ne demandent pas la
+        // camera, le canal camera le fait avec l'heure de l'envoi
+        if (msgID == MSG_JOYSTICK)
+        {
+            ControlSession* session = controlArbiter.GetSession(remoteSender);
+            if (!controlArbiter.Permits(session, COMMAND_CAMERA))
+                return;
+
+            MemoryBuffer msg(eventData[P_DATA].GetBuffer());
+            if (!session->joystick_.Decode(msg))
+                return;
+            session->joystickTime_ = controlArbiter.GetTime();
 
+            if (session->joystick_.HasProbe())
+            {
+                JoystickProbe probe;
+                probe.connection_ = remoteSender;
+                probe.sequence_ = session->joystick_.GetSequence();
+                probe.clientTime_ = session->joystick_.GetProbeTime();
+                probe.receiveTime_ = probeTimer.GetUSec(false);
+                joystickProbes.Push(probe);
+            }
+            return;
+        }
+
+        // commande texte : mise en file et executee a l'image suivante. Aucune n'est ignoree, meme au-dela du debit
+        // autorise : un mur qui perdrait un pas de camera que les autres gardent resterait decale
         if (msgID == MSG_GAME)
         {
-            
-            const PODVector<unsigned char>& data = eventData[P_DATA].GetBuffer();
-            // Use a MemoryBuffer to read the message data so that there is no unnecessary copying
-            MemoryBuffer msg(data);
+            MemoryBuffer msg(eventData[P_DATA].GetBuffer());
             String text = msg.ReadString();
-            char s[100],com[100];
-            int tx,tz,tnum,torient;
-            strcpy(s,text.CString());
-            printf("Message received:%s\n",s);
-            float timeStep = 0.1;
-            float MOVE_SPEED = 50.0f;
-
-        
-            // Read ZQSD keys and move the camera scene node to the corresponding direction if they are pressed
-            // Use the Translate() function (default local space) to move relative to the node's orientation.
-            if (s[0]=='z') {
-                //cameraNode_->SetParent(scene_);
-                printf("command interpreted : %s , %f\n", s,timeStep);
-                /*cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - myAngle, 0.0f));
-                cameraNode_->Translate(Vector3::FORWARD * MOVE_SPEED * timeStep);
-                cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));*/
-                cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - myAngle, 0.0f));
-                cameraNode_->Translate(Vector3::FORWARD * MOVE_SPEED * timeStep);
-                //cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
-            }
-        
-            else if (s[0]=='q') {
-                //cameraNode_->SetParent(scene_);
-                // cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - myAngle, 0.0f));
-                // cameraNode_->Translate(Vector3::LEFT * MOVE_SPEED * timeStep);
-                // cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
-
-                cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - myAngle, 0.0f));
-                cameraNode_->Translate(Vector3::LEFT * MOVE_SPEED * timeStep);
-                //cameraNode_->SetRotation(Quaternion(pitch_, yaw_ , 0.0f));
-            }
-        
-            else if (s[0]=='s') {
-                //cameraNode_->SetParent(scene_);
-                cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - myAngle, 0.0f));
-                cameraNode_->Translate(Vector3::BACK * MOVE_SPEED * timeStep);
-                //cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
-            }
-        
-            else if (s[0]=='d') {
-                //cameraNode_->SetParent(scene_);
-                cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - myAngle, 0.0f));
-                cameraNode_->Translate(Vector3::RIGHT * MOVE_SPEED * timeStep);
-                //cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
+            unsigned time = ReadSenderTime(msg);
+            commandQueue.Push(remoteSender, text, time);
+        }
+
+        // lot d'objets : dans la meme file que les commandes texte, pour garder leur ordre. Il n'a pas d'heure
+        // d'envoi et prend celle de la derniere commande de son client, qu'il suit
+        else if (msgID == MSG_SCENE_BATCH)
+        {
+            commandQueue.Push(remoteSender, "batch", commandQueue.GetSenderTime(remoteSender),
+                eventData[P_DATA].GetBuffer());
+        }
+
+        // instantane d'un autre mur, relaye par le client : dans la meme file, repris a l'image suivante si le
+        // controleur en a le droit
+        else if (msgID == MSG_SNAPSHOT)
+        {
+            commandQueue.Push(remoteSender, "restore", commandQueue.GetSenderTime(remoteSender),
+                eventData[P_DATA].GetBuffer());
+        }
+}
+
+
+void StaticScene::ExecuteCommand(const String& text, Connection* remoteSender, unsigned time)
+{
+        char s[100];
+        strncpy(s, text.CString(), sizeof(s) - 1);
+        s[sizeof(s) - 1] = 0;
+        commandLog->Write("Message received:%s", s);
+        if (IsSceneCommand(text.CString()))
+        {
+            ExecuteSceneCommand(text.CString());
+            return;
+        }
+        Vector3 stepMove;
+        float stepTurn;
+
+        if (!strncmp(s, "bench ", 6)) {
+            RunBenchmark(s + 6);
+        }
+
+        // snapshot : etat complet de la simulation, renvoye a l'expediteur pour le transmettre a un mur relance
+        else if (!strcmp(s, "snapshot")) {
+            VectorBuffer reply;
+            SaveSnapshot(reply);
+            remoteSender->SendMessage(MSG_SNAPSHOT, true, true, reply);
+        }
+
+        // telemetry : ressources, memoire GPU, noeuds et temps d'image, renvoyes a l'expediteur
+        else if (!strcmp(s, "telemetry")) {
+            VectorBuffer reply;
+            reply.WriteString(telemetry->BuildReport(scene_, resourceHandles) + commandQueue.BuildReport() +
+                controlArbiter.BuildReport() + resourceHandles->BuildReport() +
+                craftPropagator->BuildReport() + bodySystem->BuildReport());
+            remoteSender->SendMessage(MSG_TELEMETRY, true, true, reply);
+        }
+
+        // warp <facteur> : vitesse du temps, negative pour remonter le temps
+        else if (!strncmp(s, "warp ", 5)) {
+            bodySystem->SetTimeScale(atof(s + 5));
+            commandLog->Write("time scale %g", bodySystem->GetTimeScale());
+        }
+
+        // date <AAAA-MM-JJ> : saut direct a une date, la Terre faisant un tour en 360/|RES_T| secondes
+        else if (!strncmp(s, "date ", 5)) {
+            int year, month, day;
+            if (sscanf(s + 5, "%d-%d-%d", &year, &month, &day) == 3) {
+                double years = (DaysFromCivil(year, month, day) - DaysFromCivil(2000, 1, 1)) / 365.25;
+                HiresTimer seekTimer;
+                bodySystem->SetTime(years * 360.0 / fabs(RES_T));
+                rocketLaunch();
+                if (orbitTrails)
+                    orbitTrails->ClearTrails();
+                commandLog->Write("date %04d-%02d-%02d time=%.3f s seek=%lld us", year, month, day,
+                    bodySystem->GetTime(), seekTimer.GetUSec(false));
             }
-        
-            // else if (s[0]=='o') {
-            //     // pitch_ += 30.0f;
-            //     // pitch_ = Clamp(pitch_, -90.0f, 90.0f);
-            //     // printf("command interpreted pitch: %s , %f \n", s,pitch_);
-            //     // cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 90.0f));
+        }
+
+        // deplacement ou rotation d'un pas, pour une commande de plus d'un caractere (les autres sont fusionnees)
+        else if (GetCameraStep(s[0], stepMove, stepTurn)) {
+            ApplyCameraStep(stepMove, stepTurn);
+        }
+
+        else if (s[0]=='f') {
+            FlyToPreset(rocketPosNode, "camera_fusee", Vector3(-0.2f, 0.1f, -1.0f), time);
+        }
 
-            //     pitch_ += 30.0f;
-            //     pitch_ = Clamp(pitch_, -90.0f, 90.0f);
+        else if (s[0]=='n') {
+            labelLayer->SetEnabled(!labelLayer->IsEnabled());
+        }
 
-            // }
+        else if (s[0]=='t') {
+            FlyToPreset(earthPosNode, "camera_fusee", Vector3(-0.3f, 0.1f, -1.0f), time);
+        }
 
-            else if (s[0] == 'o'){
-                cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - myAngle, 0.0f));
-                cameraNode_->Translate(Vector3::UP * MOVE_SPEED * timeStep);
+        else if (s[0]=='S') {
+            FlyToPreset(sunPosNode, "camera_fusee", Vector3(0.0f, 5.1f, -5.0f), time);
+        }
+
+        else if (s[0]=='p')
+        {
+            if(scene_->IsUpdateEnabled())
+                scene_->SetUpdateEnabled( false);
+            else
+                scene_->SetUpdateEnabled(true);
+        }
+
+        else if (s[0] == 'b')
+        {
+            if(sky){
+                sky = false;
+                skyNode->RemoveAllComponents();
+                if (starNode)
+                    starNode->SetEnabled(false);
+            }
+            else if (starNode){
+                sky = true;
+                starNode->SetEnabled(true);
             }
+            else{
+                sky = true;
+                Skybox* skybox = skyNode->CreateComponent<Skybox>();
+                skybox->SetModel(resourceHandles->Get(boxModel));
+                skybox->SetMaterial(resourceHandles->Get(starsSkyMaterial));
+            }
+        }
 
-            else if (s[0] == 'l'){
-                cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - myAngle, 0.0f));
-                cameraNode_->Translate(Vector3::DOWN * MOVE_SPEED * timeStep);
+        else if (s[0]=='y'){
+            SetSunSecret(!secret);
+        }
+        else if (s[0]=='r'){
+            FlyToPreset(rocket_traj_center, "camera_soleil", Vector3(0.0f, 0.0f, -3.0f), time);
+        }
+        else if (s[0]=='j'){
+            FlyToPreset(jupiterPosNode, "camera_soleil", Vector3(0.0f, 0.0f, -3.0f), time);
+        }
+
+        else if (s[0]=='u'){
+            FlyToPreset(uranusPosNode, "camera_soleil", Vector3(0.0f, 0.0f, -3.0f), time);
+        }
+        else if (s[0] == '*')
+        {
+            if(!sky_secret){
+                sky_secret = true;
+                if (starNode)
+                    starNode->SetEnabled(false);
+                skyNode->RemoveAllComponents();
+                Skybox* skybox = skyNode->CreateComponent<Skybox>();
+                skybox->SetModel(resourceHandles->Get(boxModel));
+                skybox->SetMaterial(resourceHandles->Get(secretSkyMaterial));
             }
-        
-            else if (s[0]=='k') {
-                yaw_ -= 30.0f;
-                cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
+            else if (starNode){
+                sky_secret = false;
+                skyNode->RemoveAllComponents();
+                starNode->SetEnabled(sky);
             }
-        
-            // else if (s[0]=='l') {
-            //     pitch_ -= 30.0f;
-            //     pitch_ = Clamp(pitch_, -90.0f, 90.0f);
-            //     cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
-            // }
-        
-            else if (s[0]=='m') {
-                yaw_ += 30.0f;
-                cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
+            else{
+                sky_secret = false;
+                skyNode->RemoveAllComponents();
+                Skybox* skybox = skyNode->CreateComponent<Skybox>();
+                skybox->SetModel(resourceHandles->Get(boxModel));
+                skybox->SetMaterial(resourceHandles->Get(starsSkyMaterial));
             }
+        }
 
-            else if (s[0]=='f') {
-                pitch_ = 0;
-                yaw_   = myAngle;
-                camera_fusee = rocketPosNode->CreateChild("camera_fusee");
-                camera_fusee->SetPosition(Vector3(-0.2f, 0.1f, -1.0f));
-                cameraNode_->SetParent(camera_fusee);
-                cameraNode_->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
+               
+        else if (s[0]=='x')
+        {
+                // quit
+        }
+}
+
+void StaticScene::DrainCommands()
+{
+        commandQueue.TakeAll(drainedCommands);
+
+        // ordre des heures d'envoi, les memes sur tous les murs ; le tri stable garde l'ordre de chaque client. La
+        // camera est arbitree a chaque commande ou paquet camera dans cet ordre, sans dependre de l'image ou ils sont
+        // arrives sur ce mur
+        if (drainedCommands.Size() > 1)
+            std::stable_sort(&drainedCommands[0], &drainedCommands[0] + drainedCommands.Size(),
+                IsSentBefore<InboundCommand, InboundCommand>);
+        if (cameraClaims.Size() > 1)
+            std::stable_sort(&cameraClaims[0], &cameraClaims[0] + cameraClaims.Size(),
+                IsSentBefore<CameraClaim, CameraClaim>);
+
+        // les pas de camera consecutifs sont fusionnes en une seule mise a jour ; un deplacement depend de
+        // l'orientation, la rotation en attente est donc appliquee avant (et inversement)
+        Vector3 move = Vector3::ZERO;
+        float turn = 0.0f;
+        unsigned numUpdates = 0;
+        unsigned numClaims = 0;
+
+        for (unsigned i = 0; i < drainedCommands.Size(); ++i)
+        {
+            // paquets camera envoyes avant la commande
+            for (; numClaims < cameraClaims.Size() && !IsSentBefore(drainedCommands[i], cameraClaims[numClaims]);
+                ++numClaims)
+                ClaimCamera(controlArbiter.GetSession(cameraClaims[numClaims].connection_),
+                    cameraClaims[numClaims].time_);
+
+            const String& text = drainedCommands[i].text_;
+            ControlSession* session = controlArbiter.GetSession(drainedCommands[i].connection_);
+            if (text.StartsWith("hello "))
+            {
+                if (controlArbiter.Hello(drainedCommands[i].connection_, text.Substring(6)))
+                    commandLog->Write("controller %s: role %s, priority %d", session->name_.CString(),
+                        ControlArbiter::GetRoleName(session->role_), session->priority_);
+                else
+                    commandLog->Write("bad hello: %s", text.CString());
+                continue;
             }
 
-            else if (s[0]=='t') {
-                pitch_ = 0;
-                yaw_   = myAngle;
-                camera_fusee = earthPosNode->CreateChild("camera_fusee");
-                camera_fusee->SetPosition(Vector3(-0.3f, 0.1f, -1.0f));
-                cameraNode_->SetParent(camera_fusee);
-                cameraNode_->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
+            // role du controleur, et pour la camera seulement celui qui l'a une fois la commande arbitree
+            CommandClass commandClass = ControlArbiter::Classify(text.CString());
+            if (!controlArbiter.Permits(session, commandClass))
+                continue;
+            if (commandClass == COMMAND_CAMERA)
+            {
+                ClaimCamera(session, drainedCommands[i].time_);
+                if (!controlArbiter.OwnsCamera(session))
+                    continue;
             }
 
-            else if (s[0]=='S') {
-                pitch_ = 0;
-                yaw_   = myAngle;
-                camera_fusee = sunPosNode->CreateChild("camera_fusee");
-                camera_fusee->SetPosition(Vector3(0.0f, 5.1f, -5.0f));
-                cameraNode_->SetParent(camera_fusee);
-                cameraNode_->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
+            Vector3 stepMove;
+            float stepTurn;
+            if (text.Length() == 1 && GetCameraStep(text[0], stepMove, stepTurn))
+            {
+                if ((stepMove != Vector3::ZERO && turn != 0.0f) || (stepTurn != 0.0f && move != Vector3::ZERO))
+                {
+                    numUpdates += ApplyCameraStep(move, turn);
+                    move = Vector3::ZERO;
+                    turn = 0.0f;
+                }
+                move += stepMove;
+                turn += stepTurn;
+                continue;
             }
 
-            else if (s[0]=='p')
+            numUpdates += ApplyCameraStep(move, turn);
+            move = Vector3::ZERO;
+            turn = 0.0f;
+            if (drainedCommands[i].data_.Empty())
+                ExecuteCommand(text, drainedCommands[i].connection_, drainedCommands[i].time_);
+            else if (text == "restore")
             {
-                if(scene_->IsUpdateEnabled())
-                    scene_->SetUpdateEnabled( false);
+                HiresTimer restoreTimer;
+                MemoryBuffer msg(drainedCommands[i].data_);
+                if (LoadSnapshot(msg))
+                    commandLog->Write("snapshot received, restored in %lld us", restoreTimer.GetUSec(false));
                 else
-                    scene_->SetUpdateEnabled(true);
+                    commandLog->Write("snapshot received, rejected");
             }
+            else
+                ExecuteSceneBatch(drainedCommands[i].data_);
+            ++numUpdates;
+        }
+        numUpdates += ApplyCameraStep(move, turn);
+
+        for (; numClaims < cameraClaims.Size(); ++numClaims)
+            ClaimCamera(controlArbiter.GetSession(cameraClaims[numClaims].connection_), cameraClaims[numClaims].time_);
+
+        commandQueue.RecordDrain(drainedCommands.Size(), numUpdates);
+        drainedCommands.Clear();
+        cameraClaims.Clear();
+}
+
+void StaticScene::ClaimCamera(ControlSession* session, unsigned time)
+{
+        controlArbiter.Claim(session, time);
+
+        // nouveau proprietaire : la camera suit son segment en cours a partir de sa derniere entree
+        if (controlArbiter.GetCameraOwner() != anchorSession)
+        {
+            anchorSession = controlArbiter.GetCameraOwner();
+            ReleaseCameraAnchor(controlArbiter.GetOwnerTime(), true);
+        }
+}
+
+bool StaticScene::GetCameraStep(char command, Vector3& move, float& turn) const
+{
+        move = Vector3::ZERO;
+        turn = 0.0f;
+
+        switch (command)
+        {
+        case 'z': move = Vector3::FORWARD * CAMERA_STEP; break;
+        case 's': move = Vector3::BACK * CAMERA_STEP; break;
+        case 'q': move = Vector3::LEFT * CAMERA_STEP; break;
+        case 'd': move = Vector3::RIGHT * CAMERA_STEP; break;
+        case 'o': move = Vector3::UP * CAMERA_STEP; break;
+        case 'l': move = Vector3::DOWN * CAMERA_STEP; break;
+        case 'k': turn = -CAMERA_STEP_ANGLE; break;
+        case 'm': turn = CAMERA_STEP_ANGLE; break;
+        default: return false;
+        }
+        return true;
+}
 
-            else if (s[0] == 'b')
+unsigned StaticScene::ApplyCameraStep(const Vector3& move, float turn)
+{
+        unsigned numUpdates = 0;
+
+        // pendant un mouvement du canal camera, le pas s'ajoute au depart du segment suivi : le resultat ne depend
+        // pas de l'ordre d'arrivee du pas et des paquets
+        if (cameraAnchored)
+        {
+            if (move != Vector3::ZERO)
             {
-                if(sky){
-                    sky = false;
-                    skyNode->RemoveAllComponents();
-                }
-                else{
-                    sky = true;
-                    Skybox* skybox = skyNode->CreateComponent<Skybox>();
-                    skybox->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
-                    skybox->SetMaterial(cache->GetResource<Material>("Materials/skybox_stars.xml"));
-                }
+                anchorPosition += Quaternion(pitch_, yaw_ - myAngle, 0.0f) * move;
+                ++numUpdates;
             }
+            if (turn != 0.0f)
+            {
+                anchorYaw += turn;
+                yaw_ += turn;
+                ++numUpdates;
+            }
+            return numUpdates;
+        }
 
-            else if (s[0]=='y'){
-                if(!secret){
-                    Sun_graphic->RemoveAllComponents();
-                    StaticModel* sunObject = Sun_graphic->CreateComponent<StaticModel>();
-                    sunObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-                    sunObject->SetMaterial(cache->GetResource<Material>("Materials/pecheux.xml"));
-                    secret = true;
-                }
-                else{
-                    Sun_graphic->RemoveAllComponents();
-                    StaticModel* sunObject = Sun_graphic->CreateComponent<StaticModel>();  
-                    sunObject->SetModel(cache->GetResource<Model>("Models/Sphere.mdl"));
-                    sunObject->SetMaterial(cache->GetResource<Material>("Materials/sun.xml"));
-                    secret = false;
+        // deplacement dans la meme direction sur tous les murs, rotation propre a chaque mur ; le pas et la
+        // rotation sont lisses sur les images suivantes par cameraRig
+        if (move != Vector3::ZERO)
+        {
+            cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - myAngle, 0.0f));
+            cameraRig.Step(cameraNode_->GetRotation() * move);
+            ++numUpdates;
+        }
+        if (turn != 0.0f)
+        {
+            yaw_ += turn;
+            cameraRig.Turn(turn);
+            cameraNode_->SetRotation(Quaternion(pitch_, yaw_ - cameraRig.GetPendingYaw(), 0.0f));
+            ++numUpdates;
+        }
+        return numUpdates;
+}
+
+void StaticScene::FlyToPreset(Node* anchor, const char* name, const Vector3& offset, unsigned time)
+{
+        // vol vers le point de vue de l'astre, le meme sur tous les murs puisqu'il suit le temps de la simulation et
+        // part de l'heure de la commande, quelle que soit l'image ou elle arrive sur ce mur
+        ReleaseCameraAnchor(time, false);
+        pitch_ = 0;
+        yaw_   = myAngle;
+        camera_fusee = anchor->CreateChild(name);
+        camera_fusee->SetPosition(offset);
+        float age = Max((int)(Time::GetSystemTime() - time), 0) / 1000.0f;
+        cameraRig.FlyTo(camera_fusee, controlArbiter.GetTime() - age);
+}
+
+void StaticScene::RunBenchmark(const char* name)
+{
+        printf("benchmark %s\n", name);
+
+        if (!strcmp(name, "asteroids"))
+            AsteroidBelt::Benchmark(context_);
+        else if (!strcmp(name, "stars"))
+            StarField::Benchmark(context_);
+        else if (!strcmp(name, "origin"))
+            BodySystem::Benchmark(context_);
+        else if (!strcmp(name, "trails"))
+            OrbitTrails::Benchmark(context_);
+        else if (!strcmp(name, "satellites"))
+            SatelliteField::Benchmark(context_);
+        else if (!strcmp(name, "spatial"))
+            SpatialIndex::Benchmark(context_);
+        else if (!strcmp(name, "labels"))
+            LabelLayer::Benchmark(context_);
+        else if (!strcmp(name, "craft"))
+            CraftPropagator::Benchmark(context_);
+        // un million de commandes ou 10 000 objets bloquent le mur plusieurs secondes : seulement sur un mur sans
+        // fenetre, lance a part (solar_client/harness), jamais sur un mur du spectacle
+        else if ((!strcmp(name, "scene") || !strcmp(name, "batch")) && !headless)
+            printf("benchmark %s: headless walls only\n", name);
+        else if (!strcmp(name, "scene"))
+            BenchmarkSceneCommands();
+        else if (!strcmp(name, "batch"))
+            BenchmarkSceneBatch();
+        else if (!strcmp(name, "sun") && !headless)
+        {
+            // mesure sur les images suivantes du mur, comparee a l'ancien materiau texture
+            if (!sunBenchmark)
+                sunBenchmark = new SunBenchmark(context_);
+            sunBenchmark->Start(Sun_graphic->GetComponent<StaticModel>(), cameraNode_,
+                resourceHandles->GetResource<Material>("Materials/", "sun_texture.xml"));
+        }
+        else
+            printf("unknown benchmark: %s\n", name);
+}
+
+Node* StaticScene::GetCameraAnchor(unsigned index) const
+{
+        switch (index)
+        {
+        case 0: return rocketPosNode;
+        case 1: return earthPosNode;
+        case 2: return sunPosNode;
+        case 3: return rocket_traj_center;
+        case 4: return jupiterPosNode;
+        case 5: return uranusPosNode;
+        default: return 0;
+        }
+}
+
+void StaticScene::SetSunSecret(bool enable)
+{
+        Sun_graphic->RemoveAllComponents();
+        StaticModel* sunObject = Sun_graphic->CreateComponent<StaticModel>();
+        sunObject->SetModel(resourceHandles->Get(sphereModel));
+        sunObject->SetMaterial(enable ? resourceHandles->Get(secretSunMaterial) :
+            resourceHandles->GetResource<Material>(sunMaterial));
+        secret = enable;
+}
+
+void StaticScene::ApplySky()
+{
+        // meme resultat que les commandes 'b' et '*' a partir de sky et sky_secret
+        skyNode->RemoveAllComponents();
+        if (starNode)
+            starNode->SetEnabled(sky && !sky_secret);
+
+        ResourceHandle<Material> material;
+        if (sky_secret)
+            material = secretSkyMaterial;
+        else if (sky && !starNode)
+            material = starsSkyMaterial;
+
+        if (material.IsValid())
+        {
+            Skybox* skybox = skyNode->CreateComponent<Skybox>();
+            skybox->SetModel(resourceHandles->Get(boxModel));
+            skybox->SetMaterial(resourceHandles->Get(material));
+        }
+}
 
+void StaticScene::HandleSceneDescriptionChanged(StringHash eventType, VariantMap& eventData)
+{
+        using namespace SceneDescriptionChanged;
+
+        ApplySceneDescription(static_cast<XMLFile*>(eventData[P_FILE].GetPtr()), false);
+}
+
+void StaticScene::ApplySceneDescription(XMLFile* file, bool startup)
+{
+        HiresTimer applyTimer;
+        XMLElement root = file->GetRoot();
+        unsigned numChanged = 0;
+
+        XMLElement sunElem = root.GetChild("sun");
+        if (sunElem && !sunElem.GetAttribute("material").Empty() && sunElem.GetAttribute("material") != sunMaterial)
+        {
+            sunMaterial = sunElem.GetAttribute("material");
+            if (startup)
+                Sun_graphic->GetComponent<StaticModel>()->SetMaterial(resourceHandles->GetResource<Material>(sunMaterial));
+            else if (!secret)
+                hotReload->SwapMaterial(Sun_graphic->GetComponent<StaticModel>(), sunMaterial);
+            ++numChanged;
+        }
+
+        for (XMLElement bodyElem = root.GetChild("body"); bodyElem; bodyElem = bodyElem.GetNext("body"))
+        {
+            String name = bodyElem.GetAttribute("name");
+            unsigned index = NUM_BODIES;
+            // rang de l'orbite dessinee, dans l'ordre de creation des orbites
+            unsigned orbitIndex = 0;
+            for (unsigned i = 0; i < NUM_BODIES; ++i)
+            {
+                if (bodyDescs[i].name && name == bodyDescs[i].name)
+                {
+                    index = i;
+                    break;
                 }
+                if (bodyDescs[i].model && bodyDescs[i].parent < 0)
+                    ++orbitIndex;
             }
-            else if (s[0]=='r'){
-                pitch_ = 0;
-                yaw_   = myAngle;
-                camera_fusee = rocket_traj_center->CreateChild("camera_soleil");
-                camera_fusee->SetPosition(Vector3(0.0f, 0.0f, -3.0f));
-                cameraNode_->SetParent(camera_fusee);
-                cameraNode_->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
-            }
-            else if (s[0]=='j'){
-                pitch_ = 0;
-                yaw_   = myAngle;
-                camera_fusee = jupiterPosNode->CreateChild("camera_soleil");
-                camera_fusee->SetPosition(Vector3(0.0f, 0.0f, -3.0f));
-                cameraNode_->SetParent(camera_fusee);
-                cameraNode_->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
+            if (index == NUM_BODIES)
+            {
+                URHO3D_LOGERROR("Unknown body " + name + " in the scene description");
+                continue;
             }
 
-            else if (s[0]=='u'){
-                pitch_ = 0;
-                yaw_   = myAngle;
-                camera_fusee = uranusPosNode->CreateChild("camera_soleil");
-                camera_fusee->SetPosition(Vector3(0.0f, 0.0f, -3.0f));
-                cameraNode_->SetParent(camera_fusee);
-                cameraNode_->SetPosition(Vector3(0.0f, 0.0f, 0.0f));
+            const BodyParams& oldParams = bodySystem->GetParams(index);
+            BodyParams params = oldParams;
+            if (trueScale && bodyElem.HasAttribute("trueOrbitRadius"))
+                params.orbitRadius_ = bodyElem.GetFloat("trueOrbitRadius") * TRUE_SCALE_UA;
+            else if (!trueScale && bodyElem.HasAttribute("orbitRadius"))
+                params.orbitRadius_ = bodyElem.GetFloat("orbitRadius");
+            if (bodyElem.HasAttribute("orbitSpeed"))
+                params.orbitSpeed_ = bodyElem.GetFloat("orbitSpeed");
+            if (bodyElem.HasAttribute("tilt"))
+                params.tilt_ = bodyElem.GetFloat("tilt");
+            if (bodyElem.HasAttribute("spinSpeed"))
+                params.spinSpeed_ = bodyElem.GetFloat("spinSpeed");
+            if (bodyElem.HasAttribute("scale"))
+                params.scale_ = bodyElem.GetFloat("scale");
+
+            // seuls les astres modifies sont touches
+            bool changed = false;
+            if (params.orbitRadius_ != oldParams.orbitRadius_ || params.orbitSpeed_ != oldParams.orbitSpeed_ ||
+                params.tilt_ != oldParams.tilt_ || params.spinSpeed_ != oldParams.spinSpeed_ || params.scale_ != oldParams.scale_)
+            {
+                if (!startup && params.orbitRadius_ != oldParams.orbitRadius_ && bodyDescs[index].model &&
+                    bodyDescs[index].parent < 0)
+                    orbitTrails->SetOrbitRadius(orbitIndex, params.orbitRadius_);
+
+                Node* bodyNode = bodySystem->GetBodyNode(index);
+                if (!startup && params.scale_ != oldParams.scale_ && bodyNode)
+                {
+                    spatialIndex->RemoveNode(bodyNode);
+                    spatialIndex->AddNode(bodyNode, params.scale_ * 0.5f);
+                    labelLayer->RemoveLabel(bodyNode);
+                    labelLayer->AddLabel(bodyNode, bodyLabels[index], params.scale_ * 0.5f);
+                }
+
+                bodySystem->SetParams(index, params);
+                changed = true;
             }
-            else if (s[0] == '*')
+
+            StaticModel* bodyObject = bodySystem->GetBodyNode(index) ?
+                bodySystem->GetBodyNode(index)->GetComponent<StaticModel>() : 0;
+            if (bodyObject)
             {
-                if(!sky_secret){
-                    sky_secret = true;
-                    skyNode->RemoveAllComponents();
-                    Skybox* skybox = skyNode->CreateComponent<Skybox>();
-                    skybox->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
-                    skybox->SetMaterial(cache->GetResource<Material>("Materials/pecheux_sky.xml"));
+                String model = bodyElem.GetAttribute("model");
+                if (!model.Empty() && (!bodyObject->GetModel() || bodyObject->GetModel()->GetName() != model))
+                {
+                    if (startup)
+                        bodyObject->SetModel(resourceHandles->GetResource<Model>(model));
+                    else
+                        hotReload->SwapModel(bodyObject, model);
+                    changed = true;
                 }
-                else{
-                    sky_secret = false;
-                    skyNode->RemoveAllComponents();
-                    Skybox* skybox = skyNode->CreateComponent<Skybox>();
-                    skybox->SetModel(cache->GetResource<Model>("Models/Box.mdl"));
-                    skybox->SetMaterial(cache->GetResource<Material>("Materials/skybox_stars.xml"));
+
+                String material = bodyElem.GetAttribute("material");
+                if (!material.Empty() && (!bodyObject->GetMaterial() || bodyObject->GetMaterial()->GetName() != material))
+                {
+                    if (startup)
+                        bodyObject->SetMaterial(resourceHandles->GetResource<Material>(material));
+                    else
+                        hotReload->SwapMaterial(bodyObject, material);
+                    changed = true;
                 }
             }
 
-                   
-            else if (s[0]=='x')
-            {
-                    // quit
-            }  
+            if (changed)
+                ++numChanged;
         }
+
+        if (numChanged && !startup)
+        {
+            bodySystem->UpdateTransforms();
+            rocketLaunch();
+        }
+
+        printf("scene description %s: %u changes applied in %lld us\n", file->GetName().CString(), numChanged,
+            applyTimer.GetUSec(false));
 }
 
+void StaticScene::SaveSnapshot(Serializer& dest)
+{
+        dest.WriteFileID(SNAPSHOT_ID);
+        dest.WriteUInt(SNAPSHOT_VERSION);
+
+        // horloge : la fusee et les astres en sont deduits en forme close
+        dest.WriteDouble(bodySystem->GetTime());
+        dest.WriteDouble(bodySystem->GetTimeScale());
+        dest.WriteBool(scene_->IsUpdateEnabled());
+        const DoubleVector3& origin = bodySystem->GetOrigin();
+        dest.WriteDouble(origin.x_);
+        dest.WriteDouble(origin.y_);
+        dest.WriteDouble(origin.z_);
+
+        // camera : astre suivi, position et orientation relative a l'angle du mur ; pendant un vol, sa destination
+        unsigned anchor = NUM_CAMERA_ANCHORS;
+        Vector3 anchorOffset = Vector3::ZERO;
+        Node* parent = cameraRig.IsFlying() ? cameraRig.GetTarget() : cameraNode_->GetParent();
+        if (parent != scene_ && parent)
+        {
+            for (unsigned i = 0; i < NUM_CAMERA_ANCHORS; ++i)
+            {
+                if (parent->GetParent() == GetCameraAnchor(i))
+                    anchor = i;
+            }
+            anchorOffset = parent->GetPosition();
+        }
+        dest.WriteUByte((unsigned char)anchor);
+        dest.WriteVector3(anchorOffset);
+        dest.WriteVector3(cameraRig.IsFlying() ? Vector3::ZERO : cameraNode_->GetPosition());
+        dest.WriteFloat(pitch_);
+        dest.WriteFloat(yaw_ - myAngle);
+
+        dest.WriteBool(sky);
+        dest.WriteBool(secret);
+        dest.WriteBool(sky_secret);
+        dest.WriteBool(labelLayer->IsEnabled());
+
+        // points et objets crees a la demande
+        dest.WriteVLE(pointMap.size());
+        for (std::map<std::string, Vector3*>::const_iterator i = pointMap.begin(); i != pointMap.end(); ++i)
+        {
+            dest.WriteString(i->first.c_str());
+            dest.WriteVector3(*i->second);
+        }
 
-// ===================================================================
+        dest.WriteVLE(nodeMap.size());
+        for (std::map<std::string, Node*>::const_iterator i = nodeMap.begin(); i != nodeMap.end(); ++i)
+        {
+            Node* oNode = i->second;
+            StaticModel* oObject = oNode->GetComponent<StaticModel>();
+            Model* model = oObject ? oObject->GetModel() : 0;
+            Material* material = oObject ? oObject->GetMaterial() : 0;
+            dest.WriteString(i->first.c_str());
+            dest.WriteVector3(oNode->GetPosition());
+            dest.WriteQuaternion(oNode->GetRotation());
+            dest.WriteVector3(oNode->GetScale());
+            dest.WriteString(model ? model->GetName() : String::EMPTY);
+            dest.WriteString(material ? material->GetName() : String::EMPTY);
+        }
+}
 
-void StaticScene::CreateObject(char *uniqname,
-        Vector3& pos, Vector3& scale, Quaternion& quat,
-        char *model, char *material1, char *material2, int visible)
+bool StaticScene::LoadSnapshot(Deserializer& source)
 {
+        if (source.ReadFileID() != SNAPSHOT_ID || source.ReadUInt() != SNAPSHOT_VERSION)
+        {
+            URHO3D_LOGERROR("Invalid snapshot");
+            return false;
+        }
 
-        Node* oNode = scene_->CreateChild(uniqname);
-        oNode->SetPosition(pos);
-        oNode->SetScale(scale);
-        oNode->SetRotation(quat);
-        StaticModel* oObject = oNode->CreateComponent<StaticModel>();
-        char oModel[100];
-        sprintf(oModel,"Models/%s",model);
-        oObject->SetModel(cache->GetResource<Model>(oModel));
-        char oMaterial1[100];
-        sprintf(oMaterial1,"Materials/%s",material1);
-        Material *mm1=cache->GetResource<Material>(oMaterial1);
-        oObject->SetMaterial(cache->GetResource<Material>(oMaterial1));
-        char oMaterial2[100];
-        sprintf(oMaterial2,"Materials/%s",material2);
-        Material *mm2=cache->GetResource<Material>(oMaterial2);
-
-        oObject->SetMaterial(mm1);
-
-        if (visible==1)
+        // tout est lu et verifie avant d'etre applique : un instantane tronque ou invalide laisse le mur intact
+        double time = source.ReadDouble();
+        double timeScale = source.ReadDouble();
+        bool updateEnabled = source.ReadBool();
+        DoubleVector3 origin;
+        origin.x_ = source.ReadDouble();
+        origin.y_ = source.ReadDouble();
+        origin.z_ = source.ReadDouble();
+
+        unsigned anchor = source.ReadUByte();
+        Vector3 anchorOffset = source.ReadVector3();
+        Vector3 cameraPosition = source.ReadVector3();
+        float pitch = source.ReadFloat();
+        float yaw = source.ReadFloat() + myAngle;
+
+        bool skyEnabled = source.ReadBool();
+        bool sunSecret = source.ReadBool();
+        bool skySecret = source.ReadBool();
+        bool labelsEnabled = source.ReadBool();
+
+        // un point prend au moins 13 octets et un objet 43 : les nombres annonces sont bornes par la taille restante
+        unsigned numPoints = source.ReadVLE();
+        if (anchor > NUM_CAMERA_ANCHORS || numPoints > (source.GetSize() - source.GetPosition()) / 13)
+        {
+            URHO3D_LOGERROR("Invalid snapshot");
+            return false;
+        }
+        Vector<SnapshotPoint> points(numPoints);
+        for (unsigned i = 0; i < numPoints; ++i)
+        {
+            points[i].name_ = source.ReadString();
+            points[i].position_ = source.ReadVector3();
+        }
+
+        unsigned numObjects = source.ReadVLE();
+        if (numObjects > (source.GetSize() - source.GetPosition()) / 43)
+        {
+            URHO3D_LOGERROR("Invalid snapshot");
+            return false;
+        }
+        Vector<SnapshotObject> objects(numObjects);
+        for (unsigned i = 0; i < numObjects; ++i)
         {
-                oObject->SetMaterial(mm1);
-                //oNode->SetEnabled(true);
+            SnapshotObject& object = objects[i];
+            object.name_ = source.ReadString();
+            object.position_ = source.ReadVector3();
+            object.rotation_ = source.ReadQuaternion();
+            object.scale_ = source.ReadVector3();
+            object.model_ = source.ReadString();
+            object.material_ = source.ReadString();
+            // un instantane relaye par un client ne nomme que des modeles et des materiaux
+            if ((!object.model_.Empty() && !ResourceHandles::IsInDirectory(object.model_, "Models/")) ||
+                (!object.material_.Empty() && !ResourceHandles::IsInDirectory(object.material_, "Materials/")))
+            {
+                URHO3D_LOGERROR("Invalid snapshot");
+                return false;
+            }
+        }
+
+        // l'instantane se termine par le nom de materiau du dernier objet ou par le nombre d'objets nul : les deux
+        // finissent par un octet nul, absent d'un instantane tronque
+        if (!source.IsEof() || !source.GetSize() || !source.Seek(source.GetSize() - 1) || source.ReadUByte())
+        {
+            URHO3D_LOGERROR("Truncated snapshot");
+            return false;
+        }
+
+        bodySystem->SetTime(time);
+        bodySystem->SetTimeScale(timeScale);
+        scene_->SetUpdateEnabled(updateEnabled);
+        // deplace aussi les noeuds racine, dont la camera et les objets, qui sont replaces ensuite
+        bodySystem->SetOrigin(origin);
+
+        ReleaseCameraAnchor(Time::GetSystemTime(), false);
+        pitch_ = pitch;
+        yaw_ = yaw;
+        cameraRig.Stop();
+        Node* anchorNode = GetCameraAnchor(anchor);
+        if (anchorNode)
+        {
+            camera_fusee = anchorNode->CreateChild("camera_fusee");
+            camera_fusee->SetPosition(anchorOffset);
+            cameraNode_->SetParent(camera_fusee);
         }
         else
+            cameraNode_->SetParent(scene_);
+        cameraNode_->SetPosition(cameraPosition);
+        cameraNode_->SetRotation(Quaternion(pitch_, yaw_, 0.0f));
+
+        sky = skyEnabled;
+        sky_secret = skySecret;
+        labelLayer->SetEnabled(labelsEnabled);
+        if (sunSecret != secret)
+            SetSunSecret(sunSecret);
+        ApplySky();
+
+        for (unsigned i = 0; i < points.Size(); ++i)
+        {
+            std::string name = points[i].name_.CString();
+            std::map<std::string, Vector3*>::iterator point = pointMap.find(name);
+            if (point != pointMap.end())
+                *point->second = points[i].position_;
+            else
+                pointMap.insert(std::make_pair(name, new Vector3(points[i].position_)));
+        }
+
+        for (unsigned i = 0; i < objects.Size(); ++i)
         {
-                oObject->SetMaterial(mm2);
-                //oNode->SetEnabled(false);
+            const SnapshotObject& object = objects[i];
+            std::string name = object.name_.CString();
+            Node* oNode;
+            std::map<std::string, Node*>::iterator found = nodeMap.find(name);
+            if (found != nodeMap.end())
+                oNode = found->second;
+            else
+            {
+                oNode = scene_->CreateChild(name.c_str());
+                nodeMap.insert(std::make_pair(name, oNode));
+            }
+            oNode->SetPosition(object.position_);
+            oNode->SetRotation(object.rotation_);
+            oNode->SetScale(object.scale_);
+
+            StaticModel* oObject = oNode->GetOrCreateComponent<StaticModel>();
+            if (!object.model_.Empty())
+                oObject->SetModel(resourceHandles->GetResource<Model>(object.model_));
+            if (!object.material_.Empty())
+                oObject->SetMaterial(resourceHandles->GetResource<Material>(object.material_));
         }
 
-        nodeMap.insert(std::make_pair(uniqname,oNode));
+        // fusee et traines suivent le nouveau temps
+        rocketLaunch();
+        if (orbitTrails)
+            orbitTrails->ClearTrails();
+
+        return true;
 }
 
-void StaticScene::CreateObjectAtPoint(char *uniqname, char *pointname,
-        Vector3& scale, Quaternion& quat,
-        char *model, char *material1, char *material2, int visible)
+
+// ===================================================================
+
+Vector3 StaticScene::ToNodePosition(const Vector3& position) const
 {
-        Node* oNode = scene_->CreateChild(uniqname);
-    Vector3 *n=pointMap[pointname];
-        oNode->SetPosition(*n);
-        oNode->SetScale(scale);
-        oNode->SetRotation(quat);
-        StaticModel* oObject = oNode->CreateComponent<StaticModel>();
-        char oModel[100];
-        sprintf(oModel,"Models/%s",model);
-        oObject->SetModel(cache->GetResource<Model>(oModel));
-        char oMaterial1[100];
-        sprintf(oMaterial1,"Materials/%s",material1);
-        Material *mm1=cache->GetResource<Material>(oMaterial1);
-        oObject->SetMaterial(cache->GetResource<Material>(oMaterial1));
-        char oMaterial2[100];
-        sprintf(oMaterial2,"Materials/%s",material2);
-        Material *mm2=cache->GetResource<Material>(oMaterial2);
-
-        oObject->SetMaterial(mm1);
-
-        if (visible==1)
-        {
-                oObject->SetMaterial(mm1);
-        }
+        // les noeuds racine sont relatifs a l'origine flottante, les positions des clients au soleil
+        return (DoubleVector3(position) - bodySystem->GetOrigin()).ToVector3();
+}
+
+void StaticScene::CreateObject(const char* uniqname, const Vector3& pos, const Vector3& scale, const Quaternion& quat,
+        const char* model, const char* material1, const char* material2, bool visible)
+{
+        // un objet du meme nom est repris, comme au chargement d'un instantane
+        Node* oNode;
+        std::map<std::string, Node*>::iterator object = nodeMap.find(uniqname);
+        if (object != nodeMap.end())
+            oNode = object->second;
         else
         {
-                oObject->SetMaterial(mm2);
+            oNode = scene_->CreateChild(uniqname);
+            nodeMap.insert(std::make_pair(uniqname, oNode));
         }
+        oNode->SetPosition(ToNodePosition(pos));
+        oNode->SetScale(scale);
+        oNode->SetRotation(quat);
 
-        nodeMap.insert(std::make_pair(uniqname,oNode));
+        StaticModel* oObject = oNode->GetOrCreateComponent<StaticModel>();
+        oObject->SetModel(resourceHandles->GetResource<Model>("Models/", model));
+        oObject->SetMaterial(resourceHandles->GetResource<Material>("Materials/", visible ? material1 : material2));
 }
 
-void StaticScene::CreateObjectFromString(char *command)
+bool StaticScene::CreateObjectAtPoint(const char* uniqname, const char* pointname, const Vector3& scale,
+        const Quaternion& quat, const char* model, const char* material1, const char* material2, bool visible)
 {
-        float posx, posy, posz;
-        float scalex, scaley, scalez;
-        float quatx, quaty, quatz;
-        char uniqname[100];
-        char model[100];
-        char material1[100];
-        char material2[100];
-        int vis;
-
-        sscanf(command+3,"%s %f %f %f %f %f %f %f %f %f %s %s %s %d",
-                uniqname, &posx, &posy, &posz, &scalex, &scaley, &scalez,
-                &quatx, &quaty, &quatz, model, material1, material2, &vis);
-
-        printf("CreateObjectFromString %s %f %f %f %f %f %f %f %f %f %s %s %s %d\n",
-                uniqname, posx, posy, posz, scalex, scaley, scalez,
-                quatx, quaty, quatz, model, material1, material2, vis);
-
-        Vector3 pos(posx,posy,posz);
-        Vector3 scale(scalex,scaley,scalez);
-        Quaternion quat(quatx,quaty,quatz);
-
-        CreateObject(uniqname,pos,scale,quat,model,material1,material2,vis);
+        std::map<std::string, Vector3*>::const_iterator point = pointMap.find(pointname);
+        if (point == pointMap.end())
+            return false;
+
+        CreateObject(uniqname, *point->second, scale, quat, model, material1, material2, visible);
+        return true;
 }
 
-void StaticScene::CreateObjectAtPointFromString(char *command)
+Vector3* StaticScene::CreatePoint(const char* uniqname, const Vector3& pos)
 {
-        float scalex, scaley, scalez;
-        float quatx, quaty, quatz;
-        char uniqname[100];
-        char pointname[100];
-        char model[100];
-        char material1[100];
-        char material2[100];
-        int vis;
-
-        sscanf(command+3,"%s %s %f %f %f %f %f %f %s %s %s %d",
-                uniqname, pointname, &scalex, &scaley, &scalez,
-                &quatx, &quaty, &quatz, model, material1, material2, &vis);
-
-        printf("CreateObjectAtPointFromString %s %s %f %f %f %f %f %f %s %s %s %d\n",
-                uniqname, pointname, scalex, scaley, scalez,
-                quatx, quaty, quatz, model, material1, material2, vis);
-
-        Vector3 scale(scalex,scaley,scalez);
-        Quaternion quat(quatx,quaty,quatz);
-
-        CreateObjectAtPoint(uniqname,pointname,scale,quat,model,material1,material2,vis);
+        std::map<std::string, Vector3*>::iterator point = pointMap.find(uniqname);
+        if (point != pointMap.end())
+        {
+            *point->second = pos;
+            return point->second;
+        }
+
+        Vector3* newPoint = new Vector3(pos);
+        pointMap.insert(std::make_pair(uniqname, newPoint));
+        return newPoint;
 }
 
-Vector3* StaticScene::CreatePoint(char *uniqname, Vector3 *pos)
+bool StaticScene::moveObjectToPoint(const char* uniqname, const char* pointname)
 {
-        pointMap.insert(std::make_pair(uniqname,pos));
-    return pos;
+        std::map<std::string, Node*>::const_iterator object = nodeMap.find(uniqname);
+        std::map<std::string, Vector3*>::const_iterator point = pointMap.find(pointname);
+        if (object == nodeMap.end() || point == pointMap.end())
+            return false;
+
+        object->second->SetPosition(ToNodePosition(*point->second));
+        return true;
 }
 
-Vector3* StaticScene::CreatePointFromString(char *command)
+bool StaticScene::ExecuteSceneCommand(const char* command)
 {
-        float posx, posy, posz;
-        float scalex, scaley, scalez;
-        float quatx, quaty, quatz;
-        char uniqname[100];
-        char model[100];
-        char material1[100];
-        char material2[100];
-        int vis;
+        // mots bornes et nombres verifies par ParseSceneCommand : une commande mal formee est ignoree en entier
+        SceneCommand parsed;
+        if (!ParseSceneCommand(command, parsed))
+        {
+            commandLog->Write("bad scene command: %s", command);
+            return false;
+        }
 
-        sscanf(command+3,"%s %f %f %f",
-                uniqname, &posx, &posy, &posz);
+        bool applied = true;
+        switch (parsed.type_)
+        {
+        case SCENE_CREATE_OBJECT:
+            CreateObject(parsed.name_, Vector3(parsed.position_), Vector3(parsed.scale_),
+                Quaternion(parsed.rotation_[0], parsed.rotation_[1], parsed.rotation_[2]), parsed.model_,
+                parsed.material_, parsed.hiddenMaterial_, parsed.visible_);
+            break;
+
+        case SCENE_CREATE_OBJECT_AT_POINT:
+            applied = CreateObjectAtPoint(parsed.name_, parsed.point_, Vector3(parsed.scale_),
+                Quaternion(parsed.rotation_[0], parsed.rotation_[1], parsed.rotation_[2]), parsed.model_,
+                parsed.material_, parsed.hiddenMaterial_, parsed.visible_);
+            break;
+
+        case SCENE_CREATE_POINT:
+            CreatePoint(parsed.name_, Vector3(parsed.position_));
+            break;
+
+        case SCENE_MOVE_OBJECT:
+            applied = moveObjectToPoint(parsed.name_, parsed.point_);
+            break;
+        }
 
-        printf("CreatePointFromString %s %f %f %f\n",
-                uniqname, posx, posy, posz);
+        if (!applied)
+            commandLog->Write("unknown object or point: %s", command);
+        return applied;
+}
 
-        Vector3 *pos=new Vector3(posx,posy,posz);
+void StaticScene::BenchmarkSceneCommands()
+{
+        // 64 objets et 256 points ; surtout des deplacements, quelques points deplaces et objets recrees
+        const unsigned numObjects = 64;
+        const unsigned numPoints = 256;
+        const unsigned numCommands = 1000000;
+
+        Vector<String> commands;
+        char command[256];
+        for (unsigned i = 0; i < numPoints; ++i)
+        {
+            sprintf(command, "CP bench_p%u %.3f %.3f %.3f", i, Random(-100.0f, 100.0f), Random(-10.0f, 10.0f),
+                Random(-100.0f, 100.0f));
+            commands.Push(command);
+        }
+        for (unsigned i = 0; i < numObjects; ++i)
+        {
+            sprintf(command, "CO bench_o%u %.3f 0 %.3f 1 1 1 0 %.1f 0 Sphere.mdl earthmap.xml earthmap.xml 1", i,
+                Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(360.0f));
+            commands.Push(command);
+        }
+        for (unsigned i = 0; i < 4096; ++i)
+        {
+            unsigned kind = Rand() % 256;
+            if (kind == 0)
+                sprintf(command, "CA bench_o%u bench_p%u 2 2 2 0 0 0 Sphere.mdl earthmap.xml earthmap.xml 0",
+                    Rand() % numObjects, Rand() % numPoints);
+            else if (kind < 32)
+                sprintf(command, "CP bench_p%u %.3f %.3f %.3f", Rand() % numPoints, Random(-100.0f, 100.0f),
+                    Random(-10.0f, 10.0f), Random(-100.0f, 100.0f));
+            else
+                sprintf(command, "MO bench_o%u bench_p%u", Rand() % numObjects, Rand() % numPoints);
+            commands.Push(command);
+        }
 
-        return CreatePoint(uniqname,pos);
+        // analyse seule, puis chemin complet des commandes recues : journal, analyse et application a une scene privee
+        EnterBenchmarkScene();
+        HiresTimer timer;
+        SceneCommand parsed;
+        unsigned numParsed = 0;
+        for (unsigned i = 0; i < numCommands; ++i)
+            numParsed += ParseSceneCommand(commands[i % commands.Size()].CString(), parsed) ? 1 : 0;
+        long long parseTime = timer.GetUSec(true);
+
+        for (unsigned i = 0; i < numCommands; ++i)
+            ExecuteCommand(commands[i % commands.Size()], 0, Time::GetSystemTime());
+        long long executeTime = timer.GetUSec(true);
+        LeaveBenchmarkScene();
+
+        printf("scene commands: %u parsed in %.1f ms, %.2f M/s (%.0f ns each)\n", numParsed, parseTime / 1000.0f,
+            numCommands / (float)Max(parseTime, 1LL), parseTime * 1000.0f / numCommands);
+        printf("scene commands: %u executed in %.1f ms, %.2f M/s (%.0f ns each)\n", numCommands,
+            executeTime / 1000.0f, numCommands / (float)Max(executeTime, 1LL), executeTime * 1000.0f / numCommands);
 }
 
-void StaticScene::moveObjectToPointFromString(char *command)
+bool StaticScene::ExecuteSceneBatch(const PODVector<unsigned char>& data)
 {
-        char uniqname[100];
-        char pointname[100];
+        MemoryBuffer source(data);
+        if (!sceneBatch.Read(source))
+        {
+            commandLog->Write("bad scene batch of %u bytes", data.Size());
+            return false;
+        }
 
-        sscanf(command+3,"%s %s",
-                uniqname, pointname);
+        // modeles et materiaux resolus une fois pour tout le lot
+        const Vector<String>& modelNames = sceneBatch.GetModels();
+        const Vector<String>& materialNames = sceneBatch.GetMaterials();
+        batchModels.Resize(modelNames.Size());
+        for (unsigned i = 0; i < modelNames.Size(); ++i)
+            batchModels[i] = resourceHandles->GetResource<Model>("Models/", modelNames[i].CString());
+        batchMaterials.Resize(materialNames.Size());
+        for (unsigned i = 0; i < materialNames.Size(); ++i)
+            batchMaterials[i] = resourceHandles->GetResource<Material>("Materials/", materialNames[i].CString());
+
+        // un objet existant est mis a jour sur place, un nouveau recoit son noeud et son modele en une fois
+        const PODVector<SceneBatchObject>& objects = sceneBatch.GetObjects();
+        String name;
+        for (unsigned i = 0; i < objects.Size(); ++i)
+        {
+            const SceneBatchObject& object = objects[i];
+            name = sceneBatch.GetPrefix();
+            name += String(object.id_);
+
+            std::pair<std::map<std::string, Node*>::iterator, bool> slot =
+                nodeMap.insert(std::make_pair(std::string(name.CString()), (Node*)0));
+            if (slot.second)
+                slot.first->second = scene_->CreateChild(name);
+            Node* oNode = slot.first->second;
+            oNode->SetTransform(ToNodePosition(object.position_), object.rotation_, object.scale_);
+
+            StaticModel* oObject = oNode->GetOrCreateComponent<StaticModel>();
+            oObject->SetModel(batchModels[object.model_]);
+            oObject->SetMaterial(batchMaterials[object.material_]);
+        }
 
-        printf("moveObjectToPointFromString %s %s\n",
-                uniqname, pointname);
+        commandLog->Write("scene batch %s: %u objects", sceneBatch.GetPrefix().CString(), objects.Size());
+        return true;
+}
 
-    moveObjectToPoint(uniqname, pointname);
+void StaticScene::BenchmarkSceneBatch()
+{
+        // memes objets en commandes « CO » une par une, puis en lots de 1000 ; deux passes : creation puis mise a jour
+        const unsigned numObjects = 10000;
+        const unsigned batchSize = 1000;
+
+        Vector<String> commands;
+        Vector<VectorBuffer> batches;
+        SceneBatch batch;
+        char command[256];
+        for (unsigned i = 0; i < numObjects; ++i)
+        {
+            Vector3 position(Random(-100.0f, 100.0f), Random(-10.0f, 10.0f), Random(-100.0f, 100.0f));
+            float yaw = Random(360.0f);
+            sprintf(command, "CO bench_s%u %.3f %.3f %.3f 1 1 1 0 %.1f 0 Sphere.mdl earthmap.xml earthmap.xml 1", i,
+                position.x_, position.y_, position.z_, yaw);
+            commands.Push(command);
+
+            if (i % batchSize == 0)
+            {
+                batch.Clear();
+                batch.SetPrefix("bench_b");
+            }
+            SceneBatchObject object;
+            object.id_ = i;
+            object.position_ = position;
+            object.rotation_ = Quaternion(0.0f, yaw, 0.0f);
+            object.scale_ = Vector3::ONE;
+            object.model_ = batch.AddModel("Sphere.mdl");
+            object.material_ = batch.AddMaterial("earthmap.xml");
+            batch.AddObject(object);
+            if (i % batchSize == batchSize - 1 || i == numObjects - 1)
+            {
+                batches.Resize(batches.Size() + 1);
+                batch.Write(batches.Back());
+            }
+        }
+
+        unsigned commandBytes = 0;
+        for (unsigned i = 0; i < commands.Size(); ++i)
+            commandBytes += commands[i].Length() + 1;
+        unsigned batchBytes = 0;
+        for (unsigned i = 0; i < batches.Size(); ++i)
+            batchBytes += batches[i].GetSize();
+
+        static const char* passes[] = { "create", "update" };
+        EnterBenchmarkScene();
+        for (unsigned pass = 0; pass < 2; ++pass)
+        {
+            HiresTimer timer;
+            for (unsigned i = 0; i < commands.Size(); ++i)
+                ExecuteCommand(commands[i], 0, Time::GetSystemTime());
+            long long singleTime = timer.GetUSec(true);
+            for (unsigned i = 0; i < batches.Size(); ++i)
+                ExecuteSceneBatch(batches[i].GetBuffer());
+            long long batchTime = timer.GetUSec(true);
+
+            printf("scene batch %s: %u objects, single commands %.1f ms (%.0f objects/s, %u bytes), batches of %u "
+                "%.1f ms (%.0f objects/s, %u bytes), %.1fx\n", passes[pass], numObjects, singleTime / 1000.0f,
+                numObjects * 1e6f / Max(singleTime, 1LL), commandBytes, batchSize, batchTime / 1000.0f,
+                numObjects * 1e6f / Max(batchTime, 1LL), batchBytes, (float)singleTime / Max(batchTime, 1LL));
+        }
+        LeaveBenchmarkScene();
 }
 
-void StaticScene::moveObjectToPoint(char *uniqname, char *pointname)
+void StaticScene::EnterBenchmarkScene()
 {
-    std::cout << "moveObjectToPoint " << uniqname << "," << pointname << std::endl;
+        // scene et tables vides : le banc ne voit ni ne touche les objets du mur, et tout ce qu'il cree disparait
+        // avec elles, quel qu'en soit le nom
+        savedScene = scene_;
+        savedNodeMap.swap(nodeMap);
+        savedPointMap.swap(pointMap);
+        scene_ = new Scene(context_);
+        scene_->CreateComponent<Octree>();
+}
 
-        Node* oNode = nodeMap[uniqname];
-    Vector3 *n=pointMap[pointname];
-        oNode->SetPosition(*n);
+void StaticScene::LeaveBenchmarkScene()
+{
+        for (std::map<std::string, Vector3*>::iterator i = pointMap.begin(); i != pointMap.end(); ++i)
+            delete i->second;
+        pointMap.clear();
+        nodeMap.clear();
+        scene_ = savedScene;
+        savedScene.Reset();
+        nodeMap.swap(savedNodeMap);
+        pointMap.swap(savedPointMap);
 }
@@ -22,9 +22,16 @@
 
 #pragma once
 
+#include <Urho3D/Core/Timer.h>
+
+#include "CameraRig.h"
+#include "CommandQueue.h"
+#include "SceneBatch.h"
+#include "ControlArbiter.h"
+#include "DoubleVector3.h"
+#include "ResourceHandles.h"
 #include "Sample.h"
 
-#include <iostream>
 #include <list>
 #include <vector>
 #include <map>
@@ -34,18 +41,57 @@
 namespace Urho3D
 {
 
+class Connection;
+class Deserializer;
+class Material;
+class Model;
 class Node;
 class Scene;
+class Serializer;
+class XMLFile;
 
 }
 
-struct _directions
+/// Orbiting bodies managed by BodySystem. Parents precede their children.
+enum BodyId
+{
+    BODY_EARTH = 0,
+    BODY_MOON,
+    BODY_MERCURE,
+    BODY_VENUS,
+    BODY_MARS,
+    BODY_JUPITER,
+    BODY_SATURNE,
+    BODY_URANUS,
+    BODY_NEPTUNE,
+    BODY_ROCKET_TRAJ_CENTER,
+    NUM_BODIES
+};
+
+class BodySystem;
+class OrbitTrails;
+class ResourceBundle;
+class SpatialIndex;
+class CraftPropagator;
+class LabelLayer;
+class Telemetry;
+class SceneSnapshot;
+class HotReload;
+class SunBenchmark;
+class AsyncLog;
+
+/// Joystick latency probe waiting for the end of the frame that applied it.
+struct JoystickProbe
 {
-	char *n; int nt;
-	char *e; int et;
-	char *s; int st;
-	char *w; int wt;
-} ;
+    /// Controller to answer.
+    SharedPtr<Connection> connection_;
+    /// Sequence number of the probe frame.
+    unsigned short sequence_;
+    /// Client time of the probe.
+    unsigned short clientTime_;
+    /// Reception time on probeTimer, in microseconds.
+    long long receiveTime_;
+};
 
 /// Static 3D scene example.
 /// This sample demonstrates:
@@ -60,6 +106,8 @@ public:
     /// Construct.
     StaticScene(Context* context);
 
+    /// Setup before engine initialization. Mounts the resource bundle given on the command line.
+    virtual void Setup();
     /// Setup after engine initialization and before running the main loop.
     virtual void Start();
 
@@ -70,66 +118,135 @@ private:
     void CreateInstructions();
     /// Set up a viewport for displaying the scene.
     void SetupViewport();
-    /// Read input and moves the camera.
-    float Dist( Vector3 a, Vector3 b);
-
+    /// Place the rocket on its way to Mars at the current simulation time.
     void rocketLaunch();
-    /// manage eocket to mars
+    /// Read input and moves the camera.
     void MoveCamera(float timeStep);
     /// Subscribe to application-wide logic update events.
     void SubscribeToEvents();
     /// Handle the logic update event.
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
-    /// Manage joystick.
-    void ManageJoystick(float timeStep);
+    /// Place the camera from the motion segment of the camera owner, extrapolated with its velocity until the next
+    /// camera packet.
+    void ApplyCameraVelocity(float timeStep);
+    /// Stop following the motion of the camera owner until its first segment that starts at the given shared time or
+    /// after, or with wholeSegment its first segment sent at that time or after, starting from where the camera is.
+    void ReleaseCameraAnchor(unsigned time, bool wholeSegment);
+    /// Move the camera anchor with the floating origin, which shifts the camera like the other root nodes.
+    void RebaseCameraAnchor();
+    /// Arbitrate camera input of a session stamped with the shared time in ms, restarting the camera from where it is
+    /// if it changed owner.
+    void ClaimCamera(ControlSession* session, unsigned time);
 
         void HandleNetworkMessage(StringHash eventType, VariantMap& eventData);
         void HandleClientConnected(StringHash eventType, VariantMap& eventData);
+        /// Answer the joystick probes applied by the frame just presented.
+        void HandleEndFrame(StringHash eventType, VariantMap& eventData);
         void HandleClientDisconnected(StringHash eventType, VariantMap& eventData);
+        /// Run the commands queued since the last frame in the order of their stamps, arbitrating the camera at each
+        /// camera command or camera packet and merging consecutive camera steps.
+        void DrainCommands();
+        /// Run a text command of a client, stamped with the shared time in ms.
+        void ExecuteCommand(const String& text, Connection* remoteSender, unsigned time);
+        /// Return the move and turn of a camera step command. Return false if the command is not a camera step.
+        bool GetCameraStep(char command, Vector3& move, float& turn) const;
+        /// Move then turn the camera by merged steps, eased in by the camera rig. Return the number of transform updates.
+        unsigned ApplyCameraStep(const Vector3& move, float turn);
+        /// Fly the camera to a preset point of view at an offset from a body, from the shared time of the command.
+        void FlyToPreset(Node* anchor, const char* name, const Vector3& offset, unsigned time);
+        /// Run a named benchmark requested over the network and print its report.
+        void RunBenchmark(const char* name);
+    /// Return the node the camera follows for an anchor index of the snapshot, or null for the free camera.
+    Node* GetCameraAnchor(unsigned index) const;
+    /// Show the secret sun material instead of the sun.
+    void SetSunSecret(bool enable);
+    /// Rebuild the skybox and star field from the sky and sky_secret toggles.
+    void ApplySky();
+    /// Apply the tunable body parameters, models and materials of the scene description, touching only what changed.
+    void ApplySceneDescription(XMLFile* file, bool startup);
+    /// Handle the scene description reloaded after a change on disk.
+    void HandleSceneDescriptionChanged(StringHash eventType, VariantMap& eventData);
+    /// Write the simulation state: time, camera, toggles and objects created on demand.
+    void SaveSnapshot(Serializer& dest);
+    /// Restore the simulation state written by SaveSnapshot. Return true on success.
+    bool LoadSnapshot(Deserializer& source);
+    /// Write the resource bundle once the first frames have rendered, then exit.
+    void HandleMakeBundle(StringHash eventType, VariantMap& eventData);
 
 
-    void CreateObject(char* uniqname, Vector3& pos, Vector3& scale, Quaternion& quat, char *model, char *material1,char *material2, int visible);
-    void CreateObjectAtPoint(char *uniqname, char *pointname, Vector3& scale, Quaternion& quat, char *model, char *material1, char *material2, int visible);
-
-    void CreateObjectFromString(char *str);
-    Vector3 *CreatePoint(char* uniqname, Vector3 *pos);
-    Vector3 *CreatePointFromString(char *str);
-    void CreateObjectAtPointFromString(char *command);
-    void moveObjectToPointFromString(char *command);
-    void moveObjectToPoint(char *uniqname, char *pointname);
+    /// Return the root node position of a position of the client, in simulation coordinates around the sun.
+    Vector3 ToNodePosition(const Vector3& position) const;
+    /// Create an object, or move and restyle the object of the same name.
+    void CreateObject(const char* uniqname, const Vector3& pos, const Vector3& scale, const Quaternion& quat,
+        const char* model, const char* material1, const char* material2, bool visible);
+    /// Create an object at a point. Return false if the point does not exist.
+    bool CreateObjectAtPoint(const char* uniqname, const char* pointname, const Vector3& scale, const Quaternion& quat,
+        const char* model, const char* material1, const char* material2, bool visible);
+    /// Create a point, or move the point of the same name. Points stay in simulation coordinates.
+    Vector3* CreatePoint(const char* uniqname, const Vector3& pos);
+    /// Move an object to a point. Return false if either does not exist.
+    bool moveObjectToPoint(const char* uniqname, const char* pointname);
+    /// Parse and apply a scene edit command (see SceneCommands.h). Return false if it is malformed or names an unknown
+    /// object or point.
+    bool ExecuteSceneCommand(const char* command);
+    /// Measure the scene edit commands per second, parsed alone and through ExecuteCommand in a private scene, from
+    /// "bench scene" on a headless wall.
+    void BenchmarkSceneCommands();
+    /// Create or update the objects of a scene batch message. Return false if the batch is malformed.
+    bool ExecuteSceneBatch(const PODVector<unsigned char>& data);
+    /// Measure the objects per second created and updated by single "CO" commands and by scene batches in a private
+    /// scene, from "bench batch" on a headless wall.
+    void BenchmarkSceneBatch();
+    /// Swap an empty private scene, object and point tables in for a benchmark of the scene edits.
+    void EnterBenchmarkScene();
+    /// Destroy the private scene and everything the benchmark created in it, and swap the scene of the wall back.
+    void LeaveBenchmarkScene();
 
     ResourceCache *cache;
     std::map<std::string, Node*> nodeMap;
     std::map<std::string, Vector3*> pointMap;
+    /// Scene, objects and points of the wall, set aside during a benchmark of the scene edits.
+    SharedPtr<Scene> savedScene;
+    std::map<std::string, Node*> savedNodeMap;
+    std::map<std::string, Vector3*> savedPointMap;
 
     Input* input;
-    int nbJoysticks;
-    JoystickState* js;
-    int xpos, ypos;
-    Node *posNode;
-    struct _directions possibleDirections[30];
-    int cursorLocation;
 
     Node * skyNode;
+    Node * starNode;
+
+    BodySystem* bodySystem;
+    OrbitTrails* orbitTrails;
+    SpatialIndex* spatialIndex;
+    LabelLayer* labelLayer;
+    /// Spacecraft dynamics of the rocket.
+    CraftPropagator* craftPropagator;
 
     Node * Sun_graphic;
     Node *earthPosNode;
     Node *sunPosNode;
-    Node *sunPosRotNode;
     Node * marsPosNode;
     Node * jupiterPosNode;
     Node * uranusPosNode;
     Node * rocket_traj_center;
     Node* rocketNode;
-    Node * rocket_orbit;
     Node * rocketPosNode;
     Node* rocketInclinedNode;
+    /// Craft of the rocket in craftPropagator.
+    unsigned rocketCraft;
+    /// Launch time of the last departure found, -infinity before the first.
+    double rocketLaunchTime;
+    /// Periapsis state of the last departure, relative to the Earth.
+    DoubleVector3 rocketDeparturePosition;
+    DoubleVector3 rocketDepartureVelocity;
 
-    bool autorised;
     bool sky;
     bool secret;
     bool sky_secret;
-    int tkt;
+    /// Real orbit radii instead of the compressed ones.
+    bool trueScale;
+    /// No window nor rendering, from -headless. No snapshot is read or written.
+    bool headless;
 
     Node * cameraNode_;
     Node * camera_fusee;
@@ -139,4 +256,78 @@ private:
 
 	int myPort;
 	int myAngle;
+
+    /// Bundle the resources are loaded from, null when running from the loose directories.
+    SharedPtr<ResourceBundle> bundle;
+    /// Bundle to load, from -bundle.
+    String bundleName;
+    /// Bundle to write, from -makebundle.
+    String makeBundleName;
+    /// Frames rendered before writing the bundle.
+    unsigned bundleFrames;
+    /// Time since construction, for the cold start report.
+    HiresTimer startupTimer;
+    /// Frame times and memory use, reported to the client on request.
+    SharedPtr<Telemetry> telemetry;
+    /// Periodic snapshot of the simulation state, restored when the wall restarts.
+    SharedPtr<SceneSnapshot> snapshot;
+    /// Time since the last snapshot.
+    float snapshotTimer;
+    /// Reloads the scene description, materials and textures when their files change.
+    SharedPtr<HotReload> hotReload;
+    /// Sun material, from the scene description.
+    String sunMaterial;
+    /// Per-pixel cost measurement of the sun material, from "bench sun".
+    SharedPtr<SunBenchmark> sunBenchmark;
+    /// Sessions of the connected controllers and camera arbitration between them.
+    ControlArbiter controlArbiter;
+    /// Fly-to transitions and easing of the camera steps.
+    CameraRig cameraRig;
+    /// Camera owner the anchor was released for, to notice a new owner.
+    ControlSession* anchorSession;
+    /// Whether the camera follows a motion segment of the owner from anchorPosition and anchorYaw.
+    bool cameraAnchored;
+    /// Shared time in ms from which a motion segment may be followed, and whether it applies to its send time.
+    unsigned anchorTime;
+    bool anchorWholeSegment;
+    /// Start of the motion segment followed, in ms.
+    unsigned anchorStart;
+    /// Start of the run of the segment followed in ms, and motion of the run up to the start of the segment.
+    unsigned anchorRun;
+    CameraOdometry anchorKeyframe;
+    /// Camera position in its parent space and shared yaw, yaw_ minus myAngle, at the start of the segment followed.
+    Vector3 anchorPosition;
+    float anchorYaw;
+    /// Floating origin anchorPosition is relative to, to follow a rebase.
+    DoubleVector3 anchorOrigin;
+    /// Camera packet of the extrapolation, and motion extrapolated since it arrived.
+    unsigned extrapolatedSequence;
+    Vector3 extrapolatedMove;
+    float extrapolatedTurn;
+    /// Joystick probes received this frame.
+    Vector<JoystickProbe> joystickProbes;
+    /// Time base of the joystick probes.
+    HiresTimer probeTimer;
+    /// Text commands received since the last frame.
+    CommandQueue commandQueue;
+    /// Commands taken from the queue this frame, kept to reuse the allocation.
+    Vector<InboundCommand> drainedCommands;
+    /// Camera channel input received since the last frame, arbitrated with the commands.
+    Vector<CameraClaim> cameraClaims;
+    /// Last scene batch read, kept to reuse the allocations.
+    SceneBatch sceneBatch;
+    /// Models and materials of the last scene batch, held by resourceHandles.
+    PODVector<Model*> batchModels;
+    PODVector<Material*> batchMaterials;
+    /// Models and materials resolved once by name, for the scene code and the network commands.
+    SharedPtr<ResourceHandles> resourceHandles;
+    /// Skybox box and sun sphere.
+    ResourceHandle<Model> boxModel;
+    ResourceHandle<Model> sphereModel;
+    /// Star skybox, secret skybox and secret sun materials.
+    ResourceHandle<Material> starsSkyMaterial;
+    ResourceHandle<Material> secretSkyMaterial;
+    ResourceHandle<Material> secretSunMaterial;
+    /// Console log of the command path, written by a background thread.
+    SharedPtr<AsyncLog> commandLog;
 };
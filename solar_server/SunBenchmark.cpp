@@ -0,0 +1,180 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Math/Ray.h>
+#include <Urho3D/Math/Sphere.h>
+#include <Urho3D/Scene/Node.h>
+
+#include "SunBenchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+
+/// Offset of the 'S' camera preset from the sun.
+static const Vector3 PRESET_OFFSET(0.0f, 5.1f, -5.0f);
+/// Distance of the filled view from the sun centre, in sun radii. Close enough for the corners to hit the sun.
+static const float FILLED_DISTANCE = 1.2f;
+/// Rays cast across the viewport to measure the coverage.
+static const unsigned COVERAGE_COLUMNS = 64;
+static const unsigned COVERAGE_ROWS = 36;
+
+static const char* viewNames[] = { "preset S", "filled" };
+
+SunBenchmark::SunBenchmark(Context* context) :
+    Object(context),
+    phase_(NUM_PHASES),
+    frame_(0)
+{
+    for (unsigned i = 0; i < NUM_PHASES; ++i)
+        medians_[i] = 0.0f;
+    for (unsigned i = 0; i < NUM_VIEWS; ++i)
+        coverage_[i] = 0.0f;
+}
+
+SunBenchmark::~SunBenchmark()
+{
+}
+
+void SunBenchmark::Start(StaticModel* sun, Node* cameraNode, Material* reference)
+{
+    if (IsRunning() || !sun || !cameraNode)
+        return;
+
+    sun_ = sun;
+    cameraNode_ = cameraNode;
+    material_ = sun->GetMaterial();
+    reference_ = reference;
+    cameraPosition_ = cameraNode->GetPosition();
+
+    if (GetSubsystem<Graphics>()->GetVSync())
+        printf("sun benchmark: vertical sync is on, frame times are capped by the refresh rate\n");
+
+    phase_ = 0;
+    BeginPhase();
+    frameTimer_.Reset();
+
+    SubscribeToEvent(E_POSTUPDATE, URHO3D_HANDLER(SunBenchmark, HandlePostUpdate));
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(SunBenchmark, HandleEndFrame));
+}
+
+void SunBenchmark::BeginPhase()
+{
+    unsigned mode = phase_ % NUM_MODES;
+    sun_->SetEnabled(mode != MODE_HIDDEN);
+    sun_->SetMaterial(mode == MODE_REFERENCE ? reference_ : material_);
+
+    frame_ = 0;
+    times_.Clear();
+}
+
+void SunBenchmark::HandlePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (!sun_ || !cameraNode_)
+    {
+        phase_ = NUM_PHASES;
+        UnsubscribeFromAllEvents();
+        return;
+    }
+
+    // The application sets the camera rotation every update, so the view is applied again every frame
+    Node* sunNode = sun_->GetNode();
+    Vector3 center = sunNode->GetWorldPosition();
+    float radius = sunNode->GetWorldScale().x_ * 0.5f;
+    Vector3 offset = phase_ / NUM_MODES == VIEW_PRESET ? PRESET_OFFSET : Vector3(0.0f, 0.0f, -FILLED_DISTANCE * radius);
+
+    cameraNode_->SetWorldPosition(center + offset);
+    cameraNode_->LookAt(center);
+}
+
+void SunBenchmark::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    float frameTime = frameTimer_.GetUSec(true) / 1000.0f;
+    if (!IsRunning() || !sun_ || !cameraNode_)
+        return;
+
+    if (frame_++ >= WARMUP_FRAMES)
+        times_.Push(frameTime);
+    if (times_.Size() < MEASURED_FRAMES)
+        return;
+
+    Sort(times_.Begin(), times_.End());
+    medians_[phase_] = times_[times_.Size() / 2];
+    if (phase_ % NUM_MODES == MODE_HIDDEN)
+        coverage_[phase_ / NUM_MODES] = GetCoverage();
+
+    if (++phase_ < NUM_PHASES)
+        BeginPhase();
+    else
+        Finish();
+}
+
+float SunBenchmark::GetCoverage() const
+{
+    Camera* camera = cameraNode_->GetComponent<Camera>();
+    Node* sunNode = sun_->GetNode();
+    Sphere sphere(sunNode->GetWorldPosition(), sunNode->GetWorldScale().x_ * 0.5f);
+
+    unsigned hits = 0;
+    for (unsigned y = 0; y < COVERAGE_ROWS; ++y)
+    {
+        for (unsigned x = 0; x < COVERAGE_COLUMNS; ++x)
+        {
+            Ray ray = camera->GetScreenRay((x + 0.5f) / COVERAGE_COLUMNS, (y + 0.5f) / COVERAGE_ROWS);
+            if (ray.HitDistance(sphere) < M_INFINITY)
+                ++hits;
+        }
+    }
+    return (float)hits / (COVERAGE_COLUMNS * COVERAGE_ROWS);
+}
+
+void SunBenchmark::Finish()
+{
+    sun_->SetEnabled(true);
+    sun_->SetMaterial(material_);
+    cameraNode_->SetPosition(cameraPosition_);
+    UnsubscribeFromAllEvents();
+
+    Graphics* graphics = GetSubsystem<Graphics>();
+    float numPixels = (float)graphics->GetWidth() * graphics->GetHeight();
+
+    for (unsigned view = 0; view < NUM_VIEWS; ++view)
+    {
+        const float* medians = &medians_[view * NUM_MODES];
+        float sunPixels = coverage_[view] * numPixels;
+        // Cost of the sun over the same frame without it, in nanoseconds per covered pixel
+        float referenceCost = sunPixels > 0.0f ? (medians[MODE_REFERENCE] - medians[MODE_HIDDEN]) * 1e6f / sunPixels : 0.0f;
+        float currentCost = sunPixels > 0.0f ? (medians[MODE_CURRENT] - medians[MODE_HIDDEN]) * 1e6f / sunPixels : 0.0f;
+
+        printf("sun benchmark %s: coverage %.1f%% (%.0f px), frame %.3f ms without sun, %.3f ms %s (%.3f ns/px), "
+            "%.3f ms %s (%.3f ns/px)\n", viewNames[view], coverage_[view] * 100.0f, sunPixels, medians[MODE_HIDDEN],
+            medians[MODE_REFERENCE], reference_ ? reference_->GetName().CString() : "-", referenceCost,
+            medians[MODE_CURRENT], material_ ? material_->GetName().CString() : "-", currentCost);
+    }
+}
@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Material;
+class Node;
+class StaticModel;
+
+}
+
+/// Per-pixel cost of the sun material, measured on the live wall over a few hundred frames.
+/// For two views, the 'S' preset aimed at the sun and a view filled by the sun, the frame time is measured with the sun
+/// hidden, with the former textured material and with the current one. The difference to the hidden sun divided by the
+/// pixels the sun covers gives the cost per pixel. Frame times only follow the GPU load with vertical sync disabled.
+class SunBenchmark : public Object
+{
+    URHO3D_OBJECT(SunBenchmark, Object);
+
+public:
+    /// Construct.
+    SunBenchmark(Context* context);
+    /// Destruct.
+    virtual ~SunBenchmark();
+
+    /// Start measuring. The camera is moved for the duration of the benchmark and put back afterwards.
+    void Start(StaticModel* sun, Node* cameraNode, Material* reference);
+    /// Return whether a measurement is running.
+    bool IsRunning() const { return phase_ < NUM_PHASES; }
+
+    /// Frames rendered before measuring a phase.
+    static const unsigned WARMUP_FRAMES = 30;
+    /// Frames measured per phase.
+    static const unsigned MEASURED_FRAMES = 120;
+
+private:
+    /// Views measured.
+    enum View
+    {
+        VIEW_PRESET = 0,
+        VIEW_FILLED,
+        NUM_VIEWS
+    };
+    /// Sun states measured in each view.
+    enum Mode
+    {
+        MODE_HIDDEN = 0,
+        MODE_REFERENCE,
+        MODE_CURRENT,
+        NUM_MODES
+    };
+    /// Number of phases, one per view and mode.
+    static const unsigned NUM_PHASES = NUM_VIEWS * NUM_MODES;
+
+    /// Keep the camera on the view of the current phase, after the application moved it.
+    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Record the frame time and move to the next phase when enough frames are measured.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Set up the sun for the current phase.
+    void BeginPhase();
+    /// Restore the sun and the camera and print the report.
+    void Finish();
+    /// Return the fraction of the viewport covered by the sun, by casting a grid of rays.
+    float GetCoverage() const;
+
+    /// Sun model.
+    WeakPtr<StaticModel> sun_;
+    /// Camera node.
+    WeakPtr<Node> cameraNode_;
+    /// Material of the sun before the benchmark.
+    SharedPtr<Material> material_;
+    /// Material compared against.
+    SharedPtr<Material> reference_;
+    /// Camera position before the benchmark, in its parent's space.
+    Vector3 cameraPosition_;
+    /// Current phase.
+    unsigned phase_;
+    /// Frames rendered in the current phase.
+    unsigned frame_;
+    /// Frame times of the current phase in milliseconds.
+    PODVector<float> times_;
+    /// Median frame time of every phase in milliseconds.
+    float medians_[NUM_PHASES];
+    /// Viewport coverage of the sun in every view.
+    float coverage_[NUM_VIEWS];
+    /// Time since the previous frame.
+    HiresTimer frameTimer_;
+};
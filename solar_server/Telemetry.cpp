@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/IndexBuffer.h>
+#include <Urho3D/Graphics/Texture.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "ResourceHandles.h"
+#include "Telemetry.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdio>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+Telemetry::Telemetry(Context* context) :
+    Object(context),
+    frameTimes_(FRAME_HISTORY),
+    nextFrame_(0),
+    numFrames_(0)
+{
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(Telemetry, HandleEndFrame));
+}
+
+Telemetry::~Telemetry()
+{
+}
+
+void Telemetry::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    frameTimes_[nextFrame_] = frameTimer_.GetUSec(true) / 1000.0f;
+    nextFrame_ = (nextFrame_ + 1) % FRAME_HISTORY;
+    numFrames_ = Min(numFrames_ + 1, FRAME_HISTORY);
+}
+
+float Telemetry::GetFrameTimePercentile(float fraction) const
+{
+    if (!numFrames_)
+        return 0.0f;
+
+    // The oldest slots are the unused ones until the ring buffer has wrapped
+    PODVector<float> sorted(numFrames_);
+    for (unsigned i = 0; i < numFrames_; ++i)
+        sorted[i] = frameTimes_[(nextFrame_ + FRAME_HISTORY - numFrames_ + i) % FRAME_HISTORY];
+    Sort(sorted.Begin(), sorted.End());
+
+    unsigned index = Min((unsigned)(Clamp(fraction, 0.0f, 1.0f) * numFrames_), numFrames_ - 1);
+    return sorted[index];
+}
+
+String Telemetry::BuildReport(Scene* scene, ResourceHandles* handles) const
+{
+    String report;
+
+    AddLine(report, "frame.count", (unsigned long long)numFrames_);
+    AddLine(report, "frame.p50", GetFrameTimePercentile(0.5f));
+    AddLine(report, "frame.p95", GetFrameTimePercentile(0.95f));
+    AddLine(report, "frame.p99", GetFrameTimePercentile(0.99f));
+    AddLine(report, "frame.max", GetFrameTimePercentile(1.0f));
+
+    // Resource cache per type. A resource only referenced by the cache, and by the handle table that keeps it for good,
+    // is no longer used by the scene: a growing unused count after material swaps points at a leak
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    const HashMap<StringHash, ResourceGroup>& resourceGroups = cache->GetAllResources();
+    unsigned long long textureMemory = 0;
+    unsigned long long cacheMemory = 0;
+
+    for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups.Begin(); i != resourceGroups.End(); ++i)
+    {
+        const HashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
+        if (resources.Empty())
+            continue;
+
+        unsigned numUnused = 0;
+        for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin(); j != resources.End(); ++j)
+        {
+            Resource* resource = j->second_;
+            int refs = resource->Refs();
+            if (handles && handles->Holds(resource))
+                --refs;
+            if (refs == 1)
+                ++numUnused;
+            if (dynamic_cast<Texture*>(resource))
+                textureMemory += resource->GetMemoryUse();
+        }
+
+        String prefix = "cache." + resources.Front().second_->GetTypeName();
+        AddLine(report, prefix + ".count", (unsigned long long)resources.Size());
+        AddLine(report, prefix + ".unused", (unsigned long long)numUnused);
+        AddLine(report, prefix + ".memory", (unsigned long long)i->second_.memoryUse_);
+        cacheMemory += i->second_.memoryUse_;
+    }
+    AddLine(report, "cache.memory", cacheMemory);
+
+    // Scene counts, and the vertex and index buffers its drawables submit, each buffer counted once
+    unsigned long long bufferMemory = 0;
+    if (scene)
+    {
+        PODVector<Node*> nodes;
+        scene->GetChildren(nodes, true);
+        nodes.Push(scene);
+
+        HashSet<VertexBuffer*> vertexBuffers;
+        HashSet<IndexBuffer*> indexBuffers;
+        unsigned numComponents = 0;
+        unsigned numDrawables = 0;
+
+        for (unsigned i = 0; i < nodes.Size(); ++i)
+        {
+            const Vector<SharedPtr<Component> >& components = nodes[i]->GetComponents();
+            numComponents += components.Size();
+
+            for (unsigned j = 0; j < components.Size(); ++j)
+            {
+                Drawable* drawable = dynamic_cast<Drawable*>(components[j].Get());
+                if (!drawable)
+                    continue;
+                ++numDrawables;
+
+                const Vector<SourceBatch>& batches = drawable->GetBatches();
+                for (unsigned k = 0; k < batches.Size(); ++k)
+                {
+                    Geometry* geometry = batches[k].geometry_;
+                    if (!geometry)
+                        continue;
+
+                    const Vector<SharedPtr<VertexBuffer> >& buffers = geometry->GetVertexBuffers();
+                    for (unsigned l = 0; l < buffers.Size(); ++l)
+                    {
+                        VertexBuffer* buffer = buffers[l];
+                        if (buffer && !vertexBuffers.Contains(buffer))
+                        {
+                            vertexBuffers.Insert(buffer);
+                            bufferMemory += (unsigned long long)buffer->GetVertexCount() * buffer->GetVertexSize();
+                        }
+                    }
+
+                    IndexBuffer* indexBuffer = geometry->GetIndexBuffer();
+                    if (indexBuffer && !indexBuffers.Contains(indexBuffer))
+                    {
+                        indexBuffers.Insert(indexBuffer);
+                        bufferMemory += (unsigned long long)indexBuffer->GetIndexCount() * indexBuffer->GetIndexSize();
+                    }
+                }
+            }
+        }
+
+        AddLine(report, "scene.nodes", (unsigned long long)nodes.Size());
+        AddLine(report, "scene.components", (unsigned long long)numComponents);
+        AddLine(report, "scene.drawables", (unsigned long long)numDrawables);
+        AddLine(report, "gpu.vertexbuffers", (unsigned long long)vertexBuffers.Size());
+        AddLine(report, "gpu.indexbuffers", (unsigned long long)indexBuffers.Size());
+    }
+
+    // Render targets and shadow maps of the renderer are not resources and are left out
+    AddLine(report, "gpu.textures.memory", textureMemory);
+    AddLine(report, "gpu.buffers.memory", bufferMemory);
+    AddLine(report, "gpu.memory", textureMemory + bufferMemory);
+    AddLine(report, "process.resident", GetResidentMemory());
+
+    return report;
+}
+
+void Telemetry::AddLine(String& report, const String& key, unsigned long long value)
+{
+    char line[256];
+    sprintf(line, "%s %llu\n", key.CString(), value);
+    report += line;
+}
+
+void Telemetry::AddLine(String& report, const String& key, float value)
+{
+    char line[256];
+    sprintf(line, "%s %.3f\n", key.CString(), value);
+    report += line;
+}
+
+void Telemetry::AddLine(String& report, const String& key, double value)
+{
+    char line[256];
+    sprintf(line, "%s %g\n", key.CString(), value);
+    report += line;
+}
+
+unsigned long long Telemetry::GetResidentMemory()
+{
+#if defined(__linux__)
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file)
+        return 0;
+
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    int numRead = fscanf(file, "%llu %llu", &size, &resident);
+    fclose(file);
+    return numRead == 2 ? resident * (unsigned long long)sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
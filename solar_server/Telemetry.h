@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+
+// All Urho3D classes reside in namespace Urho3D
+using namespace Urho3D;
+
+namespace Urho3D
+{
+
+class Scene;
+
+}
+
+class ResourceHandles;
+
+/// Live resource and memory report of one wall, sent back to the client on request while the show runs.
+/// Frame times are kept in a ring buffer at the end of every frame; the rest is gathered when the report is built:
+/// resource cache use per type, GPU memory of the textures and of the buffers the scene draws, scene node and
+/// component counts and the resident size of the process.
+class Telemetry : public Object
+{
+    URHO3D_OBJECT(Telemetry, Object);
+
+public:
+    /// Construct. Starts recording frame times.
+    Telemetry(Context* context);
+    /// Destruct.
+    virtual ~Telemetry();
+
+    /// Build the report as "<key> <value>" lines. Frame times are in milliseconds, memory in bytes. The references
+    /// of the handle table, if any, do not count as uses of the resources.
+    String BuildReport(Scene* scene, ResourceHandles* handles = 0) const;
+    /// Return the frame time below which the given fraction of the recorded frames fall, in milliseconds.
+    float GetFrameTimePercentile(float fraction) const;
+    /// Return the number of frames recorded, at most FRAME_HISTORY.
+    unsigned GetNumFrames() const { return numFrames_; }
+
+    /// Return the resident set size of the process in bytes, or 0 when unknown.
+    static unsigned long long GetResidentMemory();
+    /// Append a "<key> <value>" line to a report. Shared by the subsystems that add their own lines to the report.
+    static void AddLine(String& report, const String& key, unsigned long long value);
+    /// Append a "<key> <value>" line with three decimals.
+    static void AddLine(String& report, const String& key, float value);
+    /// Append a "<key> <value>" line with six significant digits, for values far from 1.
+    static void AddLine(String& report, const String& key, double value);
+
+    /// Number of frame times kept.
+    static const unsigned FRAME_HISTORY = 1024;
+
+private:
+    /// Record the time since the previous frame.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+
+    /// Frame times in milliseconds, ring buffer.
+    PODVector<float> frameTimes_;
+    /// Next slot of the ring buffer.
+    unsigned nextFrame_;
+    /// Number of valid frame times.
+    unsigned numFrames_;
+    /// Time since the previous frame.
+    HiresTimer frameTimer_;
+};
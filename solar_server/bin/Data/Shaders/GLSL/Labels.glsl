@@ -0,0 +1,23 @@
+#include "Uniforms.glsl"
+#include "Samplers.glsl"
+#include "Transform.glsl"
+
+varying vec2 vTexCoord;
+varying vec4 vColor;
+
+void VS()
+{
+    // Glyph quads are laid out on the CPU directly in normalized device coordinates
+    gl_Position = vec4(iPos.xy, 0.0, 1.0);
+    vTexCoord = iTexCoord;
+    vColor = iColor;
+}
+
+void PS()
+{
+    // Distance to the glyph edge: 0.5 on the outline, a dark halo keeps the text readable over the planets
+    float distance = texture2D(sDiffMap, vTexCoord).a;
+    float fill = smoothstep(0.45, 0.55, distance);
+    float halo = smoothstep(0.25, 0.4, distance);
+    gl_FragColor = vec4(vColor.rgb * fill, vColor.a * halo);
+}
@@ -0,0 +1,24 @@
+#include "Uniforms.glsl"
+#include "Samplers.glsl"
+#include "Transform.glsl"
+
+varying vec4 vColor;
+
+#ifdef COMPILEVS
+uniform float cTrailFade;
+#endif
+
+void VS()
+{
+    mat4 modelMatrix = iModelMatrix;
+    vec3 worldPos = GetWorldPos(modelMatrix);
+    gl_Position = GetClipPos(worldPos);
+    // The first texture coordinate holds the append time: trails fade with age, orbits are stamped in the future
+    float age = cElapsedTime - iTexCoord.x;
+    vColor = vec4(iColor.rgb, iColor.a * clamp(1.0 - age * cTrailFade, 0.0, 1.0));
+}
+
+void PS()
+{
+    gl_FragColor = vec4(vColor.rgb * vColor.a, 1.0);
+}
@@ -0,0 +1,24 @@
+#include "Uniforms.glsl"
+#include "Samplers.glsl"
+#include "Transform.glsl"
+
+varying vec4 vColor;
+
+#ifdef COMPILEVS
+uniform float cSatellitePointSize;
+#endif
+
+void VS()
+{
+    mat4 modelMatrix = iModelMatrix;
+    vec3 worldPos = GetWorldPos(modelMatrix);
+    gl_Position = GetClipPos(worldPos);
+    // Payloads are drawn larger than rocket bodies and debris, the size is stored in the vertex alpha
+    gl_PointSize = max(1.0, cSatellitePointSize * iColor.a);
+    vColor = iColor;
+}
+
+void PS()
+{
+    gl_FragColor = vec4(vColor.rgb, 1.0);
+}
@@ -0,0 +1,26 @@
+#include "Uniforms.glsl"
+#include "Samplers.glsl"
+#include "Transform.glsl"
+
+varying vec4 vColor;
+
+#ifdef COMPILEVS
+uniform float cStarPointSize;
+#endif
+
+void VS()
+{
+    mat4 modelMatrix = iModelMatrix;
+    vec3 worldPos = GetWorldPos(modelMatrix);
+    gl_Position = GetClipPos(worldPos);
+    // Always behind the scene, like the skybox
+    gl_Position.z = gl_Position.w;
+    // Brightness is stored in the vertex alpha: bright stars get larger points
+    gl_PointSize = max(1.0, cStarPointSize * iColor.a);
+    vColor = iColor;
+}
+
+void PS()
+{
+    gl_FragColor = vec4(vColor.rgb * vColor.a, 1.0);
+}
@@ -0,0 +1,65 @@
+#include "Uniforms.glsl"
+#include "Samplers.glsl"
+#include "Transform.glsl"
+
+varying vec3 vPos;
+varying vec3 vNormal;
+varying vec3 vWorldPos;
+
+#ifdef COMPILEPS
+uniform vec4 cSunColorHot;
+uniform vec4 cSunColorCool;
+uniform float cSunGranuleScale;
+uniform float cSunAnimSpeed;
+uniform float cSunLimbDarkening;
+
+// Hash without sine, stable on every GPU precision
+float SunHash(vec3 p)
+{
+    p = fract(p * 0.1031);
+    p += dot(p, p.yzx + 19.19);
+    return fract((p.x + p.y) * p.z);
+}
+
+// Value noise in [0, 1] with smooth interpolation between the lattice points
+float SunNoise(vec3 p)
+{
+    vec3 i = floor(p);
+    vec3 f = fract(p);
+    f = f * f * (3.0 - 2.0 * f);
+
+    return mix(mix(mix(SunHash(i), SunHash(i + vec3(1.0, 0.0, 0.0)), f.x),
+                   mix(SunHash(i + vec3(0.0, 1.0, 0.0)), SunHash(i + vec3(1.0, 1.0, 0.0)), f.x), f.y),
+               mix(mix(SunHash(i + vec3(0.0, 0.0, 1.0)), SunHash(i + vec3(1.0, 0.0, 1.0)), f.x),
+                   mix(SunHash(i + vec3(0.0, 1.0, 1.0)), SunHash(i + vec3(1.0, 1.0, 1.0)), f.x), f.y), f.z);
+}
+#endif
+
+void VS()
+{
+    mat4 modelMatrix = iModelMatrix;
+    vec3 worldPos = GetWorldPos(modelMatrix);
+    gl_Position = GetClipPos(worldPos);
+    // The noise is evaluated on the model-space sphere, so it has no UV seam or pole pinch
+    vPos = iPos.xyz;
+    vNormal = GetWorldNormal(modelMatrix);
+    vWorldPos = worldPos;
+}
+
+void PS()
+{
+    // Granulation: three octaves drifting in different directions, so that the cells boil instead of scrolling
+    vec3 p = normalize(vPos) * cSunGranuleScale;
+    float t = cElapsedTimePS * cSunAnimSpeed;
+    float n = SunNoise(p + vec3(0.0, t, 0.0)) * 0.5 +
+        SunNoise(p * 2.03 - vec3(t * 1.7, 0.0, 0.0)) * 0.3 +
+        SunNoise(p * 4.07 + vec3(0.0, 0.0, t * 2.3)) * 0.2;
+    float granule = smoothstep(0.3, 0.7, n);
+
+    // Linear limb darkening law: the edge of the disk is cooler and dimmer than its centre
+    float mu = clamp(dot(normalize(vNormal), normalize(cCameraPosPS - vWorldPos)), 0.0, 1.0);
+    float limb = 1.0 - cSunLimbDarkening * (1.0 - mu);
+
+    vec3 color = mix(cSunColorCool.rgb, cSunColorHot.rgb, granule * mu);
+    gl_FragColor = vec4(color * limb, 1.0);
+}
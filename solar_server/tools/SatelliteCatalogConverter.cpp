@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Converts a two-line element set file (optional name line, then lines "1 ..." and "2 ...") into the binary format read
+// by SatelliteField. All elements are brought to the newest epoch of the file with the same J2 secular model the
+// server propagates with.
+//
+// Usage: SatelliteCatalogConverter <catalog.tle> <satellites.bin>
+
+#include "../SatelliteCatalog.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static const double PI = 3.14159265358979323846;
+
+/// Return a field of a TLE line by 1-based column range, as in the format description.
+static std::string Columns(const std::string& line, unsigned first, unsigned last)
+{
+    if (line.size() < first)
+        return std::string();
+    return line.substr(first - 1, last - first + 1);
+}
+
+/// Return the TLE epoch in minutes since 1950-01-01.
+static double EpochMinutes(const std::string& line1)
+{
+    int year = atoi(Columns(line1, 19, 20).c_str());
+    double dayOfYear = atof(Columns(line1, 21, 32).c_str());
+    year += year < 57 ? 2000 : 1900;
+
+    int days = 0;
+    for (int y = 1950; y < year; ++y)
+        days += (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)) ? 366 : 365;
+
+    return (days + dayOfYear - 1.0) * 1440.0;
+}
+
+/// Return the object kind from the name line.
+static unsigned Kind(const std::string& name)
+{
+    if (name.find(" DEB") != std::string::npos)
+        return SATELLITE_DEBRIS;
+    if (name.find("R/B") != std::string::npos)
+        return SATELLITE_ROCKET_BODY;
+    return SATELLITE_PAYLOAD;
+}
+
+/// Wrap an angle to [0, 2 pi).
+static double Wrap(double angle)
+{
+    angle = fmod(angle, 2.0 * PI);
+    return angle < 0.0 ? angle + 2.0 * PI : angle;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <catalog.tle> <satellites.bin>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* input = fopen(argv[1], "r");
+    if (!input)
+    {
+        printf("Could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<SatelliteRecord> records;
+    std::vector<double> epochs;
+    std::string name;
+    std::string line1;
+    char buffer[256];
+    unsigned skipped = 0;
+    unsigned kinds[3] = { 0, 0, 0 };
+    double newestEpoch = -1e30;
+
+    while (fgets(buffer, sizeof(buffer), input))
+    {
+        std::string line(buffer);
+        while (!line.empty() && (line[line.size() - 1] == '\n' || line[line.size() - 1] == '\r'))
+            line.erase(line.size() - 1);
+        if (line.empty())
+            continue;
+
+        if (line.size() >= 69 && line[0] == '1' && line[1] == ' ')
+        {
+            line1 = line;
+            continue;
+        }
+        if (!(line.size() >= 69 && line[0] == '2' && line[1] == ' '))
+        {
+            name = line;
+            continue;
+        }
+        if (line1.empty() || Columns(line1, 3, 7) != Columns(line, 3, 7))
+        {
+            ++skipped;
+            line1.clear();
+            continue;
+        }
+
+        SatelliteRecord record;
+        record.inclination_ = (float)(atof(Columns(line, 9, 16).c_str()) * PI / 180.0);
+        record.raan_ = (float)(atof(Columns(line, 18, 25).c_str()) * PI / 180.0);
+        record.eccentricity_ = (float)atof(("0." + Columns(line, 27, 33)).c_str());
+        record.argPerigee_ = (float)(atof(Columns(line, 35, 42).c_str()) * PI / 180.0);
+        record.meanAnomaly_ = (float)(atof(Columns(line, 44, 51).c_str()) * PI / 180.0);
+        record.meanMotion_ = (float)(atof(Columns(line, 53, 63).c_str()) * 2.0 * PI / 1440.0);
+        record.kind_ = Kind(name);
+
+        // Decayed or hyperbolic entries cannot be drawn
+        if (record.meanMotion_ <= 0.0f || record.eccentricity_ >= 0.99f)
+            ++skipped;
+        else
+        {
+            double epoch = EpochMinutes(line1);
+            newestEpoch = epoch > newestEpoch ? epoch : newestEpoch;
+            records.push_back(record);
+            epochs.push_back(epoch);
+            ++kinds[record.kind_];
+        }
+
+        name.clear();
+        line1.clear();
+    }
+    fclose(input);
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        SatelliteRecord& record = records[i];
+        SatelliteRates rates = GetSatelliteRates(record);
+        double dt = newestEpoch - epochs[i];
+        record.meanAnomaly_ = (float)Wrap(record.meanAnomaly_ + rates.meanAnomalyRate_ * dt);
+        record.raan_ = (float)Wrap(record.raan_ + rates.raanRate_ * dt);
+        record.argPerigee_ = (float)Wrap(record.argPerigee_ + rates.argPerigeeRate_ * dt);
+    }
+
+    if (!WriteSatelliteCatalog(argv[2], records.empty() ? 0 : &records[0], (unsigned)records.size()))
+    {
+        printf("Could not write %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%u objects written to %s (%u payloads, %u rocket bodies, %u debris; %u malformed entries skipped)\n",
+        (unsigned)records.size(), argv[2], kinds[SATELLITE_PAYLOAD], kinds[SATELLITE_ROCKET_BODY], kinds[SATELLITE_DEBRIS],
+        skipped);
+    return 0;
+}
@@ -0,0 +1,112 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Fuzz target of the scene edit command parser. Built with -DSOLAR_FUZZ=1 and clang, it is a libFuzzer target:
+//
+// Usage: SceneCommandFuzzer [corpus directory] [libFuzzer options]
+//
+// Otherwise it replays files, one command per line, and prints how many parse, to keep a corpus as a regression test:
+//
+// Usage: SceneCommandFuzzer <commands.txt> [...]
+
+#include "../SceneCommands.h"
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+
+/// Abort if a parsed command breaks the guarantees the server relies on.
+static void CheckCommand(const SceneCommand& command)
+{
+    const char* names[] = { command.name_, command.point_, command.model_, command.material_, command.hiddenMaterial_ };
+    unsigned numNames = command.type_ == SCENE_CREATE_POINT ? 1 : command.type_ == SCENE_MOVE_OBJECT ? 2 : 5;
+    for (unsigned i = 0; i < numNames; ++i)
+    {
+        // SCENE_CREATE_OBJECT has no point
+        if (i == 1 && command.type_ == SCENE_CREATE_OBJECT)
+            continue;
+        if (!memchr(names[i], 0, SCENE_NAME_LENGTH) || !names[i][0] || strchr(names[i], ' '))
+            abort();
+        if (i >= 2 && strstr(names[i], ".."))
+            abort();
+    }
+
+    if (command.type_ == SCENE_CREATE_OBJECT || command.type_ == SCENE_CREATE_POINT)
+    {
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            if (!std::isfinite(command.position_[i]))
+                abort();
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    // commands reach the parser as null-terminated strings
+    std::string text((const char*)data, size);
+    SceneCommand command;
+    if (ParseSceneCommand(text.c_str(), command))
+        CheckCommand(command);
+    return 0;
+}
+
+#ifndef SOLAR_LIBFUZZER
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("Usage: SceneCommandFuzzer <commands.txt> [...]\n");
+        return 1;
+    }
+
+    unsigned numCommands = 0;
+    unsigned numParsed = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        FILE* file = fopen(argv[i], "rb");
+        if (!file)
+        {
+            printf("Could not open %s\n", argv[i]);
+            return 1;
+        }
+
+        char line[4096];
+        while (fgets(line, sizeof(line), file))
+        {
+            line[strcspn(line, "\r\n")] = 0;
+            SceneCommand command;
+            ++numCommands;
+            if (ParseSceneCommand(line, command))
+            {
+                CheckCommand(command);
+                ++numParsed;
+            }
+        }
+        fclose(file);
+    }
+
+    printf("%u commands, %u parsed\n", numCommands, numParsed);
+    return 0;
+}
+#endif
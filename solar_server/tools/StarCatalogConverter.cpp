@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Converts a CSV star catalog (HYG database layout: columns ra in hours, dec in degrees, mag, ci) into the binary format
+// read by StarField.
+//
+// Usage: StarCatalogConverter <catalog.csv> <stars.bin> [max magnitude]
+
+#include "../StarCatalog.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/// Obliquity of the ecliptic in radians (J2000).
+static const double OBLIQUITY = 23.4392911 * 3.14159265358979323846 / 180.0;
+
+/// Split a CSV line, honouring double quotes.
+static void SplitCsv(const std::string& line, std::vector<std::string>& fields)
+{
+    fields.clear();
+    std::string field;
+    bool quoted = false;
+
+    for (size_t i = 0; i < line.size(); ++i)
+    {
+        char c = line[i];
+        if (c == '"')
+            quoted = !quoted;
+        else if (c == ',' && !quoted)
+        {
+            fields.push_back(field);
+            field.clear();
+        }
+        else if (c != '\r' && c != '\n')
+            field += c;
+    }
+    fields.push_back(field);
+}
+
+/// Return the index of a column, or -1.
+static int FindColumn(const std::vector<std::string>& header, const char* name)
+{
+    for (size_t i = 0; i < header.size(); ++i)
+    {
+        if (header[i] == name)
+            return (int)i;
+    }
+    return -1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <catalog.csv> <stars.bin> [max magnitude]\n", argv[0]);
+        return 1;
+    }
+
+    float maxMagnitude = argc > 3 ? (float)atof(argv[3]) : 99.0f;
+
+    FILE* input = fopen(argv[1], "r");
+    if (!input)
+    {
+        printf("Could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<std::string> header;
+    std::vector<std::string> fields;
+    std::vector<StarRecord> records;
+    std::string line;
+    char buffer[4096];
+    int raColumn = -1, decColumn = -1, magColumn = -1, ciColumn = -1, distColumn = -1;
+    unsigned skipped = 0;
+
+    while (fgets(buffer, sizeof(buffer), input))
+    {
+        line += buffer;
+        if (line.empty() || line[line.size() - 1] != '\n')
+        {
+            if (!feof(input))
+                continue;
+        }
+
+        if (header.empty())
+        {
+            SplitCsv(line, header);
+            raColumn = FindColumn(header, "ra");
+            decColumn = FindColumn(header, "dec");
+            magColumn = FindColumn(header, "mag");
+            ciColumn = FindColumn(header, "ci");
+            distColumn = FindColumn(header, "dist");
+            if (raColumn < 0 || decColumn < 0 || magColumn < 0)
+            {
+                printf("Missing ra, dec or mag column in %s\n", argv[1]);
+                fclose(input);
+                return 1;
+            }
+            line.clear();
+            continue;
+        }
+
+        SplitCsv(line, fields);
+        line.clear();
+
+        if ((int)fields.size() <= raColumn || (int)fields.size() <= decColumn || (int)fields.size() <= magColumn)
+        {
+            ++skipped;
+            continue;
+        }
+
+        // The sun is in the catalog at distance 0
+        if (distColumn >= 0 && (int)fields.size() > distColumn && atof(fields[distColumn].c_str()) <= 0.0)
+            continue;
+
+        float magnitude = (float)atof(fields[magColumn].c_str());
+        if (magnitude > maxMagnitude)
+            continue;
+
+        double ra = atof(fields[raColumn].c_str()) * 15.0 * 3.14159265358979323846 / 180.0;
+        double dec = atof(fields[decColumn].c_str()) * 3.14159265358979323846 / 180.0;
+
+        // Equatorial to ecliptic coordinates
+        double xq = cos(dec) * cos(ra);
+        double yq = cos(dec) * sin(ra);
+        double zq = sin(dec);
+        double xe = xq;
+        double ye = yq * cos(OBLIQUITY) + zq * sin(OBLIQUITY);
+        double ze = -yq * sin(OBLIQUITY) + zq * cos(OBLIQUITY);
+
+        // Ecliptic to scene axes: the planets move from +X towards +Z, the north ecliptic pole is +Y
+        StarRecord record;
+        record.x_ = (float)xe;
+        record.y_ = (float)ze;
+        record.z_ = (float)ye;
+        record.magnitude_ = magnitude;
+        record.colorIndex_ = ciColumn >= 0 && (int)fields.size() > ciColumn && !fields[ciColumn].empty() ?
+            (float)atof(fields[ciColumn].c_str()) : 0.65f;
+        records.push_back(record);
+    }
+    fclose(input);
+
+    if (!WriteStarCatalog(argv[2], records.empty() ? 0 : &records[0], (unsigned)records.size()))
+    {
+        printf("Could not write %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%u stars written to %s (%u malformed lines skipped)\n", (unsigned)records.size(), argv[2], skipped);
+    return 0;
+}